@@ -43,6 +43,8 @@ typedef Uint16 uint16;
 typedef Sint16 int16;
 typedef Uint32 uint32;
 typedef Sint32 int32;
+typedef Uint64 uint64;
+typedef Sint64 int64;
 typedef time_t TimeType;
 
 // Minimum and maximum values for these types
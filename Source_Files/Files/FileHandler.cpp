@@ -156,8 +156,12 @@ bool OpenedFile::Write(int32 Count, void *Buffer)
 	if (f == NULL)
 		return false;
 
+	// a short write is an error too, even if the C library didn't say which
+	errno = 0;
 	err = 0;
-	return (SDL_RWwrite(f, Buffer, 1, Count) == Count);
+	if (SDL_RWwrite(f, Buffer, 1, Count) != Count)
+		err = errno ? errno : EIO;
+	return err == 0;
 }
 
 
@@ -361,7 +365,7 @@ static std::string unix_path_separators(const std::string& input)
 #endif
 
 // Open data file
-bool FileSpecifier::Open(OpenedFile &OFile, bool Writable)
+bool FileSpecifier::Open(OpenedFile &OFile, bool Writable, bool report_errors)
 {
 	OFile.Close();
 
@@ -383,7 +387,8 @@ bool FileSpecifier::Open(OpenedFile &OFile, bool Writable)
 
 	err = f ? 0 : errno;
 	if (f == NULL) {
-		set_game_error(systemError, err);
+		if (report_errors)
+			set_game_error(systemError, err);
 		return false;
 	}
 	if (Writable)
@@ -470,6 +475,14 @@ TimeType FileSpecifier::GetDate()
 	return st.st_mtime;
 }
 
+bool FileSpecifier::SetDate(TimeType Date)
+{
+	boost::system::error_code ec;
+	boost::filesystem::last_write_time(boost::filesystem::path(GetPath()), Date, ec);
+	err = ec.value();
+	return err == 0;
+}
+
 static const char * alephone_extensions[] = {
 	".sceA",
 	".sgaA",
@@ -265,8 +265,9 @@ public:
 	// and typecode suffixes.
 	bool Create(Typecode Type);
 	
-	// Opens a file:
-	bool Open(OpenedFile& OFile, bool Writable=false);
+	// Opens a file; with report_errors off, a failure is left in GetError()
+	// and the game error is untouched (for opening off the main thread):
+	bool Open(OpenedFile& OFile, bool Writable=false, bool report_errors=true);
 	
 	// Opens either a MacOS resource fork or some imitation of it:
 	bool Open(OpenedResourceFile& OFile, bool Writable=false);
@@ -286,6 +287,9 @@ public:
 	
 	// Gets the modification date
 	TimeType GetDate();
+
+	// Sets the modification date
+	bool SetDate(TimeType Date);
 	
 	// Returns _typecode_unknown if the type could not be identified;
 	// the types returned are the _typecode_stuff in tags.h
@@ -0,0 +1,308 @@
+/*
+ *  LevelPrefetcher.cpp - reads the next level ahead of time on a background thread
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+ */
+
+#include "LevelPrefetcher.h"
+
+#include "game_wad.h"
+#include "interface.h"
+#include "map.h"
+#include "monsters.h"
+#include "shape_descriptors.h"
+#include "tags.h"
+#include "wad.h"
+
+#define DONT_REPEAT_DEFINITIONS
+#include "monster_definitions.h"
+
+#ifdef HAVE_OPENGL
+#include "OGL_Setup.h"
+#include "OGL_Subst_Texture_Def.h"
+#endif
+
+#include <string.h>
+
+extern short bit_depth;
+
+LevelPrefetcher::LevelPrefetcher() :
+	queued_(false),
+	busy_(false),
+	stop_(false),
+	map_(0),
+	map_level_(NONE),
+	thread_(0)
+{
+	mutex_ = SDL_CreateMutex();
+	cond_ = SDL_CreateCond();
+}
+
+void LevelPrefetcher::Prefetch(short level_number)
+{
+	FileSpecifier& File = get_map_file();
+
+	SDL_LockMutex(mutex_);
+	bool skip = queued_ || busy_ || (map_ && map_level_ == level_number && map_file_ == File);
+	SDL_UnlockMutex(mutex_);
+	if (skip)
+		return;
+
+	// everything the thread needs from the game is copied now, on this thread
+	Job job;
+	job.file = File;
+	job.level_number = level_number;
+	job.depth = bit_depth;
+	job.landscapes = LandscapesLoaded;
+
+	for (short collection_index = 0; collection_index < MAXIMUM_COLLECTIONS; ++collection_index)
+	{
+		if (is_collection_present(collection_index))
+			job.loaded.push_back(collection_index);
+	}
+
+	get_environment_collections(job.environments);
+
+	for (short monster_type = 0; monster_type < NUMBER_OF_MONSTER_TYPES; ++monster_type)
+	{
+		monster_definition *definition = get_monster_definition_external(monster_type);
+		job.monster_collections.push_back((definition && definition->collection != NONE) ? GET_COLLECTION(definition->collection) : NONE);
+	}
+
+#ifdef HAVE_OPENGL
+	if (OGL_IsActive())
+	{
+		job.textures.resize(MAXIMUM_COLLECTIONS);
+		for (short collection_index = 0; collection_index < MAXIMUM_COLLECTIONS; ++collection_index)
+			OGL_GetTexturePrefetches(collection_index, job.textures[collection_index]);
+	}
+#endif
+
+	SDL_LockMutex(mutex_);
+	if (!thread_)
+		thread_ = SDL_CreateThread(Run, "LevelPrefetcher_fetchThread", this);
+
+	if (thread_)
+	{
+		if (map_)
+		{
+			free(map_);
+			map_ = 0;
+		}
+
+		job_ = job;
+		queued_ = true;
+		stop_ = false;
+		SDL_CondBroadcast(cond_);
+	}
+	SDL_UnlockMutex(mutex_);
+}
+
+bool LevelPrefetcher::Stopping()
+{
+	SDL_LockMutex(mutex_);
+	bool stopping = stop_;
+	SDL_UnlockMutex(mutex_);
+	return stopping;
+}
+
+// reads the wad and stages it for TakeMap(); returns a copy for Fetch() to look inside,
+// since inflating flat data takes it over
+void *LevelPrefetcher::ReadMap(Job& job)
+{
+	void *data = read_flat_data(job.file, job.level_number);
+	if (!data)
+		return NULL;
+
+	int32 length = get_flat_data_length(data);
+	void *copy = malloc(length);
+	if (copy)
+		memcpy(copy, data, length);
+
+	SDL_LockMutex(mutex_);
+	map_ = data;
+	map_file_ = job.file;
+	map_level_ = job.level_number;
+	SDL_CondBroadcast(cond_);
+	SDL_UnlockMutex(mutex_);
+
+	return copy;
+}
+
+void LevelPrefetcher::Fetch(Job& job)
+{
+	void *data = ReadMap(job);
+	if (!data)
+		return;
+
+	// the same collections entering_map() will mark, as far as the wad can tell us
+	std::vector<short> collections;
+	std::vector<bool> wanted(MAXIMUM_COLLECTIONS, false);
+
+	wad_header header;
+	wad_data *wad = inflate_flat_data(data, &header);
+	if (!wad)
+	{
+		free(data);
+		return;
+	}
+
+	size_t length;
+	uint8 *p = (uint8 *)extract_type_from_wad(wad, MAP_INFO_TAG, &length);
+	if (p && (length == SIZEOF_static_data || length == SIZEOF_static_data - 2))
+	{
+		uint8 buffer[SIZEOF_static_data];
+		memset(buffer, 0, sizeof(buffer));
+		memcpy(buffer, p, length);
+
+		static_data map_info;
+		unpack_static_data(buffer, &map_info, 1);
+
+		if (map_info.environment_code >= 0 && map_info.environment_code < static_cast<int16>(job.environments.size()))
+		{
+			std::vector<short>& environment = job.environments[map_info.environment_code];
+			collections.insert(collections.end(), environment.begin(), environment.end());
+		}
+
+		if (job.landscapes)
+			collections.push_back(_collection_landscape1 + map_info.song_index);
+	}
+
+	p = (uint8 *)extract_type_from_wad(wad, ITEM_PLACEMENT_STRUCTURE_TAG, &length);
+	if (p && length == 2*MAXIMUM_OBJECT_TYPES*SIZEOF_object_frequency_definition)
+	{
+		object_frequency_definition placement[MAXIMUM_OBJECT_TYPES];
+		unpack_object_frequency_definition(p + MAXIMUM_OBJECT_TYPES*SIZEOF_object_frequency_definition, placement, MAXIMUM_OBJECT_TYPES);
+
+		// as mark_all_monster_collections() decides
+		for (size_t monster_type = 1; monster_type < job.monster_collections.size() && monster_type < MAXIMUM_OBJECT_TYPES; ++monster_type)
+		{
+			object_frequency_definition& info = placement[monster_type];
+			if (info.initial_count > 0 || info.minimum_count > 0 ||
+				((info.random_count > 0 || info.random_count == NONE) && info.random_chance > 1))
+			{
+				collections.push_back(job.monster_collections[monster_type]);
+			}
+		}
+	}
+
+	free_wad(wad);
+
+	// players, weapons, items and the interface are loaded now and will be again
+	collections.insert(collections.end(), job.loaded.begin(), job.loaded.end());
+
+	for (std::vector<short>::iterator it = collections.begin(); it != collections.end(); ++it)
+	{
+		short collection_index = *it;
+		if (collection_index < 0 || collection_index >= MAXIMUM_COLLECTIONS || wanted[collection_index])
+			continue;
+		wanted[collection_index] = true;
+
+		if (Stopping())
+			return;
+
+		prefetch_collection(collection_index, job.depth);
+	}
+
+	if (job.textures.empty())
+		return;
+
+	for (std::vector<short>::iterator it = collections.begin(); it != collections.end(); ++it)
+	{
+		if (*it < 0 || *it >= MAXIMUM_COLLECTIONS)
+			continue;
+
+		std::vector<ImageLoader_PrefetchRequest>& textures = job.textures[*it];
+		for (std::vector<ImageLoader_PrefetchRequest>::iterator request = textures.begin(); request != textures.end(); ++request)
+		{
+			if (Stopping())
+				return;
+
+			ImageLoader_Prefetch(*request);
+		}
+		textures.clear();
+	}
+}
+
+int LevelPrefetcher::Run(void *pv)
+{
+	LevelPrefetcher* prefetcher = reinterpret_cast<LevelPrefetcher*>(pv);
+
+	// the game has the disk for anything it can't wait for
+	SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+
+	SDL_LockMutex(prefetcher->mutex_);
+	while (true)
+	{
+		while (!prefetcher->queued_)
+			SDL_CondWait(prefetcher->cond_, prefetcher->mutex_);
+
+		Job job;
+		std::swap(job, prefetcher->job_);
+		prefetcher->queued_ = false;
+		prefetcher->busy_ = true;
+		SDL_UnlockMutex(prefetcher->mutex_);
+
+		prefetcher->Fetch(job);
+
+		SDL_LockMutex(prefetcher->mutex_);
+		prefetcher->busy_ = false;
+		SDL_CondBroadcast(prefetcher->cond_);
+	}
+
+	return 0;
+}
+
+void *LevelPrefetcher::TakeMap(FileSpecifier& File, short level_number)
+{
+	void *data = NULL;
+
+	// the wad is the first thing read; the rest can carry on while the level loads
+	SDL_LockMutex(mutex_);
+	while ((queued_ || busy_) && !map_)
+		SDL_CondWait(cond_, mutex_);
+
+	if (map_)
+	{
+		if (map_level_ == level_number && map_file_ == File)
+			data = map_;
+		else
+			free(map_);
+		map_ = 0;
+	}
+	SDL_UnlockMutex(mutex_);
+
+	return data;
+}
+
+void LevelPrefetcher::Wait()
+{
+	SDL_LockMutex(mutex_);
+	stop_ = true;
+	queued_ = false;
+	while (busy_)
+		SDL_CondWait(cond_, mutex_);
+	SDL_UnlockMutex(mutex_);
+}
+
+void LevelPrefetcher::Drain()
+{
+	SDL_LockMutex(mutex_);
+	while (queued_ || busy_)
+		SDL_CondWait(cond_, mutex_);
+	SDL_UnlockMutex(mutex_);
+}
@@ -0,0 +1,100 @@
+/*
+ *  LevelPrefetcher.h - reads the next level ahead of time on a background thread
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+
+	When a level change becomes likely (an interlevel teleport starts, or a terminal
+	with a teleport group is opened), Prefetch() snapshots what the game knows now on
+	the main thread; the prefetcher's thread then reads the level's wad, works out
+	which collections it will want, and reads those and their replacement textures.
+	Nothing it does touches the game state: the wad is handed back by TakeMap(), and
+	collections and textures are staged for load_collection() and ImageDescriptor to
+	pick up, or thrown away if the level change never comes.
+ */
+
+#ifndef LEVEL_PREFETCHER_H
+#define LEVEL_PREFETCHER_H
+
+#include "cseries.h"
+#include "FileHandler.h"
+#include "ImageLoader.h"
+
+#include <vector>
+
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
+
+class LevelPrefetcher {
+public:
+	static LevelPrefetcher* instance() {
+		static LevelPrefetcher *instance_ = nullptr;
+		if (!instance_)
+			instance_ = new LevelPrefetcher();
+		return instance_;
+	}
+
+	// starts reading level_number of the current map file; ignored while a prefetch is
+	// still running. Call on the main thread
+	void Prefetch(short level_number);
+
+	// waits for the prefetched wad, and returns it as get_flat_data() would if it is
+	// level_number of File (the caller frees it); NULL otherwise
+	void *TakeMap(FileSpecifier& File, short level_number);
+
+	// stops prefetching after whatever is being read now; before load_collections()
+	void Wait();
+
+	// lets the prefetch run to the end, and waits for it
+	void Drain();
+
+private:
+	struct Job {
+		FileSpecifier file;
+		short level_number;
+		short depth;
+		bool landscapes;
+
+		std::vector<short> loaded;				// collections loaded now
+		std::vector<std::vector<short> > environments;		// by environment code
+		std::vector<short> monster_collections;		// by monster type, or NONE
+		std::vector<std::vector<ImageLoader_PrefetchRequest> > textures;	// by collection
+	};
+
+	LevelPrefetcher();
+
+	void Fetch(Job& job);
+	void *ReadMap(Job& job);
+	bool Stopping();
+
+	Job job_;
+	bool queued_;
+	bool busy_;
+	bool stop_;
+
+	// the wad Fetch() read, until TakeMap() hands it over
+	void *map_;
+	FileSpecifier map_file_;
+	short map_level_;
+
+	// thread fun
+	SDL_Thread* thread_;
+	SDL_mutex* mutex_;
+	SDL_cond* cond_;
+	static int Run(void *);
+};
+
+#endif
@@ -0,0 +1,194 @@
+/*
+ *  SaveGameWriter.cpp - writes saved games on a background thread
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+ */
+
+#include "SaveGameWriter.h"
+
+#include "game_errors.h"
+#include "game_wad.h"
+#include "tags.h"
+
+#include <errno.h>
+
+SaveGameWriter::Job::~Job()
+{
+	if (wad)
+		free_wad(wad);
+}
+
+SaveGameWriter::SaveGameWriter() : writing_(0), quit_(false), thread_(0)
+{
+	mutex_ = SDL_CreateMutex();
+	cond_ = SDL_CreateCond();
+}
+
+bool SaveGameWriter::Save(FileSpecifier& File, const std::string& metadata, ImageBuilder build_image, DoneCallback done, ErrorCallback error)
+{
+	std::unique_ptr<Job> job(new Job);
+	job->file = File;
+	job->metadata = metadata;
+	job->build_image = build_image;
+	job->done = done;
+	job->error = error;
+
+	// the snapshot has to be taken now, and creating the file here keeps the game's
+	// error state on this thread
+	job->wad = build_save_game_snapshot(File, &job->header, &job->wad_length);
+	job->temp_file.SetTempName(File);
+
+	bool started = job->wad &&
+		create_wadfile(job->temp_file, _typecode_savegame) &&
+		open_wad_file_for_writing(job->temp_file, job->save_file);
+
+	SDL_LockMutex(mutex_);
+	if (started && !error_pending())
+	{
+		if (!thread_)
+			thread_ = SDL_CreateThread(Run, "SaveGameWriter_writeThread", this);
+
+		queued_.push_back(std::move(job));
+		SDL_CondBroadcast(cond_);
+	}
+	else
+	{
+		// the file's own error if creating or opening it failed, otherwise whatever the
+		// snapshot reported; a snapshot that couldn't be built ran out of memory
+		job->err = job->temp_file.GetError();
+		if (!job->err)
+			job->err = get_game_error(NULL);
+		if (!job->err && !job->wad)
+			job->err = ENOMEM;
+		clear_game_error();
+		close_wad_file(job->save_file);
+		job->temp_file.Delete();
+		finished_.push_back(std::move(job));
+		started = false;
+	}
+	SDL_UnlockMutex(mutex_);
+
+	return started;
+}
+
+void SaveGameWriter::Write(Job& job)
+{
+	std::string imagedata;
+	if (job.build_image)
+		imagedata = job.build_image();
+
+	job.success = write_save_game_file(job.save_file, &job.header, job.wad, job.wad_length, job.metadata, imagedata);
+	job.err = job.save_file.GetError();
+	close_wad_file(job.save_file);
+
+	// a failed write or seek sets the file's error; only building the metadata wad can
+	// fail without one
+	if (!job.success && !job.err)
+	{
+		job.err = ENOMEM;
+	}
+
+	if (job.success && !job.err && !job.temp_file.Rename(job.file))
+	{
+		job.err = errno;
+	}
+
+	if (!job.success || job.err)
+	{
+		job.success = false;
+		job.temp_file.Delete();
+	}
+}
+
+int SaveGameWriter::Run(void *pv)
+{
+	SaveGameWriter* writer = reinterpret_cast<SaveGameWriter*>(pv);
+
+	SDL_LockMutex(writer->mutex_);
+	while (true)
+	{
+		while (writer->queued_.empty() && !writer->quit_)
+			SDL_CondWait(writer->cond_, writer->mutex_);
+
+		if (writer->queued_.empty())
+			break;
+
+		std::unique_ptr<Job> job(std::move(writer->queued_.front()));
+		writer->queued_.pop_front();
+		++writer->writing_;
+		SDL_UnlockMutex(writer->mutex_);
+
+		Write(*job);
+
+		SDL_LockMutex(writer->mutex_);
+		--writer->writing_;
+		writer->finished_.push_back(std::move(job));
+		SDL_CondBroadcast(writer->cond_);
+	}
+	SDL_UnlockMutex(writer->mutex_);
+
+	return 0;
+}
+
+void SaveGameWriter::Idle()
+{
+	std::deque<std::unique_ptr<Job> > finished;
+	SDL_LockMutex(mutex_);
+	finished.swap(finished_);
+	SDL_UnlockMutex(mutex_);
+
+	for (std::deque<std::unique_ptr<Job> >::iterator it = finished.begin(); it != finished.end(); ++it)
+	{
+		Job& job = **it;
+		if (job.success)
+		{
+			if (job.done)
+				job.done(job.file);
+		}
+		else if (job.error)
+		{
+			job.error(job.file, job.err);
+		}
+	}
+}
+
+void SaveGameWriter::Finish()
+{
+	SDL_LockMutex(mutex_);
+	while (!queued_.empty() || writing_)
+		SDL_CondWait(cond_, mutex_);
+	SDL_UnlockMutex(mutex_);
+
+	Idle();
+}
+
+void SaveGameWriter::Shutdown()
+{
+	Finish();
+
+	if (thread_)
+	{
+		SDL_LockMutex(mutex_);
+		quit_ = true;
+		SDL_CondBroadcast(cond_);
+		SDL_UnlockMutex(mutex_);
+
+		SDL_WaitThread(thread_, NULL);
+		thread_ = 0;
+		quit_ = false;
+	}
+}
@@ -0,0 +1,108 @@
+/*
+ *  SaveGameWriter.h - writes saved games on a background thread
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+
+	The game is snapshotted into memory on the calling thread; the preview image, the
+	wad file itself and the rename over the real name happen on the writer's thread, and
+	the result is reported back on the main thread by Idle().
+ */
+
+#ifndef SAVE_GAME_WRITER_H
+#define SAVE_GAME_WRITER_H
+
+#include "cseries.h"
+#include "FileHandler.h"
+#include "wad.h"
+
+#include <deque>
+#include <memory>
+#include <string>
+
+#include <boost/function.hpp>
+
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
+
+class SaveGameWriter {
+public:
+	static SaveGameWriter* instance() {
+		static SaveGameWriter *instance_ = nullptr;
+		if (!instance_)
+			instance_ = new SaveGameWriter();
+		return instance_;
+	}
+
+	// runs on the writer thread, returns the encoded preview image
+	typedef boost::function<std::string (void)> ImageBuilder;
+	typedef boost::function<void (FileSpecifier&)> DoneCallback;
+	typedef boost::function<void (FileSpecifier&, int)> ErrorCallback;
+
+	// snapshots the running game, then writes it to File in the background; exactly one of
+	// the callbacks is called later, from Idle() or Finish(), with the file's errno if it
+	// failed; returns false if the save couldn't even be started (the error callback is
+	// still called)
+	bool Save(FileSpecifier& File, const std::string& metadata, ImageBuilder build_image, DoneCallback done, ErrorCallback error);
+
+	// reports finished saves; call from the main loop
+	void Idle();
+
+	// waits for every queued save to be written, then reports them; before
+	// anything that reads saved games back
+	void Finish();
+
+	// finishes, then stops the writer's thread; at exit
+	void Shutdown();
+
+private:
+	struct Job {
+		Job() : wad(0), wad_length(0), err(0), success(false) { }
+		~Job();
+
+		FileSpecifier file;
+		FileSpecifier temp_file;
+		OpenedFile save_file;
+
+		wad_header header;
+		wad_data *wad;
+		int32 wad_length;
+		std::string metadata;
+		ImageBuilder build_image;
+
+		DoneCallback done;
+		ErrorCallback error;
+		int err;
+		bool success;
+	};
+
+	SaveGameWriter();
+
+	static void Write(Job& job);
+
+	std::deque<std::unique_ptr<Job> > queued_;
+	std::deque<std::unique_ptr<Job> > finished_;
+	int writing_;
+	bool quit_;
+
+	// thread fun
+	SDL_Thread* thread_;
+	SDL_mutex* mutex_;
+	SDL_cond* cond_;
+	static int Run(void *);
+};
+
+#endif
@@ -77,6 +77,13 @@ Nov 26, 2000 (Loren Petrich):
 Feb 15, 2002 (Br'fin (Jeremy Parsons)):
 	Additional save data is now applied to the Temporary file instead of the original
 	(Old level preview info is now saved under Macintosh again)
+
+Oct 17, 2026:
+	load_level_from_map() and get_map_for_net_transfer() take the level from the
+	LevelPrefetcher when it has already read it
+	Levels and entry points are read through a WadFileView of the map file, which is
+	mapped and has its directory parsed once, instead of being read level by level
+	Added benchmark_map_reading()
 */
 
 // This needs to do the right thing on save game, which is storing the precalculated crap.
@@ -94,6 +101,7 @@ Feb 15, 2002 (Br'fin (Jeremy Parsons)):
 #include "player.h"
 #include "platforms.h"
 #include "flood_map.h"
+#include "polygon_visibility.h"
 #include "scenery.h"
 #include "lightsource.h"
 #include "media.h"
@@ -115,6 +123,8 @@ Feb 15, 2002 (Br'fin (Jeremy Parsons)):
 #include "preferences.h"
 #include "SoundManager.h"
 #include "Plugins.h"
+#include "SaveGameWriter.h"
+#include "LevelPrefetcher.h"
 
 // LP change: added chase-cam init and render allocation
 #include "ChaseCam.h"
@@ -217,6 +227,17 @@ void *get_map_for_net_transfer(
 {
 	assert(file_is_set);
 	
+	void *data= LevelPrefetcher::instance()->TakeMap(MapFileSpec, entry->level_number);
+	if (data) return data;
+
+	/* Straight out of the mapped file, when that works */
+	std::shared_ptr<WadFileView> view= WadFileView::Get(MapFileSpec, false);
+	if (view)
+	{
+		data= view->GetFlatData(entry->level_number);
+		if (data) return data;
+	}
+
 	/* false means don't use union maps.. */
 	return get_flat_data(MapFileSpec, false, entry->level_number);
 }
@@ -283,8 +304,46 @@ bool load_level_from_map(
 		{
 			restoring_game= true;
 			index_to_load= 0; /* Saved games are always index 0 */
+
+			/* Nothing may be left reading while the error state is looked at */
+			LevelPrefetcher::instance()->Wait();
 		} else {
 			index_to_load= level_index;
+
+			/* The level may have been read while the last one was ending */
+			void *data= LevelPrefetcher::instance()->TakeMap(MapFileSpec, index_to_load);
+			if (data)
+			{
+				wad= inflate_flat_data(data, &header);
+				if (wad)
+				{
+					process_map_wad(wad, restoring_game, header.data_version);
+					free_wad(wad); /* Note that the flat data points into the wad. */
+				}
+
+				/* The rest of the prefetch ran alongside; it is for this level,
+					so let it finish before the error state is looked at */
+				LevelPrefetcher::instance()->Drain();
+				return (!error_pending());
+			}
+
+			LevelPrefetcher::instance()->Wait();
+
+			/* Levels are read in place from the mapped map file; saved games are left
+				unmapped, since they get written over; anything odd falls through to the
+				usual reading code, which reports it */
+			std::shared_ptr<WadFileView> view= WadFileView::Get(MapFileSpec, false);
+			if (view && index_to_load>=0 && index_to_load<view->Header().wad_count)
+			{
+				wad= view->GetReadOnlyWad(index_to_load);
+				if (wad)
+				{
+					process_map_wad(wad, restoring_game, view->Header().data_version);
+					free_wad(wad);
+					
+					return (!error_pending());
+				}
+			}
 		}
 		
 		OpenedFile MapFile;
@@ -346,6 +405,7 @@ void complete_loading_level(
 	/* Scan, add the doors, recalculate, and generally tie up all loose ends */
 	/* Recalculate the redundant data.. */
 	load_redundant_map_data(_map_indexes, map_index_count);
+	build_polygon_lookup_grid();
 
 	static_platforms.clear();
 
@@ -534,6 +594,58 @@ bool new_game(
 	return success;
 }
 
+/* The entry point flags and name of the level in the given directory position: from the
+	directory, if the map file has one, or else from the level's map info */
+static bool get_level_entry_point_info(
+	WadFileView& view,
+	short index,
+	int32 *entry_point_flags,
+	char *level_name)
+{
+	const wad_header& header= view.Header();
+
+	if (header.application_specific_directory_data_size == SIZEOF_directory_data)
+	{
+		// New style wad
+		uint8 *p = view.GetDirectoryData(index);
+		directory_data directory;
+		unpack_directory_data(p, &directory, 1);
+
+		*entry_point_flags= directory.entry_point_flags;
+		strncpy(level_name, directory.level_name, 66);
+		return true;
+	}
+
+	// Old style wad; the map info is read straight out of the file
+	size_t length;
+	uint8 *p = view.GetTag(index, MAP_INFO_TAG, &length);
+	if (!p)
+		return false;
+
+	assert(length == SIZEOF_static_data);
+	static_data map_info;
+	unpack_static_data(p, &map_info, 1);
+
+	// single-player Marathon 1 levels aren't always marked
+	if (header.data_version == MARATHON_ONE_DATA_VERSION &&
+	    map_info.entry_point_flags == 0)
+		map_info.entry_point_flags = _single_player_entry_point;
+
+	// Marathon 1 handled (then-unused) coop flag differently
+	if (header.data_version == MARATHON_ONE_DATA_VERSION)
+	{
+		if (map_info.entry_point_flags & _single_player_entry_point)
+			map_info.entry_point_flags |= _multiplayer_cooperative_entry_point;
+		if (map_info.entry_point_flags & _multiplayer_carnage_entry_point)
+			map_info.entry_point_flags &= ~_multiplayer_cooperative_entry_point;
+	}
+
+	*entry_point_flags= map_info.entry_point_flags;
+	assert(strlen(map_info.level_name)<LEVEL_NAME_LENGTH);
+	strncpy(level_name, map_info.level_name, 66);
+	return true;
+}
+
 bool get_indexed_entry_point(
 	struct entry_point *entry_point, 
 	short *index, 
@@ -541,96 +653,31 @@ bool get_indexed_entry_point(
 {
 	short actual_index;
 	
-	// Open map file
+	// Map file's directory (parsed once per file)
 	assert(file_is_set);
-	OpenedFile MapFile;
-	if (!open_wad_file_for_reading(MapFileSpec,MapFile))
+	std::shared_ptr<WadFileView> view= WadFileView::Get(MapFileSpec);
+	if (!view)
 		return false;
 
-	// Read header
-	wad_header header;
-	if (!read_wad_header(MapFile, &header)) {
-		close_wad_file(MapFile);
-		return false;
-	}
-    
-	bool success = false;
-	if (header.application_specific_directory_data_size == SIZEOF_directory_data)
+	for(actual_index= *index; actual_index<view->Header().wad_count; ++actual_index)
 	{
-
-		// New style wad
-		void *total_directory_data= read_directory_data(MapFile, &header);
-
-		assert(total_directory_data);
-		for(actual_index= *index; actual_index<header.wad_count; ++actual_index)
-		{
-			uint8 *p = (uint8 *)get_indexed_directory_data(&header, actual_index, total_directory_data);
-			directory_data directory;
-			unpack_directory_data(p, &directory, 1);
-
-			/* Find the flags that match.. */
-			if(directory.entry_point_flags & type)
-			{
-				/* This one is valid! */
-				entry_point->level_number= actual_index;
-				strncpy(entry_point->level_name, directory.level_name, 66);
-			
-				*index= actual_index+1;
-				success= true;
-				break; /* Out of the for loop */
-			}
-		}
-		free(total_directory_data);
-
-	} else {
-
-		// Old style wad, find the index
-		for(actual_index= *index; !success && actual_index<header.wad_count; ++actual_index)
+		int32 entry_point_flags;
+		char level_name[66];
+		
+		/* Find the flags that match.. */
+		if(get_level_entry_point_info(*view, actual_index, &entry_point_flags, level_name) &&
+			(entry_point_flags & type))
 		{
-			struct wad_data *wad;
-
-			/* Read the file */
-			wad= read_indexed_wad_from_file(MapFile, &header, actual_index, true);
-			if (wad)
-			{
-				/* IF this has the proper type.. */
-				size_t length;
-				uint8 *p = (uint8 *)extract_type_from_wad(wad, MAP_INFO_TAG, &length);
-				assert(length == SIZEOF_static_data);
-				static_data map_info;
-				unpack_static_data(p, &map_info, 1);
-
-				// single-player Marathon 1 levels aren't always marked
-				if (header.data_version == MARATHON_ONE_DATA_VERSION &&
-				    map_info.entry_point_flags == 0)
-					map_info.entry_point_flags = _single_player_entry_point;
-
-				// Marathon 1 handled (then-unused) coop flag differently
-				if (header.data_version == MARATHON_ONE_DATA_VERSION)
-				{
-					if (map_info.entry_point_flags & _single_player_entry_point)
-						map_info.entry_point_flags |= _multiplayer_cooperative_entry_point;
-					if (map_info.entry_point_flags & _multiplayer_carnage_entry_point)
-						map_info.entry_point_flags &= ~_multiplayer_cooperative_entry_point;
-				}
-
-				if(map_info.entry_point_flags & type)
-				{
-					/* This one is valid! */
-					entry_point->level_number= actual_index;
-					assert(strlen(map_info.level_name)<LEVEL_NAME_LENGTH);
-					strncpy(entry_point->level_name, map_info.level_name, 66);
+			/* This one is valid! */
+			entry_point->level_number= actual_index;
+			strncpy(entry_point->level_name, level_name, 66);
 		
-					*index= actual_index+1;
-					success= true;
-				}
-				
-				free_wad(wad);
-			}
+			*index= actual_index+1;
+			return true;
 		}
 	}
 
-	return success;
+	return false;
 }
 
 // Get vector of map entry points matching given type
@@ -638,86 +685,23 @@ bool get_entry_points(vector<entry_point> &vec, int32 type)
 {
 	vec.clear();
 
-	// Open map file
+	// Map file's directory (parsed once per file)
 	assert(file_is_set);
-	OpenedFile MapFile;
-	if (!open_wad_file_for_reading(MapFileSpec,MapFile))
+	std::shared_ptr<WadFileView> view= WadFileView::Get(MapFileSpec);
+	if (!view)
 		return false;
 
-	// Read header
-	wad_header header;
-	if (!read_wad_header(MapFile, &header)) {
-		close_wad_file(MapFile);
-		return false;
-	}
-
 	bool success = false;
-	if (header.application_specific_directory_data_size == SIZEOF_directory_data) {
-
-		// New style wad, read directory data
-		void *total_directory_data = read_directory_data(MapFile, &header);
-		assert(total_directory_data);
-
-		// Push matching directory entries into vector
-		for (int i=0; i<header.wad_count; i++) {
-			uint8 *p = (uint8 *)get_indexed_directory_data(&header, i, total_directory_data);
-			directory_data directory;
-			unpack_directory_data(p, &directory, 1);
-
-			if (directory.entry_point_flags & type) {
-
-				// This one is valid
-				entry_point point;
-				point.level_number = i;
-				strncpy(point.level_name, directory.level_name, 66);
-				vec.push_back(point);
-				success = true;
-			}
-		}
-		free(total_directory_data);
-
-	} else {
-
-		// Old style wad
-		for (int i=0; i<header.wad_count; i++) {
-
-			wad_data *wad = read_indexed_wad_from_file(MapFile, &header, i, true);
-			if (!wad)
-				continue;
-
-			// Read map_info data
-			size_t length;
-			uint8 *p = (uint8 *)extract_type_from_wad(wad, MAP_INFO_TAG, &length);
-			assert(length == SIZEOF_static_data);
-			static_data map_info;
-			unpack_static_data(p, &map_info, 1);
-
-			// single-player Marathon 1 levels aren't always marked
-			if (header.data_version == MARATHON_ONE_DATA_VERSION &&
-			    map_info.entry_point_flags == 0)
-				map_info.entry_point_flags = _single_player_entry_point;
-
-			// Marathon 1 handled (then-unused) coop flag differently
-			if (header.data_version == MARATHON_ONE_DATA_VERSION)
-			{
-				if (map_info.entry_point_flags & _single_player_entry_point)
-					map_info.entry_point_flags |= _multiplayer_cooperative_entry_point;
-				if (map_info.entry_point_flags & _multiplayer_carnage_entry_point)
-					map_info.entry_point_flags &= ~_multiplayer_cooperative_entry_point;
-			}
-
-			if (map_info.entry_point_flags & type) {
-
-				// This one is valid
-				entry_point point;
-				point.level_number = i;
-				assert(strlen(map_info.level_name) < LEVEL_NAME_LENGTH);
-				strncpy(point.level_name, map_info.level_name, 66);
-				vec.push_back(point);
-				success = true;
-			}
-				
-			free_wad(wad);
+	for (int i=0; i<view->Header().wad_count; i++) {
+		entry_point point;
+		int32 entry_point_flags;
+		if (get_level_entry_point_info(*view, i, &entry_point_flags, point.level_name) &&
+			(entry_point_flags & type)) {
+
+			// This one is valid
+			point.level_number = i;
+			vec.push_back(point);
+			success = true;
 		}
 	}
 
@@ -1162,6 +1146,9 @@ bool load_game_from_file(FileSpecifier& File, bool run_scripts, bool *was_map_fo
 {
 	bool success= false;
 
+	// it may still be being written
+	SaveGameWriter::instance()->Finish();
+
 	ResetPassedLua();
 	
 	/* Setup for a revert.. */
@@ -1283,6 +1270,72 @@ bool revert_game(
 	return successful;
 }
 
+/* Film keyframes: the same wad build_save_game_snapshot() makes, but with no metadata,
+	preview image or revert info; the caller owns (and must free_wad()) the result */
+struct wad_data *build_game_snapshot(
+	void)
+{
+	struct wad_header header;
+	int32 wad_length;
+
+	/* Save off the random seed. */
+	dynamic_world->random_seed= get_random_seed();
+
+	fill_default_wad_header(MapFileSpec, CURRENT_WADFILE_VERSION, EDITOR_MAP_VERSION, 1, 0, &header);
+	return build_save_game_wad(&header, &wad_length);
+}
+
+/* Replace the running level with a snapshot; this is revert_game() for a wad that's already
+	in memory.  The snapshot is left intact, so it can be restored again later. */
+bool restore_game_snapshot(
+	struct wad_data *wad)
+{
+	short old_level_number= dynamic_world->current_level_number;
+	bool successful;
+
+	leaving_map();
+	ResetPassedLua();
+
+	successful= process_map_wad(wad, true, EDITOR_MAP_VERSION);
+	if (successful)
+	{
+		set_random_seed(dynamic_world->random_seed);
+
+		// Being careful to carry over errors so that Pfhortran errors can be ignored
+		short SavedType, SavedError = get_game_error(&SavedType);
+		RunLevelScript(dynamic_world->current_level_number);
+		RunScriptChunks();
+		if (dynamic_world->player_count == 1)
+		{
+			LoadSoloLua();
+		}
+		else
+		{
+			LoadReplayNetLua();
+		}
+		LoadStatsLua();
+		set_game_error(SavedType,SavedError);
+
+		Music::instance()->PreloadLevelMusic();
+		RunLuaScript();
+		successful= entering_map(true /*restoring game*/);
+	}
+
+	if (successful)
+	{
+		update_interface(NONE);
+		ChaseCam_Reset();
+		ResetFieldOfView();
+		reset_messages();
+		if (dynamic_world->current_level_number != old_level_number)
+		{
+			ReloadViewContext();
+		}
+	}
+
+	return successful;
+}
+
 bool export_level(FileSpecifier& File)
 {
 	struct wad_header header;
@@ -1366,21 +1419,162 @@ bool export_level(FileSpecifier& File)
 	
 }
 
-void get_current_saved_game_name(FileSpecifier& File)
+/* Writes level_count levels, cycled from the current map file, to a scratch map file with
+	no directory data (so the entry points come out of every level's map info) */
+static bool write_benchmark_map_file(FileSpecifier& File, short level_count)
 {
-	File = revert_game_data.SavedGame;
+	OpenedFile MapFile;
+	if (!open_wad_file_for_reading(MapFileSpec, MapFile))
+		return false;
+
+	struct wad_header source_header, header;
+	bool success= false;
+	if (read_wad_header(MapFile, &source_header) && source_header.wad_count > 0)
+	{
+		fill_default_wad_header(File, CURRENT_WADFILE_VERSION, source_header.data_version, level_count, 0, &header);
+
+		OpenedFile OFile;
+		if (create_wadfile(File, _typecode_scenario) && open_wad_file_for_writing(File, OFile))
+		{
+			std::vector<uint8> entries(get_size_of_directory_data(&header));
+			int32 offset= SIZEOF_wad_header;
+
+			success= write_wad_header(OFile, &header);
+			for (short index= 0; success && index<level_count; ++index)
+			{
+				// write_wad() wants a wad of its own, not one pointing into a file
+				struct wad_data *wad= read_indexed_wad_from_file(MapFile, &source_header, index % source_header.wad_count, false);
+				if (!wad)
+				{
+					success= false;
+					break;
+				}
+
+				int32 wad_length= calculate_wad_length(&header, wad);
+				set_indexed_directory_offset_and_length(&header, &entries[0], index, offset, wad_length, index);
+				success= write_wad(OFile, &header, wad, offset);
+				offset+= wad_length;
+				free_wad(wad);
+			}
+
+			if (success)
+			{
+				header.directory_offset= offset;
+				success= write_wad_header(OFile, &header) && write_directorys(OFile, &header, &entries[0]);
+			}
+			close_wad_file(OFile);
+		}
+	}
+	close_wad_file(MapFile);
+
+	return success && !error_pending();
 }
 
-/* The current mapfile should be set to the save game file... */
-bool save_game_file(FileSpecifier& File, const std::string& metadata, const std::string& imagedata)
+/* Reads every level of a scratch map file of level_count levels, and the map info the
+	entry points come from, first the way the levels used to be read (a file read per
+	wad) and then through a WadFileView; true if both found the same bytes */
+bool benchmark_map_reading(short level_count, uint32 *file_ticks, uint32 *view_ticks)
 {
+	*file_ticks= *view_ticks= 0;
+	if (!file_is_set)
+		return false;
+
+	FileSpecifier BenchmarkFile;
+	BenchmarkFile.SetToLocalDataDir();
+	BenchmarkFile += "Map Reading Benchmark.sceA";
+	if (!write_benchmark_map_file(BenchmarkFile, level_count))
+	{
+		clear_game_error();
+		BenchmarkFile.Delete();
+		return false;
+	}
+
+	std::vector<std::vector<uint8> > file_levels(level_count), view_levels(level_count);
+	std::vector<std::vector<uint8> > file_infos(level_count), view_infos(level_count);
+
+	// the old way: the header, then a read of each wad, for the entry points and again
+	// for the level itself
+	uint32 start_ticks= machine_tick_count();
+	OpenedFile OFile;
 	struct wad_header header;
-	short err = 0;
-	bool success= false;
-	int32 offset, wad_length;
-	struct directory_entry entries[2];
-	struct wad_data *wad, *meta_wad;
+	if (open_wad_file_for_reading(BenchmarkFile, OFile))
+	{
+		if (read_wad_header(OFile, &header))
+		{
+			for (short index= 0; index<level_count; ++index)
+			{
+				struct wad_data *wad= read_indexed_wad_from_file(OFile, &header, index, true);
+				if (!wad) continue;
+
+				size_t length;
+				uint8 *p= (uint8 *)extract_type_from_wad(wad, MAP_INFO_TAG, &length);
+				if (p) file_infos[index].assign(p, p + length);
+				free_wad(wad);
+			}
+
+			for (short index= 0; index<level_count; ++index)
+			{
+				void *data= get_flat_data(BenchmarkFile, false, index);
+				if (!data) continue;
+
+				uint8 *p= (uint8 *)data;
+				file_levels[index].assign(p, p + get_flat_data_length(data));
+				free(data);
+			}
+		}
+		close_wad_file(OFile);
+	}
+	*file_ticks= machine_tick_count() - start_ticks;
+
+	// mapped, with the directory parsed once
+	WadFileView::ReleaseAll();
+	start_ticks= machine_tick_count();
+	std::shared_ptr<WadFileView> view= WadFileView::Get(BenchmarkFile, false);
+	if (view)
+	{
+		for (short index= 0; index<level_count; ++index)
+		{
+			size_t length;
+			uint8 *p= view->GetTag(index, MAP_INFO_TAG, &length);
+			if (p) view_infos[index].assign(p, p + length);
+		}
+
+		for (short index= 0; index<level_count; ++index)
+		{
+			void *data= view->GetFlatData(index);
+			if (!data) continue;
 
+			uint8 *p= (uint8 *)data;
+			view_levels[index].assign(p, p + get_flat_data_length(data));
+			free(data);
+		}
+	}
+	*view_ticks= machine_tick_count() - start_ticks;
+
+	bool identical= view && file_levels == view_levels && file_infos == view_infos;
+
+	// no deleting a mapped file on Windows
+	view.reset();
+	WadFileView::ReleaseAll();
+	BenchmarkFile.Delete();
+	clear_game_error();
+
+	return identical;
+}
+
+void get_current_saved_game_name(FileSpecifier& File)
+{
+	File = revert_game_data.SavedGame;
+}
+
+/* The current mapfile should be set to the save game file...
+	Everything a saved game needs from the running game, taken up front so the file can be
+	written later by write_save_game_file(); the caller owns (and must free_wad()) the result */
+struct wad_data *build_save_game_snapshot(
+	FileSpecifier& File,
+	struct wad_header *header,
+	int32 *length)
+{
 	/* Save off the random seed. */
 	dynamic_world->random_seed= get_random_seed();
 
@@ -1388,88 +1582,68 @@ bool save_game_file(FileSpecifier& File, const std::string& metadata, const std:
 	revert_game_data.game_is_from_disk= true;
 	revert_game_data.SavedGame = File;
 
-	// LP: add a file here; use temporary file for a safe save.
-	// Write into the temporary file first
-	FileSpecifier TempFile;
-	TempFile.SetTempName(File);
-	
-	/* Fill in the default wad header (we are using File instead of TempFile to get the name right in the header) */
-	fill_default_wad_header(File, CURRENT_WADFILE_VERSION, EDITOR_MAP_VERSION, 2, 0, &header);
-		
-	/* Assume that we confirmed on save as... */
-	if (create_wadfile(TempFile,_typecode_savegame))
+	/* Fill in the default wad header (we are using File instead of the temporary file to get the name right in the header) */
+	fill_default_wad_header(File, CURRENT_WADFILE_VERSION, EDITOR_MAP_VERSION, 2, 0, header);
+	header->parent_checksum= read_wad_file_checksum(MapFileSpec);
+
+	return build_save_game_wad(header, length);
+}
+
+/* Write a snapshot and its metadata wad to an open (temporary) file.  This doesn't touch
+	the game or the game error state, so the save writer runs it on its own thread. */
+bool write_save_game_file(
+	OpenedFile& SaveFile,
+	struct wad_header *header,
+	struct wad_data *wad,
+	int32 wad_length,
+	const std::string& metadata,
+	const std::string& imagedata)
+{
+	bool success= false;
+	int32 offset, meta_wad_length;
+	struct directory_entry entries[2];
+	struct wad_data *meta_wad;
+
+	/* Write out the new header */
+	if (write_wad_header(SaveFile, header))
 	{
-		OpenedFile SaveFile;
-		if(open_wad_file_for_writing(TempFile,SaveFile))
+		offset= SIZEOF_wad_header;
+
+		/* Set the entry data.. */
+		set_indexed_directory_offset_and_length(header, 
+			entries, 0, offset, wad_length, 0);
+		
+		/* Save it.. */
+		if (write_wad(SaveFile, header, wad, offset))
 		{
-			/* Write out the new header */
-			if (write_wad_header(SaveFile, &header))
+			/* Update the new header */
+			offset+= wad_length;
+			header->directory_offset= offset;
+			
+			/* Create metadata wad */
+			meta_wad = build_meta_game_wad(metadata, imagedata, header, &meta_wad_length);
+			if (meta_wad)
 			{
-				offset= SIZEOF_wad_header;
-		
-				wad= build_save_game_wad(&header, &wad_length);
-				if (wad)
+				set_indexed_directory_offset_and_length(header,
+					entries, 1, offset, meta_wad_length, SAVE_GAME_METADATA_INDEX);
+				
+				if (write_wad(SaveFile, header, meta_wad, offset))
 				{
-					/* Set the entry data.. */
-					set_indexed_directory_offset_and_length(&header, 
-						entries, 0, offset, wad_length, 0);
-					
-					/* Save it.. */
-					if (write_wad(SaveFile, &header, wad, offset))
+					offset+= meta_wad_length;
+					header->directory_offset= offset;
+			
+					if (write_wad_header(SaveFile, header) && write_directorys(SaveFile, header, entries))
 					{
-						/* Update the new header */
-						offset+= wad_length;
-						header.directory_offset= offset;
-						header.parent_checksum= read_wad_file_checksum(MapFileSpec);
-						
-						/* Create metadata wad */
-						meta_wad = build_meta_game_wad(metadata, imagedata, &header, &wad_length);
-						if (meta_wad)
-						{
-							set_indexed_directory_offset_and_length(&header,
-								entries, 1, offset, wad_length, SAVE_GAME_METADATA_INDEX);
-							
-							if (write_wad(SaveFile, &header, meta_wad, offset))
-							{
-								offset+= wad_length;
-								header.directory_offset= offset;
-						
-								if (write_wad_header(SaveFile, &header) && write_directorys(SaveFile, &header, entries))
-								{
-									/* We win. */
-									success= true;
-								}
-							}
-							
-							free_wad(meta_wad);
-						}
+						/* We win. */
+						success= true;
 					}
-
-					free_wad(wad);
 				}
-			}
-
-			err = SaveFile.GetError();
-			close_wad_file(SaveFile);
-		}
-		
-		if (!err)
-		{
-			if (!TempFile.Rename(File))
-			{
-				err = 1;
+				
+				free_wad(meta_wad);
 			}
 		}
 	}
-	
-	if(err || error_pending())
-	{
-		if(!err) err= get_game_error(NULL);
-		alert_user(infoError, strERRORS, fileError, err);
-		clear_game_error();
-		success= false;
-	}
-	
+
 	return success;
 }
 
@@ -1953,6 +2127,7 @@ static void load_redundant_map_data(
 		assert(count == static_cast<size_t>(static_cast<int16>(count)));
 		assert(0 <= static_cast<int16>(count));
 		dynamic_world->map_index_count= static_cast<int16>(count);
+		precalculate_polygon_visibility();
 	}
 	else
 	{
@@ -2604,6 +2779,11 @@ static void complete_restoring_level(
 	ok_to_reset_scenery_solidity = false;
 	/* Loading games needs this done. */
 	reset_action_queues();
+	rebuild_active_slot_lists();
+	build_polygon_lookup_grid();
+	/* the last level's set would otherwise answer line-of-sight checks; this is quick when
+		it's the same level again (reverting, or a film keyframe) */
+	precalculate_polygon_visibility();
 }
 
 
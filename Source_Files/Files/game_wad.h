@@ -37,8 +37,11 @@ Aug 12, 2000 (Loren Petrich):
 #include <string>
 
 class FileSpecifier;
+class OpenedFile;
 
-bool save_game_file(FileSpecifier& File, const std::string& metadata, const std::string& imagedata);
+// saved games are built in two steps so the second can go to SaveGameWriter's thread
+struct wad_data *build_save_game_snapshot(FileSpecifier& File, struct wad_header *header, int32 *length);
+bool write_save_game_file(OpenedFile& SaveFile, struct wad_header *header, struct wad_data *wad, int32 wad_length, const std::string& metadata, const std::string& imagedata);
 struct wad_data *build_meta_game_wad(const std::string& metadata, const std::string& imagedata, struct wad_header *header, int32 *length);
 
 bool export_level(FileSpecifier& File);
@@ -53,6 +56,10 @@ void set_saved_game_name_to_default();
 // ZZZ: exposed this for netgame-resuming code
 bool process_map_wad(struct wad_data *wad, bool restoring_game, short version);
 
+// in-memory saved games, for film keyframes
+struct wad_data *build_game_snapshot(void);
+bool restore_game_snapshot(struct wad_data *wad);
+
 bool match_checksum_with_map(short vRefNum, long dirID, uint32 checksum, 
 	FileSpecifier& File);
 void set_map_file(FileSpecifier& File);
@@ -62,6 +69,9 @@ FileSpecifier& get_map_file(void);
 
 void level_has_embedded_physics_lua(int Level, bool& HasPhysics, bool& HasLua);
 
+// times reading level_count levels with and without a WadFileView; true if they agree
+bool benchmark_map_reading(short level_count, uint32 *file_ticks, uint32 *view_ticks);
+
 /* --------- from PREPROCESS_MAP_MAC.C */
 // Most of the get_default_filespecs moved to interface.h
 void get_savegame_filedesc(FileSpecifier& File);
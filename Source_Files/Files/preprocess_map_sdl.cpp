@@ -131,11 +131,9 @@ bool choose_saved_game_to_load(FileSpecifier &saved_game)
 bool save_game(void)
 {
 	pause_game();
+    // false if the save couldn't be started; "Game saved" or "Save failed" is printed
+    // once the file has been written
     bool success = create_quick_save();
-    if (success)
-        screen_printf("Game saved");
-    else
-        screen_printf("Save failed");
 	resume_game();
 
 	return success;
@@ -72,6 +72,12 @@ Sep 30, 2001 (Loren Petrich):
 
 Jan 25, 2002 (Br'fin (Jeremy Parsons)):
 	Adjusted Carbon flow to avoid a p2cstr
+
+Oct 17, 2026:
+	Added read_flat_data(), which leaves the game error alone so the level prefetcher
+	can call it from its own thread
+	Added WadFileView, which maps a wad file and parses its directory once; free_wad()
+	leaves the data of wads borrowed from one alone
 */
 
 // Note that level_transition_malloc is specific to marathon...
@@ -90,6 +96,20 @@ Jan 25, 2002 (Br'fin (Jeremy Parsons)):
 #include "FileHandler.h"
 #include "Packing.h"
 
+#include <map>
+#include <string>
+
+#include <sys/stat.h>
+#include <SDL_mutex.h>
+
+#if defined(__WIN32__)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 // Formerly in portable_files.h
 inline short memory_error() {return 0;}
 
@@ -751,7 +771,7 @@ void free_wad(
 	if(wad->read_only_data)
 	{
 		/* Read only wad.. */
-		free(wad->read_only_data);
+		if(!wad->borrowed) free(wad->read_only_data);
 		free(wad->tag_data);
 	} else {
 		/* Modifiable */
@@ -796,13 +816,56 @@ int32 calculate_wad_length(
 const int SIZEOF_encapsulated_wad_data = 2*4 + SIZEOF_wad_header;
 	
 
+/* Reads the header and wad into one block, as get_flat_data() returns them */
+static uint8 *read_flat_data_from_file(
+	OpenedFile& OFile,
+	struct wad_header *header,
+	short wad_index,
+	int *error)
+{
+	uint8 *data= NULL;
+	int32 length;
+
+	/* Allocate the conglomerate data.. */
+	if (size_of_indexed_wad(OFile, header, wad_index, &length))
+	{
+		data= (uint8 *)malloc(length+SIZEOF_encapsulated_wad_data);
+		if(data)
+		{
+			uint8 *buffer= data + SIZEOF_encapsulated_wad_data;
+			
+			// Pack the encapsulated header
+			uint8 *S = data;
+			ValueToStream(S,uint32(CURRENT_FLAT_MAGIC_COOKIE));
+			ValueToStream(S,int32(length + SIZEOF_encapsulated_wad_data));
+			S = pack_wad_header(S,header,1);
+			assert((S - data) == SIZEOF_encapsulated_wad_data);
+			
+			/* Read into our buffer... */
+			if (!read_indexed_wad_from_file_into_buffer(OFile, header, wad_index, 
+				buffer, &length))
+			{
+				/* Error-> didn't get it.. */
+				free(data);
+				data= NULL;
+				*error = OFile.GetError();
+			}
+		} 
+		else 
+		{
+			*error= memory_error();
+		}
+	}
+
+	return data;
+}
+
 void *get_flat_data(
 	FileSpecifier& File, 
 	bool use_union, 
 	short wad_index)
 {
 	struct wad_header header;
-	bool success= false;
 	uint8 *data= NULL;
 	
 	assert(!use_union);
@@ -811,46 +874,10 @@ void *get_flat_data(
 	if (open_wad_file_for_reading(File,OFile))
 	{
 		/* Read the file */
-		success= read_wad_header(OFile, &header);
-
-		if (success)
+		if (read_wad_header(OFile, &header))
 		{
-			int32 length;
 			int error = 0;
-		
-			/* Allocate the conglomerate data.. */
-			if (size_of_indexed_wad(OFile, &header, wad_index, &length))
-			{
-				data= (uint8 *)malloc(length+SIZEOF_encapsulated_wad_data);
-				if(data)
-				{
-					uint8 *buffer= data + SIZEOF_encapsulated_wad_data;
-					
-					// Pack the encapsulated header
-					uint8 *S = data;
-					ValueToStream(S,uint32(CURRENT_FLAT_MAGIC_COOKIE));
-					ValueToStream(S,int32(length + SIZEOF_encapsulated_wad_data));
-					S = pack_wad_header(S,&header,1);
-					assert((S - data) == SIZEOF_encapsulated_wad_data);
-					
-					/* Read into our buffer... */
-					success = read_indexed_wad_from_file_into_buffer(OFile, &header, wad_index, 
-						buffer, &length);
-					
-					if (!success)
-					{
-						/* Error-> didn't get it.. */
-						free(data);
-						data= NULL;
-						error = OFile.GetError();
-					}
-				} 
-				else 
-				{
-					error= memory_error();
-				}
-			}
-
+			data= read_flat_data_from_file(OFile, &header, wad_index, &error);
 			set_game_error(systemError, error);
 		}
 		
@@ -861,6 +888,14 @@ void *get_flat_data(
 	return data;
 }
 
+void *read_flat_data(
+	FileSpecifier& File,
+	short wad_index)
+{
+	std::shared_ptr<WadFileView> view= WadFileView::Get(File, false);
+	return view ? view->GetFlatData(wad_index) : NULL;
+}
+
 int32 get_flat_data_length(
 	void *data)
 {
@@ -904,6 +939,412 @@ struct wad_data *inflate_flat_data(
 	return wad;
 }
 
+/* ---------- mapped wad files */
+
+// views Get() has handed out, by path
+static std::map<std::string, std::shared_ptr<WadFileView> > wad_file_views;
+
+static SDL_mutex *wad_file_views_mutex()
+{
+	static SDL_mutex *mutex= SDL_CreateMutex();
+	return mutex;
+}
+
+// the date and size of a file, or zeros if it isn't a plain file (it may be in an archive)
+static void get_file_date_and_size(
+	FileSpecifier& File,
+	TimeType *date,
+	int32 *size)
+{
+	struct stat st;
+	if (stat(File.GetPath(), &st) == 0)
+	{
+		*date= st.st_mtime;
+		*size= static_cast<int32>(st.st_size);
+	}
+	else
+	{
+		*date= 0;
+		*size= 0;
+	}
+}
+
+WadFileView::WadFileView() :
+	base(NULL),
+	size(0),
+	mapped(false),
+#if defined(__WIN32__)
+	mapping(NULL),
+#endif
+	date(0),
+	file_size(0)
+{
+	obj_clear(header);
+}
+
+WadFileView::~WadFileView()
+{
+	if (!base) return;
+
+	if (mapped)
+	{
+#if defined(__WIN32__)
+		UnmapViewOfFile(base);
+		CloseHandle(mapping);
+#else
+		munmap(base, size);
+#endif
+	}
+	else
+	{
+		free(base);
+	}
+}
+
+std::shared_ptr<WadFileView> WadFileView::Get(
+	FileSpecifier& File,
+	bool report_errors)
+{
+	std::string path= File.GetPath();
+	TimeType date;
+	int32 file_size;
+	get_file_date_and_size(File, &date, &file_size);
+
+	std::shared_ptr<WadFileView> view;
+	SDL_LockMutex(wad_file_views_mutex());
+	std::map<std::string, std::shared_ptr<WadFileView> >::iterator it= wad_file_views.find(path);
+	if (it != wad_file_views.end() && it->second->date == date && it->second->file_size == file_size)
+	{
+		view= it->second;
+	}
+	SDL_UnlockMutex(wad_file_views_mutex());
+	if (view) return view;
+
+	view.reset(new WadFileView);
+	view->date= date;
+	view->file_size= file_size;
+	if (view->Load(File) && view->Parse())
+	{
+		SDL_LockMutex(wad_file_views_mutex());
+		wad_file_views[path]= view;
+		SDL_UnlockMutex(wad_file_views_mutex());
+	}
+	else
+	{
+		view.reset();
+
+		/* Let the usual routines work out what went wrong */
+		if (report_errors)
+		{
+			OpenedFile OFile;
+			if (open_wad_file_for_reading(File, OFile))
+			{
+				struct wad_header header;
+				if (read_wad_header(OFile, &header))
+				{
+					set_game_error(gameError, errUnknownWadVersion);
+				}
+				close_wad_file(OFile);
+			}
+		}
+	}
+
+	return view;
+}
+
+void WadFileView::ReleaseAll()
+{
+	std::map<std::string, std::shared_ptr<WadFileView> > views;
+	SDL_LockMutex(wad_file_views_mutex());
+	views.swap(wad_file_views);
+	SDL_UnlockMutex(wad_file_views_mutex());
+}
+
+bool WadFileView::Load(
+	FileSpecifier& File)
+{
+#if defined(__WIN32__)
+	HANDLE file= CreateFileA(File.GetPath(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER length;
+		if (GetFileSizeEx(file, &length) && length.QuadPart > 0 && length.QuadPart <= INT32_MAX)
+		{
+			/* Copy on write, so nobody can change the file through us */
+			mapping= CreateFileMapping(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+			if (mapping)
+			{
+				base= (uint8 *) MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+				if (base)
+				{
+					size= static_cast<int32>(length.QuadPart);
+				}
+				else
+				{
+					CloseHandle(mapping);
+					mapping= NULL;
+				}
+			}
+		}
+		CloseHandle(file);
+	}
+#else
+	int fd= open(File.GetPath(), O_RDONLY);
+	if (fd >= 0)
+	{
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size > 0 && st.st_size <= INT32_MAX)
+		{
+			/* Private and writable: nobody can change the file through us */
+			void *p= mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED)
+			{
+				base= (uint8 *) p;
+				size= static_cast<int32>(st.st_size);
+			}
+		}
+		close(fd);
+	}
+#endif
+
+	if (base)
+	{
+		mapped= true;
+		return true;
+	}
+
+	/* Not a plain file; read all of it at once instead (quietly, since
+		the prefetcher calls this off the main thread; Get() reports) */
+	OpenedFile OFile;
+	int32 length;
+	if (File.Open(OFile, false, false) && OFile.GetLength(length) && length > 0)
+	{
+		base= (uint8 *) malloc(length);
+		if (base && OFile.Read(length, base))
+		{
+			size= length;
+		}
+		else
+		{
+			free(base);
+			base= NULL;
+		}
+	}
+
+	return base != NULL;
+}
+
+bool WadFileView::Parse()
+{
+	if (size < SIZEOF_wad_header) return false;
+
+	/* Same checks as read_wad_header() */
+	unpack_wad_header(base, &header, 1);
+	if (header.version>CURRENT_WADFILE_VERSION || header.data_version>2 || header.wad_count<1)
+	{
+		return false;
+	}
+
+	short base_entry_size= get_directory_base_length(&header);
+	int32 unit_size= header.application_specific_directory_data_size + base_entry_size;
+	if (header.application_specific_directory_data_size < 0 || header.directory_offset < SIZEOF_wad_header ||
+		header.directory_offset + header.wad_count * unit_size > size)
+	{
+		return false;
+	}
+
+	slots.resize(header.wad_count);
+	wads.assign(header.wad_count, NONE);
+	for (short position= 0; position<header.wad_count; ++position)
+	{
+		uint8 *p= base + calculate_directory_offset(&header, position);
+		slot& entry_slot= slots[position];
+
+		directory_entry entry;
+		short index= position;
+		if (base_entry_size >= SIZEOF_directory_entry)
+		{
+			unpack_directory_entry(p, &entry, 1);
+			/* For old files, the index is the position */
+			if (header.version > WADFILE_HAS_DIRECTORY_ENTRY) index= entry.index;
+		}
+		else
+		{
+			unpack_old_directory_entry(p, (old_directory_entry *) &entry, 1);
+		}
+
+		entry_slot.offset= entry.offset_to_start;
+		entry_slot.length= entry.length;
+		if (entry.offset_to_start < 0 || entry.length < 0 || entry.offset_to_start > size - entry.length)
+		{
+			entry_slot.length= NONE;
+		}
+		entry_slot.directory_data= header.application_specific_directory_data_size ? p + base_entry_size : NULL;
+
+		/* read_indexed_directory_data() looks from the index's own position onwards, and
+			takes the first match; do the same if there are duplicates */
+		if (index >= 0 && index < header.wad_count)
+		{
+			short other= wads[index];
+			if (other == NONE ||
+				(position - index + header.wad_count) % header.wad_count < (other - index + header.wad_count) % header.wad_count)
+			{
+				wads[index]= position;
+			}
+		}
+	}
+
+	return true;
+}
+
+uint8 *WadFileView::GetWad(
+	short index,
+	int32 *length) const
+{
+	*length= 0;
+	if (index < 0 || index >= static_cast<short>(wads.size()) || wads[index] == NONE)
+	{
+		return NULL;
+	}
+
+	/* An empty wad is still there, as read_indexed_wad_from_file() has it; there is
+		just nothing to read */
+	const slot& entry_slot= slots[wads[index]];
+	if (entry_slot.length == NONE)
+	{
+		return NULL;
+	}
+
+	*length= entry_slot.length;
+	return entry_slot.length ? base + entry_slot.offset : base;
+}
+
+// walks the entry headers the way convert_wad_from_raw() does, but never past the end
+bool WadFileView::GetTags(
+	short index,
+	std::vector<struct tag_data>& tags) const
+{
+	int32 length;
+	uint8 *raw_wad= GetWad(index, &length);
+	if (!raw_wad) return false;
+
+	struct wad_header file_header= header;
+	int32 entry_header_size= get_entry_header_length(&file_header);
+
+	tags.clear();
+	int32 offset= 0;
+	while (offset >= 0 && offset <= length - entry_header_size)
+	{
+		/* The tag, next offset and length come first in both kinds of entry header */
+		uint8 *S= raw_wad + offset;
+		struct tag_data tag;
+		int32 next_offset;
+		StreamToValue(S, tag.tag);
+		StreamToValue(S, next_offset);
+		StreamToValue(S, tag.length);
+		if (tag.length < 0 || tag.length > length - offset - entry_header_size)
+		{
+			return false;
+		}
+
+		tag.data= raw_wad + offset + entry_header_size;
+		tag.offset= 0;
+		tags.push_back(tag);
+
+		if (next_offset == 0) return true;
+		if (next_offset <= offset) return false;
+		offset= next_offset;
+	}
+
+	return false;
+}
+
+uint8 *WadFileView::GetTag(
+	short index,
+	WadDataType type,
+	size_t *length) const
+{
+	*length= 0;
+
+	std::vector<struct tag_data> tags;
+	if (!GetTags(index, tags)) return NULL;
+
+	for (size_t i= 0; i<tags.size(); ++i)
+	{
+		if (tags[i].tag == type)
+		{
+			*length= tags[i].length;
+			return tags[i].data;
+		}
+	}
+
+	return NULL;
+}
+
+struct wad_data *WadFileView::GetReadOnlyWad(
+	short index) const
+{
+	std::vector<struct tag_data> tags;
+	if (!GetTags(index, tags)) return NULL;
+
+	struct wad_data *wad= create_empty_wad();
+	if (wad && !tags.empty())
+	{
+		wad->tag_data= (struct tag_data *) malloc(tags.size() * sizeof(struct tag_data));
+		if (wad->tag_data)
+		{
+			memcpy(wad->tag_data, &tags[0], tags.size() * sizeof(struct tag_data));
+			wad->tag_count= static_cast<short>(tags.size());
+			wad->read_only_data= base;
+			wad->borrowed= true;
+		}
+		else
+		{
+			free(wad);
+			wad= NULL;
+		}
+	}
+
+	return wad;
+}
+
+void *WadFileView::GetFlatData(
+	short index) const
+{
+	int32 length;
+	uint8 *raw_wad= GetWad(index, &length);
+	if (!raw_wad) return NULL;
+
+	uint8 *data= (uint8 *) malloc(length + SIZEOF_encapsulated_wad_data);
+	if (data)
+	{
+		struct wad_header file_header= header;
+
+		// Pack the encapsulated header
+		uint8 *S= data;
+		ValueToStream(S,uint32(CURRENT_FLAT_MAGIC_COOKIE));
+		ValueToStream(S,int32(length + SIZEOF_encapsulated_wad_data));
+		S= pack_wad_header(S,&file_header,1);
+		assert((S - data) == SIZEOF_encapsulated_wad_data);
+
+		memcpy(S, raw_wad, length);
+	}
+
+	return data;
+}
+
+uint8 *WadFileView::GetDirectoryData(
+	short position) const
+{
+	if (position < 0 || position >= static_cast<short>(slots.size()))
+	{
+		return NULL;
+	}
+
+	return slots[position].directory_data;
+}
+
 /* ---------- debugging routines. */
 void dump_wad(
 	struct wad_data *wad)
@@ -926,6 +1367,8 @@ void dump_wad(
 /* ---------- file management routines */
 bool create_wadfile(FileSpecifier& File, Typecode Type)
 {
+	/* A mapped file can't be replaced on some systems */
+	WadFileView::ReleaseAll();
 	return File.Create(Type);
 }
 
@@ -37,10 +37,16 @@ Feb 3, 2000 (Loren Petrich):
 
 Aug 12, 2000 (Loren Petrich):
 	Using object-oriented file handler
+
+Oct 17, 2026:
+	Added WadFileView, a mapped, read-only view of a whole wad file
 */
 
 #include "tags.h"
 
+#include <memory>
+#include <vector>
+
 #define PRE_ENTRY_POINT_WADFILE_VERSION 0
 #define WADFILE_HAS_DIRECTORY_ENTRY 1
 #define WADFILE_SUPPORTS_OVERLAYS 2
@@ -121,7 +127,7 @@ struct tag_data {
 /* This is what a wad * actually is.. */
 struct wad_data {
 	short tag_count;			/* Tag count */
-	short padding;
+	short borrowed;				/* If non zero, read_only_data belongs to a WadFileView */
 	byte *read_only_data;		/* If this is non NULL, we are read only.... */
 	struct tag_data *tag_data;	/* Tag data array */
 };
@@ -187,11 +193,73 @@ bool find_file_with_modification_date(FileSpecifier& File,
 /* These functions are used for transferring data, and it completely encapsulates */
 /*  a given wad from a given file... */
 void *get_flat_data(FileSpecifier& File, bool use_union, short wad_index);
+/* Same, but never sets the game error, so it is safe from other threads; NULL on failure */
+void *read_flat_data(FileSpecifier& File, short wad_index);
 int32 get_flat_data_length(void *data);
 
 /* This is how you dispose of it-> you inflate it, then use free_wad() */
 struct wad_data *inflate_flat_data(void *data, struct wad_header *header);
 
+/* ------------ Mapped wad files */
+/* A whole wad file mapped into memory (or read in one go, where it can't be), with the
+	header and directory parsed once; wads and tags are pointers into it, not copies.
+	Get() hands out the same view of a file until the file changes, so only use it for
+	files that aren't rewritten in place, like scenarios. Safe to use from any thread */
+class WadFileView
+{
+public:
+	// NULL if File can't be read or isn't a wad file; report_errors sets the game error
+	// the way open_wad_file_for_reading() and read_wad_header() would
+	static std::shared_ptr<WadFileView> Get(FileSpecifier& File, bool report_errors = true);
+
+	// forgets every view, so the files can be replaced; views in use stay valid
+	static void ReleaseAll();
+
+	~WadFileView();
+
+	const struct wad_header& Header() const {return header;}
+
+	// the raw wad with the given wad index, or NULL
+	uint8 *GetWad(short index, int32 *length) const;
+
+	// a tag of that wad, as extract_type_from_wad() would find it, or NULL
+	uint8 *GetTag(short index, WadDataType type, size_t *length) const;
+
+	// that wad, read only and pointing into the view; keep the view until free_wad()
+	struct wad_data *GetReadOnlyWad(short index) const;
+
+	// that wad as get_flat_data() returns it (a copy)
+	void *GetFlatData(short index) const;
+
+	// the application-specific data of the directory entry in that position, or NULL
+	uint8 *GetDirectoryData(short position) const;
+
+private:
+	WadFileView();
+	bool Load(FileSpecifier& File);
+	bool Parse();
+	bool GetTags(short index, std::vector<struct tag_data>& tags) const;
+
+	struct wad_header header;
+	uint8 *base;
+	int32 size;
+	bool mapped;
+#if defined(__WIN32__)
+	void *mapping;
+#endif
+
+	// what the file looked like when we read it
+	TimeType date;
+	int32 file_size;
+
+	struct slot {
+		int32 offset, length;	/* of the wad; length is NONE if the entry is bad */
+		uint8 *directory_data;
+	};
+	std::vector<slot> slots;	/* by position in the directory */
+	std::vector<short> wads;	/* slot for each wad index, or NONE */
+};
+
 /* ------------  Write File functions */
 struct wad_data *create_empty_wad(void);
 void fill_default_wad_header(FileSpecifier& File, short wadfile_version,
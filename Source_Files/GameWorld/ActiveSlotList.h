@@ -0,0 +1,83 @@
+/*
+ *  ActiveSlotList.h
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+
+ *  The indices of the used slots in one of the dynamic-limit arrays (monsters, projectiles,
+ *  effects), kept sorted.  The per-tick update loops walk this instead of every slot up to
+ *  MAXIMUM_*_PER_MAP, which MML can raise into the thousands.
+ *
+ *  Walk it with next(), asking again after every element: slots can be used or freed by the
+ *  loop body, and next() always answers from the current set, so the visiting order (and
+ *  which newly-used slots get visited this tick) is exactly what a full scan of the array
+ *  would give.  Films depend on that.
+ */
+
+#ifndef ACTIVESLOTLIST_H
+#define ACTIVESLOTLIST_H
+
+#include "cseries.h"
+#include "map.h" // SLOT_IS_USED()
+
+#include <algorithm>
+#include <vector>
+
+class ActiveSlotList
+{
+public:
+	void clear() { mIndices.clear(); }
+
+	void add(short inIndex)
+	{
+		std::vector<short>::iterator i = std::lower_bound(mIndices.begin(), mIndices.end(), inIndex);
+		if (i == mIndices.end() || *i != inIndex)
+			mIndices.insert(i, inIndex);
+	}
+
+	void remove(short inIndex)
+	{
+		std::vector<short>::iterator i = std::lower_bound(mIndices.begin(), mIndices.end(), inIndex);
+		if (i != mIndices.end() && *i == inIndex)
+			mIndices.erase(i);
+	}
+
+	// the first used slot after inIndex (pass NONE to start), or NONE at the end
+	short next(short inIndex) const
+	{
+		std::vector<short>::const_iterator i = std::upper_bound(mIndices.begin(), mIndices.end(), inIndex);
+		return i == mIndices.end() ? static_cast<short>(NONE) : *i;
+	}
+
+	size_t size() const { return mIndices.size(); }
+
+	// for when slots were filled in wholesale, e.g. unpacked from a saved game
+	template <typename tSlotType>
+	void rebuild(const tSlotType* inSlots, size_t inSlotCount)
+	{
+		mIndices.clear();
+		for (size_t i = 0; i < inSlotCount; i++)
+		{
+			if (SLOT_IS_USED(&inSlots[i]))
+				mIndices.push_back(static_cast<short>(i));
+		}
+	}
+
+private:
+	std::vector<short> mIndices;
+};
+
+#endif
@@ -127,6 +127,7 @@ short new_effect(
 						effect->data= 0;
 						effect->delay= definition->delay ? global_random()%definition->delay : 0;
 						MARK_SLOT_AS_USED(effect);
+						ActiveEffects.add(effect_index);
 						
 						SET_OBJECT_OWNER(object, _object_is_effect);
 						object->sound_pitch= definition->sound_pitch;
@@ -155,8 +156,9 @@ void update_effects(
 	struct effect_data *effect;
 	short effect_index;
 	
-	for (effect_index= 0, effect= effects; effect_index<MAXIMUM_EFFECTS_PER_MAP; ++effect_index, ++effect)
+	for (effect_index= ActiveEffects.next(NONE); effect_index!=NONE; effect_index= ActiveEffects.next(effect_index))
 	{
+		effect= effects+effect_index;
 		if (SLOT_IS_USED(effect))
 		{
 			struct object_data *object= get_object_data(effect->object_index);
@@ -206,6 +208,7 @@ void remove_effect(
 	remove_map_object(effect->object_index);
 	L_Invalidate_Effect(effect_index);
 	MARK_SLOT_AS_FREE(effect);
+	ActiveEffects.remove(effect_index);
 }
 
 void remove_all_nonpersistent_effects(
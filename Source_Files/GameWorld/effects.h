@@ -44,6 +44,7 @@ Aug 30, 2000 (Loren Petrich):
 #include "dynamic_limits.h"
 
 #include "world.h"
+#include "ActiveSlotList.h"
 #include <vector>
 
 /* ---------- effect structure */
@@ -155,6 +156,9 @@ const int SIZEOF_effect_definition = 14;
 extern std::vector<effect_data> EffectList;
 #define effects (EffectList.data())
 
+// the used slots of EffectList, in slot order
+extern ActiveSlotList ActiveEffects;
+
 // extern struct effect_data *effects;
 
 /* ---------- prototypes/EFFECTS.C */
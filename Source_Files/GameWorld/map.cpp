@@ -91,6 +91,12 @@ Feb 3, 2003 (Loren Petrich):
 
  June 14, 2003 (Woody Zenfell):
 	New functions for manipulating polygons' object lists (in support of prediction).
+
+Oct 17, 2026:
+	world_point_to_polygon_index() looks in a uniform grid over the polygons' bounding boxes
+	instead of testing every polygon; it still returns the lowest-indexed polygon containing the point.
+	The grid is built whenever a level is loaded or a saved game restored.
+	Added get_environment_collections() for the level prefetcher.
  */
 
 /*
@@ -103,6 +109,7 @@ find_line_crossed leaving polygon could be sped up considerable by reversing the
 #include "cseries.h"
 #include "map.h"
 #include "FilmProfile.h"
+#include "polygon_visibility.h"
 #include "interface.h"
 #include "monsters.h"
 #include "preferences.h"
@@ -123,6 +130,7 @@ find_line_crossed leaving polygon could be sped up considerable by reversing the
 #include <limits.h>
 
 #include <list>
+#include <vector>
 
 /* ---------- structures */
 
@@ -184,6 +192,9 @@ vector<effect_data> EffectList(MAXIMUM_EFFECTS_PER_MAP);
 vector<object_data> ObjectList(MAXIMUM_OBJECTS_PER_MAP);
 vector<monster_data> MonsterList(MAXIMUM_MONSTERS_PER_MAP);
 vector<projectile_data> ProjectileList(MAXIMUM_PROJECTILES_PER_MAP);
+ActiveSlotList ActiveEffects;
+ActiveSlotList ActiveMonsters;
+ActiveSlotList ActiveProjectiles;
 // struct object_data *objects = NULL;
 // struct monster_data *monsters = NULL;
 // struct projectile_data *projectiles = NULL;
@@ -420,6 +431,7 @@ void initialize_map_for_new_level(
 	objlist_clear(projectiles,  ProjectileList.size());
 	objlist_clear(monsters,  MonsterList.size());
 	objlist_clear(objects,  ObjectList.size());
+	rebuild_active_slot_lists();
 
 	/* Note that these pointers just point into a larger structure, so this is not a bad thing */
 	// map_polygons= NULL;
@@ -626,6 +638,23 @@ void mark_environment_collections(
 			mark_collection_for_unloading(_collection_landscape1+static_world->song_index);
 }
 
+/* the collections mark_environment_collections() marks, for every environment code, leaving
+	out the landscape; for looking ahead at a level that hasn't been loaded yet */
+void get_environment_collections(
+	std::vector<std::vector<short> >& collections)
+{
+	collections.resize(NUMBER_OF_ENVIRONMENTS);
+	for (short environment_code= 0; environment_code<NUMBER_OF_ENVIRONMENTS; ++environment_code)
+	{
+		collections[environment_code].clear();
+		for (short i= 0; i<NUMBER_OF_ENV_COLLECTIONS; ++i)
+		{
+			if (Environments[environment_code][i] != NONE)
+				collections[environment_code].push_back(Environments[environment_code][i]);
+		}
+	}
+}
+
 /* make the object list and the map consistent */
 void reconnect_map_object_list(
 	void)
@@ -848,6 +877,8 @@ remove_object_from_polygon_object_list(short object_index, short polygon_index)
 		assert(*next_object != NONE);
 	}
 
+	record_predicted_field(*next_object);
+	record_predicted_field(object->polygon);
 	*next_object= object->next_object;
 
 	object->polygon= NONE;
@@ -868,86 +899,25 @@ add_object_to_polygon_object_list(short object_index, short polygon_index)
 	struct object_data* object = get_object_data(object_index);
 	struct polygon_data* polygon= get_polygon_data(polygon_index);
 
+	record_predicted_field(object->next_object);
+	record_predicted_field(object->polygon);
+	record_predicted_field(polygon->first_object);
 	object->next_object= polygon->first_object;
 	polygon->first_object= object_index;
 
 	object->polygon= polygon_index;
 }
 
-typedef std::pair<short, short>	DeferredObjectListInsertion;
-typedef std::list<DeferredObjectListInsertion> DeferredObjectListInsertionList;
-static DeferredObjectListInsertionList sDeferredObjectListInsertions;
-
-void
-deferred_add_object_to_polygon_object_list(short object_index, short index_to_precede)
+/* for when the monster, projectile and effect arrays were filled in or resized wholesale,
+	rather than through new_xxx() and remove_xxx() */
+void rebuild_active_slot_lists(
+	void)
 {
-	sDeferredObjectListInsertions.push_back(DeferredObjectListInsertion(object_index, index_to_precede));
+	ActiveEffects.rebuild(effects, EffectList.size());
+	ActiveMonsters.rebuild(monsters, MonsterList.size());
+	ActiveProjectiles.rebuild(projectiles, ProjectileList.size());
 }
 
-
-
-void
-perform_deferred_polygon_object_list_manipulations()
-{
-	// Loop while the list of insertions is non-empty (we may need to make multiple passes)
-	while(!sDeferredObjectListInsertions.empty())
-	{
-		// Pass over the list of insertions, inserting whatever we can.
-		bool something_changed = false;
-
-		for(DeferredObjectListInsertionList::iterator i = sDeferredObjectListInsertions.begin(); i != sDeferredObjectListInsertions.end(); )
-		{
-			short object_to_insert_index = (*i).first;
-			short object_index_to_precede = (*i).second;
-			object_data* object = get_object_data(object_to_insert_index);
-			polygon_data* polygon = get_polygon_data(object->polygon);
-
-			// Find object index we're supposed to predece... and insert the object before it
-			short* next_object_index_p = &(polygon->first_object);
-			bool inserted = false;
-
-			while(!inserted)
-			{
-				if(*next_object_index_p == object_index_to_precede)
-				{
-					object->next_object = *next_object_index_p;
-					*next_object_index_p = object_to_insert_index;
-					inserted = true;
-				}
-
-				if(*next_object_index_p == NONE)
-					break;
-
-				next_object_index_p = &(get_object_data(*next_object_index_p)->next_object);
-
-			} // Insert object before object it's supposed to precede
-
-			// Each branch of this if() will increment i
-			if(inserted)
-			{
-				// Most concise way to correctly remove-and-increment
-				sDeferredObjectListInsertions.erase(i++);
-				something_changed = true;
-			}
-			else
-				// Perhaps we were trying to insert before another object that's scheduled for insertion.
-				// In that case, maybe by the time we come around again, the other object will be inserted.
-				// For now, we leave the insertion pending.
-				++i;
-
-		} // Pass over the list of insertions, inserting whatever we can.
-
-		// We must make progress, otherwise my algorithm is flawed (we'd loop forever).  Progress here
-		// is performing insertions into the polygon object lists and removing the corresponding deferred
-		// insertions from the insertion list.
-		assert(something_changed);
-
-	} // Loop while the list of insertions is non-empty
-
-} // perform_deferred_polygon_object_list_manipulations
-
-
-
 /* if a new polygon index is supplied, it will be used, otherwise well try to find the new
 	polygon index ourselves */
 bool translate_map_object(
@@ -1292,6 +1262,21 @@ void calculate_line_midpoint(
 	midpoint->z= (line->lowest_adjacent_ceiling+line->highest_adjacent_floor)>>1;
 }
 
+/* false if p is on the outside of the given edge's line */
+static inline bool point_inside_polygon_edge(
+	struct polygon_data *polygon,
+	short i,
+	world_point2d *p)
+{
+	struct line_data *line= get_line_data(polygon->line_indexes[i]);
+	bool clockwise= line->endpoint_indexes[0]==polygon->endpoint_indexes[i];
+	world_point2d *e0= &get_endpoint_data(line->endpoint_indexes[0])->vertex;
+	world_point2d *e1= &get_endpoint_data(line->endpoint_indexes[1])->vertex;
+	int32 cross_product= (p->x-e0->x)*(e1->y-e0->y) - (p->y-e0->y)*(e1->x-e0->x);
+	
+	return !((clockwise && cross_product>0) || (!clockwise && cross_product<0));
+}
+
 bool point_in_polygon(
 	short polygon_index,
 	world_point2d *p)
@@ -1302,13 +1287,7 @@ bool point_in_polygon(
 	
 	for (i=0;i<polygon->vertex_count;++i)
 	{
-		struct line_data *line= get_line_data(polygon->line_indexes[i]);
-		bool clockwise= line->endpoint_indexes[0]==polygon->endpoint_indexes[i];
-		world_point2d *e0= &get_endpoint_data(line->endpoint_indexes[0])->vertex;
-		world_point2d *e1= &get_endpoint_data(line->endpoint_indexes[1])->vertex;
-		int32 cross_product= (p->x-e0->x)*(e1->y-e0->y) - (p->y-e0->y)*(e1->x-e0->x);
-		
-		if ((clockwise && cross_product>0) || (!clockwise && cross_product<0))
+		if (!point_inside_polygon_edge(polygon, i, p))
 		{
 			point_inside= false;
 			break;
@@ -1348,8 +1327,221 @@ short clockwise_endpoint_in_line(
 	return line->endpoint_indexes[index];
 }
 
+/* every non-detached polygon is listed (in index order) in each grid cell its bounding box touches.
+	point_in_polygon() accepts exactly the intersection of its edges' half-planes, which for a
+	well-formed polygon is the polygon itself and so inside its bounding box; malformed ones
+	(collinear, non-convex, edges that don't match the endpoints) are checked for every point.
+	the cross products in point_in_polygon() can't overflow for points inside the box as long as
+	neither side of it is longer than 32767, and for points outside it as long as the two sides
+	add up to no more than that; otherwise we fall back to testing every polygon. */
+
+enum
+{
+	MINIMUM_POLYGON_GRID_CELL_SHIFT= 8, /* WORLD_ONE/4 */
+	MAXIMUM_POLYGON_GRID_CELLS_PER_SIDE= 256,
+	MAXIMUM_POLYGON_GRID_EXTENT= 32767
+};
+
+struct polygon_grid_data
+{
+	short polygon_count; /* NONE if there's no grid */
+	int32 left, top, right, bottom;
+	short cell_shift;
+	int32 width, height;
+	bool outside_is_empty;
+
+	std::vector<int32> first_cell_polygon; /* width*height+1 */
+	std::vector<short> cell_polygons;
+	std::vector<short> malformed_polygons;
+};
+
+static struct polygon_grid_data polygon_grid= {NONE};
+
+static short linear_world_point_to_polygon_index(world_point2d *location);
+static short first_polygon_containing_point(const short *polygons, size_t count, world_point2d *location);
+static bool polygon_is_well_formed(short polygon_index);
+
+void build_polygon_lookup_grid(
+	void)
+{
+	struct polygon_grid_data& grid= polygon_grid;
+	short polygon_index;
+	struct polygon_data *polygon;
+
+	grid.polygon_count= NONE;
+	grid.first_cell_polygon.clear();
+	grid.cell_polygons.clear();
+	grid.malformed_polygons.clear();
+
+	/* the box around everything point_in_polygon() looks at */
+	grid.left= grid.top= INT32_MAX;
+	grid.right= grid.bottom= INT32_MIN;
+	for (polygon_index= 0, polygon= map_polygons; polygon_index<dynamic_world->polygon_count; ++polygon_index, ++polygon)
+	{
+		if (POLYGON_IS_DETACHED(polygon)) continue;
+
+		for (short i= 0; i<polygon->vertex_count; ++i)
+		{
+			struct line_data *line= get_line_data(polygon->line_indexes[i]);
+
+			for (short j= 0; j<2; ++j)
+			{
+				world_point2d *p= &get_endpoint_data(line->endpoint_indexes[j])->vertex;
+
+				grid.left= MIN(grid.left, p->x), grid.right= MAX(grid.right, p->x);
+				grid.top= MIN(grid.top, p->y), grid.bottom= MAX(grid.bottom, p->y);
+			}
+		}
+	}
+	if (grid.left>grid.right) return;
+	if (grid.right-grid.left>MAXIMUM_POLYGON_GRID_EXTENT || grid.bottom-grid.top>MAXIMUM_POLYGON_GRID_EXTENT) return;
+	grid.outside_is_empty= (grid.right-grid.left)+(grid.bottom-grid.top)<=MAXIMUM_POLYGON_GRID_EXTENT;
+
+	/* about two cells per polygon */
+	int32 extent= MAX(grid.right-grid.left, grid.bottom-grid.top)+1;
+	grid.cell_shift= MINIMUM_POLYGON_GRID_CELL_SHIFT;
+	while ((extent>>grid.cell_shift)>MAXIMUM_POLYGON_GRID_CELLS_PER_SIDE ||
+		(((grid.right-grid.left)>>grid.cell_shift)+1)*(((grid.bottom-grid.top)>>grid.cell_shift)+1)>2*dynamic_world->polygon_count)
+	{
+		if ((extent>>grid.cell_shift)<=1) break;
+		grid.cell_shift+= 1;
+	}
+	grid.width= ((grid.right-grid.left)>>grid.cell_shift)+1;
+	grid.height= ((grid.bottom-grid.top)>>grid.cell_shift)+1;
+
+	/* count, then fill; polygons go in in index order so each cell's list stays sorted */
+	std::vector<int32> counts(grid.width*grid.height+1, 0);
+	for (int pass= 0; pass<2; ++pass)
+	{
+		for (polygon_index= 0, polygon= map_polygons; polygon_index<dynamic_world->polygon_count; ++polygon_index, ++polygon)
+		{
+			if (POLYGON_IS_DETACHED(polygon)) continue;
+			if (!polygon_is_well_formed(polygon_index))
+			{
+				if (pass) grid.malformed_polygons.push_back(polygon_index);
+				continue;
+			}
+
+			int32 left= INT32_MAX, top= INT32_MAX, right= INT32_MIN, bottom= INT32_MIN;
+			for (short i= 0; i<polygon->vertex_count; ++i)
+			{
+				world_point2d *p= &get_endpoint_data(polygon->endpoint_indexes[i])->vertex;
+
+				left= MIN(left, p->x), right= MAX(right, p->x);
+				top= MIN(top, p->y), bottom= MAX(bottom, p->y);
+			}
+
+			for (int32 y= (top-grid.top)>>grid.cell_shift; y<=(bottom-grid.top)>>grid.cell_shift; ++y)
+			{
+				for (int32 x= (left-grid.left)>>grid.cell_shift; x<=(right-grid.left)>>grid.cell_shift; ++x)
+				{
+					int32 cell= y*grid.width+x;
+
+					if (pass)
+					{
+						grid.cell_polygons[grid.first_cell_polygon[cell]+counts[cell]++]= polygon_index;
+					}
+					else
+					{
+						counts[cell]+= 1;
+					}
+				}
+			}
+		}
+
+		if (!pass)
+		{
+			grid.first_cell_polygon.resize(counts.size());
+			int32 total= 0;
+			for (size_t cell= 0; cell<counts.size(); ++cell)
+			{
+				grid.first_cell_polygon[cell]= total;
+				total+= counts[cell];
+				counts[cell]= 0;
+			}
+			grid.cell_polygons.resize(total);
+		}
+	}
+
+	grid.polygon_count= dynamic_world->polygon_count;
+}
+
 short world_point_to_polygon_index(
 	world_point2d *location)
+{
+	struct polygon_grid_data& grid= polygon_grid;
+
+	if (grid.polygon_count!=dynamic_world->polygon_count) return linear_world_point_to_polygon_index(location);
+
+	short polygon_index= NONE;
+	if (location->x<grid.left || location->x>grid.right || location->y<grid.top || location->y>grid.bottom)
+	{
+		if (!grid.outside_is_empty) return linear_world_point_to_polygon_index(location);
+	}
+	else
+	{
+		int32 cell= ((location->y-grid.top)>>grid.cell_shift)*grid.width + ((location->x-grid.left)>>grid.cell_shift);
+		int32 first= grid.first_cell_polygon[cell];
+
+		polygon_index= first_polygon_containing_point(grid.cell_polygons.empty() ? NULL : &grid.cell_polygons[first],
+			grid.first_cell_polygon[cell+1]-first, location);
+	}
+
+	/* the malformed ones can turn up anywhere; keep the lowest index */
+	for (size_t i= 0; i<grid.malformed_polygons.size(); ++i)
+	{
+		short malformed_polygon_index= grid.malformed_polygons[i];
+
+		if (polygon_index!=NONE && malformed_polygon_index>polygon_index) break;
+		if (point_in_polygon(malformed_polygon_index, location))
+		{
+			polygon_index= malformed_polygon_index;
+			break;
+		}
+	}
+
+	return polygon_index;
+}
+
+/* times random lookups both ways, checking that they agree; returns false if they don't */
+bool benchmark_world_point_to_polygon_index(
+	int32 query_count,
+	uint32 *linear_ticks,
+	uint32 *grid_ticks)
+{
+	std::vector<world_point2d> points(query_count);
+	std::vector<short> linear_results(query_count), grid_results(query_count);
+	uint32 seed= 0x12345678;
+
+	/* not global_random(), which would desync films */
+	for (int32 i= 0; i<query_count; ++i)
+	{
+		seed= seed*1664525 + 1013904223;
+		points[i].x= static_cast<world_distance>(seed>>16);
+		seed= seed*1664525 + 1013904223;
+		points[i].y= static_cast<world_distance>(seed>>16);
+
+		/* mostly inside the map */
+		if (polygon_grid.polygon_count!=NONE && (i&7))
+		{
+			points[i].x= static_cast<world_distance>(polygon_grid.left + (static_cast<uint16>(points[i].x)%(polygon_grid.right-polygon_grid.left+1)));
+			points[i].y= static_cast<world_distance>(polygon_grid.top + (static_cast<uint16>(points[i].y)%(polygon_grid.bottom-polygon_grid.top+1)));
+		}
+	}
+
+	uint32 start_ticks= machine_tick_count();
+	for (int32 i= 0; i<query_count; ++i) linear_results[i]= linear_world_point_to_polygon_index(&points[i]);
+	*linear_ticks= machine_tick_count()-start_ticks;
+
+	start_ticks= machine_tick_count();
+	for (int32 i= 0; i<query_count; ++i) grid_results[i]= world_point_to_polygon_index(&points[i]);
+	*grid_ticks= machine_tick_count()-start_ticks;
+
+	return linear_results==grid_results;
+}
+
+static short linear_world_point_to_polygon_index(
+	world_point2d *location)
 {
 	short polygon_index;
 	struct polygon_data *polygon;
@@ -1366,6 +1558,55 @@ short world_point_to_polygon_index(
 	return polygon_index;
 }
 
+static short first_polygon_containing_point(
+	const short *polygons,
+	size_t count,
+	world_point2d *location)
+{
+	for (size_t i= 0; i<count; ++i)
+	{
+		if (point_in_polygon(polygons[i], location)) return polygons[i];
+	}
+
+	return NONE;
+}
+
+/* true if the half-planes point_in_polygon() tests meet in exactly this (convex) polygon */
+static bool polygon_is_well_formed(
+	short polygon_index)
+{
+	struct polygon_data *polygon= get_polygon_data(polygon_index);
+	int64 twice_area= 0;
+
+	if (polygon->vertex_count<3) return false;
+	for (short i= 0; i<polygon->vertex_count; ++i)
+	{
+		short next= (i==polygon->vertex_count-1) ? 0 : i+1;
+		struct line_data *line= get_line_data(polygon->line_indexes[i]);
+
+		/* the edge has to join this vertex and the next, or the edges needn't go around */
+		if (!((line->endpoint_indexes[0]==polygon->endpoint_indexes[i] && line->endpoint_indexes[1]==polygon->endpoint_indexes[next]) ||
+			(line->endpoint_indexes[1]==polygon->endpoint_indexes[i] && line->endpoint_indexes[0]==polygon->endpoint_indexes[next])))
+		{
+			return false;
+		}
+
+		world_point2d *e0= &get_endpoint_data(polygon->endpoint_indexes[i])->vertex;
+		world_point2d *e1= &get_endpoint_data(polygon->endpoint_indexes[next])->vertex;
+		if (e0->x==e1->x && e0->y==e1->y) return false;
+		twice_area+= (int64)e0->x*e1->y - (int64)e1->x*e0->y;
+
+		/* every vertex has to pass this edge's test (the same arithmetic as point_in_polygon()) */
+		for (short j= 0; j<polygon->vertex_count; ++j)
+		{
+			if (!point_inside_polygon_edge(polygon, i, &get_endpoint_data(polygon->endpoint_indexes[j])->vertex)) return false;
+		}
+	}
+
+	/* all collinear: the half-planes meet in a whole line */
+	return twice_area!=0;
+}
+
 /* return the polygon on the other side of the given line from the given polygon (i.e., return
 	the polygon adjacent to line_index which isnt polygon_index).  can return NONE. */
 short find_adjacent_polygon(
@@ -2173,6 +2414,8 @@ bool line_is_obstructed(
 	bool obstructed= false;
 	short line_index;
 	
+	if (!polygon_is_potentially_visible(polygon_index1, p1, polygon_index2, p2)) return true;
+	
 	do
 	{
 		bool last_line = false;
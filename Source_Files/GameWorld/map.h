@@ -1086,6 +1086,31 @@ std::pair<bool, int16> update_world(void);
 void reset_intermediate_action_queues();
 void set_prediction_wanted(bool inPrediction);
 
+// saves the bytes about to be overwritten, if we're in the middle of predicting, so they
+// can be put back when the real update catches up; a no-op otherwise
+void record_predicted_write(void* inAddress, size_t inSize);
+template<class T> inline void record_predicted_field(T& ioField) { record_predicted_write(&ioField, sizeof(T)); }
+
+// subsystems timed separately by fast_forward_replay()
+enum {
+	_world_subsystem_lua_idle,
+	_world_subsystem_players,
+	_world_subsystem_projectiles,
+	_world_subsystem_monsters,
+	_world_subsystem_other,
+	NUMBER_OF_WORLD_SUBSYSTEMS
+};
+
+// Headless film playback: runs every remaining tick of the current replay as fast as
+// possible, without rendering, sound or interface updates. Returns the number of ticks run;
+// fills in the wall-clock time spent in each subsystem.
+int32 fast_forward_replay(uint64 outSubsystemMicroseconds[NUMBER_OF_WORLD_SUBSYSTEMS]);
+// Film seeking: replays ticks until the world reaches inTargetTick; false if the film ended
+// or the level changed first
+bool advance_replay_to_tick(int32 inTargetTick);
+// CRC of the deterministic world state (players, monsters, projectiles, objects)
+uint32 calculate_world_checksum(void);
+
 /* Called to activate lights, platforms, etc. (original polygon may be NONE) */
 void changed_polygon(short original_polygon_index, short new_polygon_index, short player_index);
 
@@ -1101,6 +1126,7 @@ void initialize_map_for_new_game(void);
 void initialize_map_for_new_level(void);
 
 void mark_environment_collections(short environment_code, bool loading);
+void get_environment_collections(std::vector<std::vector<short> >& collections);
 void mark_map_collections(bool loading);
 bool collection_in_environment(short collection_code, short environment_code);
 
@@ -1114,6 +1140,7 @@ short new_map_object(struct object_location *location, shape_descriptor shape);
 short attach_parasitic_object(short host_index, shape_descriptor shape, angle facing);
 void remove_parasitic_object(short host_index);
 bool translate_map_object(short object_index, world_point3d *new_location, short new_polygon_index);
+void rebuild_active_slot_lists(void);
 short find_new_object_polygon(world_point2d *parent_location, world_point2d *child_location, short parent_polygon_index);
 void remove_map_object(short index);
 
@@ -1123,16 +1150,6 @@ void remove_map_object(short index);
 extern void remove_object_from_polygon_object_list(short object_index);
 extern void remove_object_from_polygon_object_list(short object_index, short polygon_index);
 
-// schedules object at object_index for later insertion into a polygon object list.  it'll be inserted
-// before the object with index index_to_precede (which had better be in the list or be scheduled for insertion
-// by the time perform_deferred_polygon_object_list_manipulations() is called, else A1 will assert).
-extern void deferred_add_object_to_polygon_object_list(short object_index, short index_to_precede);
-
-// actually does the insertions scheduled by deferred_add_object_to_polygon_object_list().  uses the polygon
-// index each scheduled object has _when this function is called_, not whatever polygon index it had when
-// deferred_add_object_to_polygon_object_list() was called!
-extern void perform_deferred_polygon_object_list_manipulations();
-
 
 
 struct shape_and_transfer_mode
@@ -1168,6 +1185,8 @@ void initialize_map_for_new_player(void);
 void generate_map(short level);
 
 short world_point_to_polygon_index(world_point2d *location);
+void build_polygon_lookup_grid(void);
+bool benchmark_world_point_to_polygon_index(int32 query_count, uint32 *linear_ticks, uint32 *grid_ticks);
 short clockwise_endpoint_in_line(short polygon_index, short line_index, short index);
 
 short find_adjacent_polygon(short polygon_index, short line_index);
@@ -54,6 +54,7 @@ const bool DoIncorrectCountVWarn = true;
 #include "flood_map.h"
 #include "platforms.h"
 #include "Packing.h"
+#include "polygon_visibility.h"
 
 #include <limits.h>
 #include <vector>
@@ -661,6 +662,7 @@ void precalculate_map_indexes(
 	}
 
 	precalculate_polygon_sound_sources();
+	precalculate_polygon_visibility();
 }
 
 static void find_intersecting_endpoints_and_lines(
@@ -72,6 +72,12 @@ Feb 8, 2003 (Woody Zenfell):
 	Player movement prediction support:
 	+ Support for retaining a partial game-state (this could be moved out to another file)
 	+ Changes to update_world() to take advantage of partial game-state saving/restoring.
+
+Oct 17, 2026:
+	Prediction now saves only the fields predicted ticks write, in an undo log, instead of
+	whole player/monster/object copies; polygon object lists log their own changes, so no
+	more deferred re-insertion.  The local player's projectiles are predicted as well.
+	entering_map() waits for the LevelPrefetcher before loading collections.
 */
 
 #include "cseries.h"
@@ -120,8 +126,15 @@ Feb 8, 2003 (Woody Zenfell):
 #include "Statistics.h"
 
 #include "motion_sensor.h"
+#include "LevelPrefetcher.h"
+
+// for headless replay checksums
+#include "crc.h"
+#include "Packing.h"
+#include "vbl.h"
 
 #include <limits.h>
+#include <vector>
 
 /* ---------- constants */
 
@@ -194,16 +207,72 @@ set_prediction_wanted(bool inPrediction)
 	sPredictionWanted= inPrediction;
 }
 
-static player_data sSavedPlayerData[MAXIMUM_NUMBER_OF_PLAYERS];
-static monster_data sSavedPlayerMonsterData[MAXIMUM_NUMBER_OF_PLAYERS];
-static object_data sSavedPlayerObjectData[MAXIMUM_NUMBER_OF_PLAYERS];
-static object_data sSavedPlayerParasiticObjectData[MAXIMUM_NUMBER_OF_PLAYERS];
-static short sSavedPlayerObjectNextObject[MAXIMUM_NUMBER_OF_PLAYERS];
+// Prediction undo log: rather than copying whole player, monster and object structures
+// on the way into predictive mode, we save just the bytes predicted ticks are about to
+// overwrite, and exit_predictive_mode() plays them back newest-first.  Anything that can
+// be written during a predicted tick has to go through record_predicted_write() first.
+struct prediction_undo_record
+{
+	void* address;
+	size_t size;
+	size_t offset; // into sPredictionUndoBytes
+};
+
+static std::vector<prediction_undo_record> sPredictionUndoLog;
+static std::vector<uint8> sPredictionUndoBytes;
+static bool sPredictionUndoActive = false;
 
 // For sanity-checking...
 static int32 sSavedTickCount;
 static uint16 sSavedRandomSeed;
 
+void
+record_predicted_write(void* inAddress, size_t inSize)
+{
+	if(!sPredictionUndoActive)
+		return;
+
+	prediction_undo_record theRecord = { inAddress, inSize, sPredictionUndoBytes.size() };
+	sPredictionUndoBytes.insert(sPredictionUndoBytes.end(), static_cast<uint8*>(inAddress), static_cast<uint8*>(inAddress) + inSize);
+	sPredictionUndoLog.push_back(theRecord);
+}
+
+
+// The fields a predictive update_players() writes: physics_update() only changes the
+// physics variables; instantiate_physics_variables() shadows them into the rest of these.
+// Polygon object lists log their own changes.
+static void
+record_predicted_player(short inPlayerIndex)
+{
+	player_data* player = get_player_data(inPlayerIndex);
+
+	record_predicted_field(player->variables);
+	record_predicted_field(player->location);
+	record_predicted_field(player->camera_location);
+	record_predicted_field(player->camera_polygon_index);
+	record_predicted_field(player->supporting_polygon_index);
+	record_predicted_field(player->last_supporting_polygon_index);
+	record_predicted_field(player->step_height);
+	record_predicted_field(player->facing);
+	record_predicted_field(player->elevation);
+
+	if(player->monster_index == NONE)
+		return;
+
+	monster_data* monster = get_monster_data(player->monster_index);
+	record_predicted_field(monster->sound_location);
+	record_predicted_field(monster->sound_polygon_index);
+
+	for(short theObjectIndex = monster->object_index; theObjectIndex != NONE; )
+	{
+		object_data* object = get_object_data(theObjectIndex);
+		record_predicted_field(object->location);
+		record_predicted_field(object->polygon);
+		record_predicted_field(object->facing);
+		theObjectIndex = object->parasitic_object;
+	}
+}
+
 
 // ZZZ: If not already in predictive mode, save off partial game-state for later restoration.
 static void
@@ -211,21 +280,10 @@ enter_predictive_mode()
 {
 	if(sPredictedTicks == 0)
 	{
+		sPredictionUndoActive = true;
+
 		for(short i = 0; i < dynamic_world->player_count; i++)
-		{
-			sSavedPlayerData[i] = *get_player_data(i);
-			if(sSavedPlayerData[i].monster_index != NONE)
-			{
-				sSavedPlayerMonsterData[i] = *get_monster_data(sSavedPlayerData[i].monster_index);
-				if(sSavedPlayerMonsterData[i].object_index != NONE)
-				{
-					sSavedPlayerObjectData[i] = *get_object_data(sSavedPlayerMonsterData[i].object_index);
-					sSavedPlayerObjectNextObject[i] = sSavedPlayerObjectData[i].next_object;
-					if(sSavedPlayerObjectData[i].parasitic_object != NONE)
-						sSavedPlayerParasiticObjectData[i] = *get_object_data(sSavedPlayerObjectData[i].parasitic_object);
-				}
-			}
-		}
+			record_predicted_player(i);
 		
 		// Sanity checking
 		sSavedTickCount = dynamic_world->tick_count;
@@ -279,53 +337,16 @@ exit_predictive_mode()
 {
 	if(sPredictedTicks > 0)
 	{
-		for(short i = 0; i < dynamic_world->player_count; i++)
+		// Newest first, so each byte ends up with the oldest value saved for it
+		for(size_t i = sPredictionUndoLog.size(); i-- > 0; )
 		{
-			player_data* player = get_player_data(i);
-			
-			assert(player->monster_index == sSavedPlayerData[i].monster_index);
-
-			{
-				// We *don't* restore this tiny part of the game-state back because
-				// otherwise the player can't use [] to scroll the inventory panel.
-				// [] scrolling happens outside the normal input/update system, so that's
-				// enough to persuade me that not restoring this won't OOS any more often
-				// than []-scrolling did before prediction.  :)
-				int16 saved_interface_flags = player->interface_flags;
-				int16 saved_interface_decay = player->interface_decay;
-				
-				*player = sSavedPlayerData[i];
-
-				player->interface_flags = saved_interface_flags;
-				player->interface_decay = saved_interface_decay;
-			}
-
-			if(sSavedPlayerData[i].monster_index != NONE)
-			{
-				assert(get_monster_data(sSavedPlayerData[i].monster_index)->object_index == sSavedPlayerMonsterData[i].object_index);
-
-				*get_monster_data(sSavedPlayerData[i].monster_index) = sSavedPlayerMonsterData[i];
-				
-				if(sSavedPlayerMonsterData[i].object_index != NONE)
-				{
-					assert(get_object_data(sSavedPlayerMonsterData[i].object_index)->parasitic_object == sSavedPlayerObjectData[i].parasitic_object);
-
-					remove_object_from_polygon_object_list(sSavedPlayerMonsterData[i].object_index);
-					
-					*get_object_data(sSavedPlayerMonsterData[i].object_index) = sSavedPlayerObjectData[i];
-
-					// We have to defer this insertion since the object lists could still have other players
-					// in their predictive locations etc. - we need to reconstruct everything exactly as it
-					// was when we entered predictive mode.
-					deferred_add_object_to_polygon_object_list(sSavedPlayerMonsterData[i].object_index, sSavedPlayerObjectNextObject[i]);
-					
-					if(sSavedPlayerObjectData[i].parasitic_object != NONE)
-						*get_object_data(sSavedPlayerObjectData[i].parasitic_object) = sSavedPlayerParasiticObjectData[i];
-				}
-			}
+			const prediction_undo_record& theRecord = sPredictionUndoLog[i];
+			memcpy(theRecord.address, &sPredictionUndoBytes[theRecord.offset], theRecord.size);
 		}
 
-		perform_deferred_polygon_object_list_manipulations();
+		sPredictionUndoLog.clear();
+		sPredictionUndoBytes.clear();
+		sPredictionUndoActive = false;
 		
 		sPredictedTicks = 0;
 
@@ -377,6 +398,28 @@ overlay_queue_with_queue_into_queue(ActionQueues* inBaseQueues, ActionQueues* in
 }
 
 
+// Wall-clock time spent in each subsystem, in performance-counter units; only collected
+// by fast_forward_replay(), whose copy of update_world_elements_one_tick() is the only
+// one with the timing compiled in
+static uint64* sSubsystemTimes = NULL;
+static uint64 sSubsystemStartTime;
+
+template <bool timed>
+static inline void
+begin_subsystem_timing()
+{
+	if (timed)
+		sSubsystemStartTime = SDL_GetPerformanceCounter();
+}
+
+template <bool timed>
+static inline void
+end_subsystem_timing(int inSubsystem)
+{
+	if (timed)
+		sSubsystemTimes[inSubsystem] += SDL_GetPerformanceCounter() - sSubsystemStartTime;
+}
+
 // Return values for update_world_elements_one_tick()
 enum {
         kUpdateNormalCompletion,
@@ -385,6 +428,7 @@ enum {
 };
 
 // ZZZ: split out from update_world()'s loop.
+template <bool timed>
 static int
 update_world_elements_one_tick(bool& call_postidle)
 {
@@ -395,7 +439,9 @@ update_world_elements_one_tick(bool& call_postidle)
 	} 
 	else
 	{
+		begin_subsystem_timing<timed>();
 		L_Call_Idle();
+		end_subsystem_timing<timed>(_world_subsystem_lua_idle);
 		call_postidle = true;
 		
 		update_lights();
@@ -403,9 +449,15 @@ update_world_elements_one_tick(bool& call_postidle)
 		update_platforms();
 		
 		update_control_panels(); // don't put after update_players
+		begin_subsystem_timing<timed>();
 		update_players(GameQueue, false);
+		end_subsystem_timing<timed>(_world_subsystem_players);
+		begin_subsystem_timing<timed>();
 		move_projectiles();
+		end_subsystem_timing<timed>(_world_subsystem_projectiles);
+		begin_subsystem_timing<timed>();
 		move_monsters();
+		end_subsystem_timing<timed>(_world_subsystem_monsters);
 		update_effects();
 		recreate_objects();
 		
@@ -496,12 +548,14 @@ update_world()
 		// Transition from predictive -> real update mode, if necessary.
 		exit_predictive_mode();
 
+		record_replay_keyframe();
+
 		// Capture the flags for each player for use in prediction
 		for(short i = 0; i < dynamic_world->player_count; i++)
 			sMostRecentFlagsForPlayer[i] = GameQueue->peekActionFlags(i, 0);
 
 		bool call_postidle = true;
-		theUpdateResult = update_world_elements_one_tick(call_postidle);
+		theUpdateResult = update_world_elements_one_tick<false>(call_postidle);
 
                 theElapsedTime++;
 
@@ -562,6 +616,10 @@ update_world()
 			// update_players() will dequeue the elements we just put in there
 			update_players(&thePredictiveQueues, true);
 
+			// Carry the local player's shots along too, so they don't trail behind by the latency
+			if(local_player_index != NONE)
+				move_predicted_projectiles(get_player_data(local_player_index)->monster_index, dynamic_world->tick_count + sPredictedTicks);
+
 			didPredict = true;
 			
 		} // loop while local player has flags we haven't used for prediction
@@ -572,6 +630,148 @@ update_world()
         return std::pair<bool, int16>(didPredict || theElapsedTime != 0, theElapsedTime);
 }
 
+// Headless film playback: feeds the replay's flags straight into the world, one tick at a
+// time, with none of the speed limiting, interface, fade or prediction work update_world() does.
+int32
+fast_forward_replay(uint64 outSubsystemMicroseconds[NUMBER_OF_WORLD_SUBSYSTEMS])
+{
+	uint64 theSubsystemTimes[NUMBER_OF_WORLD_SUBSYSTEMS];
+	int32 theTickCount = 0;
+
+	std::fill_n(theSubsystemTimes, static_cast<int>(NUMBER_OF_WORLD_SUBSYSTEMS), 0);
+	sSubsystemTimes = theSubsystemTimes;
+	
+	uint64 theStartTime = SDL_GetPerformanceCounter();
+	while (true)
+	{
+		if (GameQueue->countActionFlags(0) == 0)
+		{
+			if (!pull_replay_tick_flags())
+				break;
+			if (!overlay_queue_with_queue_into_queue(GetRealActionQueues(), GetLuaActionQueues(), GameQueue))
+				break;
+		}
+
+		bool call_postidle = true;
+		int theUpdateResult = update_world_elements_one_tick<true>(call_postidle);
+		if (call_postidle)
+			L_Call_PostIdle();
+		theTickCount++;
+
+		if (theUpdateResult == kUpdateGameOver)
+			break;
+	}
+	uint64 theTotalTime = SDL_GetPerformanceCounter() - theStartTime;
+	
+	sSubsystemTimes = NULL;
+
+	// whatever wasn't spent in the subsystems we time separately
+	theSubsystemTimes[_world_subsystem_other] = theTotalTime;
+	for (int i = 0; i < _world_subsystem_other; i++)
+		theSubsystemTimes[_world_subsystem_other] -= theSubsystemTimes[i];
+
+	uint64 theFrequency = SDL_GetPerformanceFrequency();
+	for (int i = 0; i < NUMBER_OF_WORLD_SUBSYSTEMS; i++)
+		outSubsystemMicroseconds[i] = theSubsystemTimes[i] * 1000000 / theFrequency;
+
+	return theTickCount;
+}
+
+bool
+advance_replay_to_tick(int32 inTargetTick)
+{
+	while (dynamic_world->tick_count < inTargetTick)
+	{
+		// use up any flags the input controller already read ahead before going back to the film
+		if (GameQueue->countActionFlags(0) == 0 && !overlay_queue_with_queue_into_queue(GetRealActionQueues(), GetLuaActionQueues(), GameQueue))
+		{
+			if (!pull_replay_tick_flags())
+				return false;
+			if (!overlay_queue_with_queue_into_queue(GetRealActionQueues(), GetLuaActionQueues(), GameQueue))
+				return false;
+		}
+
+		record_replay_keyframe();
+
+		bool call_postidle = true;
+		int theUpdateResult = update_world_elements_one_tick<false>(call_postidle);
+		if (call_postidle)
+			L_Call_PostIdle();
+
+		if (theUpdateResult != kUpdateNormalCompletion)
+			return false;
+	}
+
+	return true;
+}
+
+template<class T> static void
+append_checksum_value(std::vector<uint8>& ioBuffer, T inValue)
+{
+	uint8 theBytes[sizeof(T)];
+	uint8* S = theBytes;
+	ValueToStream(S, inValue);
+	ioBuffer.insert(ioBuffer.end(), theBytes, theBytes + sizeof(T));
+}
+
+// Only the deterministic simulation state goes in; nothing that depends on rendering or
+// the local interface, so that two builds replaying the same film must agree.
+uint32
+calculate_world_checksum()
+{
+	std::vector<uint8> theBuffer;
+
+	append_checksum_value(theBuffer, dynamic_world->tick_count);
+	append_checksum_value(theBuffer, get_random_seed());
+
+	for (short i = 0; i < dynamic_world->player_count; i++)
+	{
+		player_data* player = get_player_data(i);
+		append_checksum_value(theBuffer, player->location.x);
+		append_checksum_value(theBuffer, player->location.y);
+		append_checksum_value(theBuffer, player->location.z);
+		append_checksum_value(theBuffer, player->facing);
+		append_checksum_value(theBuffer, player->elevation);
+		append_checksum_value(theBuffer, player->supporting_polygon_index);
+		append_checksum_value(theBuffer, player->suit_energy);
+		append_checksum_value(theBuffer, player->suit_oxygen);
+	}
+
+	for (short i = 0; i < MAXIMUM_MONSTERS_PER_MAP; i++)
+	{
+		monster_data* monster = monsters + i;
+		if (SLOT_IS_FREE(monster)) continue;
+		append_checksum_value(theBuffer, i);
+		append_checksum_value(theBuffer, monster->type);
+		append_checksum_value(theBuffer, monster->vitality);
+		append_checksum_value(theBuffer, monster->mode);
+		append_checksum_value(theBuffer, monster->action);
+	}
+
+	for (short i = 0; i < MAXIMUM_PROJECTILES_PER_MAP; i++)
+	{
+		projectile_data* projectile = projectiles + i;
+		if (SLOT_IS_FREE(projectile)) continue;
+		append_checksum_value(theBuffer, i);
+		append_checksum_value(theBuffer, projectile->type);
+		append_checksum_value(theBuffer, projectile->object_index);
+	}
+
+	for (short i = 0; i < MAXIMUM_OBJECTS_PER_MAP; i++)
+	{
+		object_data* object = objects + i;
+		if (SLOT_IS_FREE(object)) continue;
+		append_checksum_value(theBuffer, i);
+		append_checksum_value(theBuffer, object->location.x);
+		append_checksum_value(theBuffer, object->location.y);
+		append_checksum_value(theBuffer, object->location.z);
+		append_checksum_value(theBuffer, object->polygon);
+		append_checksum_value(theBuffer, object->facing);
+	}
+
+	return calculate_data_crc(theBuffer.data(), static_cast<int32>(theBuffer.size()));
+}
+
 /* call this function before leaving the old level, but DO NOT call it when saving the player.
 	it should be called when you're leaving the game (i.e., quitting or reverting, etc.) */
 void leaving_map(
@@ -642,6 +842,8 @@ bool entering_map(bool restoring_saved)
 	MarkLuaCollections(true);
 	MarkLuaHUDCollections(true);
 
+	// whatever has been prefetched by now is staged for load_collections()
+	LevelPrefetcher::instance()->Wait();
 	load_collections(true, get_screen_mode()->acceleration != _no_acceleration);
 
 	load_all_monster_sounds();
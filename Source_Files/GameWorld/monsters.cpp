@@ -100,6 +100,7 @@ Jan 12, 2003 (Loren Petrich)
 #include "interface.h"
 #include "FilmProfile.h"
 #include "flood_map.h"
+#include "polygon_visibility.h"
 #include "effects.h"
 #include "monsters.h"
 #include "projectiles.h"
@@ -421,6 +422,7 @@ short new_monster(
 					monster->sound_polygon_index= object->polygon;
 					monster->sound_location= object->location;
 					MARK_SLOT_AS_USED(monster);
+					ActiveMonsters.add(monster_index);
 					
 					/* initialize the monsters object */
 					if (definition->flags&_monster_is_invisible) object->transfer_mode= _xfer_invisibility;
@@ -467,8 +469,9 @@ void move_monsters(
 	bool monster_built_path= (dynamic_world->tick_count&3) ? true : false;
 	short monster_index;
 
-	for (monster_index= 0, monster= monsters; monster_index<MAXIMUM_MONSTERS_PER_MAP; ++monster_index, ++monster)
+	for (monster_index= ActiveMonsters.next(NONE); monster_index!=NONE; monster_index= ActiveMonsters.next(monster_index))
 	{
+		monster= monsters+monster_index;
 		if (SLOT_IS_USED(monster) && !MONSTER_IS_PLAYER(monster))
 		{
 			struct object_data *object= get_object_data(monster->object_index);
@@ -590,6 +593,7 @@ void move_monsters(
 									remove_map_object(monster->object_index);
 									L_Invalidate_Monster(monster_index);
 									MARK_SLOT_AS_FREE(monster);
+									ActiveMonsters.remove(monster_index);
 								}
 								break;
 							
@@ -2384,6 +2388,13 @@ static bool clear_line_of_sight(
 			}
 		}
 
+		/* no line from our polygon can reach his */
+		if (target_visible && !polygon_is_potentially_visible(viewer_object->polygon, (world_point2d *)origin,
+			target_object->polygon, (world_point2d *)destination))
+		{
+			target_visible= false;
+		}
+
 		/* make sure there are no non-transparent lines between the viewer and the target */
 		if (target_visible)
 		{
@@ -2716,6 +2727,7 @@ static void kill_monster(
 
 	L_Invalidate_Monster(monster_index);
 	MARK_SLOT_AS_FREE(monster);
+	ActiveMonsters.remove(monster_index);
 }
 		
 /* move the monster along his current heading; if he reaches the center of his destination square,
@@ -50,6 +50,7 @@ Oct 24, 2000 (Mark Levin)
 #include <vector>
 
 #include "world.h"
+#include "ActiveSlotList.h"
 
 using std::vector;
 
@@ -265,6 +266,9 @@ const int SIZEOF_monster_definition = 156;
 extern vector<monster_data> MonsterList;
 #define monsters (MonsterList.data())
 
+// the used slots of MonsterList, in slot order
+extern ActiveSlotList ActiveMonsters;
+
 // extern struct monster_data *monsters;
 
 /* ---------- prototypes/MONSTERS.C */
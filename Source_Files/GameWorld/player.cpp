@@ -129,6 +129,9 @@ May 22, 2003 (Woody Zenfell):
 	Made all the MML-settable stuff in this file have a ResetValues method that resets to
 	old values (which we now save). Had to move some free-standing variables into structs
 	for this.
+
+Oct 17, 2026:
+	Starting an interlevel teleport starts prefetching the level
 */
 
 #define DONT_REPEAT_DEFINITIONS
@@ -173,6 +176,8 @@ May 22, 2003 (Woody Zenfell):
 // jkvw addition:
 #include "lua_script.h"
 
+#include "LevelPrefetcher.h"
+
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -1399,6 +1404,9 @@ static void update_player_teleport(
 				{
 					short other_player_index;
 				
+					/* Read the next level while the teleport plays out */
+					LevelPrefetcher::instance()->Prefetch(-player->teleporting_destination - 1);
+
 					/* Everyone plays the teleporting effect out. */
 					if (View_DoInterlevelTeleportOutEffects()) {
 						start_teleporting_effect(true);
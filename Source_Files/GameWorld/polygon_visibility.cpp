@@ -0,0 +1,717 @@
+/*
+	POLYGON_VISIBILITY.CPP
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+
+Oct 17, 2026:
+	Created.  Both line_is_obstructed() and clear_line_of_sight() walk from polygon to polygon
+	along the segment p1p2, and find_line_crossed_leaving_polygon() (either version) only ever
+	reports an edge e0e1 with e0 on or left of the directed line p1p2 and e1 on or right of it.
+	So a walk that crosses the edges c1..ck needs a single directed line with every ci.e0 on its
+	left and every ci.e1 on its right, i.e. a normal n with n.(ci.e0-cj.e1) >= 0 for all i, j.
+	For each polygon we enumerate the simple chains of edges through which such a line exists
+	(every two-sided line counts, since platforms change solidity and transparency) and mark
+	everything they reach, plus everything sharing an endpoint with it for the Infinity
+	line_is_obstructed() fix.  Anything left unmarked could never have been reached.
+
+	The orientation tests can overflow if the points are more than 32767 world units apart, so
+	the set is only used when both points lie in the map's bounding box (plus a margin) and the
+	box fits in that range.
+
+Oct 17, 2026:
+	A polygon's row is now built the first time a query starts in it, instead of all of them
+	during the level load; a level gets MAXIMUM_VISIBILITY_STEPS in all, after which rows not
+	built yet answer "visible".  The cache is written with AOStreamBE, with a version, and holds
+	the rows built so far; it is written when the next level's set is set up.
+*/
+
+#include "cseries.h"
+#include "map.h"
+#include "polygon_visibility.h"
+#include "AStream.h"
+#include "FileHandler.h"
+#include "Logging.h"
+
+#include <vector>
+
+extern DirectorySpecifier local_data_dir;
+
+/* ---------- constants */
+
+enum
+{
+	MAXIMUM_POLYGONS_FOR_VISIBILITY= 8192, /* 8M of bits */
+	MAXIMUM_VISIBILITY_STEPS_PER_POLYGON= 1<<14, /* past this we give up and call everything visible */
+	MAXIMUM_VISIBILITY_STEPS= 1<<20, /* per level; past this, rows not built yet aren't */
+	VISIBILITY_BOUNDS_MARGIN= WORLD_ONE,
+	MAXIMUM_VISIBILITY_EXTENT= 32767
+};
+
+const uint32 POLYGON_VISIBILITY_CACHE_TAG= FOUR_CHARS_TO_INT('p', 'v', 's', ' ');
+const uint32 POLYGON_VISIBILITY_CACHE_VERSION= 2;
+const int SIZEOF_polygon_visibility_cache_header= 32;
+
+/* ---------- structures */
+
+struct visibility_vector
+{
+	int64 x, y;
+};
+
+enum /* visibility cone kinds */
+{
+	_cone_full, /* no constraints yet */
+	_cone_sweep, /* counterclockwise from lo to hi, at most a half-plane */
+	_cone_ray, /* only lo */
+	_cone_line, /* lo and -lo */
+	_cone_empty
+};
+
+/* the directions n a line's normal may still take */
+struct visibility_cone
+{
+	short kind;
+	visibility_vector lo, hi;
+};
+
+struct visibility_frame
+{
+	short polygon_index;
+	short next_edge;
+	struct visibility_cone cone;
+};
+
+/* once the cone is down to a single normal n, all a chain still constrains is the line's offset
+	c (n.p+c is the side of p), so a chain into a polygon with an offset range inside one we've
+	already followed from there can't reach anything new; without this, lines running exactly
+	along collinear edges (all over axis-aligned maps) branch at every vertex */
+struct visibility_ray_state
+{
+	int64 normal_x, normal_y;
+	int64 minimum_offset, maximum_offset;
+};
+
+struct visibility_search
+{
+	std::vector<short> reached;
+	std::vector<visibility_frame> frames;
+	std::vector<world_point2d> left_points, right_points;
+	std::vector<bool> on_path;
+	std::vector<std::vector<visibility_ray_state> > ray_states;
+	int32 steps_left;
+};
+
+/* what the cache file is for; packed big-endian after the tag */
+struct polygon_visibility_cache_header
+{
+	uint32 version;
+	uint32 geometry_hash_low, geometry_hash_high;
+	int32 polygon_count, line_count, endpoint_count;
+	int32 row_words;
+};
+
+/* ---------- globals */
+
+static std::vector<uint32> visibility_rows;
+static std::vector<uint32> visibility_built; /* a bit for each polygon whose row is built */
+static size_t visibility_row_words= 0;
+static short visibility_polygon_count= 0; /* zero if there's no usable set */
+static uint64 visibility_geometry_hash= 0;
+static int32 visibility_left, visibility_right, visibility_top, visibility_bottom;
+static struct polygon_visibility_cache_header visibility_cache_header;
+static bool visibility_cache_dirty= false; /* rows built since the cache was read */
+static struct visibility_search visibility_search_state;
+static std::vector<std::vector<short> > visibility_endpoint_polygons; /* for the endpoint-sharing leniency */
+
+/* ---------- private prototypes */
+
+static uint64 calculate_geometry_hash(void);
+static bool calculate_visibility_bounds(void);
+static void build_visibility_row(short polygon_index);
+static bool find_visible_polygons(short polygon_index, uint32 *row, struct visibility_search& search);
+static bool ray_state_is_new(std::vector<visibility_ray_state>& states, const visibility_vector& normal,
+	const std::vector<world_point2d>& left_points, const std::vector<world_point2d>& right_points);
+static void constrain_visibility_cone(struct visibility_cone *cone, const world_point2d& e0,
+	const world_point2d& e1);
+static FileSpecifier get_visibility_cache_file(uint64 hash);
+static bool load_polygon_visibility_cache(void);
+static void save_polygon_visibility_cache(void);
+
+/* ---------- code */
+
+void precalculate_polygon_visibility(
+	void)
+{
+	uint64 hash= calculate_geometry_hash();
+
+	if (visibility_polygon_count && hash==visibility_geometry_hash &&
+		visibility_polygon_count==dynamic_world->polygon_count)
+	{
+		/* same level again (reverting, or a film keyframe) */
+		return;
+	}
+
+	/* keep what the last level built */
+	if (visibility_polygon_count && visibility_cache_dirty) save_polygon_visibility_cache();
+
+	visibility_polygon_count= 0;
+	visibility_rows.clear();
+	visibility_built.clear();
+	visibility_endpoint_polygons.clear();
+	visibility_cache_dirty= false;
+	visibility_geometry_hash= hash;
+
+	if (dynamic_world->polygon_count<=1 || dynamic_world->polygon_count>MAXIMUM_POLYGONS_FOR_VISIBILITY) return;
+	if (!calculate_visibility_bounds()) return;
+
+	short polygon_count= dynamic_world->polygon_count;
+	visibility_row_words= (polygon_count+31)/32;
+	visibility_cache_header.version= POLYGON_VISIBILITY_CACHE_VERSION;
+	visibility_cache_header.geometry_hash_low= (uint32)hash;
+	visibility_cache_header.geometry_hash_high= (uint32)(hash>>32);
+	visibility_cache_header.polygon_count= polygon_count;
+	visibility_cache_header.line_count= dynamic_world->line_count;
+	visibility_cache_header.endpoint_count= dynamic_world->endpoint_count;
+	visibility_cache_header.row_words= (int32)visibility_row_words;
+
+	if (!load_polygon_visibility_cache())
+	{
+		visibility_rows.assign(polygon_count*visibility_row_words, 0);
+		visibility_built.assign(visibility_row_words, 0);
+	}
+
+	/* polygons by endpoint, for the endpoint-sharing leniency */
+	visibility_endpoint_polygons.resize(dynamic_world->endpoint_count);
+	for (short i= 0; i<polygon_count; ++i)
+	{
+		struct polygon_data *polygon= get_polygon_data(i);
+
+		for (short j= 0; j<polygon->vertex_count; ++j)
+		{
+			short endpoint_index= polygon->endpoint_indexes[j];
+			if (endpoint_index>=0 && endpoint_index<dynamic_world->endpoint_count)
+			{
+				visibility_endpoint_polygons[endpoint_index].push_back(i);
+			}
+		}
+	}
+
+	struct visibility_search& search= visibility_search_state;
+	search.reached.clear();
+	search.on_path.assign(polygon_count, false);
+	search.ray_states.assign(polygon_count, std::vector<visibility_ray_state>());
+	search.steps_left= MAXIMUM_VISIBILITY_STEPS;
+
+	visibility_polygon_count= polygon_count;
+}
+
+bool polygon_is_potentially_visible(
+	short polygon_index1,
+	world_point2d *p1,
+	short polygon_index2,
+	world_point2d *p2)
+{
+	if (!visibility_polygon_count) return true;
+	if (polygon_index1<0 || polygon_index1>=visibility_polygon_count) return true;
+	if (polygon_index2<0 || polygon_index2>=visibility_polygon_count) return true;
+
+	/* a zero-length walk has no direction to constrain it */
+	if (p1->x==p2->x && p1->y==p2->y) return true;
+	if (p1->x<visibility_left || p1->x>visibility_right || p1->y<visibility_top || p1->y>visibility_bottom) return true;
+	if (p2->x<visibility_left || p2->x>visibility_right || p2->y<visibility_top || p2->y>visibility_bottom) return true;
+
+	if (!(visibility_built[polygon_index1>>5]&((uint32)1<<(polygon_index1&31))))
+	{
+		/* out of time for this level */
+		if (visibility_search_state.steps_left<=0) return true;
+		build_visibility_row(polygon_index1);
+		if (!(visibility_built[polygon_index1>>5]&((uint32)1<<(polygon_index1&31)))) return true;
+	}
+
+	const uint32 *row= &visibility_rows[polygon_index1*visibility_row_words];
+	return (row[polygon_index2>>5]&((uint32)1<<(polygon_index2&31))) ? true : false;
+}
+
+/* ---------- private code */
+
+static uint64 calculate_geometry_hash(
+	void)
+{
+	uint64 hash= UINT64_C(14695981039346656037);
+
+#define HASH_VALUE(v) do { hash^= (uint16)(v); hash*= UINT64_C(1099511628211); } while (0)
+	HASH_VALUE(dynamic_world->polygon_count);
+	HASH_VALUE(dynamic_world->line_count);
+	HASH_VALUE(dynamic_world->endpoint_count);
+	for (short i= 0; i<dynamic_world->polygon_count; ++i)
+	{
+		struct polygon_data *polygon= get_polygon_data(i);
+
+		HASH_VALUE(polygon->vertex_count);
+		for (short j= 0; j<polygon->vertex_count; ++j)
+		{
+			HASH_VALUE(polygon->endpoint_indexes[j]);
+			HASH_VALUE(polygon->line_indexes[j]);
+		}
+	}
+	for (short i= 0; i<dynamic_world->line_count; ++i)
+	{
+		struct line_data *line= get_line_data(i);
+
+		HASH_VALUE(line->clockwise_polygon_owner);
+		HASH_VALUE(line->counterclockwise_polygon_owner);
+	}
+	for (short i= 0; i<dynamic_world->endpoint_count; ++i)
+	{
+		struct endpoint_data *endpoint= get_endpoint_data(i);
+
+		HASH_VALUE(endpoint->vertex.x);
+		HASH_VALUE(endpoint->vertex.y);
+	}
+#undef HASH_VALUE
+
+	return hash;
+}
+
+static bool calculate_visibility_bounds(
+	void)
+{
+	if (!dynamic_world->endpoint_count) return false;
+
+	int32 left= INT32_MAX, right= INT32_MIN, top= INT32_MAX, bottom= INT32_MIN;
+	for (short i= 0; i<dynamic_world->endpoint_count; ++i)
+	{
+		world_point2d *vertex= &get_endpoint_data(i)->vertex;
+
+		left= MIN(left, vertex->x), right= MAX(right, vertex->x);
+		top= MIN(top, vertex->y), bottom= MAX(bottom, vertex->y);
+	}
+
+	visibility_left= left-VISIBILITY_BOUNDS_MARGIN, visibility_right= right+VISIBILITY_BOUNDS_MARGIN;
+	visibility_top= top-VISIBILITY_BOUNDS_MARGIN, visibility_bottom= bottom+VISIBILITY_BOUNDS_MARGIN;
+
+	return visibility_right-visibility_left<=MAXIMUM_VISIBILITY_EXTENT &&
+		visibility_bottom-visibility_top<=MAXIMUM_VISIBILITY_EXTENT;
+}
+
+static void build_visibility_row(
+	short polygon_index)
+{
+	struct visibility_search& search= visibility_search_state;
+	uint32 *row= &visibility_rows[polygon_index*visibility_row_words];
+	bool out_of_time= search.steps_left<MAXIMUM_VISIBILITY_STEPS_PER_POLYGON;
+
+	if (!find_visible_polygons(polygon_index, row, search))
+	{
+		if (out_of_time)
+		{
+			/* the level's budget ran out, not this polygon's; nothing to keep */
+			for (size_t word= 0; word<visibility_row_words; ++word) row[word]= 0;
+			search.steps_left= 0;
+			logNote("polygon visibility: out of time after polygon %d", polygon_index);
+			return;
+		}
+
+		for (size_t word= 0; word<visibility_row_words; ++word) row[word]= ~(uint32)0;
+	}
+	else
+	{
+		for (size_t j= 0; j<search.reached.size(); ++j)
+		{
+			struct polygon_data *polygon= get_polygon_data(search.reached[j]);
+
+			for (short k= 0; k<polygon->vertex_count; ++k)
+			{
+				short endpoint_index= polygon->endpoint_indexes[k];
+				if (endpoint_index<0 || endpoint_index>=dynamic_world->endpoint_count) continue;
+
+				std::vector<short>& neighbors= visibility_endpoint_polygons[endpoint_index];
+				for (size_t n= 0; n<neighbors.size(); ++n)
+				{
+					row[neighbors[n]>>5]|= (uint32)1<<(neighbors[n]&31);
+				}
+			}
+		}
+	}
+
+	visibility_built[polygon_index>>5]|= (uint32)1<<(polygon_index&31);
+	visibility_cache_dirty= true;
+}
+
+/* depth-first through every simple chain of edges leaving polygon_index that one line can
+	cross; returns false if that took too long */
+static bool find_visible_polygons(
+	short polygon_index,
+	uint32 *row,
+	struct visibility_search& search)
+{
+	std::vector<visibility_frame>& frames= search.frames;
+	std::vector<world_point2d>& left_points= search.left_points;
+	std::vector<world_point2d>& right_points= search.right_points;
+	int32 steps= MIN((int32)MAXIMUM_VISIBILITY_STEPS_PER_POLYGON, search.steps_left);
+	bool finished= true;
+
+	for (size_t i= 0; i<search.reached.size(); ++i) search.ray_states[search.reached[i]].clear();
+	search.reached.clear();
+	frames.clear();
+	left_points.clear();
+	right_points.clear();
+
+	search.reached.push_back(polygon_index);
+	row[polygon_index>>5]|= (uint32)1<<(polygon_index&31);
+	search.on_path[polygon_index]= true;
+
+	visibility_frame first;
+	first.polygon_index= polygon_index;
+	first.next_edge= 0;
+	first.cone.kind= _cone_full;
+	frames.push_back(first);
+
+	while (!frames.empty())
+	{
+		size_t depth= frames.size()-1;
+		struct polygon_data *polygon= get_polygon_data(frames[depth].polygon_index);
+
+		if (!finished || frames[depth].next_edge>=polygon->vertex_count)
+		{
+			search.on_path[frames[depth].polygon_index]= false;
+			frames.pop_back();
+			if (depth)
+			{
+				left_points.pop_back();
+				right_points.pop_back();
+			}
+			continue;
+		}
+
+		short edge= frames[depth].next_edge++;
+		short line_index= polygon->line_indexes[edge];
+		if (line_index<0 || line_index>=dynamic_world->line_count) continue;
+
+		/* find_adjacent_polygon(), without its assertion */
+		struct line_data *line= get_line_data(line_index);
+		short adjacent_polygon_index= (frames[depth].polygon_index==line->clockwise_polygon_owner) ?
+			line->counterclockwise_polygon_owner : line->clockwise_polygon_owner;
+		if (adjacent_polygon_index<0 || adjacent_polygon_index>=dynamic_world->polygon_count) continue;
+		if (search.on_path[adjacent_polygon_index]) continue; /* a straight line can't come back */
+
+		world_point2d& e0= get_endpoint_data(polygon->endpoint_indexes[edge])->vertex;
+		world_point2d& e1= get_endpoint_data(polygon->endpoint_indexes[edge==polygon->vertex_count-1 ? 0 : edge+1])->vertex;
+
+		struct visibility_cone cone= frames[depth].cone;
+		constrain_visibility_cone(&cone, e0, e1);
+		for (size_t i= 0; i<left_points.size() && cone.kind!=_cone_empty; ++i)
+		{
+			constrain_visibility_cone(&cone, e0, right_points[i]);
+			constrain_visibility_cone(&cone, left_points[i], e1);
+		}
+		if (cone.kind==_cone_empty) continue;
+
+		if (!(row[adjacent_polygon_index>>5]&((uint32)1<<(adjacent_polygon_index&31))))
+		{
+			row[adjacent_polygon_index>>5]|= (uint32)1<<(adjacent_polygon_index&31);
+			search.reached.push_back(adjacent_polygon_index);
+		}
+
+		left_points.push_back(e0);
+		right_points.push_back(e1);
+
+		if (cone.kind==_cone_ray &&
+			!ray_state_is_new(search.ray_states[adjacent_polygon_index], cone.lo, left_points, right_points))
+		{
+			left_points.pop_back();
+			right_points.pop_back();
+			continue;
+		}
+
+		if (--steps<0)
+		{
+			finished= false;
+			left_points.pop_back();
+			right_points.pop_back();
+			continue;
+		}
+
+		search.on_path[adjacent_polygon_index]= true;
+
+		visibility_frame next;
+		next.polygon_index= adjacent_polygon_index;
+		next.next_edge= 0;
+		next.cone= cone;
+		frames.push_back(next);
+	}
+
+	search.steps_left-= MIN((int32)MAXIMUM_VISIBILITY_STEPS_PER_POLYGON, search.steps_left)-MAX(steps, 0);
+	return finished;
+}
+
+/* records the chain's offset range for this normal unless one we've followed already covers it */
+static bool ray_state_is_new(
+	std::vector<visibility_ray_state>& states,
+	const visibility_vector& normal,
+	const std::vector<world_point2d>& left_points,
+	const std::vector<world_point2d>& right_points)
+{
+	int64 a= normal.x<0 ? -normal.x : normal.x, b= normal.y<0 ? -normal.y : normal.y;
+	while (b) { int64 t= a%b; a= b; b= t; }
+
+	visibility_ray_state state;
+	state.normal_x= normal.x/a;
+	state.normal_y= normal.y/a;
+
+	/* n.e0+c >= 0 for every left point and n.e1+c <= 0 for every right point */
+	state.minimum_offset= INT64_MIN;
+	state.maximum_offset= INT64_MAX;
+	for (size_t i= 0; i<left_points.size(); ++i)
+	{
+		state.minimum_offset= MAX(state.minimum_offset, -(state.normal_x*left_points[i].x + state.normal_y*left_points[i].y));
+		state.maximum_offset= MIN(state.maximum_offset, -(state.normal_x*right_points[i].x + state.normal_y*right_points[i].y));
+	}
+
+	for (size_t i= 0; i<states.size(); ++i)
+	{
+		if (states[i].normal_x==state.normal_x && states[i].normal_y==state.normal_y &&
+			states[i].minimum_offset<=state.minimum_offset && states[i].maximum_offset>=state.maximum_offset)
+		{
+			return false;
+		}
+	}
+
+	states.push_back(state);
+	return true;
+}
+
+static inline int64 visibility_dot(
+	const visibility_vector& a,
+	const visibility_vector& b)
+{
+	return a.x*b.x + a.y*b.y;
+}
+
+static inline int64 visibility_cross(
+	const visibility_vector& a,
+	const visibility_vector& b)
+{
+	return a.x*b.y - a.y*b.x;
+}
+
+static inline bool visibility_ray_in_sweep(
+	const visibility_vector& r,
+	const struct visibility_cone *cone)
+{
+	return visibility_cross(cone->lo, r)>=0 && visibility_cross(r, cone->hi)>=0;
+}
+
+/* intersect the cone with the half-plane n.(e0-e1) >= 0 */
+static void constrain_visibility_cone(
+	struct visibility_cone *cone,
+	const world_point2d& e0,
+	const world_point2d& e1)
+{
+	visibility_vector v;
+	v.x= (int64)e0.x - e1.x;
+	v.y= (int64)e0.y - e1.y;
+	if (!v.x && !v.y) return;
+
+	/* the boundary rays of the half-plane, clockwise and counterclockwise of v */
+	visibility_vector clockwise, counterclockwise;
+	clockwise.x= v.y, clockwise.y= -v.x;
+	counterclockwise.x= -v.y, counterclockwise.y= v.x;
+
+	switch (cone->kind)
+	{
+		case _cone_full:
+			cone->kind= _cone_sweep;
+			cone->lo= clockwise;
+			cone->hi= counterclockwise;
+			break;
+
+		case _cone_ray:
+			if (visibility_dot(cone->lo, v)<0) cone->kind= _cone_empty;
+			break;
+
+		case _cone_line:
+		{
+			int64 dot= visibility_dot(cone->lo, v);
+
+			if (dot>0)
+			{
+				cone->kind= _cone_ray;
+			}
+			else if (dot<0)
+			{
+				cone->kind= _cone_ray;
+				cone->lo.x= -cone->lo.x, cone->lo.y= -cone->lo.y;
+			}
+			break;
+		}
+
+		case _cone_sweep:
+		{
+			bool lo_inside= visibility_dot(cone->lo, v)>=0;
+			bool hi_inside= visibility_dot(cone->hi, v)>=0;
+
+			if (lo_inside && hi_inside)
+			{
+				/* a half-plane whose boundary is v's boundary keeps either itself or the boundary */
+				if (visibility_cross(cone->lo, cone->hi)==0)
+				{
+					visibility_vector middle;
+					middle.x= -cone->lo.y, middle.y= cone->lo.x;
+					if (visibility_dot(middle, v)<0) cone->kind= _cone_line;
+				}
+			}
+			else if (lo_inside)
+			{
+				cone->hi= visibility_ray_in_sweep(clockwise, cone) ? clockwise : counterclockwise;
+				if (visibility_cross(cone->lo, cone->hi)==0) cone->kind= _cone_ray;
+			}
+			else if (hi_inside)
+			{
+				cone->lo= visibility_ray_in_sweep(clockwise, cone) ? clockwise : counterclockwise;
+				if (visibility_cross(cone->lo, cone->hi)==0)
+				{
+					cone->kind= _cone_ray;
+					cone->lo= cone->hi;
+				}
+			}
+			else
+			{
+				cone->kind= _cone_empty;
+			}
+			break;
+		}
+	}
+}
+
+static FileSpecifier get_visibility_cache_file(
+	uint64 hash)
+{
+	char name[32];
+	sprintf(name, "%08x%08x.pvs", (uint32)(hash>>32), (uint32)hash);
+
+	DirectorySpecifier directory= local_data_dir;
+	directory+= "PVS Cache";
+	directory.CreateDirectory();
+
+	return directory+name;
+}
+
+static bool load_polygon_visibility_cache(
+	void)
+{
+	uint64 hash= ((uint64)visibility_cache_header.geometry_hash_high<<32) | visibility_cache_header.geometry_hash_low;
+	FileSpecifier file= get_visibility_cache_file(hash);
+	OpenedFile opened_file;
+	int32 length;
+	if (!file.Exists() || !file.Open(opened_file, false, false) || !opened_file.GetLength(length)) return false;
+	if (length<SIZEOF_polygon_visibility_cache_header) return false;
+
+	std::vector<uint8> buffer(length);
+	if (!opened_file.Read(length, &buffer[0])) return false;
+
+	size_t row_words= visibility_row_words;
+	std::vector<uint32> rows(visibility_cache_header.polygon_count*row_words, 0);
+	std::vector<uint32> built(row_words, 0);
+
+	AIStreamBE stream(&buffer[0], length);
+	try
+	{
+		uint32 tag;
+		struct polygon_visibility_cache_header header;
+		stream >> tag >> header.version;
+		if (tag!=POLYGON_VISIBILITY_CACHE_TAG || header.version!=POLYGON_VISIBILITY_CACHE_VERSION) return false;
+
+		stream >> header.geometry_hash_low >> header.geometry_hash_high;
+		stream >> header.polygon_count >> header.line_count >> header.endpoint_count;
+		stream >> header.row_words;
+		if (header.geometry_hash_low!=visibility_cache_header.geometry_hash_low ||
+			header.geometry_hash_high!=visibility_cache_header.geometry_hash_high ||
+			header.polygon_count!=visibility_cache_header.polygon_count ||
+			header.line_count!=visibility_cache_header.line_count ||
+			header.endpoint_count!=visibility_cache_header.endpoint_count ||
+			header.row_words!=visibility_cache_header.row_words)
+		{
+			return false;
+		}
+
+		/* which rows are there, then those rows in order */
+		stream.read(&built[0], row_words);
+		for (short i= 0; i<header.polygon_count; ++i)
+		{
+			if (built[i>>5]&((uint32)1<<(i&31))) stream.read(&rows[i*row_words], row_words);
+		}
+	}
+	catch (const AStream::failure&)
+	{
+		return false;
+	}
+	if (stream.tellg()!=stream.maxg()) return false;
+
+	visibility_rows.swap(rows);
+	visibility_built.swap(built);
+	return true;
+}
+
+static void save_polygon_visibility_cache(
+	void)
+{
+	const struct polygon_visibility_cache_header& header= visibility_cache_header;
+	size_t row_words= visibility_row_words;
+
+	size_t built_count= 0;
+	for (short i= 0; i<header.polygon_count; ++i)
+	{
+		if (visibility_built[i>>5]&((uint32)1<<(i&31))) ++built_count;
+	}
+
+	std::vector<uint8> buffer(SIZEOF_polygon_visibility_cache_header + (1+built_count)*row_words*sizeof(uint32));
+	AOStreamBE stream(&buffer[0], buffer.size());
+	try
+	{
+		stream << POLYGON_VISIBILITY_CACHE_TAG << header.version;
+		stream << header.geometry_hash_low << header.geometry_hash_high;
+		stream << header.polygon_count << header.line_count << header.endpoint_count;
+		stream << header.row_words;
+
+		stream.write(&visibility_built[0], row_words);
+		for (short i= 0; i<header.polygon_count; ++i)
+		{
+			if (visibility_built[i>>5]&((uint32)1<<(i&31))) stream.write(&visibility_rows[i*row_words], row_words);
+		}
+	}
+	catch (const AStream::failure&)
+	{
+		return;
+	}
+	assert(stream.tellp()==buffer.size());
+
+	uint64 hash= ((uint64)header.geometry_hash_high<<32) | header.geometry_hash_low;
+	FileSpecifier file= get_visibility_cache_file(hash);
+	OpenedFile opened_file;
+	if (!file.Create(_typecode_unknown) || !file.Open(opened_file, true, false))
+	{
+		logWarning("couldn't write polygon visibility cache %s", file.GetPath());
+		return;
+	}
+
+	if (!opened_file.Write(buffer.size(), &buffer[0]))
+	{
+		opened_file.Close();
+		file.Delete();
+	}
+}
@@ -0,0 +1,42 @@
+#ifndef __POLYGON_VISIBILITY_H
+#define __POLYGON_VISIBILITY_H
+
+/*
+	POLYGON_VISIBILITY.H
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+
+	A conservative polygon-to-polygon potential visibility set, used to reject
+	line_is_obstructed() and clear_line_of_sight() queries without walking the map.
+	A pair is only marked invisible if no straight line could carry either walk from
+	the first polygon to the second, so the answers (and films) never change.
+*/
+
+#include "cstypes.h"
+#include "world.h"
+
+// called by precalculate_map_indexes() and when loading a map with precalculated indexes;
+// sets up an empty set (rows are built as queries need them), reusing the previous level's
+// or the on-disk cache's rows when the geometry hasn't changed
+void precalculate_polygon_visibility(void);
+
+// false if a line walked from p1 in polygon_index1 to p2 cannot end in (or, with the
+// Infinity line_is_obstructed() fix, next to) polygon_index2
+bool polygon_is_potentially_visible(short polygon_index1, world_point2d *p1,
+	short polygon_index2, world_point2d *p2);
+
+#endif
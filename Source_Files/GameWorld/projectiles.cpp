@@ -79,6 +79,10 @@ Aug 30, 2000 (Loren Petrich):
 	
 Oct 13, 2000 (Loren Petrich)
 	Converted the intersected-objects list into a Standard Template Library vector
+
+Oct 17, 2026:
+	Added move_predicted_projectiles(), so network prediction can carry a player's own
+	shots forward along with the player
 */
 
 #include "cseries.h"
@@ -131,6 +135,8 @@ enum /* things the projectile can hit in detonate_projectile() */
 
 /* ---------- private prototypes */
 
+static void update_projectile_gravity(struct projectile_data *projectile, struct projectile_definition *definition, int32 tick);
+
 /* ---------- globals */
 
 /* import projectile definition structures, constants and globals */
@@ -298,6 +304,7 @@ short new_projectile(
 				projectile->distance_travelled= 0;
 				projectile->damage_scale= damage_scale;
 				MARK_SLOT_AS_USED(projectile);
+				ActiveProjectiles.add(projectile_index);
 
 				SET_OBJECT_OWNER(object, _object_is_projectile);
 				object->sound_pitch= definition->sound_pitch;
@@ -323,8 +330,9 @@ void move_projectiles(
 	struct projectile_data *projectile;
 	short projectile_index;
 	
-	for (projectile_index=0,projectile=projectiles;projectile_index<MAXIMUM_PROJECTILES_PER_MAP;++projectile_index,++projectile)
+	for (projectile_index= ActiveProjectiles.next(NONE); projectile_index!=NONE; projectile_index= ActiveProjectiles.next(projectile_index))
 	{
+		projectile= projectiles+projectile_index;
 		if (SLOT_IS_USED(projectile))
 		{
 			struct object_data *object= get_object_data(projectile->object_index);
@@ -371,13 +379,7 @@ void move_projectiles(
 					
 					/* move the projectile and check for collisions; if we didnt detonate move the
 						projectile and check to see if we need to leave a contrail */
-					if ((definition->flags&_affected_by_half_gravity) && (dynamic_world->tick_count&1)) projectile->gravity-= GRAVITATIONAL_ACCELERATION;
-					if (definition->flags&_affected_by_gravity) projectile->gravity-= GRAVITATIONAL_ACCELERATION;
-					if (definition->flags&_doubly_affected_by_gravity) projectile->gravity-= 2*GRAVITATIONAL_ACCELERATION;
-					if (film_profile.m1_low_gravity_projectiles && static_world->environment_flags&_environment_low_gravity && static_world->environment_flags&_environment_m1_weapons)
-					{
-						projectile->gravity /= 2;
-					}
+					update_projectile_gravity(projectile, definition, dynamic_world->tick_count);
 					new_location.z+= projectile->gravity;
 					translate_point3d(&new_location, speed, object->facing, projectile->elevation);
 					if (definition->flags&_vertical_wander) new_location.z+= (global_random()&1) ? WANDER_MAGNITUDE : -WANDER_MAGNITUDE;
@@ -576,6 +578,67 @@ void move_projectiles(
 	}
 }
 
+/* prediction: fly the given monster's projectiles along their paths for one tick without
+	letting them hit anything; whatever would detonate just waits for the real update.
+	random and target-seeking projectiles are left alone, because moving them would
+	touch state the prediction undo log doesn't cover. */
+void move_predicted_projectiles(
+	short owner_index,
+	int32 tick)
+{
+	struct projectile_data *projectile;
+	short projectile_index;
+	
+	if (owner_index==NONE) return;
+	
+	for (projectile_index= ActiveProjectiles.next(NONE); projectile_index!=NONE; projectile_index= ActiveProjectiles.next(projectile_index))
+	{
+		projectile= projectiles+projectile_index;
+		if (SLOT_IS_USED(projectile) && projectile->owner_index==owner_index)
+		{
+			struct projectile_definition *definition= get_projectile_definition(projectile->type);
+			struct object_data *object= get_object_data(projectile->object_index);
+			world_point3d new_location, old_location;
+			short obstruction_index, new_polygon_index;
+			uint16 flags;
+			
+			if (definition->flags&(_guided|_vertical_wander|_horizontal_wander|_usually_pass_transparent_side|_sometimes_pass_transparent_side)) continue;
+			/* nor do we fly anything past the end of its range */
+			if (definition->maximum_range!=NONE && projectile->distance_travelled + (tick - dynamic_world->tick_count + 1)*definition->speed>=definition->maximum_range) continue;
+			
+			record_predicted_field(projectile->gravity);
+			update_projectile_gravity(projectile, definition, tick);
+			
+			new_location= old_location= object->location;
+			new_location.z+= projectile->gravity;
+			translate_point3d(&new_location, definition->speed, object->facing, projectile->elevation);
+			/* as a preflight, so that it can't toggle control panels: the undo log can't take that back */
+			flags= translate_projectile(projectile->type, &old_location, object->polygon, &new_location, &new_polygon_index, projectile->owner_index, &obstruction_index, 0, true, projectile_index);
+			
+			if (!(flags&_projectile_hit))
+			{
+				record_predicted_field(object->location);
+				record_predicted_field(object->polygon);
+				translate_map_object(projectile->object_index, &new_location, new_polygon_index);
+			}
+		}
+	}
+}
+
+static void update_projectile_gravity(
+	struct projectile_data *projectile,
+	struct projectile_definition *definition,
+	int32 tick)
+{
+	if ((definition->flags&_affected_by_half_gravity) && (tick&1)) projectile->gravity-= GRAVITATIONAL_ACCELERATION;
+	if (definition->flags&_affected_by_gravity) projectile->gravity-= GRAVITATIONAL_ACCELERATION;
+	if (definition->flags&_doubly_affected_by_gravity) projectile->gravity-= 2*GRAVITATIONAL_ACCELERATION;
+	if (film_profile.m1_low_gravity_projectiles && static_world->environment_flags&_environment_low_gravity && static_world->environment_flags&_environment_m1_weapons)
+	{
+		projectile->gravity /= 2;
+	}
+}
+
 void remove_projectile(
 	short projectile_index)
 {
@@ -583,6 +646,7 @@ void remove_projectile(
 	L_Invalidate_Projectile(projectile_index);
 	remove_map_object(projectile->object_index);
 	MARK_SLOT_AS_FREE(projectile);
+	ActiveProjectiles.remove(projectile_index);
 }
 
 void remove_all_projectiles(
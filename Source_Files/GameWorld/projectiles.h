@@ -44,6 +44,7 @@ Jan 6, 2001 (Loren Petrich):
 // LP addition:
 #include "dynamic_limits.h"
 #include "world.h" // for angle
+#include "ActiveSlotList.h"
 
 #include <vector>
 
@@ -157,6 +158,9 @@ enum /* translate_projectile() flags */
 extern std::vector<projectile_data> ProjectileList;
 #define projectiles (ProjectileList.data())
 
+// the used slots of ProjectileList, in slot order
+extern ActiveSlotList ActiveProjectiles;
+
 // extern struct projectile_data *projectiles;
 
 /* ---------- prototypes/PROJECTILES.C */
@@ -175,6 +179,7 @@ void detonate_projectile(world_point3d *origin, short polygon_index, short type,
 uint16 translate_projectile(short type, world_point3d *old_location, short old_polygon_index, world_point3d *new_location, short *new_polygon_index, short owner_index, short *obstruction_index, short *last_line_index, bool preflight, short projectile_indexx);
 
 void move_projectiles(void); /* assumes t==1 tick */
+void move_predicted_projectiles(short owner_index, int32 tick);
 
 void remove_projectile(short projectile_index);
 void remove_all_projectiles(void);
@@ -49,6 +49,19 @@ static inline int luaL_typerror(lua_State* L, int narg, const char* tname)
 	return 0;  // satisfy compiler
 }
 
+// the C function at index, if it has no upvalues of its own and so can be called
+// straight from another C function's stack frame; otherwise 0
+static inline lua_CFunction L_Plain_CFunction(lua_State* L, int index)
+{
+	lua_CFunction f = lua_tocfunction(L, index);
+	if (f && lua_getupvalue(L, index, 1))
+	{
+		lua_pop(L, 1);
+		return 0;
+	}
+	return f;
+}
+
 // helper functions for finding the script's data path
 // not in lua_script.h because they expose lua_State
 extern void L_Set_Search_Path(lua_State* L, const std::string& path);
@@ -127,6 +140,21 @@ protected:
 
 	// special tables
 	static void _push_custom_fields_table(lua_State *L);
+
+	// __index and __newindex functions are closures over the get (or set) methods table
+	// and the metatable, so _get and _set don't look them up on every access
+	static void _push_get_closure(lua_State *L, lua_CFunction f) {
+		_push_closure(L, f, _push_get_methods_key);
+	}
+
+	static void _push_set_closure(lua_State *L, lua_CFunction f) {
+		_push_closure(L, f, _push_set_methods_key);
+	}
+
+private:
+	static void _push_closure(lua_State *L, lua_CFunction f, void (*push_methods_key)(lua_State *));
+	static void _push_methods_table(lua_State *L, void (*push_methods_key)(lua_State *));
+	static void _check_instance(lua_State *L, int index);
 };
 
 struct always_valid
@@ -148,27 +176,6 @@ void L_Class<name, index_t>::Register(lua_State *L, const luaL_Reg get[], const
 	lua_pushstring(L, name);
 	lua_settable(L, LUA_REGISTRYINDEX);
 
-	// register metatable get
-	lua_pushcfunction(L, _get);
-	lua_setfield(L, -2, "__index");
-
-	// register metatable set
-	lua_pushcfunction(L, _set);
-	lua_setfield(L, -2, "__newindex");
-
-	// register metatable tostring
-	lua_pushcfunction(L, _tostring);
-	lua_setfield(L, -2, "__tostring");
-
-	lua_pushcfunction(L, _new);
-	lua_setfield(L, -2, "__new");
-
-	if (metatable)
-		luaL_setfuncs(L, metatable, 0);
-	
-	// clear the stack
-	lua_pop(L, 1);
-	
 	// register get methods
 	_push_get_methods_key(L);
 	lua_newtable(L);
@@ -188,6 +195,27 @@ void L_Class<name, index_t>::Register(lua_State *L, const luaL_Reg get[], const
 	if (set)
 		luaL_setfuncs(L, set, 0);
 	lua_settable(L, LUA_REGISTRYINDEX);
+
+	// register metatable get
+	_push_get_closure(L, _get);
+	lua_setfield(L, -2, "__index");
+
+	// register metatable set
+	_push_set_closure(L, _set);
+	lua_setfield(L, -2, "__newindex");
+
+	// register metatable tostring
+	lua_pushcfunction(L, _tostring);
+	lua_setfield(L, -2, "__tostring");
+
+	lua_pushcfunction(L, _new);
+	lua_setfield(L, -2, "__new");
+
+	if (metatable)
+		luaL_setfuncs(L, metatable, 0);
+	
+	// clear the stack
+	lua_pop(L, 1);
 		
 	// register a table for instances
 	_push_instances_key(L);
@@ -352,7 +380,7 @@ int L_Class<name, index_t>::_get(lua_State *L)
 	if (lua_isstring(L, 2))
 	{
 		luaL_checktype(L, 1, LUA_TUSERDATA);
-		luaL_checkudata(L, 1, name);
+		_check_instance(L, 1);
 		if (!Valid(Index(L, 1)) && strcmp(lua_tostring(L, 2), "valid") != 0 && strcmp(lua_tostring(L, 2), "index") != 0)
 			luaL_error(L, "invalid object");
 
@@ -378,15 +406,26 @@ int L_Class<name, index_t>::_get(lua_State *L)
 		else
 		{
 			// pop the get table
-			_push_get_methods_key(L);
-			lua_gettable(L, LUA_REGISTRYINDEX);
+			_push_methods_table(L, _push_get_methods_key);
 
 			// get the function from that table
 			lua_pushvalue(L, 2);
-			lua_gettable(L, -2);
+			lua_rawget(L, -2);
 			lua_remove(L, -2);
-		
-			if (lua_isfunction(L, -1))
+
+			lua_CFunction getter = L_Plain_CFunction(L, -1);
+			if (getter)
+			{
+				// call it in place, with the stack it would get from lua_pcall; its
+				// errors already carry the script's line, as the rethrow below adds
+				lua_settop(L, 1);
+				int results = getter(L);
+				if (results == 0)
+					lua_pushnil(L);
+				else if (results > 1)
+					lua_pop(L, results - 1);
+			}
+			else if (lua_isfunction(L, -1))
 			{
 				// execute the function with table as our argument
 				lua_pushvalue(L, 1);
@@ -434,7 +473,7 @@ template<char *name, typename index_t>
 int L_Class<name, index_t>::_set(lua_State *L)
 {
 	luaL_checktype(L, 1, LUA_TUSERDATA);
-	luaL_checkudata(L, 1, name);
+	_check_instance(L, 1);
 
 	if (lua_isstring(L, 2) && lua_tostring(L, 2)[0] == '_')
 	{
@@ -469,17 +508,26 @@ int L_Class<name, index_t>::_set(lua_State *L)
 	else
 	{
 		// pop the set table
-		_push_set_methods_key(L);
-		lua_gettable(L, LUA_REGISTRYINDEX);
+		_push_methods_table(L, _push_set_methods_key);
 		
 		// get the function from that table
 		lua_pushvalue(L, 2);
-		lua_gettable(L, -2);
+		lua_rawget(L, -2);
 		
 		if (lua_isnil(L, -1))
 		{
 			luaL_error(L, "no such index");
 		}
+
+		lua_CFunction setter = L_Plain_CFunction(L, -1);
+		if (setter)
+		{
+			// call it in place with (table, value), as lua_pcall would
+			lua_settop(L, 3);
+			lua_remove(L, 2);
+			setter(L);
+			return 0;
+		}
 		
 		// execute the function with table, value as our arguments
 		lua_pushvalue(L, 1);
@@ -509,6 +557,45 @@ int L_Class<name, index_t>::_tostring(lua_State *L)
 }
 
 
+template<char *name, typename index_t>
+void L_Class<name, index_t>::_push_closure(lua_State *L, lua_CFunction f, void (*push_methods_key)(lua_State *))
+{
+	push_methods_key(L);
+	lua_gettable(L, LUA_REGISTRYINDEX);
+	luaL_getmetatable(L, name);
+	lua_pushcclosure(L, f, 2);
+}
+
+template<char *name, typename index_t>
+void L_Class<name, index_t>::_push_methods_table(lua_State *L, void (*push_methods_key)(lua_State *))
+{
+	// derived classes' __index functions call _get, and might not be our closures
+	if (lua_istable(L, lua_upvalueindex(1)))
+	{
+		lua_pushvalue(L, lua_upvalueindex(1));
+	}
+	else
+	{
+		push_methods_key(L);
+		lua_gettable(L, LUA_REGISTRYINDEX);
+	}
+}
+
+template<char *name, typename index_t>
+void L_Class<name, index_t>::_check_instance(lua_State *L, int index)
+{
+	// luaL_checkudata(), without fetching the metatable from the registry by name
+	if (lua_istable(L, lua_upvalueindex(2)) && lua_getmetatable(L, index))
+	{
+		bool matches = lua_rawequal(L, -1, lua_upvalueindex(2));
+		lua_pop(L, 1);
+		if (matches)
+			return;
+	}
+
+	luaL_checkudata(L, index, name);
+}
+
 template<char *name, typename index_t>
 void L_Class<name, index_t>::_push_custom_fields_table(lua_State *L)
 {
@@ -797,7 +884,7 @@ void L_Container<name, T>::Register(lua_State *L, const luaL_Reg get[], const lu
 	L_Class<name>::Register(L, get, set, metatable);
 	luaL_getmetatable(L, name);
 	
-	lua_pushcfunction(L, _get_container);
+	L_Class<name>::_push_get_closure(L, _get_container);
 	lua_setfield(L, -2, "__index");
 	
 	lua_pushcfunction(L, _call);
@@ -888,7 +975,7 @@ void L_EnumContainer<name, T>::Register(lua_State *L, const luaL_Reg methods[],
 	
 	luaL_getmetatable(L, name);
 
-	lua_pushcfunction(L, _get_enumcontainer);
+	L_Class<name>::_push_get_closure(L, _get_enumcontainer);
 	lua_setfield(L, -2, "__index");
 
 	lua_pop(L, 1);
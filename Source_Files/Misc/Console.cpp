@@ -40,6 +40,20 @@
 #include "FileHandler.h"
 #include "game_wad.h"
 
+// for benchmarking
+#include "map.h"
+#include "interface.h"
+#include "Mixer.h"
+#include "scottish_textures.h"
+#include "screen.h"
+#include "sdl_fonts.h"
+#ifdef HAVE_OPENGL
+#include "Dim3_Loader.h"
+#endif
+
+// for film seeking
+#include "vbl.h"
+
 #include <boost/algorithm/string/predicate.hpp>
 
 using namespace std;
@@ -51,6 +65,8 @@ Console::Console() : m_active(false), m_carnage_messages_exist(false), m_use_lua
 	m_command_iter = m_prev_commands.end();
 	m_carnage_messages.resize(NUMBER_OF_PROJECTILE_TYPES);
 	register_save_commands();
+	register_benchmark_commands();
+	register_replay_commands();
 }
 
 Console *Console::instance() {
@@ -451,6 +467,156 @@ void Console::register_save_commands()
 	register_command("save", saveParser);
 }
 	
+struct benchmark_collections
+{
+	void operator() (const std::string&) const {
+		uint32 streamed_ticks[3], bulk_ticks[3];
+		bool identical = benchmark_collection_loading(streamed_ticks, bulk_ticks);
+		logNote("collection loading benchmark: 8-bit streamed %u ms, bulk %u ms; 16-bit streamed %u ms, bulk %u ms; 32-bit streamed %u ms, bulk %u ms, %s", streamed_ticks[0], bulk_ticks[0], streamed_ticks[1], bulk_ticks[1], streamed_ticks[2], bulk_ticks[2], identical ? "identical" : "MISMATCH");
+		screen_printf("collections: streamed %u/%u/%u ms, bulk %u/%u/%u ms (%s)", streamed_ticks[0], streamed_ticks[1], streamed_ticks[2], bulk_ticks[0], bulk_ticks[1], bulk_ticks[2], identical ? "identical" : "MISMATCH");
+	}
+};
+
+#ifdef HAVE_OPENGL
+struct benchmark_models
+{
+	void operator() (const std::string& arg) const {
+		FileSpecifier File(arg);
+		Model3D Model;
+		Model3D::BuildTrigTables();
+		if (arg.empty() || !LoadModel_Dim3(File, Model, LoadModelDim3_First) || Model.TrueNumSeqs() == 0)
+		{
+			screen_printf("models: no animated Dim3 model at \"%s\"", arg.c_str());
+			return;
+		}
+		const int repeats = 8;
+		uint32 pose_count, scalar_ticks, vector_ticks, cached_ticks;
+		bool identical = Model.BenchmarkPosing(repeats, &pose_count, &scalar_ticks, &vector_ticks, &cached_ticks);
+		logNote("model posing benchmark: %d vertices, %u poses x %d, scalar %u ms, vector %u ms, vector+cache %u ms, %s", static_cast<int>(Model.VtxSrcIndices.size()), pose_count, repeats, scalar_ticks, vector_ticks, cached_ticks, identical ? "identical" : "MISMATCH");
+		screen_printf("models: scalar %u ms, vector %u ms, cached %u ms (%s)", scalar_ticks, vector_ticks, cached_ticks, identical ? "identical" : "MISMATCH");
+	}
+};
+#endif
+
+struct benchmark_polygon_lookup
+{
+	void operator() (const std::string&) const {
+		const int32 query_count = 100000;
+		uint32 linear_ticks, grid_ticks;
+		bool identical = benchmark_world_point_to_polygon_index(query_count, &linear_ticks, &grid_ticks);
+		logNote("polygon lookup benchmark: %d polygons, %d points, linear %u ms, grid %u ms, %s", dynamic_world->polygon_count, query_count, linear_ticks, grid_ticks, identical ? "identical" : "MISMATCH");
+		screen_printf("polygon lookup: linear %u ms, grid %u ms (%s)", linear_ticks, grid_ticks, identical ? "identical" : "MISMATCH");
+	}
+};
+
+struct benchmark_maps
+{
+	void operator() (const std::string& arg) const {
+		int level_count = atoi(arg.c_str());
+		if (level_count <= 0 || level_count > 1024)
+			level_count = 128;
+		uint32 file_ticks, view_ticks;
+		bool identical = benchmark_map_reading(level_count, &file_ticks, &view_ticks);
+		logNote("map reading benchmark: %d levels, file %u ms, view %u ms, %s", level_count, file_ticks, view_ticks, identical ? "identical" : "MISMATCH");
+		screen_printf("maps: file %u ms, view %u ms (%s)", file_ticks, view_ticks, identical ? "identical" : "MISMATCH");
+	}
+};
+
+struct benchmark_mixer
+{
+	void operator() (const std::string& arg) const {
+		int seconds = atoi(arg.c_str());
+		if (seconds <= 0)
+			seconds = 10;
+		const int channel_count = 16;
+		uint32 reference_ticks, scalar_ticks, vector_ticks;
+		bool identical = Mixer::instance()->BenchmarkMix(seconds, channel_count, &reference_ticks, &scalar_ticks, &vector_ticks);
+		logNote("mixer benchmark: %d channels, %d seconds, reference %u ms, scalar %u ms, vector %u ms, %s", channel_count, seconds, reference_ticks, scalar_ticks, vector_ticks, identical ? "identical" : "MISMATCH");
+		screen_printf("mixer: reference %u ms, scalar %u ms, vector %u ms (%s)", reference_ticks, scalar_ticks, vector_ticks, identical ? "identical" : "MISMATCH");
+	}
+};
+
+struct benchmark_screen
+{
+	void operator() (const std::string& arg) const {
+		int frames = atoi(arg.c_str());
+		if (frames <= 0)
+			frames = 200;
+		uint32 scalar_ticks, vector_ticks;
+		bool identical = benchmark_screen_blits(frames, &scalar_ticks, &vector_ticks);
+		logNote("screen blit benchmark: %d frames, scalar %u ms, vector %u ms, %s", frames, scalar_ticks, vector_ticks, identical ? "identical" : "MISMATCH");
+		screen_printf("screen: scalar %u ms, vector %u ms (%s)", scalar_ticks, vector_ticks, identical ? "identical" : "MISMATCH");
+	}
+};
+
+struct benchmark_spans
+{
+	void operator() (const std::string& arg) const {
+		int megapixels = atoi(arg.c_str());
+		if (megapixels <= 0)
+			megapixels = 500;
+		// the pixel count has to fit in an int32
+		megapixels = std::min(megapixels, static_cast<int>(INT32_MAX / 1000000));
+		uint32 scalar_ticks, vector_ticks;
+		bool identical = benchmark_texture_spans(static_cast<int32>(megapixels) * 1000000, &scalar_ticks, &vector_ticks);
+		logNote("span benchmark: %d megapixels, scalar %u ms, vector %u ms, %s", megapixels, scalar_ticks, vector_ticks, identical ? "identical" : "MISMATCH");
+		screen_printf("spans: scalar %u ms, vector %u ms (%s)", scalar_ticks, vector_ticks, identical ? "identical" : "MISMATCH");
+	}
+};
+
+struct benchmark_text_cache
+{
+	void operator() (const std::string&) const {
+		uint32 hits, misses;
+		get_text_cache_stats(hits, misses);
+		reset_text_cache_stats();
+		uint32 percent = (hits + misses) ? static_cast<uint32>(100ULL * hits / (hits + misses)) : 0;
+		logNote("text cache: %u hits, %u misses (%u%%)", hits, misses, percent);
+		screen_printf("text cache: %u hits, %u misses (%u%%)", hits, misses, percent);
+	}
+};
+
+void Console::register_benchmark_commands()
+{
+	CommandParser benchmarkParser;
+	benchmarkParser.register_command("collections", benchmark_collections());
+	benchmarkParser.register_command("maps", benchmark_maps());
+	benchmarkParser.register_command("mixer", benchmark_mixer());
+#ifdef HAVE_OPENGL
+	benchmarkParser.register_command("models", benchmark_models());
+#endif
+	benchmarkParser.register_command("polygons", benchmark_polygon_lookup());
+	benchmarkParser.register_command("screen", benchmark_screen());
+	benchmarkParser.register_command("spans", benchmark_spans());
+	benchmarkParser.register_command("text", benchmark_text_cache());
+	register_command("benchmark", benchmarkParser);
+}
+
+struct replay_seek
+{
+	void operator() (const std::string& arg) const {
+		if (arg.empty())
+		{
+			screen_printf("usage: replay seek [+|-]seconds");
+			return;
+		}
+
+		int32 tick = static_cast<int32>(atof(arg.c_str()) * TICKS_PER_SECOND);
+		if (arg[0] == '+' || arg[0] == '-')
+			tick += dynamic_world->tick_count;
+
+		if (!seek_replay(tick))
+			screen_printf("Seek stopped at %d:%02d", dynamic_world->tick_count / TICKS_PER_SECOND / 60, dynamic_world->tick_count / TICKS_PER_SECOND % 60);
+	}
+};
+
+void Console::register_replay_commands()
+{
+	CommandParser replayParser;
+	replayParser.register_command("seek", replay_seek());
+	register_command("replay", replayParser);
+}
+
 void Console::clear_saves()
 {
 	last_level.clear();
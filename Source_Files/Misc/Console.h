@@ -111,6 +111,8 @@ private:
 	bool m_use_lua_console;
 
 	void register_save_commands();
+	void register_benchmark_commands();
+	void register_replay_commands();
 };
 
 class InfoTree;
@@ -22,6 +22,11 @@
 	Jan. 16, 2003 (Woody Zenfell): Created.
 
 	May 21, 2003 (Woody Zenfell): being a little more defensive about NULL file pointer.
+
+	Oct. 17, 2026: messages are formatted on the caller's thread as before, but written out by
+	a writer thread, from a lock-free ring that never makes the caller wait (unless flush is
+	on: then each message is written and flushed at once); a rate limit; JSON lines as an
+	alternative output format.
 */
 
 #include "Logging.h"
@@ -36,21 +41,70 @@
 #include "FileHandler.h"
 #include "InfoTree.h"
 
+#include <SDL_atomic.h>
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
+
 #ifndef NO_STD_NAMESPACE
 using std::vector;
 using std::string;
 #endif
 
-enum { kStringBufferSize = 1024 };
+enum {
+	kStringBufferSize = 1024,
+	kLogEntryTextSize = 2 * kStringBufferSize,	// the contexts being entered, and the message
+	kLogQueueSize = 128,				// entries; a power of two
+	kLogDrainTimeout = 1000				// ms flush() waits for the writer thread
+};
 
 static Logger*	sCurrentLogger	= NULL;
 static FILE*	sOutputFile	= NULL;
 static int	sLoggingThreshhold = logNoteLevel;	// log messages at or above this level will be squelched
 static bool	sShowLocations	= true;			// should filenames and line numbers be printed as well?
 static bool	sFlushOutput	= false;		// flush output after every log-write?  (good if crash expected)
+static int	sLoggingFormat	= logFormatText;	// of the log file; stderr always gets text
 const char*	logDomain	= "global";
 
 
+// A message, formatted but not yet written out
+struct LogEntry {
+	int		level;
+	bool		showLocation;
+	const char*	file;		// __FILE__, so it lives forever
+	int		line;
+	uint32		time;		// machine ticks
+	uint16		contextLength;	// text starts with this many characters of "while ..." lines,
+	uint16		messageOffset;	// then indentation, and the message from here
+	uint16		length;
+	char		domain[32];
+	char		text[kLogEntryTextSize];
+};
+
+// The ring between the loggers and the writer thread: any number of threads put entries in,
+// and only the writer takes them out.  Each slot's sequence number says whose turn it is:
+// equal to the put position when the slot is free, one more once it's full, so a thread can
+// claim a slot with one compare-and-swap, and nobody ever waits on a lock.
+struct LogQueueSlot {
+	SDL_atomic_t	sequence;
+	LogEntry	entry;
+};
+
+static LogQueueSlot	sLogQueue[kLogQueueSize];
+static SDL_atomic_t	sLogQueuePutPosition;
+static SDL_atomic_t	sLogQueueTakePosition;		// only the writer moves it
+static SDL_atomic_t	sLogEntriesDropped;		// because the ring was full
+static SDL_sem*		sLogWriterWakeup = NULL;
+static SDL_Thread*	sLogWriterThread = NULL;
+static SDL_atomic_t	sLogWriterRunning;
+
+// At most so many messages a second; errors and worse are never held back.  Like the other
+// settings, this is for all logging, whatever the domain
+static int		sRateLimit	= 0;		// 0: no limit
+static SDL_atomic_t	sRateLimitSecond;
+static SDL_atomic_t	sRateLimitCount;
+static SDL_atomic_t	sRateLimitSuppressed;
+
+
 static void InitializeLogging();
 
 
@@ -97,6 +151,251 @@ Logger::~Logger() {
 
 
 
+static const char*
+log_level_name(int inLevel) {
+	if(inLevel <= logFatalLevel)	return "fatal";
+	if(inLevel <= logErrorLevel)	return "error";
+	if(inLevel <= logWarningLevel)	return "warning";
+	if(inLevel <= logAnomalyLevel)	return "anomaly";
+	if(inLevel <= logNoteLevel)	return "note";
+	if(inLevel <= logSummaryLevel)	return "summary";
+	if(inLevel <= logTraceLevel)	return "trace";
+	return "dump";
+}
+
+
+static void
+append_json_string(string& ioString, const char* inText, size_t inLength) {
+	ioString += '"';
+	for(size_t i = 0; i < inLength; i++) {
+		unsigned char c = inText[i];
+		switch(c) {
+		case '"':	ioString += "\\\""; break;
+		case '\\':	ioString += "\\\\"; break;
+		case '\n':	ioString += "\\n"; break;
+		case '\r':	ioString += "\\r"; break;
+		case '\t':	ioString += "\\t"; break;
+		default:
+			if(c < 0x20) {
+				char theEscape[8];
+				snprintf(theEscape, sizeof(theEscape), "\\u%04x", c);
+				ioString += theEscape;
+			}
+			else
+				ioString += c;
+		}
+	}
+	ioString += '"';
+}
+
+
+// Each entry is one object on one line:
+// {"time":..., "level":"note", "domain":"global", "file":"...", "line":..., "context":[...], "message":"..."}
+static void
+write_json_log_entry(FILE* inFile, const LogEntry& inEntry) {
+	char	stringBuffer[kStringBufferSize];
+	snprintf(stringBuffer, kStringBufferSize, "{\"time\":%u,\"level\":\"%s\",\"domain\":", inEntry.time, log_level_name(inEntry.level));
+	string	theString(stringBuffer);
+	append_json_string(theString, inEntry.domain, strlen(inEntry.domain));
+	if(inEntry.showLocation) {
+		theString += ",\"file\":";
+		append_json_string(theString, inEntry.file, strlen(inEntry.file));
+		snprintf(stringBuffer, kStringBufferSize, ",\"line\":%d", inEntry.line);
+		theString += stringBuffer;
+	}
+
+	// the contexts entered since the last message, without their indentation or "while "
+	theString += ",\"context\":[";
+	size_t theStart = 0;
+	bool first = true;
+	while(theStart < inEntry.contextLength) {
+		const char* theEnd = static_cast<const char*>(memchr(inEntry.text + theStart, '\n', inEntry.contextLength - theStart));
+		size_t theLineEnd = theEnd ? theEnd - inEntry.text : inEntry.contextLength;
+		size_t theLineStart = theStart;
+		while(theLineStart < theLineEnd && inEntry.text[theLineStart] == ' ')
+			theLineStart++;
+		if(theLineEnd - theLineStart >= 6 && strncmp(inEntry.text + theLineStart, "while ", 6) == 0)
+			theLineStart += 6;
+		if(!first)
+			theString += ',';
+		append_json_string(theString, inEntry.text + theLineStart, theLineEnd - theLineStart);
+		first = false;
+		theStart = theLineEnd + 1;
+	}
+	theString += "],\"message\":";
+	append_json_string(theString, inEntry.text + inEntry.messageOffset, inEntry.length - inEntry.messageOffset);
+	theString += "}\n";
+
+	fwrite(theString.data(), 1, theString.size(), inFile);
+}
+
+
+static void
+write_log_entry(const LogEntry& inEntry) {
+	char	theLocation[kStringBufferSize];
+	if(inEntry.showLocation)
+		snprintf(theLocation, kStringBufferSize, " (%s:%d)\n", inEntry.file, inEntry.line);
+	else
+		strcpy(theLocation, "\n");
+
+	if(sLoggingFormat == logFormatJSON)
+		write_json_log_entry(sOutputFile, inEntry);
+	else
+		fprintf(sOutputFile, "%.*s%s", static_cast<int>(inEntry.length), inEntry.text, theLocation);
+	fprintf(stderr, "%.*s%s", static_cast<int>(inEntry.length), inEntry.text, theLocation);
+}
+
+
+// false if the ring is full, or nobody is there to empty it
+static bool
+put_log_entry(const LogEntry& inEntry) {
+	if(!SDL_AtomicGet(&sLogWriterRunning))
+		return false;
+
+	LogQueueSlot* theSlot;
+	uint32 thePosition = static_cast<uint32>(SDL_AtomicGet(&sLogQueuePutPosition));
+	while(true) {
+		theSlot = &sLogQueue[thePosition & (kLogQueueSize - 1)];
+		int32 theDifference = static_cast<int32>(static_cast<uint32>(SDL_AtomicGet(&theSlot->sequence)) - thePosition);
+		if(theDifference == 0) {
+			if(SDL_AtomicCAS(&sLogQueuePutPosition, static_cast<int>(thePosition), static_cast<int>(thePosition + 1)))
+				break;
+		}
+		else if(theDifference < 0)
+			return false;
+
+		// somebody else got there first
+		thePosition = static_cast<uint32>(SDL_AtomicGet(&sLogQueuePutPosition));
+	}
+
+	// only the header and as much text as there is
+	memcpy(&theSlot->entry, &inEntry, offsetof(LogEntry, text) + inEntry.length);
+	SDL_AtomicSet(&theSlot->sequence, static_cast<int>(thePosition + 1));
+	SDL_SemPost(sLogWriterWakeup);
+	return true;
+}
+
+
+static uint32
+log_queue_count() {
+	return static_cast<uint32>(SDL_AtomicGet(&sLogQueuePutPosition)) - static_cast<uint32>(SDL_AtomicGet(&sLogQueueTakePosition));
+}
+
+
+// Only ever called by one thread at a time: the writer, or after it has stopped, whoever stopped it
+static void
+drain_log_queue() {
+	bool wroteAny = false;
+	uint32 thePosition = static_cast<uint32>(SDL_AtomicGet(&sLogQueueTakePosition));
+	while(true) {
+		LogQueueSlot* theSlot = &sLogQueue[thePosition & (kLogQueueSize - 1)];
+		if(static_cast<uint32>(SDL_AtomicGet(&theSlot->sequence)) != thePosition + 1)
+			break;
+
+		write_log_entry(theSlot->entry);
+		wroteAny = true;
+
+		SDL_AtomicSet(&theSlot->sequence, static_cast<int>(thePosition + kLogQueueSize));
+		SDL_AtomicSet(&sLogQueueTakePosition, static_cast<int>(++thePosition));
+	}
+
+	int theDroppedCount = SDL_AtomicSet(&sLogEntriesDropped, 0);
+	if(theDroppedCount > 0) {
+		char theMessage[kStringBufferSize];
+		snprintf(theMessage, kStringBufferSize, "%d log messages dropped: the log writer fell behind", theDroppedCount);
+		if(sLoggingFormat == logFormatJSON)
+			fprintf(sOutputFile, "{\"time\":%u,\"level\":\"warning\",\"domain\":\"%s\",\"context\":[],\"message\":\"%s\"}\n", machine_tick_count(), logDomain, theMessage);
+		else
+			fprintf(sOutputFile, "(%s)\n", theMessage);
+		fprintf(stderr, "(%s)\n", theMessage);
+		wroteAny = true;
+	}
+
+	// once per batch, rather than once per message (with flush on, messages don't come this way)
+	if(wroteAny && sFlushOutput)
+		fflush(sOutputFile);
+}
+
+
+static int
+log_writer_thread(void*) {
+	SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+
+	while(SDL_AtomicGet(&sLogWriterRunning)) {
+		SDL_SemWaitTimeout(sLogWriterWakeup, 100);
+		drain_log_queue();
+	}
+
+	return 0;
+}
+
+
+static void
+stop_log_writer() {
+	if(sLogWriterThread == NULL)
+		return;
+
+	SDL_AtomicSet(&sLogWriterRunning, 0);
+	SDL_SemPost(sLogWriterWakeup);
+	SDL_WaitThread(sLogWriterThread, NULL);
+	sLogWriterThread = NULL;
+
+	// whatever went in while it was stopping
+	drain_log_queue();
+	fflush(sOutputFile);
+}
+
+
+// If this fails, messages are written as they're logged, as they used to be
+static void
+start_log_writer() {
+	for(int i = 0; i < kLogQueueSize; i++)
+		SDL_AtomicSet(&sLogQueue[i].sequence, i);
+	SDL_AtomicSet(&sLogQueuePutPosition, 0);
+	SDL_AtomicSet(&sLogQueueTakePosition, 0);
+	SDL_AtomicSet(&sLogEntriesDropped, 0);
+
+	sLogWriterWakeup = SDL_CreateSemaphore(0);
+	if(sLogWriterWakeup == NULL)
+		return;
+
+	SDL_AtomicSet(&sLogWriterRunning, 1);
+	sLogWriterThread = SDL_CreateThread(log_writer_thread, "Logging_writerThread", NULL);
+	if(sLogWriterThread == NULL) {
+		SDL_AtomicSet(&sLogWriterRunning, 0);
+		return;
+	}
+
+	atexit(stop_log_writer);
+}
+
+
+// false if this message is over the limit; otherwise, outSuppressedCount says how many were
+// held back since the last one that got through
+static bool
+rate_limit_allows(int inLevel, int& outSuppressedCount) {
+	outSuppressedCount = 0;
+	if(inLevel <= logErrorLevel || sRateLimit <= 0)
+		return true;
+
+	// a new second starts a new count; whoever notices first resets it
+	int theSecond = static_cast<int>(machine_tick_count() / MACHINE_TICKS_PER_SECOND);
+	int theLimitSecond = SDL_AtomicGet(&sRateLimitSecond);
+	if(theLimitSecond != theSecond && SDL_AtomicCAS(&sRateLimitSecond, theLimitSecond, theSecond))
+		SDL_AtomicSet(&sRateLimitCount, 0);
+
+	if(SDL_AtomicAdd(&sRateLimitCount, 1) >= sRateLimit) {
+		SDL_AtomicAdd(&sRateLimitSuppressed, 1);
+		return false;
+	}
+
+	outSuppressedCount = SDL_AtomicSet(&sRateLimitSuppressed, 0);
+	return true;
+}
+
+
+
+
 
 
 class TopLevelLogger : public Logger {
@@ -150,7 +449,19 @@ TopLevelLogger::logMessageV(const char* inDomain, int inLevel, const char* inFil
     // Obviously eventually this will be settable more dynamically...
     // Also eventually some logged messages could be posted in a dialog in addition to appended to the file.
     if(sOutputFile != NULL && inLevel < sLoggingThreshhold) {
-        char	stringBuffer[kStringBufferSize];
+        int theSuppressedCount = 0;
+        if(!rate_limit_allows(inLevel, theSuppressedCount))
+            return;
+
+        LogEntry theEntry;
+        theEntry.level = inLevel;
+        theEntry.showLocation = sShowLocations;
+        theEntry.file = inFile;
+        theEntry.line = inLine;
+        theEntry.time = machine_tick_count();
+        strncpy(theEntry.domain, inDomain, sizeof(theEntry.domain) - 1);
+        theEntry.domain[sizeof(theEntry.domain) - 1] = '\0';
+
         size_t firstDepthToPrint = mMostRecentCommonStackDepth;
     /*
         // This was designed to give a little context when coming back from deep stacks, but it seems
@@ -159,35 +470,53 @@ TopLevelLogger::logMessageV(const char* inDomain, int inLevel, const char* inFil
         if(mMostRecentlyPrintedStackDepth != mMostRecentCommonStackDepth && firstDepthToPrint > 0)
             firstDepthToPrint--;
     */
+        string theContextString;
         for(size_t depth = firstDepthToPrint; depth < mContextStack.size(); depth++) {
-            string	theString(depth * 2, ' ');
-    
-            theString += "while ";
-            theString += mContextStack[depth];
-            
-            fprintf(sOutputFile, "%s\n", theString.c_str());
-			fprintf(stderr, "%s\n", theString.c_str());
+            theContextString.append(depth * 2, ' ');
+            theContextString += "while ";
+            theContextString += mContextStack[depth];
+            theContextString += "\n";
         }
-        
-        vsnprintf(stringBuffer, kStringBufferSize, inMessage, inArgs);
-    
-        string	theString(mContextStack.size() * 2, ' ');
-        
-        theString += stringBuffer;
-        
-        if(sShowLocations) {
-            snprintf(stringBuffer, kStringBufferSize, " (%s:%d)\n", inFile, inLine);
-            theString += stringBuffer;
+        if(theContextString.size() > kLogEntryTextSize / 2)
+            theContextString.resize(kLogEntryTextSize / 2);
+        memcpy(theEntry.text, theContextString.data(), theContextString.size());
+        theEntry.contextLength = theContextString.size();
+
+        size_t theLength = theEntry.contextLength;
+        size_t theIndent = std::min(mContextStack.size() * 2, static_cast<size_t>(kLogEntryTextSize / 4));
+        memset(theEntry.text + theLength, ' ', theIndent);
+        theLength += theIndent;
+        theEntry.messageOffset = theLength;
+
+        int theMessageLength = vsnprintf(theEntry.text + theLength, kLogEntryTextSize - theLength, inMessage, inArgs);
+        if(theMessageLength > 0)
+            theLength = std::min(theLength + theMessageLength, static_cast<size_t>(kLogEntryTextSize - 1));
+
+        if(theSuppressedCount > 0) {
+            int theNoteLength = snprintf(theEntry.text + theLength, kLogEntryTextSize - theLength, " [%d earlier messages were over the rate limit]", theSuppressedCount);
+            if(theNoteLength > 0)
+                theLength = std::min(theLength + theNoteLength, static_cast<size_t>(kLogEntryTextSize - 1));
         }
-        else
-            theString += "\n";
-        
-        fprintf(sOutputFile, "%s", theString.c_str());
-		fprintf(stderr, "%s", theString.c_str());
-        
-        if(sFlushOutput)
-                fflush(sOutputFile);
-        
+        theEntry.length = theLength;
+
+        if(sFlushOutput) {
+            // flush="true" is for when a crash is expected: each message has to be in the
+            // file before the caller goes on
+            write_log_entry(theEntry);
+            fflush(sOutputFile);
+        }
+        else if(!put_log_entry(theEntry)) {
+            // with no writer, or if it's an error and the writer is behind, write it ourselves
+            if(!SDL_AtomicGet(&sLogWriterRunning) || inLevel <= logErrorLevel)
+                write_log_entry(theEntry);
+            else
+                SDL_AtomicAdd(&sLogEntriesDropped, 1);
+        }
+
+        // the program is about to go; make sure this gets out first
+        if(inLevel <= logFatalLevel)
+            flush();
+
         mMostRecentCommonStackDepth = mContextStack.size();
         mMostRecentlyPrintedStackDepth = mContextStack.size();
     }
@@ -195,6 +524,14 @@ TopLevelLogger::logMessageV(const char* inDomain, int inLevel, const char* inFil
 
 void TopLevelLogger::flush()
 {
+	// let the writer catch up, unless it has stopped
+	uint32 theStartTime = machine_tick_count();
+	while (SDL_AtomicGet(&sLogWriterRunning) && log_queue_count() > 0 && machine_tick_count() - theStartTime < kLogDrainTimeout)
+	{
+		SDL_SemPost(sLogWriterWakeup);
+		SDL_Delay(1);
+	}
+
 	if (sOutputFile)
 	{
 		fflush(sOutputFile);
@@ -236,6 +573,8 @@ InitializeLogging() {
 	    time_t theTime = time(NULL);
 	    const char* theTimeString = ctime(&theTime);
 	    fprintf(sOutputFile, "\n-------------------- %s\n\n", theTimeString == NULL ? "(timestamp unavailable)" : theTimeString);
+
+	    start_log_writer();
     }
 }
 
@@ -263,6 +602,18 @@ setFlushLoggingOutput(const char* inDomain, bool inFlushOutput) {
 }
 
 
+void
+setLoggingFormat(const char* inDomain, int16 inFormat) {
+        sLoggingFormat = inFormat;
+}
+
+
+void
+setLoggingRateLimit(const char* inDomain, int16 inMessagesPerSecond) {
+        sRateLimit = inMessagesPerSecond;
+}
+
+
 void reset_mml_logging()
 {
 	// no reset
@@ -285,5 +636,11 @@ void parse_mml_logging(const InfoTree& root)
 		bool flush;
 		if (dtree.read_attr("flush", flush))
 			setFlushLoggingOutput(domain.c_str(), flush);
+		int16 rate_limit;
+		if (dtree.read_attr("rate_limit", rate_limit))
+			setLoggingRateLimit(domain.c_str(), rate_limit);
+		std::string format;
+		if (dtree.read_attr("format", format))
+			setLoggingFormat(domain.c_str(), format == "json" ? logFormatJSON : logFormatText);
 	}
 }
@@ -25,6 +25,9 @@
 	Split out the repetitive bits to Logging_gruntwork.h; now generating that with a script
 	Now offering logWarningNMT3() and co. for use in non-main threads, for added safety
 	New Logging level 'summary'
+
+Oct. 17, 2026:
+	Messages are written out by a background thread, unless flush is on; a rate limit; JSON lines output
 */
 
 #ifndef LOGGING_H
@@ -43,6 +46,11 @@ enum {
 	logDumpLevel	= 60	// values of data etc.
 };
 
+enum {
+	logFormatText,		// as the messages would appear on the console
+	logFormatJSON		// one JSON object per message, per line
+};
+
 
 class Logger {
 public:
@@ -65,7 +73,9 @@ Logger* GetCurrentLogger();
 // Other functions
 void setLoggingThreshhold(const char* inDomain, short inThreshhold); // message appears if its level < inThreshhold
 void setShowLoggingLocations(const char* inDomain, bool inShowLocations);	// show file and line?
-void setFlushLoggingOutput(const char* inDomain, bool inFlushOutput);	// flush output file after every log message?
+void setFlushLoggingOutput(const char* inDomain, bool inFlushOutput);	// write and flush every log message at once, rather than from the writer thread?
+void setLoggingFormat(const char* inDomain, short inFormat);	// of the log file; see below
+void setLoggingRateLimit(const char* inDomain, short inMessagesPerSecond);	// for all domains; 0: no limit; errors are never limited
 
 
 class InfoTree;
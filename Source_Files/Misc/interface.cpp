@@ -148,6 +148,7 @@ extern TP2PerfGlobals perf_globals;
 #include "QuickSave.h"
 #include "Plugins.h"
 #include "Statistics.h"
+#include "Logging.h"
 
 #ifdef HAVE_SMPEG
 #include <smpeg/smpeg.h>
@@ -317,6 +318,7 @@ static void draw_button(short index, bool pressed);
 static void draw_powered_by_aleph_one();
 static void handle_replay(bool last_replay);
 static bool begin_game(short user, bool cheat);
+static void load_film_profile_for_recording(short recording_version);
 static void start_game(short user, bool changing_level);
 // LP: "static" removed
 void handle_load_game(void);
@@ -1014,6 +1016,88 @@ bool handle_open_replay(FileSpecifier& File)
 	return success;
 }
 
+extern bool benchmark_replay(FileSpecifier& File);
+
+static bool headless_replay = false;
+
+// Headless film benchmark: sets the replay up the way begin_game() would, minus everything
+// that touches the screen, then runs it to the end as fast as the CPU allows
+bool benchmark_replay(FileSpecifier& File)
+{
+	struct entry_point entry;
+	struct player_start_data starts[MAXIMUM_NUMBER_OF_PLAYERS];
+	struct game_data game_information;
+	short number_of_players;
+	short recording_version;
+	uint32 unused;
+
+	clear_game_error();
+	objlist_clear(starts, MAXIMUM_NUMBER_OF_PLAYERS);
+
+	if (!get_map_file().Exists() || !setup_for_replay_from_file(File, get_current_map_checksum()))
+	{
+		fprintf(stderr, "Couldn't open film %s (or the map it was recorded on)\n", File.GetPath());
+		return false;
+	}
+
+	get_recording_header_data(&number_of_players, &entry.level_number, &unused, &recording_version,
+		starts, &game_information);
+	if (recording_version > max_handled_recording)
+	{
+		stop_replay();
+		fprintf(stderr, "Film %s was recorded by a newer version\n", File.GetPath());
+		return false;
+	}
+	load_film_profile_for_recording(recording_version);
+
+	entry.level_name[0] = 0;
+	game_information.game_options |= _overhead_map_is_omniscient;
+	standardize_player_behavior_modifiers();
+	Plugins::instance()->set_mode(number_of_players > 1 ? Plugins::kMode_Net : Plugins::kMode_Solo);
+
+	uint32 load_ticks = machine_tick_count();
+	if (!new_game(number_of_players, false, &game_information, starts, &entry))
+	{
+		stop_replay();
+		fprintf(stderr, "Couldn't start film %s\n", File.GetPath());
+		return false;
+	}
+	load_ticks = machine_tick_count() - load_ticks;
+
+	set_prediction_wanted(false);
+	headless_replay = true;
+	game_state.state = _game_in_progress;
+	game_state.user = _replay;
+	game_state.flags = 0;
+
+	uint64 subsystem_microseconds[NUMBER_OF_WORLD_SUBSYSTEMS];
+	uint32 run_ticks = machine_tick_count();
+	int32 world_ticks = fast_forward_replay(subsystem_microseconds);
+	run_ticks = machine_tick_count() - run_ticks;
+	uint32 checksum = calculate_world_checksum();
+
+	static const char *subsystem_names[NUMBER_OF_WORLD_SUBSYSTEMS] = {
+		"Lua idle", "players", "projectiles", "monsters", "other"
+	};
+
+	printf("Film: %s\n", File.GetPath());
+	printf("Level load: %u ms\n", load_ticks);
+	printf("Simulated %d ticks in %u ms (%.1f ticks/s, %.1fx real time)\n", world_ticks, run_ticks,
+		run_ticks ? world_ticks * 1000.0 / run_ticks : 0.0,
+		run_ticks ? world_ticks * 1000.0 / run_ticks / TICKS_PER_SECOND : 0.0);
+	for (int i = 0; i < NUMBER_OF_WORLD_SUBSYSTEMS; i++)
+	{
+		printf("  %-12s %10.1f ms\n", subsystem_names[i], subsystem_microseconds[i] / 1000.0);
+	}
+	printf("World checksum: %08x\n", checksum);
+	logNote("film benchmark %s: %d ticks in %u ms, checksum %08x", File.GetPath(), world_ticks, run_ticks, checksum);
+
+	leaving_map();
+	stop_replay();
+	headless_replay = false;
+	return true;
+}
+
 // Called from within update_world..
 bool check_level_change(
 	void)
@@ -1886,6 +1970,19 @@ static void transfer_to_new_level(
 	}
 #endif // !defined(DISABLE_NETWORKING)
 
+	if(success && headless_replay)
+	{
+		// no screen, movies or chapter screens; just keep simulating, and end
+		// the benchmark if the film runs into the epilogue or a broken level
+		if (level_number == (shapes_file_is_m1() ? 100 : EPILOGUE_LEVEL_NUMBER) ||
+			!goto_level(&entry, false, dynamic_world->player_count))
+		{
+			stop_replay();
+		}
+		game_state.state= _game_in_progress;
+		return;
+	}
+
 	if(success)
 	{
 		stop_fade();
@@ -1953,6 +2050,32 @@ static void handle_replay( /* This is gross. */
 	if(!success) display_main_menu();
 }
 
+static void load_film_profile_for_recording(
+	short recording_version)
+{
+	switch (recording_version)
+	{
+	case RECORDING_VERSION_MARATHON_2:
+		load_film_profile(FILM_PROFILE_MARATHON_2);
+		break;
+	case RECORDING_VERSION_MARATHON_INFINITY:
+		load_film_profile(FILM_PROFILE_MARATHON_INFINITY);
+		break;
+	case RECORDING_VERSION_ALEPH_ONE_1_0:
+		load_film_profile(FILM_PROFILE_ALEPH_ONE_1_0);
+		break;
+	case RECORDING_VERSION_ALEPH_ONE_1_1:
+		load_film_profile(FILM_PROFILE_ALEPH_ONE_1_1);
+		break;
+	case RECORDING_VERSION_ALEPH_ONE_1_2:
+		load_film_profile(FILM_PROFILE_DEFAULT);
+		break;
+	default:
+		load_film_profile(environment_preferences->film_profile);
+		break;
+	}
+}
+
 // ZZZ: some modifications to use generalized game-startup
 static bool begin_game(
 	short user,
@@ -2078,27 +2201,7 @@ static bool begin_game(
 				}
 				else
 				{
-					switch (recording_version)
-					{
-					case RECORDING_VERSION_MARATHON_2:
-						load_film_profile(FILM_PROFILE_MARATHON_2);
-						break;
-					case RECORDING_VERSION_MARATHON_INFINITY:
-						load_film_profile(FILM_PROFILE_MARATHON_INFINITY);
-						break;
-					case RECORDING_VERSION_ALEPH_ONE_1_0:
-						load_film_profile(FILM_PROFILE_ALEPH_ONE_1_0);
-						break;
-					case RECORDING_VERSION_ALEPH_ONE_1_1:
-						load_film_profile(FILM_PROFILE_ALEPH_ONE_1_1);
-						break;
-					case RECORDING_VERSION_ALEPH_ONE_1_2:
-						load_film_profile(FILM_PROFILE_DEFAULT);
-						break;
-					default:
-						load_film_profile(environment_preferences->film_profile);
-						break;
-					}
+					load_film_profile_for_recording(recording_version);
 
 					entry.level_name[0] = 0;
 					game_information.game_options |= _overhead_map_is_omniscient;
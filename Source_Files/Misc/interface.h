@@ -330,6 +330,16 @@ int count_replacement_collections();
 void load_replacement_collections();
 void unload_all_collections(void);
 
+// loads every collection at 8, 16 and 32 bits, reading fields from the Shapes file one at a
+// time and then with one read per collection, as load_collection() does; true if both agreed
+bool benchmark_collection_loading(uint32 streamed_ticks[3], uint32 bulk_ticks[3]);
+
+// reads a collection from the Shapes file at the given bit depth and keeps the bytes for
+// load_collections(); safe to call from any thread. discard_prefetched_collections() drops
+// whatever hasn't been used
+bool prefetch_collection(short collection_index, short depth);
+void discard_prefetched_collections();
+
 void set_shapes_patch_data(uint8 *data, size_t length);
 uint8* get_shapes_patch_data(size_t &length);
 
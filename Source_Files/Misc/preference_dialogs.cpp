@@ -167,6 +167,7 @@ OpenGLDialog::~OpenGLDialog()
 	delete m_sRGBWidget;
 	delete m_geForceFixWidget;
 	delete m_useNPOTWidget;
+	delete m_cacheTexturesWidget;
 	delete m_vsyncWidget;
 	delete m_wallsFilterWidget;
 	delete m_spritesFilterWidget;
@@ -222,6 +223,9 @@ void OpenGLDialog::OpenGLPrefsByRunning ()
 	BoolPref useNPOTPref (graphics_preferences->OGL_Configure.Use_NPOT);
 	binders.insert<bool> (m_useNPOTWidget, &useNPOTPref);
 	
+	BoolPref cacheTexturesPref (graphics_preferences->OGL_Configure.CacheTextures);
+	binders.insert<bool> (m_cacheTexturesWidget, &cacheTexturesPref);
+	
 	BoolPref vsyncPref (graphics_preferences->OGL_Configure.WaitForVSync);
 	binders.insert<bool> (m_vsyncWidget, &vsyncPref);
 	
@@ -443,6 +447,12 @@ public:
 		advanced_table->dual_add_row(new w_static_text("Non-power-of-two textures conserve memory,"), m_dialog);
 		advanced_table->dual_add_row(new w_static_text("but cause problems on some machines."), m_dialog);
 
+		w_toggle *cache_textures_w = new w_toggle(false);
+		advanced_table->dual_add(cache_textures_w->label("Cache Decoded Textures"), m_dialog);
+		advanced_table->dual_add(cache_textures_w, m_dialog);
+		advanced_table->dual_add_row(new w_static_text("Speeds up loading texture packs that aren't DDS,"), m_dialog);
+		advanced_table->dual_add_row(new w_static_text("at the cost of disk space."), m_dialog);
+
 		advanced_table->add_row(new w_spacer(), true);
 		advanced_table->dual_add_row(new w_static_text("Texture Filtering"), m_dialog);
 		advanced_placer->add(advanced_table, true);
@@ -588,6 +598,7 @@ public:
 
 		m_geForceFixWidget = new ToggleWidget (geforce_fix_w);
 		m_useNPOTWidget = new ToggleWidget (use_npot_w);
+		m_cacheTexturesWidget = new ToggleWidget (cache_textures_w);
 		m_vsyncWidget = new ToggleWidget (vsync_w);
 		
 		m_wallsFilterWidget = new SelectSelectorWidget (far_filter_wa[OGL_Txtr_Wall]);
@@ -66,6 +66,7 @@ protected:
 	
 	ToggleWidget*		m_geForceFixWidget;
 	ToggleWidget*		m_useNPOTWidget;
+	ToggleWidget*		m_cacheTexturesWidget;
 	ToggleWidget* m_vsyncWidget;
 	SelectSelectorWidget*		m_wallsFilterWidget;
 	SelectSelectorWidget*		m_spritesFilterWidget;
@@ -988,6 +988,13 @@ static const char* mouse_accel_labels[] = {
 	"Off", "Classic", NULL
 };
 
+static const char* sw_render_threads_labels[] = {
+	"Automatic", "1", "2", "4", "8", "16", NULL
+};
+static const int16 sw_render_threads_values[] = {
+	0, 1, 2, 4, 8, 16
+};
+
 static const char* max_saves_labels[] = {
 	"20", "100", "500", "Unlimited", NULL
 };
@@ -1042,6 +1049,14 @@ static void software_rendering_options_dialog(void* arg)
 	w_select *sw_driver_w = new w_select(graphics_preferences->software_sdl_driver, sw_sdl_driver_labels);
 	table->dual_add(sw_driver_w->label("Acceleration"), d);
 	table->dual_add(sw_driver_w, d);
+
+	w_select *sw_threads_w = new w_select(0, sw_render_threads_labels);
+	for (int i = 0; sw_render_threads_labels[i] != NULL; ++i) {
+		if (sw_render_threads_values[i] == graphics_preferences->software_render_threads)
+			sw_threads_w->set_selection(i);
+	}
+	table->dual_add(sw_threads_w->label("Rendering Threads"), d);
+	table->dual_add(sw_threads_w, d);
 	
 	placer->add(table, true);
 
@@ -1087,6 +1102,13 @@ static void software_rendering_options_dialog(void* arg)
 			graphics_preferences->software_sdl_driver = sw_driver_w->get_selection();
 			changed = true;
 		}
+
+		int16 threads = sw_render_threads_values[sw_threads_w->get_selection()];
+		if (threads != graphics_preferences->software_render_threads)
+		{
+			graphics_preferences->software_render_threads = threads;
+			changed = true;
+		}
 		
 		if (changed)
 			write_preferences();
@@ -3097,12 +3119,14 @@ InfoTree graphics_preferences_tree()
 	root.put_attr("ogl_flags", graphics_preferences->OGL_Configure.Flags);
 	root.put_attr("software_alpha_blending", graphics_preferences->software_alpha_blending);
 	root.put_attr("software_sdl_driver", graphics_preferences->software_sdl_driver);
+	root.put_attr("software_render_threads", graphics_preferences->software_render_threads);
 	root.put_attr("anisotropy_level", graphics_preferences->OGL_Configure.AnisotropyLevel);
 	root.put_attr("multisamples", graphics_preferences->OGL_Configure.Multisamples);
 	root.put_attr("geforce_fix", graphics_preferences->OGL_Configure.GeForceFix);
 	root.put_attr("wait_for_vsync", graphics_preferences->OGL_Configure.WaitForVSync);
 	root.put_attr("gamma_corrected_blending", graphics_preferences->OGL_Configure.Use_sRGB);
 	root.put_attr("use_npot", graphics_preferences->OGL_Configure.Use_NPOT);
+	root.put_attr("cache_textures", graphics_preferences->OGL_Configure.CacheTextures);
 	root.put_attr("double_corpse_limit", graphics_preferences->double_corpse_limit);
 	root.put_attr("hog_the_cpu", graphics_preferences->hog_the_cpu);
 	root.put_attr("movie_export_video_quality", graphics_preferences->movie_export_video_quality);
@@ -3516,6 +3540,7 @@ static void default_graphics_preferences(graphics_preferences_data *preferences)
 
 	preferences->software_alpha_blending = _sw_alpha_off;
 	preferences->software_sdl_driver = _sw_driver_default;
+	preferences->software_render_threads = 0;
 
 	preferences->movie_export_video_quality = 50;
 	preferences->movie_export_audio_quality = 50;
@@ -3975,12 +4000,14 @@ void parse_graphics_preferences(InfoTree root, std::string version)
 	root.read_attr("ogl_flags", graphics_preferences->OGL_Configure.Flags);
 	root.read_attr("software_alpha_blending", graphics_preferences->software_alpha_blending);
 	root.read_attr("software_sdl_driver", graphics_preferences->software_sdl_driver);
+	root.read_attr("software_render_threads", graphics_preferences->software_render_threads);
 	root.read_attr("anisotropy_level", graphics_preferences->OGL_Configure.AnisotropyLevel);
 	root.read_attr("multisamples", graphics_preferences->OGL_Configure.Multisamples);
 	root.read_attr("geforce_fix", graphics_preferences->OGL_Configure.GeForceFix);
 	root.read_attr("wait_for_vsync", graphics_preferences->OGL_Configure.WaitForVSync);
 	root.read_attr("gamma_corrected_blending", graphics_preferences->OGL_Configure.Use_sRGB);
 	root.read_attr("use_npot", graphics_preferences->OGL_Configure.Use_NPOT);
+	root.read_attr("cache_textures", graphics_preferences->OGL_Configure.CacheTextures);
 	root.read_attr("double_corpse_limit", graphics_preferences->double_corpse_limit);
 	root.read_attr("hog_the_cpu", graphics_preferences->hog_the_cpu);
 	root.read_attr_bounded<int16>("movie_export_video_quality", graphics_preferences->movie_export_video_quality, 0, 100);
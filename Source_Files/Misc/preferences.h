@@ -87,6 +87,7 @@ struct graphics_preferences_data
 
 	int16 software_alpha_blending;
 	int16 software_sdl_driver;
+	int16 software_render_threads;	// 0 means one per processor
 
 	bool hog_the_cpu;
 
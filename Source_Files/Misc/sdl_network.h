@@ -120,6 +120,12 @@ void NetDDPDisposeFrame(DDPFramePtr frame);
 
 OSErr NetDDPSendFrame(DDPFramePtr frame, NetAddrBlock *address, short protocolType, short socket);
 
+// Hands outgoing frames to sendProc instead of the socket (NULL puts the socket back);
+// for the loopback harness, which stands in a simulated network.  sendProc is called
+// wherever NetDDPSendFrame() is, which is with the mytm mutex held.
+typedef void (*DDPSendProcPtr)(DDPFramePtr frame, NetAddrBlock *address);
+void NetDDPSetSendProc(DDPSendProcPtr sendProc);
+
 /* ---------- prototypes/NETWORK_ADSP.C */
 
 // jkvw: removed - we use TCPMess now
@@ -74,6 +74,10 @@ Aug 26, 2000 (Loren Petrich):
 
 Feb 20, 2002 (Woody Zenfell):
     Uses GetRealActionQueues()->enqueueActionFlags() rather than queue_action_flags().
+
+Oct 17, 2026:
+	Film keyframes: replays keep an in-memory saved game every 30 seconds of game time,
+	so seek_replay() can jump anywhere in the film by restoring the nearest one.
 */
 
 #include "cseries.h"
@@ -98,6 +102,12 @@ Feb 20, 2002 (Woody Zenfell):
 #include "joystick.h"
 #include "Movie.h"
 #include "InfoTree.h"
+#include "wad.h"
+#include "game_wad.h"
+#include "lua_script.h"
+#include "SoundManager.h"
+
+#include <vector>
 
 /* ---------- constants */
 
@@ -108,6 +118,8 @@ Feb 20, 2002 (Woody Zenfell):
 #define DISK_CACHE_SIZE             ((sizeof(int16)+sizeof(uint32))*100)
 #define MAXIMUM_REPLAY_SPEED         5
 #define MINIMUM_REPLAY_SPEED        -5
+#define REPLAY_KEYFRAME_INTERVAL    (30*TICKS_PER_SECOND)
+#define MAXIMUM_REPLAY_KEYFRAMES     64
 
 /* ---------- macros */
 
@@ -131,6 +143,28 @@ static OpenedFile FilmFile;
 
 struct replay_private_data replay;
 
+/* a film keyframe is a saved game plus everything needed to carry on reading the film from
+	that tick: where the reader was, and the flags it had read but not yet used */
+struct replay_keyframe
+{
+	int32 tick;
+	struct wad_data *wad;
+	
+	int32 film_position; // file position, or offset into resource_data
+	std::vector<char> cache;
+	bool have_read_last_chunk;
+	
+	std::vector<uint32> recording_flags[MAXIMUM_NUMBER_OF_PLAYERS];
+	std::vector<uint32> real_flags[MAXIMUM_NUMBER_OF_PLAYERS];
+	std::vector<uint32> lua_flags[MAXIMUM_NUMBER_OF_PLAYERS];
+	std::vector<uint32> game_flags[MAXIMUM_NUMBER_OF_PLAYERS];
+};
+
+static std::vector<replay_keyframe> replay_keyframes;
+static int32 replay_keyframe_interval= REPLAY_KEYFRAME_INTERVAL;
+
+extern ModifiableActionQueues *GetGameQueue();
+
 #ifdef DEBUG
 ActionQueue *get_player_recording_queue(
 	short player_index)
@@ -149,6 +183,9 @@ static void read_recording_queue_chunks(void);
 static bool pull_flags_from_recording(short count);
 // LP modifications for object-oriented file handling; returns a test for end-of-file
 static bool vblFSRead(OpenedFile& File, int32 *count, void *dest, bool& HitEOF);
+static void clear_replay_keyframes(void);
+static void copy_action_queues(ActionQueues *queues, std::vector<uint32> *flags);
+static void refill_action_queues(ActionQueues *queues, const std::vector<uint32> *flags);
 static void record_action_flags(short player_identifier, const uint32 *action_flags, short count);
 static short get_recording_queue_size(short which_queue);
 
@@ -481,6 +518,179 @@ static bool pull_flags_from_recording(
 	return success;
 }
 
+/* headless playback: there's no timer task, so refill the recording queues ourselves and
+	move one tick of flags into the real action queues. returns false at the end of the film */
+bool pull_replay_tick_flags(
+	void)
+{
+	if (!replay.game_is_being_replayed) return false;
+	
+	check_recording_replaying();
+	if (!pull_flags_from_recording(1)) return false;
+	
+	heartbeat_count++;
+	return true;
+}
+
+/* called at the start of every replayed tick; every replay_keyframe_interval ticks we keep
+	a snapshot of the world, so seek_replay() never has to simulate more than that far */
+void record_replay_keyframe(
+	void)
+{
+	if (!replay.game_is_being_replayed || game_is_networked) return;
+	if (dynamic_world->tick_count % replay_keyframe_interval) return;
+	if (!replay_keyframes.empty() && replay_keyframes.back().tick >= dynamic_world->tick_count) return;
+	
+	replay_keyframe keyframe;
+	keyframe.tick= dynamic_world->tick_count;
+	keyframe.wad= build_game_snapshot();
+	if (!keyframe.wad) return;
+	
+	if (replay.resource_data)
+	{
+		keyframe.film_position= replay.film_resource_offset;
+	}
+	else
+	{
+		FilmFile.GetPosition(keyframe.film_position);
+		keyframe.cache.assign(replay.location_in_cache, replay.location_in_cache + replay.bytes_in_cache);
+	}
+	keyframe.have_read_last_chunk= replay.have_read_last_chunk;
+	
+	for (short player_index= 0; player_index<dynamic_world->player_count; ++player_index)
+	{
+		ActionQueue *queue= get_player_recording_queue(player_index);
+		for (short index= queue->read_index; index!=queue->write_index; )
+		{
+			keyframe.recording_flags[player_index].push_back(queue->buffer[index]);
+			INCREMENT_QUEUE_COUNTER(index);
+		}
+	}
+	copy_action_queues(GetRealActionQueues(), keyframe.real_flags);
+	copy_action_queues(GetLuaActionQueues(), keyframe.lua_flags);
+	copy_action_queues(GetGameQueue(), keyframe.game_flags);
+	
+	replay_keyframes.push_back(keyframe);
+	
+	/* long films: drop every other keyframe rather than growing without bound */
+	if (replay_keyframes.size() > MAXIMUM_REPLAY_KEYFRAMES)
+	{
+		std::vector<replay_keyframe> kept;
+		
+		replay_keyframe_interval*= 2;
+		for (size_t index= 0; index<replay_keyframes.size(); ++index)
+		{
+			if (replay_keyframes[index].tick % replay_keyframe_interval)
+				free_wad(replay_keyframes[index].wad);
+			else
+				kept.push_back(replay_keyframes[index]);
+		}
+		replay_keyframes.swap(kept);
+	}
+}
+
+/* jump to the given tick of the film being replayed by restoring the last keyframe at or
+	before it (or carrying on from where we are, if that's closer) and replaying forward.
+	keyframes are only made as the film plays, so seeking ahead of the furthest point reached
+	so far costs a full simulation of the gap. stops early at a level change. */
+bool seek_replay(
+	int32 tick)
+{
+	if (!replay.game_is_being_replayed || game_is_networked) return false;
+	if (tick < 0) tick= 0;
+	
+	const replay_keyframe *keyframe= NULL;
+	for (size_t index= 0; index<replay_keyframes.size() && replay_keyframes[index].tick <= tick; ++index)
+	{
+		keyframe= &replay_keyframes[index];
+	}
+	
+	if (tick < dynamic_world->tick_count || (keyframe && keyframe->tick > dynamic_world->tick_count))
+	{
+		if (!keyframe || !restore_game_snapshot(keyframe->wad)) return false;
+		
+		if (replay.resource_data)
+		{
+			replay.film_resource_offset= keyframe->film_position;
+		}
+		else
+		{
+			FilmFile.SetPosition(keyframe->film_position);
+			if (!keyframe->cache.empty())
+				memcpy(replay.fsread_buffer, &keyframe->cache[0], keyframe->cache.size());
+			replay.location_in_cache= replay.fsread_buffer;
+			replay.bytes_in_cache= keyframe->cache.size();
+		}
+		replay.have_read_last_chunk= keyframe->have_read_last_chunk;
+		
+		for (short player_index= 0; player_index<dynamic_world->player_count; ++player_index)
+		{
+			ActionQueue *queue= get_player_recording_queue(player_index);
+			const std::vector<uint32>& flags= keyframe->recording_flags[player_index];
+			
+			queue->read_index= queue->write_index= 0;
+			for (size_t index= 0; index<flags.size(); ++index)
+			{
+				queue->buffer[queue->write_index]= flags[index];
+				INCREMENT_QUEUE_COUNTER(queue->write_index);
+			}
+		}
+		refill_action_queues(GetRealActionQueues(), keyframe->real_flags);
+		refill_action_queues(GetLuaActionQueues(), keyframe->lua_flags);
+		refill_action_queues(GetGameQueue(), keyframe->game_flags);
+	}
+	
+	bool reached= advance_replay_to_tick(tick);
+	
+	/* the input controller reads ahead of the world, so the heartbeat has to as well */
+	heartbeat_count= dynamic_world->tick_count + GetRealActionQueues()->countActionFlags(0);
+	SoundManager::instance()->StopAllSounds();
+	
+	return reached;
+}
+
+static void clear_replay_keyframes(
+	void)
+{
+	for (size_t index= 0; index<replay_keyframes.size(); ++index)
+	{
+		free_wad(replay_keyframes[index].wad);
+	}
+	replay_keyframes.clear();
+	replay_keyframe_interval= REPLAY_KEYFRAME_INTERVAL;
+}
+
+static void copy_action_queues(
+	ActionQueues *queues,
+	std::vector<uint32> *flags)
+{
+	for (short player_index= 0; player_index<dynamic_world->player_count; ++player_index)
+	{
+		flags[player_index].clear();
+		
+		// zombies' queues don't hold anything (but claim to be full)
+		if (!queues->zombiesControllable() && PLAYER_IS_ZOMBIE(get_player_data(player_index))) continue;
+		
+		unsigned count= queues->countActionFlags(player_index);
+		for (unsigned index= 0; index<count; ++index)
+		{
+			flags[player_index].push_back(queues->peekActionFlags(player_index, index));
+		}
+	}
+}
+
+static void refill_action_queues(
+	ActionQueues *queues,
+	const std::vector<uint32> *flags)
+{
+	queues->reset();
+	for (short player_index= 0; player_index<dynamic_world->player_count; ++player_index)
+	{
+		if (!flags[player_index].empty())
+			queues->enqueueActionFlags(player_index, &flags[player_index][0], flags[player_index].size());
+	}
+}
+
 static short get_recording_queue_size(
 	short which_queue)
 {
@@ -759,6 +969,7 @@ void stop_replay(
 		close_stream_file();
 #endif
 	}
+	clear_replay_keyframes();
 
 	/* Unecessary, because reset_player_queues calls this. */
 	replay.valid= false;
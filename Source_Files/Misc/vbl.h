@@ -48,6 +48,9 @@ void get_recording_header_data(short *number_of_players, short *level_number, ui
 
 bool input_controller(void);
 void increment_heartbeat_count(int value = 1);
+bool pull_replay_tick_flags(void);
+void record_replay_keyframe(void);
+bool seek_replay(int32 tick);
 
 /* ------------ prototypes/VBL_MACINTOSH.C */
 void initialize_keyboard_controller(void);
@@ -24,6 +24,7 @@
 
 #include <string.h>
 #include <math.h>
+#include <map>
 
 #include "VecOps.h"
 #include "cseries.h"
@@ -40,28 +41,64 @@
 /* Need Sgl* macros */
 #include "OGL_Setup.h"
 
+#include <SDL_cpuinfo.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MODEL3D_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MODEL3D_NEON
+#endif
+
 // Bone-stack and transformation-matrix locally-used arrays;
 // the matrices have dimensions (output coords)(input-coord multipliers + offset for output)
 static vector<Model3D_Transform> BoneMatrices;
 static vector<size_t> BoneStack;
 
+// The bone matrices with the model's and sequence's transforms folded in,
+// and the skinned coordinates of one group
+static vector<Model3D_Transform> PosMatrices, NormMatrices;
+static vector<GLfloat> SkinX, SkinY, SkinZ;
+
+// Model3D::BenchmarkPosing() flips these to compare against the original skinning
+static bool use_vector_skinning = true;
+static bool use_pose_cache = true;
+
+static bool vector_kernels_available()
+{
+#if defined(MODEL3D_SSE2)
+	static bool available = SDL_HasSSE2();
+	return available;
+#elif defined(MODEL3D_NEON)
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+	static bool available = SDL_HasNEON();
+	return available;
+#else
+	return true;
+#endif
+#else
+	return false;
+#endif
+}
+
 
 // Find transform of point (source and dest must be different arrays)
-inline void TransformPoint(GLfloat *Dest, GLfloat *Src, Model3D_Transform& T)
+inline void TransformPoint(GLfloat *Dest, const GLfloat *Src, const Model3D_Transform& T)
 {
 	for (int ic=0; ic<3; ic++)
 	{
-		GLfloat *Row = T.M[ic];
+		const GLfloat *Row = T.M[ic];
 		Dest[ic] = ScalarProd(Src,Row) + Row[3];
 	}
 }
 
 // Like above, but a vector, such as a normal (source and dest must be different arrays)
-inline void TransformVector(GLfloat *Dest, GLfloat *Src, Model3D_Transform& T)
+inline void TransformVector(GLfloat *Dest, const GLfloat *Src, const Model3D_Transform& T)
 {
 	for (int ic=0; ic<3; ic++)
 	{
-		GLfloat *Row = T.M[ic];
+		const GLfloat *Row = T.M[ic];
 		Dest[ic] = ScalarProd(Src,Row);
 	}
 }
@@ -73,7 +110,7 @@ static void FindBoneTransform(Model3D_Transform& T, Model3D_Bone& Bone,
 	Model3D_Frame& Frame, GLfloat MixFrac, Model3D_Frame& AddlFrame);
 
 // Res = A * B, in that order
-static void TMatMultiply(Model3D_Transform& Res, Model3D_Transform& A, Model3D_Transform& B);
+static void TMatMultiply(Model3D_Transform& Res, const Model3D_Transform& A, const Model3D_Transform& B);
 
 	
 // Trig-function conversion:
@@ -97,6 +134,7 @@ void Model3D::Clear()
 	Frames.clear();
 	SeqFrames.clear();
 	SeqFrmPointers.clear();
+	ClearPoses();
 	FindBoundingBox();
 }
 
@@ -218,6 +256,8 @@ void Model3D::CalculateTangents()
 // Normalize the normals
 void Model3D::AdjustNormals(int NormalType, float SmoothThreshold)
 {
+	ClearPoses();
+	
 	// Copy in normal sources for processing
 	if (!NormSources.empty())
 	{
@@ -658,6 +698,8 @@ void Model3D::BuildInverseVSIndices()
 {
 	if (VtxSrcIndices.empty()) return;
 	
+	ClearPoses();
+	
 	InverseVSIndices.resize(VtxSrcIndices.size());
 	InvVSIPointers.resize(VtxSources.size()+1);		// One extra member
 	
@@ -772,21 +814,10 @@ bool Model3D::FindPositions_Neutral(bool UseModelTransform)
 	return true;
 }
 
-// Frame case
-bool Model3D::FindPositions_Frame(bool UseModelTransform,
-	GLshort FrameIndex, GLfloat MixFrac, GLshort AddlFrameIndex)
+// Find the bone matrices for a frame, including their parents' transforms
+void Model3D::FindBoneMatrices(GLshort FrameIndex, GLfloat MixFrac, GLshort AddlFrameIndex)
 {
-	// Bad inputs: do nothing and return false
-	
-	if (Frames.empty()) return false;
-	
 	size_t NumBones = Bones.size();
-	if (FrameIndex < 0 || NumBones*FrameIndex >= Frames.size()) return false;
-	
-	if (InverseVSIndices.empty()) BuildInverseVSIndices();
-	
-	size_t NumVertices = VtxSrcIndices.size();
-	Positions.resize(3*NumVertices);
 	
 	// Set sizes:
 	BoneMatrices.resize(NumBones);
@@ -834,9 +865,14 @@ bool Model3D::FindPositions_Frame(bool UseModelTransform,
 		// Default: parent of next bone is current bone
 		Parent = ib;
 	}
-		
+}
+
+
+// The original skinning, one vertex source at a time, with the transforms done afterward;
+// kept as the reference for the vectorized version
+void Model3D::SkinVertices_Scalar(const Model3D_Transform *PosTransform, const Model3D_Transform *NormTransform)
+{
 	bool NormalsPresent = !NormSources.empty();
-	if (NormalsPresent) Normals.resize(NormSources.size());
 	
 	for (unsigned ivs=0; ivs<VtxSources.size(); ivs++)
 	{
@@ -903,23 +939,397 @@ bool Model3D::FindPositions_Frame(bool UseModelTransform,
 			VecCopy(Position,PosBase() + 3*InverseVSIndices[iv]);
 	}
 	
-	if (UseModelTransform)
+	if (PosTransform)
 	{
 		GLfloat *PP = PosBase();
 		for (size_t k=0; k<Positions.size()/3; k++, PP+=3)
 		{
 			GLfloat Position[3];
-			TransformPoint(Position,PP,TransformPos);
+			TransformPoint(Position,PP,*PosTransform);
 			VecCopy(Position,PP);
 		}
+	}
+	if (NormTransform && NormalsPresent)
+	{
 		GLfloat *NP = NormBase();
 		for (size_t k=0; k<Normals.size()/3; k++, NP+=3)
 		{
 			GLfloat Normal[3];
-			TransformVector(Normal,NP,TransformNorm);
+			TransformVector(Normal,NP,*NormTransform);
 			VecCopy(Normal,NP);
 		}
 	}
+}
+
+
+void Model3D_SkinArrays::Clear()
+{
+	X.clear();
+	Y.clear();
+	Z.clear();
+	Blend.clear();
+	Index.clear();
+}
+
+void Model3D_SkinArrays::Add(const GLfloat *V, GLfloat _Blend, GLushort _Index)
+{
+	X.push_back(V[0]);
+	Y.push_back(V[1]);
+	Z.push_back(V[2]);
+	Blend.push_back(_Blend);
+	Index.push_back(_Index);
+}
+
+void Model3D_SkinArrays::Pad()
+{
+	const GLfloat Zero[3] = {0,0,0};
+	while (Index.size() % 4)
+		Add(Zero,0,UNONE);
+}
+
+
+// Sort the vertex sources (and the normals of their vertices) by the pair of bones
+// they follow, so that each group can be skinned with one pair of matrices
+void Model3D::BuildSkinGroups()
+{
+	SkinGroups.clear();
+	SkinPositions.Clear();
+	SkinNormals.Clear();
+	
+	bool NormalsPresent = !NormSources.empty();
+	
+	std::map<std::pair<GLshort,GLshort>, vector<GLushort> > Groups;
+	for (unsigned ivs=0; ivs<VtxSources.size(); ivs++)
+	{
+		Model3D_VertexSource& VS = VtxSources[ivs];
+		GLshort Bone0 = NONE, Bone1 = NONE;
+		if (VS.Bone0 >= 0)
+		{
+			Bone0 = VS.Bone0;
+			if (VS.Bone1 >= 0 && VS.Blend != 0)
+				Bone1 = VS.Bone1;
+		}
+		Groups[std::make_pair(Bone0,Bone1)].push_back(ivs);
+	}
+	
+	for (std::map<std::pair<GLshort,GLshort>, vector<GLushort> >::iterator Iter = Groups.begin();
+		Iter != Groups.end();
+		Iter++)
+	{
+		Model3D_SkinGroup Group;
+		Group.Bone0 = Iter->first.first;
+		Group.Bone1 = Iter->first.second;
+		
+		Group.PosStart = SkinPositions.Index.size();
+		Group.NormStart = SkinNormals.Index.size();
+		for (vector<GLushort>::iterator VSI_Iter = Iter->second.begin();
+			VSI_Iter != Iter->second.end();
+			VSI_Iter++)
+		{
+			GLushort ivs = *VSI_Iter;
+			Model3D_VertexSource& VS = VtxSources[ivs];
+			SkinPositions.Add(VS.Position,VS.Blend,ivs);
+			
+			if (NormalsPresent)
+			{
+				for (int iv=InvVSIPointers[ivs]; iv<InvVSIPointers[ivs+1]; iv++)
+					SkinNormals.Add(NormSrcBase() + 3*InverseVSIndices[iv],VS.Blend,InverseVSIndices[iv]);
+			}
+		}
+		SkinPositions.Pad();
+		SkinNormals.Pad();
+		Group.PosEnd = SkinPositions.Index.size();
+		Group.NormEnd = SkinNormals.Index.size();
+		
+		SkinGroups.push_back(Group);
+	}
+}
+
+
+// Out = T0 * In, blended toward T1 * In by Blend if T1 is present; Count is a multiple of 4.
+// The arithmetic is done in the same order as TransformPoint() and the blending above.
+static void SkinBatch(const GLfloat *X, const GLfloat *Y, const GLfloat *Z, const GLfloat *Blend,
+	size_t Count, const Model3D_Transform& T0, const Model3D_Transform *T1, bool Translate,
+	GLfloat *OX, GLfloat *OY, GLfloat *OZ)
+{
+	GLfloat *Out[3] = {OX, OY, OZ};
+	
+#if defined(MODEL3D_SSE2)
+	if (vector_kernels_available())
+	{
+		__m128 M0[3][4], M1[3][4];
+		for (int ic=0; ic<3; ic++)
+			for (int j=0; j<4; j++)
+			{
+				M0[ic][j] = _mm_set1_ps((j < 3 || Translate) ? T0.M[ic][j] : 0);
+				if (T1) M1[ic][j] = _mm_set1_ps((j < 3 || Translate) ? T1->M[ic][j] : 0);
+			}
+		
+		for (size_t i=0; i<Count; i+=4)
+		{
+			__m128 VX = _mm_loadu_ps(X + i);
+			__m128 VY = _mm_loadu_ps(Y + i);
+			__m128 VZ = _mm_loadu_ps(Z + i);
+			__m128 VB = _mm_loadu_ps(Blend + i);
+			for (int ic=0; ic<3; ic++)
+			{
+				__m128 V = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(VX,M0[ic][0]),
+					_mm_mul_ps(VY,M0[ic][1])), _mm_mul_ps(VZ,M0[ic][2])), M0[ic][3]);
+				if (T1)
+				{
+					__m128 V1 = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(VX,M1[ic][0]),
+						_mm_mul_ps(VY,M1[ic][1])), _mm_mul_ps(VZ,M1[ic][2])), M1[ic][3]);
+					V = _mm_add_ps(V, _mm_mul_ps(_mm_sub_ps(V1,V),VB));
+				}
+				_mm_storeu_ps(Out[ic] + i, V);
+			}
+		}
+		return;
+	}
+#elif defined(MODEL3D_NEON)
+	if (vector_kernels_available())
+	{
+		float32x4_t M0[3][4], M1[3][4];
+		for (int ic=0; ic<3; ic++)
+			for (int j=0; j<4; j++)
+			{
+				M0[ic][j] = vdupq_n_f32((j < 3 || Translate) ? T0.M[ic][j] : 0);
+				if (T1) M1[ic][j] = vdupq_n_f32((j < 3 || Translate) ? T1->M[ic][j] : 0);
+			}
+		
+		for (size_t i=0; i<Count; i+=4)
+		{
+			float32x4_t VX = vld1q_f32(X + i);
+			float32x4_t VY = vld1q_f32(Y + i);
+			float32x4_t VZ = vld1q_f32(Z + i);
+			float32x4_t VB = vld1q_f32(Blend + i);
+			for (int ic=0; ic<3; ic++)
+			{
+				float32x4_t V = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(VX,M0[ic][0]),
+					vmulq_f32(VY,M0[ic][1])), vmulq_f32(VZ,M0[ic][2])), M0[ic][3]);
+				if (T1)
+				{
+					float32x4_t V1 = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(VX,M1[ic][0]),
+						vmulq_f32(VY,M1[ic][1])), vmulq_f32(VZ,M1[ic][2])), M1[ic][3]);
+					V = vaddq_f32(V, vmulq_f32(vsubq_f32(V1,V),VB));
+				}
+				vst1q_f32(Out[ic] + i, V);
+			}
+		}
+		return;
+	}
+#endif
+	
+	for (size_t i=0; i<Count; i++)
+	{
+		for (int ic=0; ic<3; ic++)
+		{
+			const GLfloat *Row = T0.M[ic];
+			GLfloat V = X[i]*Row[0] + Y[i]*Row[1] + Z[i]*Row[2];
+			if (Translate) V += Row[3];
+			if (T1)
+			{
+				const GLfloat *Row1 = T1->M[ic];
+				GLfloat V1 = X[i]*Row1[0] + Y[i]*Row1[1] + Z[i]*Row1[2];
+				if (Translate) V1 += Row1[3];
+				V += (V1 - V)*Blend[i];
+			}
+			Out[ic][i] = V;
+		}
+	}
+}
+
+
+// The vectorized skinning: the transforms are folded into the bone matrices,
+// so that each group of vertex sources and normals is done in one pass
+void Model3D::SkinVertices(const Model3D_Transform *PosTransform, const Model3D_Transform *NormTransform)
+{
+	if (SkinGroups.empty()) BuildSkinGroups();
+	
+	bool NormalsPresent = !NormSources.empty();
+	size_t NumBones = Bones.size();
+	
+	// The last one is for the root bone
+	PosMatrices.resize(NumBones+1);
+	NormMatrices.resize(NumBones+1);
+	for (size_t ib=0; ib<=NumBones; ib++)
+	{
+		Model3D_Transform Bone;
+		if (ib < NumBones)
+			obj_copy(Bone,BoneMatrices[ib]);
+		else
+			Bone.Identity();
+		
+		if (PosTransform)
+			TMatMultiply(PosMatrices[ib],*PosTransform,Bone);
+		else
+			obj_copy(PosMatrices[ib],Bone);
+		
+		if (NormTransform)
+			TMatMultiply(NormMatrices[ib],*NormTransform,Bone);
+		else
+			obj_copy(NormMatrices[ib],Bone);
+	}
+	
+	SkinX.resize(std::max(SkinPositions.Index.size(),SkinNormals.Index.size()));
+	SkinY.resize(SkinX.size());
+	SkinZ.resize(SkinX.size());
+	
+	for (vector<Model3D_SkinGroup>::iterator Group = SkinGroups.begin();
+		Group != SkinGroups.end();
+		Group++)
+	{
+		size_t M0 = (Group->Bone0 >= 0) ? Group->Bone0 : NumBones;
+		size_t M1 = Group->Bone1;
+		
+		// Positions: one for each vertex source, copied to all of its vertices
+		size_t Start = Group->PosStart;
+		size_t Count = Group->PosEnd - Start;
+		SkinBatch(&SkinPositions.X[Start], &SkinPositions.Y[Start], &SkinPositions.Z[Start],
+			&SkinPositions.Blend[Start], Count, PosMatrices[M0],
+			(Group->Bone1 >= 0) ? &PosMatrices[M1] : NULL, true,
+			&SkinX[0], &SkinY[0], &SkinZ[0]);
+		
+		for (size_t i=0; i<Count; i++)
+		{
+			GLushort ivs = SkinPositions.Index[Start+i];
+			if (ivs == UNONE) continue;
+			for (int iv=InvVSIPointers[ivs]; iv<InvVSIPointers[ivs+1]; iv++)
+			{
+				GLfloat *Position = PosBase() + 3*InverseVSIndices[iv];
+				Position[0] = SkinX[i];
+				Position[1] = SkinY[i];
+				Position[2] = SkinZ[i];
+			}
+		}
+		
+		if (!NormalsPresent) continue;
+		
+		// Normals: one for each vertex
+		Start = Group->NormStart;
+		Count = Group->NormEnd - Start;
+		if (Count == 0) continue;
+		SkinBatch(&SkinNormals.X[Start], &SkinNormals.Y[Start], &SkinNormals.Z[Start],
+			&SkinNormals.Blend[Start], Count, NormMatrices[M0],
+			(Group->Bone1 >= 0) ? &NormMatrices[M1] : NULL, false,
+			&SkinX[0], &SkinY[0], &SkinZ[0]);
+		
+		for (size_t i=0; i<Count; i++)
+		{
+			GLushort iv = SkinNormals.Index[Start+i];
+			if (iv == UNONE) continue;
+			GLfloat *Normal = NormBase() + 3*iv;
+			Normal[0] = SkinX[i];
+			Normal[1] = SkinY[i];
+			Normal[2] = SkinZ[i];
+		}
+	}
+}
+
+
+void Model3D::ClearPoses()
+{
+	SkinGroups.clear();
+	SkinPositions.Clear();
+	SkinNormals.Clear();
+	Poses.clear();
+}
+
+// Copies the pose into the vertex arrays if it is cached
+bool Model3D::FindPose(GLshort SeqIndex, GLshort FrameIndex, GLfloat MixFrac,
+	GLshort AddlFrameIndex, bool UseModelTransform)
+{
+	if (!use_pose_cache) return false;
+	
+	for (vector<Model3D_Pose>::iterator Pose = Poses.begin(); Pose != Poses.end(); Pose++)
+	{
+		if (Pose->Sequence == SeqIndex && Pose->Frame == FrameIndex &&
+			Pose->MixFrac == MixFrac && Pose->AddlFrame == AddlFrameIndex &&
+			Pose->UseModelTransform == UseModelTransform)
+		{
+			Pose->LastUsed = ++PoseClock;
+			Positions = Pose->Positions;
+			if (!Pose->Normals.empty())
+				Normals = Pose->Normals;
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+// Keeps the pose just found, in place of the least recently used one if the cache is full
+void Model3D::StorePose(GLshort SeqIndex, GLshort FrameIndex, GLfloat MixFrac,
+	GLshort AddlFrameIndex, bool UseModelTransform)
+{
+	if (!use_pose_cache) return;
+	
+	Model3D_Pose *Pose;
+	if (Poses.size() < MaxPoses)
+	{
+		Poses.push_back(Model3D_Pose());
+		Pose = &Poses.back();
+	}
+	else
+	{
+		Pose = &Poses[0];
+		for (vector<Model3D_Pose>::iterator Iter = Poses.begin(); Iter != Poses.end(); Iter++)
+			if (Iter->LastUsed < Pose->LastUsed)
+				Pose = &(*Iter);
+	}
+	
+	Pose->Sequence = SeqIndex;
+	Pose->Frame = FrameIndex;
+	Pose->MixFrac = MixFrac;
+	Pose->AddlFrame = AddlFrameIndex;
+	Pose->UseModelTransform = UseModelTransform;
+	Pose->LastUsed = ++PoseClock;
+	Pose->Positions = Positions;
+	if (!NormSources.empty())
+		Pose->Normals = Normals;
+	else
+		Pose->Normals.clear();
+}
+
+
+// Frame case
+bool Model3D::FindPositions_Frame(bool UseModelTransform,
+	GLshort FrameIndex, GLfloat MixFrac, GLshort AddlFrameIndex)
+{
+	// Bad inputs: do nothing and return false
+	
+	if (Frames.empty()) return false;
+	
+	size_t NumBones = Bones.size();
+	if (FrameIndex < 0 || NumBones*FrameIndex >= Frames.size()) return false;
+	
+	// The same pose either way
+	if (MixFrac == 0 || AddlFrameIndex == FrameIndex)
+	{
+		MixFrac = 0;
+		AddlFrameIndex = FrameIndex;
+	}
+	
+	if (InverseVSIndices.empty()) BuildInverseVSIndices();
+	
+	size_t NumVertices = VtxSrcIndices.size();
+	Positions.resize(3*NumVertices);
+	
+	bool NormalsPresent = !NormSources.empty();
+	if (NormalsPresent) Normals.resize(NormSources.size());
+	
+	if (FindPose(NONE,FrameIndex,MixFrac,AddlFrameIndex,UseModelTransform)) return true;
+	
+	FindBoneMatrices(FrameIndex,MixFrac,AddlFrameIndex);
+	
+	Model3D_Transform *PosTransform = UseModelTransform ? &TransformPos : NULL;
+	Model3D_Transform *NormTransform = UseModelTransform ? &TransformNorm : NULL;
+	if (use_vector_skinning)
+		SkinVertices(PosTransform,NormTransform);
+	else
+		SkinVertices_Scalar(PosTransform,NormTransform);
+	
+	StorePose(NONE,FrameIndex,MixFrac,AddlFrameIndex,UseModelTransform);
 	
 	return true;
 }
@@ -943,61 +1353,133 @@ bool Model3D::FindPositions_Sequence(bool UseModelTransform, GLshort SeqIndex,
 	
 	if (FrameIndex < 0 || FrameIndex >= NumSF) return false;
 	
-	Model3D_Transform TSF;
+	if (MixFrac == 0 || AddlFrameIndex == FrameIndex)
+	{
+		MixFrac = 0;
+		AddlFrameIndex = FrameIndex;
+	}
+	else if (AddlFrameIndex < 0 || AddlFrameIndex >= NumSF) return false;
 	
 	Model3D_SeqFrame& SF = SeqFrames[SeqFrmPointers[SeqIndex] + FrameIndex];
+	Model3D_SeqFrame& ASF = SeqFrames[SeqFrmPointers[SeqIndex] + AddlFrameIndex];
+	
+	if (Frames.empty()) return false;
+	
+	size_t NumBones = Bones.size();
+	if (SF.Frame < 0 || NumBones*SF.Frame >= Frames.size()) return false;
+	
+	if (InverseVSIndices.empty()) BuildInverseVSIndices();
+	
+	size_t NumVertices = VtxSrcIndices.size();
+	Positions.resize(3*NumVertices);
 	
-	if (MixFrac != 0 && AddlFrameIndex != FrameIndex)
+	bool NormalsPresent = !NormSources.empty();
+	if (NormalsPresent) Normals.resize(NormSources.size());
+	
+	if (FindPose(SeqIndex,FrameIndex,MixFrac,AddlFrameIndex,UseModelTransform)) return true;
+	
+	Model3D_Transform TSF;
+	FindFrameTransform(TSF,SF,MixFrac,ASF);
+	FindBoneMatrices(SF.Frame,MixFrac,ASF.Frame);
+	
+	// The sequence frame's transform, and the model's after it
+	Model3D_Transform PosTransform, NormTransform;
+	if (UseModelTransform)
 	{
-		if (AddlFrameIndex < 0 || AddlFrameIndex >= NumSF) return false;
-		
-		Model3D_SeqFrame& ASF = SeqFrames[SeqFrmPointers[SeqIndex] + AddlFrameIndex];
-		FindFrameTransform(TSF,SF,MixFrac,ASF);
-		
-		if (!FindPositions_Frame(false,SF.Frame,MixFrac,ASF.Frame)) return false;
+		TMatMultiply(PosTransform,TransformPos,TSF);
+		TMatMultiply(NormTransform,TransformNorm,TSF);
 	}
 	else
 	{
-		if (!FindPositions_Frame(false,SF.Frame)) return false;
-		FindFrameTransform(TSF,SF,0,SF);
+		obj_copy(PosTransform,TSF);
+		obj_copy(NormTransform,TSF);
 	}
 	
-	Model3D_Transform TTot;
-	if (UseModelTransform)
-		TMatMultiply(TTot,TransformPos,TSF);
+	if (use_vector_skinning)
+		SkinVertices(&PosTransform,&NormTransform);
 	else
-		obj_copy(TTot,TSF);
+		SkinVertices_Scalar(&PosTransform,&NormTransform);
+	
+	StorePose(SeqIndex,FrameIndex,MixFrac,AddlFrameIndex,UseModelTransform);
+	
+	return true;
+}
+
+
+static bool PoseAgrees(const vector<GLfloat>& A, const vector<GLfloat>& B)
+{
+	if (A.size() != B.size()) return false;
+	
+	// Folding the transforms into the bone matrices rounds differently
+	for (size_t k=0; k<A.size(); k++)
+		if (fabs(A[k] - B[k]) > 1e-4*(1 + fabs(A[k])))
+			return false;
+	
+	return true;
+}
+
+bool Model3D::BenchmarkPosing(int Repeats, uint32 *PoseCount,
+	uint32 *ScalarTicks, uint32 *VectorTicks, uint32 *CachedTicks)
+{
+	const GLfloat MixFracs[] = {0, 0.25, 0.5, 0.75};
+	const int NumMixFracs = sizeof(MixFracs)/sizeof(MixFracs[0]);
+	
+	bool saved_use_vector_skinning = use_vector_skinning;
+	bool saved_use_pose_cache = use_pose_cache;
 	
-	size_t NumVerts = Positions.size()/3;
-	GLfloat *Pos = PosBase();
-	for (size_t iv=0; iv<NumVerts; iv++)
+	*PoseCount = 0;
+	*ScalarTicks = *VectorTicks = *CachedTicks = 0;
+	
+	// Check every pose once
+	bool Agree = true;
+	use_pose_cache = false;
+	for (GLshort Seq=0; Seq<TrueNumSeqs(); Seq++)
 	{
-		GLfloat NewPos[3];
-		TransformPoint(NewPos,Pos,TTot);
-		VecCopy(NewPos,Pos);
-		Pos += 3;
+		GLshort NumSF = NumSeqFrames(Seq);
+		for (GLshort Frame=0; Frame<NumSF; Frame++)
+			for (int im=0; im<NumMixFracs; im++)
+			{
+				GLshort NextFrame = (Frame + 1) % NumSF;
+				
+				use_vector_skinning = false;
+				if (!FindPositions_Sequence(true,Seq,Frame,MixFracs[im],NextFrame)) continue;
+				vector<GLfloat> ScalarPositions(Positions), ScalarNormals(Normals);
+				
+				use_vector_skinning = true;
+				FindPositions_Sequence(true,Seq,Frame,MixFracs[im],NextFrame);
+				if (!PoseAgrees(ScalarPositions,Positions) || !PoseAgrees(ScalarNormals,Normals))
+					Agree = false;
+				
+				(*PoseCount)++;
+			}
 	}
 	
-	bool NormalsPresent = !NormSources.empty();
-	if (NormalsPresent)
-	{	
-		// OK, since the bones don't change bulk
-		if (UseModelTransform)
-			TMatMultiply(TTot,TransformNorm,TSF);
-		else
-			obj_copy(TTot,TSF);
-				
-		GLfloat *Norm = NormBase();
-		for (size_t iv=0; iv<NumVerts; iv++)
+	// Then time them; each pose is found Repeats times in a row,
+	// as for that many monsters in step with each other
+	uint32 *Ticks[3] = {ScalarTicks, VectorTicks, CachedTicks};
+	for (int Method=0; Method<3; Method++)
+	{
+		use_vector_skinning = (Method > 0);
+		use_pose_cache = (Method == 2);
+		ClearPoses();
+		
+		uint32 Start = machine_tick_count();
+		for (GLshort Seq=0; Seq<TrueNumSeqs(); Seq++)
 		{
-			GLfloat NewNorm[3];
-			TransformVector(NewNorm,Norm,TTot);
-			VecCopy(NewNorm,Norm);
-			Norm += 3;
+			GLshort NumSF = NumSeqFrames(Seq);
+			for (GLshort Frame=0; Frame<NumSF; Frame++)
+				for (int im=0; im<NumMixFracs; im++)
+					for (int ir=0; ir<Repeats; ir++)
+						FindPositions_Sequence(true,Seq,Frame,MixFracs[im],(Frame + 1) % NumSF);
 		}
+		*Ticks[Method] = machine_tick_count() - Start;
 	}
 	
-	return true;
+	use_vector_skinning = saved_use_vector_skinning;
+	use_pose_cache = saved_use_pose_cache;
+	ClearPoses();
+	
+	return Agree;
 }
 
 
@@ -1116,7 +1598,7 @@ static void FindBoneTransform(Model3D_Transform& T, Model3D_Bone& Bone,
 
 
 // Res = A * B, in that order
-static void TMatMultiply(Model3D_Transform& Res, Model3D_Transform& A, Model3D_Transform& B)
+static void TMatMultiply(Model3D_Transform& Res, const Model3D_Transform& A, const Model3D_Transform& B)
 {
 	// Multiply the rotation parts
 	for (int i=0; i<3; i++)
@@ -97,6 +97,42 @@ struct Model3D_Transform
 };
 
 
+// The vertex sources and normals rearranged for skinning several at a time:
+// separate arrays of each coordinate, in groups that follow the same bones.
+// Each group is padded out to a multiple of 4 entries, with index UNONE.
+struct Model3D_SkinArrays
+{
+	vector<GLfloat> X, Y, Z, Blend;
+	vector<GLushort> Index;		// Vertex source for the positions, vertex for the normals
+	
+	void Clear();
+	void Add(const GLfloat *V, GLfloat _Blend, GLushort _Index);
+	void Pad();
+};
+
+struct Model3D_SkinGroup
+{
+	GLshort Bone0, Bone1;		// NONE for the root bone; Bone1 is NONE for no blending
+	GLuint PosStart, PosEnd;	// Into the position arrays
+	GLuint NormStart, NormEnd;	// Into the normal arrays
+};
+
+
+// A pose found by FindPositions_Frame() or FindPositions_Sequence(), kept so that
+// drawing the model again in the same frame of animation (as a crowd of monsters
+// of the same kind often does) need only copy it
+struct Model3D_Pose
+{
+	GLshort Sequence;		// NONE for FindPositions_Frame()
+	GLshort Frame, AddlFrame;
+	GLfloat MixFrac;
+	bool UseModelTransform;
+	uint32 LastUsed;
+	
+	vector<GLfloat> Positions, Normals;
+};
+
+
 struct Model3D
 {
 	// Assumed dimensions:
@@ -181,9 +217,22 @@ struct Model3D
 	// True number of sequences:
 	int TrueNumSeqs() {return std::max(int(SeqFrmPointers.size()-1),0);}
 	
-	// Add-on transforms for the positions and the normals
+	// Add-on transforms for the positions and the normals;
+	// call ClearPoses() after changing them
 	Model3D_Transform TransformPos, TransformNorm;
 	
+	// Skinning layout; built from the vertex sources when first needed
+	vector<Model3D_SkinGroup> SkinGroups;
+	Model3D_SkinArrays SkinPositions, SkinNormals;
+	
+	// The most recently used poses, up to MaxPoses of them
+	enum {MaxPoses = 8};
+	vector<Model3D_Pose> Poses;
+	uint32 PoseClock;
+	
+	// Forget the skinning layout and the poses found with it
+	void ClearPoses();
+	
 	// Bounding box (first index: 0 = min, 1 = max)
 	GLfloat BoundingBox[2][3];
 	
@@ -251,8 +300,29 @@ struct Model3D
 	bool FindPositions_Sequence(bool UseModelTransform, GLshort SeqIndex,
 		GLshort FrameIndex, GLfloat MixFrac = 0, GLshort AddlFrameIndex = 0);
 	
+	// Poses the model through every frame of every sequence, with several crossfade
+	// fractions, three ways: with the original one-vertex-at-a-time skinning, with the
+	// vectorized skinning, and with the vectorized skinning and the pose cache;
+	// each pose is found Repeats times in a row. Returns whether the first two
+	// agree to within rounding error.
+	bool BenchmarkPosing(int Repeats, uint32 *PoseCount,
+		uint32 *ScalarTicks, uint32 *VectorTicks, uint32 *CachedTicks);
+	
 	// Constructor
-	Model3D() {FindBoundingBox(); TransformPos.Identity(); TransformNorm.Identity();}
+	Model3D(): PoseClock(0) {FindBoundingBox(); TransformPos.Identity(); TransformNorm.Identity();}
+	
+private:
+	void FindBoneMatrices(GLshort FrameIndex, GLfloat MixFrac, GLshort AddlFrameIndex);
+	void BuildSkinGroups();
+	
+	// Skin with the bone matrices, then apply the transforms (either may be NULL)
+	void SkinVertices(const Model3D_Transform *PosTransform, const Model3D_Transform *NormTransform);
+	void SkinVertices_Scalar(const Model3D_Transform *PosTransform, const Model3D_Transform *NormTransform);
+	
+	bool FindPose(GLshort SeqIndex, GLshort FrameIndex, GLfloat MixFrac,
+		GLshort AddlFrameIndex, bool UseModelTransform);
+	void StorePose(GLshort SeqIndex, GLshort FrameIndex, GLfloat MixFrac,
+		GLshort AddlFrameIndex, bool UseModelTransform);
 };
 
 #endif
@@ -24,6 +24,9 @@
  *
  *  May 27, 2003 (Woody Zenfell):
  *	Support for lossy streaming data distribution.
+ *
+ *  Oct 17, 2026:
+ *	Sync() with a local player index of NONE runs just the hub, for the dedicated hub.
  */
 
 #if !defined(DISABLE_NETWORKING)
@@ -56,6 +59,7 @@ protected:
 
 static WritableTickBasedActionQueue* sStarQueues[MAXIMUM_NUMBER_OF_NETWORK_PLAYERS];
 static bool		sHubIsLocal;
+static bool		sSpokeIsLocal;
 static NetTopology*	sTopology = NULL;
 static short*		sNetStatePtr = NULL;
 
@@ -112,20 +116,25 @@ StarGameProtocol::Sync(NetTopology* inTopology, int32 inSmallestGameTick, size_t
 	assert(inTopology != NULL);
 	
 	sTopology = inTopology;
+
+	// a dedicated hub has no player, and so no spoke (or game world) of its own
+	sSpokeIsLocal = (inLocalPlayerIndex != static_cast<size_t>(NONE));
 	
         bool theConnectedPlayerStatus[MAXIMUM_NUMBER_OF_NETWORK_PLAYERS];
+        bool theCompactActionFlags[MAXIMUM_NUMBER_OF_NETWORK_PLAYERS];
 
         for(int i = 0; i < sTopology->player_count; i++)
         {
-                if(sTopology->players[i].identifier == NONE)
+                if(sTopology->players[i].identifier == NONE || !sSpokeIsLocal)
                         sStarQueues[i] = NULL;
                 else
                         sStarQueues[i] = new LegacyActionQueueToTickBasedQueueAdapter<action_flags_t>(i);
 
                 theConnectedPlayerStatus[i] = ((sTopology->players[i].identifier != NONE) && !sTopology->players[i].net_dead);
+                theCompactActionFlags[i] = theConnectedPlayerStatus[i] && NetPlayerReadsCompactActionFlags(i);
         }
 
-        if(inLocalPlayerIndex == inServerPlayerIndex)
+        if(inLocalPlayerIndex == inServerPlayerIndex || !sSpokeIsLocal)
         {
 		sHubIsLocal = true;
 		
@@ -134,13 +143,14 @@ StarGameProtocol::Sync(NetTopology* inTopology, int32 inSmallestGameTick, size_t
                 for(int i = 0; i < sTopology->player_count; i++)
                         theAddresses[i] = (theConnectedPlayerStatus[i] ? &(sTopology->players[i].ddpAddress) : NULL);
 
-                hub_initialize(inSmallestGameTick, sTopology->player_count, theAddresses, inLocalPlayerIndex);
+                hub_initialize(inSmallestGameTick, sTopology->player_count, theAddresses, inLocalPlayerIndex, theCompactActionFlags);
         }
 	else
 		sHubIsLocal = false;
 
-        spoke_initialize(sTopology->players[inServerPlayerIndex].ddpAddress, inSmallestGameTick, sTopology->player_count,
-                         sStarQueues, theConnectedPlayerStatus, inLocalPlayerIndex, sHubIsLocal);
+        if(sSpokeIsLocal)
+                spoke_initialize(sTopology->players[inServerPlayerIndex].ddpAddress, inSmallestGameTick, sTopology->player_count,
+                                 sStarQueues, theConnectedPlayerStatus, inLocalPlayerIndex, sHubIsLocal, theCompactActionFlags[inServerPlayerIndex]);
 
         *sNetStatePtr = netActive;
 
@@ -154,7 +164,8 @@ StarGameProtocol::UnSync(bool inGraceful, int32 inSmallestPostgameTick)
 {
         if(*sNetStatePtr == netStartingUp || *sNetStatePtr == netActive)
         {
-                spoke_cleanup(inGraceful);
+                if(sSpokeIsLocal)
+                        spoke_cleanup(inGraceful);
                 if(sHubIsLocal)
                         hub_cleanup(inGraceful, inSmallestPostgameTick);
 
@@ -218,6 +229,10 @@ StarGameProtocol::UpdateUnconfirmedActionFlags()
 void
 make_player_really_net_dead(size_t inPlayerIndex)
 {
+        // (the loopback harness runs a spoke without a game)
+        if(sTopology == NULL)
+                return;
+
         assert(inPlayerIndex < static_cast<size_t>(sTopology->player_count));
         sTopology->players[inPlayerIndex].net_dead = true;
 }
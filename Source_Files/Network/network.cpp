@@ -94,6 +94,9 @@ July 03, 2003 (jkvw):
 September 17, 2004 (jkvw):
 	NAT-friendly networking.  That is, joiners behind firewalls should be able to play.
 	Also moved to TCPMess for TCP communications.
+
+Oct 17, 2026:
+	Added NetGatherDedicated(), for gathering and serving a game from a dedicated hub
 */
 
 #if defined(DISABLE_NETWORKING)
@@ -203,6 +206,7 @@ static MessageInflater *inflater = NULL;
 static MessageDispatcher *joinDispatcher = NULL;
 static uint32 next_join_attempt;
 static Capabilities my_capabilities;
+static Capabilities gatherer_capabilities; // as the gatherer sent them, when joining
 
 static GatherCallbacks *gatherCallbacks = NULL;
 static ChatCallbacks *chatCallbacks = NULL;
@@ -305,6 +309,10 @@ static bool		new_incoming_chat_message = false;
 // Used, at least, on the gatherer to determine whether or not to resort players by address
 static bool resuming_saved_game = false;
 
+// Are we a dedicated hub?  It gathers as usual, but holds the server's slot with a player who
+// is netdead from the start, and runs only the hub at NetSync().
+static bool sDedicatedHub = false;
+
 
 /* ---------- private prototypes */
 void NetPrintInfo(void);
@@ -771,6 +779,7 @@ static void handleCapabilitiesMessage(CapabilitiesMessage* capabilitiesMessage,
 {
 	if (handlerState == netJoining) {
 		Capabilities capabilities = *capabilitiesMessage->capabilities();
+		gatherer_capabilities = capabilities;
 		if (capabilities[Capabilities::kGameworld] < Capabilities::kGameworldVersion || (shapes_file_is_m1() && capabilities[Capabilities::kGameworldM1] < Capabilities::kGameworldM1Version) || (network_preferences->game_protocol == _network_game_protocol_star && capabilities[Capabilities::kStar] < Capabilities::kStarVersion))
 		{
 			// I'm not gatherable
@@ -1221,11 +1230,13 @@ bool NetEnter(void)
 	}
 
 	my_capabilities.clear();
+	gatherer_capabilities.clear();
 	my_capabilities[Capabilities::kGameworld] = Capabilities::kGameworldVersion;
 	my_capabilities[Capabilities::kGameworldM1] = Capabilities::kGameworldM1Version;
 	my_capabilities[Capabilities::kSpeex] = Capabilities::kSpeexVersion;
 	if (network_preferences->game_protocol == _network_game_protocol_star) {
 		my_capabilities[Capabilities::kStar] = Capabilities::kStarVersion;
+		my_capabilities[Capabilities::kStarCompactFlags] = Capabilities::kStarCompactFlagsVersion;
 	} else {
 		my_capabilities[Capabilities::kRing] = Capabilities::kRingVersion;
 	}
@@ -1292,6 +1303,7 @@ void NetExit(
 			sCurrentGameProtocol->Exit2();
       
 			netState= netUninitialized;
+			sDedicatedHub = false;
 		} else {
 			logAnomaly("NetDDPCloseSocket returned %i", error);
 		}
@@ -1350,6 +1362,10 @@ void NetExit(
 bool
 NetSync()
 {
+	// a dedicated hub has no world; new games start at tick 0
+	if (sDedicatedHub)
+		return sCurrentGameProtocol->Sync(topology, 0, NONE, sServerPlayerIndex);
+
 	return sCurrentGameProtocol->Sync(topology, dynamic_world->tick_count, localPlayerIndex, sServerPlayerIndex);
 }
 
@@ -1358,6 +1374,10 @@ NetSync()
 bool
 NetUnSync()
 {
+	// nor does it know when the game ends; it stops once the players have gone
+	if (sDedicatedHub)
+		return sCurrentGameProtocol->UnSync(false, 0);
+
 	return sCurrentGameProtocol->UnSync(true, dynamic_world->tick_count);
 }
 
@@ -1534,6 +1554,23 @@ bool NetGather(
 	return true;
 }
 
+bool NetGatherDedicated(
+	void *game_data,
+	short game_data_size,
+	void *player_data,
+	short player_data_size)
+{
+	assert(network_preferences->game_protocol == _network_game_protocol_star);
+
+	if (!NetGather(game_data, game_data_size, player_data, player_data_size, false))
+		return false;
+
+	sDedicatedHub = true;
+	topology->players[localPlayerIndex].net_dead = true;
+
+	return true;
+}
+
 void NetCancelGather(
 	void)
 {
@@ -1720,6 +1757,33 @@ short NetGetPlayerIdentifier(
 	return topology->players[player_index].identifier;
 }
 
+// The gatherer knows what each joiner can read; a joiner only sends to the hub, and so
+// only needs to know about the gatherer.
+bool NetPlayerReadsCompactActionFlags(
+	short player_index)
+{
+	assert(player_index>=0&&player_index<topology->player_count);
+
+	if (player_index == localPlayerIndex)
+		return true;
+
+	if (localPlayerIndex == sServerPlayerIndex)
+	{
+		const NetPlayer& player = topology->players[player_index];
+		if (player.identifier == NONE)
+			return false;
+
+		client_map_t::iterator it = connections_to_clients.find(player.stream_id);
+		return it != connections_to_clients.end() && it->second->capabilities[Capabilities::kStarCompactFlags] >= Capabilities::kStarCompactFlagsVersion;
+	}
+	else if (player_index == sServerPlayerIndex)
+	{
+		return gatherer_capabilities[Capabilities::kStarCompactFlags] >= Capabilities::kStarCompactFlagsVersion;
+	}
+
+	return false;
+}
+
 bool NetNumberOfPlayerIsValid(
 	void)
 {
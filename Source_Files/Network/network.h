@@ -194,6 +194,10 @@ void NetExit(void);
 bool NetGather(void *game_data, short game_data_size, void *player_data, 
 	short player_data_size, bool resuming_game);
 
+// for a dedicated hub: gathers a new game that the hub (player_data) serves but doesn't play in
+bool NetGatherDedicated(void *game_data, short game_data_size, void *player_data,
+	short player_data_size);
+
 struct SSLP_ServiceInstance;
 
 enum { // NetGatherPlayer results
@@ -31,5 +31,6 @@ const string Capabilities::kGatherable = "Gatherable";
 const string Capabilities::kZippedData = "ZippedData";
 const string Capabilities::kNetworkStats = "NetworkStats";
 const string Capabilities::kRugby = "Rugby";
+const string Capabilities::kStarCompactFlags = "StarCompactFlags";
 
 
@@ -47,6 +47,7 @@ class Capabilities : public capabilities_t
   static const int kZippedDataVersion = 1; // map, lua, physics
   static const int kNetworkStatsVersion = 1; // latency, jitter, errors
   static const int kRugbyVersion = 1; // sane score limit
+  static const int kStarCompactFlagsVersion = 1; // V2 star game data packets
 
   static const string kGameworld;    // the PRNG, physics, etc.
   static const string kGameworldM1;  // like gameworld, but for Marathon 1 compatibility
@@ -59,6 +60,7 @@ class Capabilities : public capabilities_t
   static const string kZippedData;   // can receive zipped data
   static const string kNetworkStats; // can receive network stats
   static const string kRugby;        // rugby version
+  static const string kStarCompactFlags; // reads run-length encoded action flags
   
   uint32& operator[](const string& k) { 
     assert(k.length() < kMaxKeySize);
@@ -0,0 +1,346 @@
+/*
+ *  network_dedicated_hub.cpp - hosts netgames from a machine with no player on it
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+
+ *  The gathering is network.cpp's, as the gather dialog would drive it with autogather
+ *  on; the hub is network_star_hub.cpp's, started by NetSync() with no local player.
+ *  Joiners see the hub as the server player, netdead from the first tick, and need
+ *  nothing new.
+ *
+ *  The hub never simulates the game, so it can't tell when the level changes: a game
+ *  is one level, and ends when every player has gone netdead (which they do when it
+ *  ends for them).  Netscripts aren't sent.
+ */
+
+#if !defined(DISABLE_NETWORKING)
+
+#include "cseries.h"
+#include "network_dedicated_hub.h"
+
+#include "network.h"
+#include "network_private.h"
+#include "network_dialogs.h"
+#include "network_games.h"
+#include "game_wad.h"
+#include "interface.h"
+#include "map.h"
+#include "preferences.h"
+#include "wad.h"
+#include "Logging.h"
+
+#include <map>
+
+#include "SDL_timer.h"
+
+dedicated_hub_options::dedicated_hub_options() :
+	name("Hub"),
+	port(0),
+	level(NONE),
+	players(MAXIMUM_NUMBER_OF_NETWORK_PLAYERS - 1),
+	wait(60),
+	report_period(30),
+	games(0)
+{
+}
+
+// how long to sleep between looking at the network, while gathering and in game
+static const uint32 kGatherPollPeriod = MACHINE_TICKS_PER_SECOND / 20;
+static const uint32 kGamePollPeriod = MACHINE_TICKS_PER_SECOND / 100;
+
+// joiners we haven't gathered yet, and those we've gathered who haven't accepted
+typedef std::map<int, prospective_joiner_info> joiner_map_t;
+static joiner_map_t sUngatheredPlayers;
+static joiner_map_t sJoiningPlayers;
+
+class DedicatedHubGatherCallbacks : public GatherCallbacks
+{
+public:
+	void JoinSucceeded(const prospective_joiner_info *player) {
+		joiner_map_t::iterator it = sJoiningPlayers.find(player->stream_id);
+		if (it != sJoiningPlayers.end())
+		{
+			printf("%s joined\n", it->second.name);
+			logNote("dedicated hub: %s joined", it->second.name);
+			sJoiningPlayers.erase(it);
+		}
+	}
+
+	void JoiningPlayerDropped(const prospective_joiner_info *player) {
+		sUngatheredPlayers.erase(player->stream_id);
+	}
+
+	void JoinedPlayerDropped(const prospective_joiner_info *player) {
+		logNote("dedicated hub: player on stream %i left before the game started", player->stream_id);
+	}
+};
+
+static bool setup_game(const dedicated_hub_options& options, game_info& game)
+{
+	obj_clear(game);
+
+	game.net_game_type = network_preferences->game_type;
+	game.game_options = network_preferences->game_options | _ammo_replenishes | _weapons_replenish | _specials_replenish;
+	if (game.net_game_type == _game_of_cooperative_play)
+		game.game_options |= _overhead_map_is_omniscient;
+	game.time_limit = network_preferences->game_is_untimed ? INT32_MAX : network_preferences->time_limit;
+	game.kill_limit = network_preferences->kill_limit;
+	game.difficulty_level = network_preferences->difficulty_level;
+	game.allow_mic = network_preferences->allow_microphone;
+	game.cheat_flags = network_preferences->cheat_flags;
+	game.server_is_playing = false;
+	game.initial_updates_per_packet = 1;
+	game.initial_update_latency = 0;
+	game.initial_random_seed = static_cast<uint16>(machine_tick_count());
+
+	// the level asked for, if the game type can be played there; otherwise the first that can
+	int16 level = (options.level != NONE) ? options.level : network_preferences->entry_point;
+	int32 entry_flags = get_entry_point_flags_for_game_type(game.net_game_type);
+
+	entry_point entry, first_entry;
+	short index = 0;
+	bool found = false, found_any = false;
+	while (!found && get_indexed_entry_point(&entry, &index, entry_flags))
+	{
+		if (!found_any)
+		{
+			first_entry = entry;
+			found_any = true;
+		}
+		found = (entry.level_number == level);
+	}
+
+	if (!found_any)
+	{
+		fprintf(stderr, "The map file has no levels for this game type\n");
+		return false;
+	}
+	if (!found)
+	{
+		logWarning("dedicated hub: level %i can't be played in this game type; using level %i", level, first_entry.level_number);
+		entry = first_entry;
+	}
+
+	game.level_number = entry.level_number;
+	strncpy(game.level_name, entry.level_name, MAX_LEVEL_NAME_LENGTH);
+	game.level_name[MAX_LEVEL_NAME_LENGTH] = 0;
+	game.parent_checksum = read_wad_file_checksum(get_map_file());
+
+	return true;
+}
+
+// returns once enough players have joined, or we've waited long enough for more
+static void gather_players(const dedicated_hub_options& options)
+{
+	GathererAvailableAnnouncer announcer;
+	uint32 first_join_ticks = 0;
+
+	while (true)
+	{
+		GathererAvailableAnnouncer::pump();
+
+		prospective_joiner_info info;
+		while (NetCheckForNewJoiner(info))
+			sUngatheredPlayers[info.stream_id] = info;
+
+		// everyone who can, as autogather would
+		joiner_map_t::iterator it = sUngatheredPlayers.begin();
+		while (it != sUngatheredPlayers.end() && NetGetNumberOfPlayers() + static_cast<int>(sJoiningPlayers.size()) < MAXIMUM_NUMBER_OF_NETWORK_PLAYERS)
+		{
+			if (NetGatherPlayer(it->second, reassign_player_colors) != kGatherPlayerFailed)
+				sJoiningPlayers[it->first] = it->second;
+			sUngatheredPlayers.erase(it++);
+		}
+
+		int joined = NetGetNumberOfPlayers() - 1;
+		if (joined >= options.players || joined + 1 >= MAXIMUM_NUMBER_OF_NETWORK_PLAYERS)
+			break;
+
+		if (joined == 0)
+			first_join_ticks = 0;
+		else if (first_join_ticks == 0)
+			first_join_ticks = machine_tick_count();
+		else if (options.wait > 0 && machine_tick_count() - first_join_ticks >= static_cast<uint32>(options.wait) * MACHINE_TICKS_PER_SECOND)
+			break;
+
+		SDL_Delay(kGatherPollPeriod);
+	}
+
+	// anyone still on their way in would arrive after the game started
+	for (joiner_map_t::iterator it = sJoiningPlayers.begin(); it != sJoiningPlayers.end(); ++it)
+		NetHandleUngatheredPlayer(it->second);
+	for (joiner_map_t::iterator it = sUngatheredPlayers.begin(); it != sUngatheredPlayers.end(); ++it)
+		NetHandleUngatheredPlayer(it->second);
+	sJoiningPlayers.clear();
+	sUngatheredPlayers.clear();
+}
+
+static bool distribute_map(const game_info& game)
+{
+	entry_point entry;
+	entry.level_number = game.level_number;
+	strncpy(entry.level_name, game.level_name, sizeof(entry.level_name));
+
+	byte *wad = static_cast<byte *>(get_map_for_net_transfer(&entry));
+	if (!wad)
+	{
+		logError("dedicated hub: couldn't read level %i of the map", game.level_number);
+		return false;
+	}
+
+	OSErr error = NetDistributeGameDataToAllPlayers(wad, get_net_map_data_length(wad), true);
+	free(wad);
+
+	return error == noErr;
+}
+
+static void report_players()
+{
+	short hub_index = NetGetLocalPlayerIndex();
+	for (short player_index = 0; player_index < NetGetNumberOfPlayers(); ++player_index)
+	{
+		if (player_index == hub_index)
+			continue;
+
+		const char *name = static_cast<player_info *>(NetGetPlayerData(player_index))->name;
+		const NetworkStats& stats = NetGetStats(player_index);
+		if (stats.latency == NetworkStats::disconnected)
+		{
+			printf("  %-32s netdead\n", name);
+		}
+		else if (stats.latency == NetworkStats::invalid)
+		{
+			printf("  %-32s waiting\n", name);
+		}
+		else
+		{
+			printf("  %-32s latency %4i ms, jitter %4i ms, %u errors\n", name, stats.latency, stats.jitter, stats.errors);
+			logNote("dedicated hub: player %i (%s) latency %i ms, jitter %i ms, %u errors", player_index, name, stats.latency, stats.jitter, stats.errors);
+		}
+	}
+	fflush(stdout);
+}
+
+// returns once every player has gone netdead
+static void serve_game(const dedicated_hub_options& options)
+{
+	const uint32 report_period = static_cast<uint32>(std::max(options.report_period, 1)) * MACHINE_TICKS_PER_SECOND;
+	uint32 last_report = machine_tick_count();
+
+	while (true)
+	{
+		// relays chat, and sends joiners everyone's stats
+		NetProcessMessagesInGame();
+
+		bool anyone_connected = false;
+		for (short player_index = 0; player_index < NetGetNumberOfPlayers(); ++player_index)
+		{
+			if (NetGetStats(player_index).latency != NetworkStats::disconnected)
+				anyone_connected = true;
+		}
+		if (!anyone_connected)
+			break;
+
+		if (machine_tick_count() - last_report >= report_period)
+		{
+			report_players();
+			last_report = machine_tick_count();
+		}
+
+		SDL_Delay(kGamePollPeriod);
+	}
+
+	report_players();
+}
+
+// returns false if the game couldn't be set up at all
+static bool host_game(const dedicated_hub_options& options, int game_number)
+{
+	game_info game;
+	if (!setup_game(options, game))
+		return false;
+
+	player_info hub;
+	obj_clear(hub);
+	strncpy(hub.name, options.name.c_str(), MAX_NET_PLAYER_NAME_LENGTH);
+	hub.color = hub.desired_color = hub.team = 0;
+
+	SetNetscriptStatus(false);
+
+	if (!NetEnter())
+		return false;
+
+	if (!NetGatherDedicated(&game, sizeof(game), &hub, sizeof(hub)))
+	{
+		NetExit();
+		return false;
+	}
+
+	printf("Game %i: waiting for players on port %u, level %i (%s)\n", game_number, network_preferences->game_port, game.level_number, game.level_name);
+	fflush(stdout);
+	logNote("dedicated hub: gathering game %i on port %u, level %i", game_number, network_preferences->game_port, game.level_number);
+
+	DedicatedHubGatherCallbacks callbacks;
+	NetSetGatherCallbacks(&callbacks);
+	gather_players(options);
+	NetSetGatherCallbacks(NULL);
+	NetDoneGathering();
+
+	if (NetGetNumberOfPlayers() > 1)
+	{
+		NetStart();
+		printf("Game %i: started with %i players\n", game_number, NetGetNumberOfPlayers() - 1);
+		fflush(stdout);
+		logNote("dedicated hub: game %i started with %i players", game_number, NetGetNumberOfPlayers() - 1);
+
+		if (distribute_map(game))
+		{
+			if (NetSync())
+				serve_game(options);
+			NetUnSync();
+		}
+
+		printf("Game %i: over\n", game_number);
+		fflush(stdout);
+		logNote("dedicated hub: game %i over", game_number);
+	}
+	else
+	{
+		NetCancelGather();
+	}
+
+	NetExit();
+	return true;
+}
+
+int run_dedicated_hub(const dedicated_hub_options& options)
+{
+	// the hub is the star protocol's
+	network_preferences->game_protocol = _network_game_protocol_star;
+	if (options.port)
+		network_preferences->game_port = options.port;
+
+	for (int game_number = 1; options.games == 0 || game_number <= options.games; ++game_number)
+	{
+		if (!host_game(options, game_number))
+			return 1;
+	}
+
+	return 0;
+}
+
+#endif // !defined(DISABLE_NETWORKING)
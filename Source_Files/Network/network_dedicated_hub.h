@@ -0,0 +1,48 @@
+#ifndef NETWORK_DEDICATED_HUB_H
+#define NETWORK_DEDICATED_HUB_H
+
+/*
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+
+	Hosts netgames without playing in them: gathers joiners, sends them the map, and
+	runs the star hub until they have all gone, with no window, sound or game world.
+	The game is set up from the network game preferences, as the gatherer last set it.
+
+*/
+
+#include "cseries.h"
+
+#include <string>
+
+struct dedicated_hub_options
+{
+	std::string name;	// shown to joiners as the (netdead) server player
+	uint16 port;		// 0: the game port from the preferences
+	int16 level;		// NONE: the level from the preferences
+	int16 players;		// start the game once this many have joined...
+	int32 wait;		// ...or this many seconds after the first one did (0: never)
+	int32 report_period;	// seconds between reports of each player's latency
+	int32 games;		// host this many games, one after another (0: until killed)
+
+	dedicated_hub_options();
+};
+
+// returns the exit status: nonzero if a game couldn't be set up
+int run_dedicated_hub(const dedicated_hub_options& options);
+
+#endif
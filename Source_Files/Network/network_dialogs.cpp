@@ -64,6 +64,9 @@ Apr 10, 2003 (Woody Zenfell):
  August 27, 2003 (Woody Zenfell):
 	Reworked netscript selection stuff to use Preferences and to be more cross-platform
 	and more consistent with other dialog code
+
+Oct 17, 2026:
+	The progress dialog does nothing without a main screen (on the dedicated hub)
 */
 
 #if !defined(DISABLE_NETWORKING)
@@ -2963,6 +2966,10 @@ void open_progress_dialog(size_t message_id, bool show_progress_bar)
 //printf("open_progress_dialog %d\n", message_id);
 
     assert(sProgressDialog == NULL);
+
+    // nowhere to show it (a dedicated hub has no window)
+    if (!MainScreenVisible())
+	    return;
     
     sProgressDialog 	= new dialog;
     sProgressMessage	= new w_static_text(TS_GetCString(strPROGRESS_MESSAGES, message_id));
@@ -2986,6 +2993,9 @@ void open_progress_dialog(size_t message_id, bool show_progress_bar)
 void set_progress_dialog_message(size_t message_id)
 {
 //printf("set_progress_dialog_message %d\n", message_id);
+    if (!sProgressDialog)
+	    return;
+
     assert(sProgressMessage != NULL);
 
     sProgressMessage->set_text(TS_GetCString(strPROGRESS_MESSAGES, message_id));
@@ -2999,7 +3009,8 @@ void close_progress_dialog(void)
 {
 //printf("close_progress_dialog\n");
 
-    assert(sProgressDialog != NULL);
+    if (!sProgressDialog)
+	    return;
     
     sProgressDialog->quit(0);
     
@@ -298,6 +298,9 @@ class Message;
 
 const NetDistributionInfo* NetGetDistributionInfoForType(int16 inType);
 
+// can this player's end of the star protocol read (and so be sent) compact action flags?
+bool NetPlayerReadsCompactActionFlags(short player_index);
+
 struct ClientChatInfo
 {
 	std::string name;
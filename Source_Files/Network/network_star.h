@@ -39,6 +39,7 @@ enum {
 #endif
 
 #include <stdio.h>
+#include <vector>
 
 enum {
         kEndOfMessagesMessageType = 0x454d,	// 'EM'
@@ -51,6 +52,10 @@ enum {
 	kSpokeToHubGameDataPacketV1Magic = 0x5331, // 'S1'
 	kHubToSpokeGameDataPacketV1Magic = 0x4831, // 'H1'
 	kHubToSpokeGameDataPacketWithSpokeFlagsV1Magic = 0x4631, // 'F1'
+	// as V1, but with the action_flags in the compact encoding (see network_star_flags.cpp)
+	kSpokeToHubGameDataPacketV2Magic = 0x5332, // 'S2'
+	kHubToSpokeGameDataPacketV2Magic = 0x4832, // 'H2'
+	kHubToSpokeGameDataPacketWithSpokeFlagsV2Magic = 0x4632, // 'F2'
 	kPingRequestPacket = 0x5051, // 'PQ'
 	kPingResponsePacket = 0x5052, // 'PR'
 
@@ -58,6 +63,8 @@ enum {
         kActionFlagsSerializedLength = 4,	// bytes for each serialized action_flags_t (should be elsewhere)
 	
 	kStarPacketHeaderSize = 4, // 2 bytes for packet magic, 2 for CRC
+
+	kMaximumCompactActionFlagsCount = TICKS_PER_SECOND * 5, // per player per packet; no queue holds more
 };
 
 typedef uint32 action_flags_t;	// (should be elsewhere)
@@ -66,15 +73,22 @@ typedef WritableTickBasedCircularQueue<action_flags_t> WritableTickBasedActionQu
 
 
 class InfoTree;
+class AIStream;
+class AOStream;
+
+// One player's run of consecutive action_flags, run-length encoded; see network_star_flags.cpp
+extern void write_compact_action_flags(AOStream& ps, const std::vector<action_flags_t>& inFlags);
+extern void read_compact_action_flags(AIStream& ps, std::vector<action_flags_t>& outFlags);
 
-extern void hub_initialize(int32 inStartingTick, size_t inNumPlayers, const NetAddrBlock* const* inPlayerAddresses, size_t inLocalPlayerIndex);
+// inCompactActionFlags (if not NULL) tells, for each player, whether that player's spoke reads the compact encoding
+extern void hub_initialize(int32 inStartingTick, size_t inNumPlayers, const NetAddrBlock* const* inPlayerAddresses, size_t inLocalPlayerIndex, const bool* inCompactActionFlags = NULL);
 extern void hub_cleanup(bool inGraceful, int32 inSmallestPostGameTick);
 extern void hub_received_network_packet(DDPPacketBufferPtr inPacket);
 extern void DefaultHubPreferences();
 extern InfoTree HubPreferencesTree();
 extern void HubParsePreferencesTree(InfoTree prefs, std::string version);
 
-extern void spoke_initialize(const NetAddrBlock& inHubAddress, int32 inFirstTick, size_t inNumberOfPlayers, WritableTickBasedActionQueue* const inPlayerQueues[], bool inPlayerConnectedStatus[], size_t inLocalPlayerIndex, bool inHubIsLocal);
+extern void spoke_initialize(const NetAddrBlock& inHubAddress, int32 inFirstTick, size_t inNumberOfPlayers, WritableTickBasedActionQueue* const inPlayerQueues[], bool inPlayerConnectedStatus[], size_t inLocalPlayerIndex, bool inHubIsLocal, bool inHubReadsCompactActionFlags = false);
 extern void spoke_cleanup(bool inGraceful);
 extern void spoke_received_network_packet(DDPPacketBufferPtr inPacket);
 extern int32 spoke_get_net_time();
@@ -87,6 +101,7 @@ extern int32 spoke_latency(); // in ms, kNetLatencyInvalid if not yet valid
 extern int32 hub_latency(int player_index); // in ms, kNetLatencyInvalid if not valid, kNetLatencyDisconnected if d/c
 extern TickBasedActionQueue* spoke_get_unconfirmed_flags_queue();
 extern int32 spoke_get_smallest_unconfirmed_tick();
+extern bool spoke_is_connected(); // false once the spoke has given up on the hub
 extern void DefaultSpokePreferences();
 extern InfoTree SpokePreferencesTree();
 extern void SpokeParsePreferencesTree(InfoTree prefs, std::string version);
@@ -0,0 +1,146 @@
+/*
+ *  network_star_flags.cpp
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+
+ *  The compact action_flags encoding used by the V2 star game data packets.
+ *
+ *  A player's flags for consecutive ticks are sent as their count, followed by runs
+ *  until that many flags have been described.  Each run starts with a length n:
+ *	n even: the one action_flags_t that follows holds for the next n/2 ticks
+ *	n odd: the next n/2 ticks' action_flags_t follow, one after another
+ *  Counts and lengths are written seven bits to a byte, least significant first,
+ *  with the high bit set on all but the last byte.  Players mostly hold the same keys
+ *  for many ticks, so a second's worth of flags often fits in five or six bytes; at
+ *  worst, when every tick differs, this costs a couple of bytes more than sending
+ *  the flags as they are.
+ */
+
+#if !defined(DISABLE_NETWORKING)
+
+#include "cseries.h"
+#include "network_star.h"
+#include "AStream.h"
+
+static void
+write_count(AOStream& ps, uint32 inCount)
+{
+	while(inCount >= 0x80)
+	{
+		ps << static_cast<uint8>((inCount & 0x7f) | 0x80);
+		inCount >>= 7;
+	}
+	ps << static_cast<uint8>(inCount);
+}
+
+
+
+static uint32
+read_count(AIStream& ps)
+{
+	uint32 theCount = 0;
+	for(int theShift = 0; theShift < 32; theShift += 7)
+	{
+		uint8 theByte;
+		ps >> theByte;
+		theCount |= static_cast<uint32>(theByte & 0x7f) << theShift;
+		if(!(theByte & 0x80))
+			return theCount;
+	}
+
+	throw AStream::failure("compact action_flags count too long");
+}
+
+
+
+void
+write_compact_action_flags(AOStream& ps, const std::vector<action_flags_t>& inFlags)
+{
+	size_t theCount = inFlags.size();
+	write_count(ps, theCount);
+
+	size_t theLiteralsStart = 0;
+	size_t i = 0;
+	while(i < theCount)
+	{
+		size_t theRunEnd = i + 1;
+		while(theRunEnd < theCount && inFlags[theRunEnd] == inFlags[i])
+			theRunEnd++;
+
+		// even two equal flags are cheaper as a run than as literals
+		bool isRun = (theRunEnd - i >= 2);
+		if(!isRun && theRunEnd < theCount)
+		{
+			i = theRunEnd;
+			continue;
+		}
+
+		size_t theLiteralsEnd = isRun ? i : theCount;
+		if(theLiteralsEnd > theLiteralsStart)
+		{
+			write_count(ps, static_cast<uint32>(((theLiteralsEnd - theLiteralsStart) << 1) | 1));
+			for(size_t j = theLiteralsStart; j < theLiteralsEnd; j++)
+				ps << inFlags[j];
+		}
+
+		if(isRun)
+		{
+			write_count(ps, static_cast<uint32>((theRunEnd - i) << 1));
+			ps << inFlags[i];
+		}
+
+		i = theRunEnd;
+		theLiteralsStart = theRunEnd;
+	}
+}
+
+
+
+void
+read_compact_action_flags(AIStream& ps, std::vector<action_flags_t>& outFlags)
+{
+	uint32 theCount = read_count(ps);
+	if(theCount > kMaximumCompactActionFlagsCount)
+		throw AStream::failure("too many compact action_flags");
+
+	outFlags.clear();
+	outFlags.reserve(theCount);
+	while(outFlags.size() < theCount)
+	{
+		uint32 theLength = read_count(ps);
+		uint32 theTicks = theLength >> 1;
+		if(theTicks == 0 || theTicks > theCount - outFlags.size())
+			throw AStream::failure("bad compact action_flags run");
+
+		action_flags_t theFlags;
+		if(theLength & 1)
+		{
+			for(uint32 i = 0; i < theTicks; i++)
+			{
+				ps >> theFlags;
+				outFlags.push_back(theFlags);
+			}
+		}
+		else
+		{
+			ps >> theFlags;
+			outFlags.insert(outFlags.end(), theTicks, theFlags);
+		}
+	}
+}
+
+#endif // !defined(DISABLE_NETWORKING)
@@ -40,6 +40,10 @@
  *	NAT-friendly networking - we no longer get spoke addresses form topology -
  *	instead spokes send identification packets to hub with player ID.
  *	Hub can then associate the ID in the identification packet with the paket's source address.
+ *
+ *  Oct 17, 2026:
+ *	hub_initialize() takes NONE for the local player index, for the dedicated hub; the timing
+ *	reference is then a remote player, and moves on when that player goes netdead.
  */
 
 #if !defined(DISABLE_NETWORKING)
@@ -231,6 +235,9 @@ struct NetworkPlayer_hub {
 	// the last time a recovery set of flags was sent instead of incremental
 	int32           mLastRecoverySend;
 
+	// can the player's spoke read V2 (compact action_flags) game data packets?
+	bool		mCompactActionFlags;
+
 	// latency stuff
 	int32 mLatencyTicks; // sum of the latency ticks from the last second
 	std::deque<int32> mLatencyBuffer;
@@ -332,7 +339,7 @@ static bool		sHubInitialized = false;
 static void hub_check_for_completion();
 static void player_acknowledged_up_to_tick(size_t inPlayerIndex, int32 inSmallestUnacknowledgedTick);
 static bool player_provided_flags_from_tick_to_tick(size_t inPlayerIndex, int32 inFirstNewTick, int32 inSmallestUnreceivedTick);
-static void hub_received_game_data_packet_v1(AIStream& ps, int inSenderIndex);
+static void hub_received_game_data_packet_v1(AIStream& ps, int inSenderIndex, bool inCompactActionFlags);
 static void hub_received_identification_packet(AIStream& ps, NetAddrBlock address);
 static void hub_received_ping_request(AIStream& ps, NetAddrBlock address);
 static void hub_received_ping_response(AIStream& ps, NetAddrBlock address);
@@ -423,7 +430,7 @@ bool debug_timing_adjustments = false;
 #endif
 
 void
-hub_initialize(int32 inStartingTick, size_t inNumPlayers, const NetAddrBlock* const* inPlayerAddresses, size_t inLocalPlayerIndex)
+hub_initialize(int32 inStartingTick, size_t inNumPlayers, const NetAddrBlock* const* inPlayerAddresses, size_t inLocalPlayerIndex, const bool* inCompactActionFlags)
 {
 //        assert(sNetworkState == eNetworkDown);
 
@@ -459,15 +466,30 @@ hub_initialize(int32 inStartingTick, size_t inNumPlayers, const NetAddrBlock* co
 	}
 #endif
 
-        assert(inLocalPlayerIndex < inNumPlayers);
+        // A dedicated hub passes NONE: it has no local player.
+        assert(inLocalPlayerIndex < inNumPlayers || inLocalPlayerIndex == (size_t)NONE);
         sLocalPlayerIndex = inLocalPlayerIndex;
-	sReferencePlayerIndex = sLocalPlayerIndex;
 
 #ifdef A1_NETWORK_STANDALONE_HUB
 	// There is no local player on standalone hub.
 	sLocalPlayerIndex = (size_t)NONE;
 #endif
 
+	// Timing is measured against the local player, or without one, against a remote player.
+	sReferencePlayerIndex = sLocalPlayerIndex;
+	if(sReferencePlayerIndex == (size_t)NONE)
+	{
+		sReferencePlayerIndex = 0;
+		for(size_t i = 0; i < inNumPlayers; i++)
+		{
+			if(inPlayerAddresses[i] != NULL)
+			{
+				sReferencePlayerIndex = i;
+				break;
+			}
+		}
+	}
+
 	sSmallestPostGameTick = INT32_MAX;
         sSmallestRealGameTick = inStartingTick;
         int32 theFirstTick = inStartingTick - kPregameTicks;
@@ -518,6 +540,7 @@ hub_initialize(int32 inStartingTick, size_t inNumPlayers, const NetAddrBlock* co
 
                 thePlayer.mLastNetworkTickHeard = 0;
 		thePlayer.mLastRecoverySend = 0;
+		thePlayer.mCompactActionFlags = (inCompactActionFlags != NULL && inCompactActionFlags[i]);
                 thePlayer.mSmallestUnacknowledgedTick = theFirstTick;
 		thePlayer.mSmallestUnheardTick = theFirstTick;
 		thePlayer.mNthElementFinder.reset(sHubPreferences.mPregameWindowSize);
@@ -669,7 +692,7 @@ hub_received_network_packet(DDPPacketBufferPtr inPacket)
 
 		if (thePacketCRC != calculate_data_crc_ccitt(inPacket->datagramData, inPacket->datagramSize))
 		{
-			if (thePacketMagic == kSpokeToHubGameDataPacketV1Magic)
+			if (thePacketMagic == kSpokeToHubGameDataPacketV1Magic || thePacketMagic == kSpokeToHubGameDataPacketV2Magic)
 			{
 				AddressToPlayerIndexType::iterator theEntry = sAddressToPlayerIndex.find(inPacket->sourceAddress);
 				if (theEntry != sAddressToPlayerIndex.end())
@@ -684,6 +707,7 @@ hub_received_network_packet(DDPPacketBufferPtr inPacket)
                 switch(thePacketMagic)
                 {
                         case kSpokeToHubGameDataPacketV1Magic:
+                        case kSpokeToHubGameDataPacketV2Magic:
 			{
 				// Find sender
 				AddressToPlayerIndexType::iterator theEntry = sAddressToPlayerIndex.find(inPacket->sourceAddress);
@@ -694,7 +718,7 @@ hub_received_network_packet(DDPPacketBufferPtr inPacket)
 				
 				if (getNetworkPlayer(theSenderIndex).mConnected)
 				{
-					hub_received_game_data_packet_v1(ps, theSenderIndex);
+					hub_received_game_data_packet_v1(ps, theSenderIndex, thePacketMagic == kSpokeToHubGameDataPacketV2Magic);
 				}
 				else
 				{
@@ -802,8 +826,9 @@ hub_received_ping_response(AIStream& ps, NetAddrBlock address)
 // I suppose to be safer, this should check the entire packet before acting on any of it.
 // As it stands, a malformed packet could have have a well-formed prefix of it interpreted
 // before the remainder is discarded.
+// V2 packets differ only in carrying the action_flags in the compact encoding.
 static void
-hub_received_game_data_packet_v1(AIStream& ps, int inSenderIndex)
+hub_received_game_data_packet_v1(AIStream& ps, int inSenderIndex, bool inCompactActionFlags)
 {
         // Process the piggybacked acknowledgement
         int32	theSmallestUnacknowledgedTick;
@@ -833,12 +858,23 @@ hub_received_game_data_packet_v1(AIStream& ps, int inSenderIndex)
         int32	theStartTick;
         ps >> theStartTick;
 
-        // Make sure there's an integral number of action_flags
-        int	theRemainingDataLength = ps.maxg() - ps.tellg();
-        if(theRemainingDataLength % kActionFlagsSerializedLength != 0)
-                return;
+        std::vector<action_flags_t> theIncomingFlags;
+        if(inCompactActionFlags)
+                read_compact_action_flags(ps, theIncomingFlags);
+        else
+        {
+                // Make sure there's an integral number of action_flags
+                int	theRemainingDataLength = ps.maxg() - ps.tellg();
+                if(theRemainingDataLength % kActionFlagsSerializedLength != 0)
+                        return;
+
+                theIncomingFlags.resize(theRemainingDataLength / kActionFlagsSerializedLength);
+                for(size_t i = 0; i < theIncomingFlags.size(); i++)
+                        ps >> theIncomingFlags[i];
+        }
 
-        int32	theActionFlagsCount = theRemainingDataLength / kActionFlagsSerializedLength;
+        int32	theActionFlagsCount = theIncomingFlags.size();
+        int32	theNextActionFlags = 0;
 
         TickBasedActionQueue& theQueue = getFlagsQueue(inSenderIndex);
 	TickBasedActionQueue& theLateQueue = getLateFlagsQueue(inSenderIndex);
@@ -861,16 +897,14 @@ hub_received_game_data_packet_v1(AIStream& ps, int inSenderIndex)
         // Skip redundant flags without processing/checking them
 //        int	theRedundantActionFlagsCount = std::min(theQueue.getWriteTick() - theStartTick, theActionFlagsCount);
 	int     theRedundantActionFlagsCount = std::min(theLateQueue.getWriteTick() - theStartTick, theActionFlagsCount);
-	int	theRedundantDataLength = theRedundantActionFlagsCount * kActionFlagsSerializedLength;
-	ps.ignore(theRedundantDataLength);
+	theNextActionFlags += theRedundantActionFlagsCount;
 
 	assert(theQueue.getWriteTick() >= theLateQueue.getWriteTick());
 	// Enqueue late flags
 	int theLateActionFlagsCount = std::min(theQueue.getWriteTick() - theLateQueue.getWriteTick(), theActionFlagsCount - theRedundantActionFlagsCount);
 	for (int i = 0; i < theLateActionFlagsCount; i++)
 	{
-		action_flags_t theActionFlags;
-		ps >> theActionFlags;
+		action_flags_t theActionFlags = theIncomingFlags[theNextActionFlags++];
 		// we consume these faster than we enqueue them (hopefully)
 		// so, not checking for capacity though we probably should
 		theLateQueue.enqueue(theActionFlags);
@@ -886,8 +920,7 @@ hub_received_game_data_packet_v1(AIStream& ps, int inSenderIndex)
         
         for(int i = 0; i < theEnqueueableFlagsCount; i++)
         {
-                action_flags_t theActionFlags;
-                ps >> theActionFlags;
+                action_flags_t theActionFlags = theIncomingFlags[theNextActionFlags++];
                 theQueue.enqueue(theActionFlags);
 		theLateQueue.enqueue(theActionFlags);
 		sLastFlagsReceived[inSenderIndex] = theActionFlags;
@@ -1064,7 +1097,7 @@ static bool make_up_flags_for_first_incomplete_tick()
 		return false;
 
 	// never make up flags for ourself
-	if (getFlagsQueue(sLocalPlayerIndex).getWriteTick() == sSmallestIncompleteTick)
+	if (sLocalPlayerIndex != (size_t)NONE && getFlagsQueue(sLocalPlayerIndex).getWriteTick() == sSmallestIncompleteTick)
 		return false;
 
 	// check to make sure everyone we want to make up flags for is in the lagging players bitmask
@@ -1275,6 +1308,19 @@ make_player_netdead(int inPlayerIndex)
 		thePlayer.mConnected = false;
 		sConnectedPlayersBitmask &= ~(((uint32)1) << inPlayerIndex);
 		sAddressToPlayerIndex.erase(thePlayer.mAddress);
+
+		// Without a local player, the reference has to be someone still here.
+		if(inPlayerIndex == sReferencePlayerIndex && sLocalPlayerIndex == (size_t)NONE)
+		{
+			for(size_t i = 0; i < sNetworkPlayers.size(); i++)
+			{
+				if(sNetworkPlayers[i].mConnected)
+				{
+					sReferencePlayerIndex = i;
+					break;
+				}
+			}
+		}
 	}
 
 	// We save this off because player_provided... call below may change it.
@@ -1436,6 +1482,51 @@ hub_tick()
 #define INT8_MIN -128
 #endif
 
+// Writes the start tick and each player's flags for [inStartTick, inEndTick) in the compact
+// encoding, leaving ticks off the end of the window until they fit in the packet.
+static void
+write_compact_game_data_flags(AOStream& ps, int32 inStartTick, int32 inEndTick, const std::vector<int32>& inSmallestTickWeWontSend)
+{
+	uint32 theFlagsOffset = ps.tellp();
+	std::vector<action_flags_t> theFlags;
+
+	while(true)
+	{
+		AOStreamBE fs(sOutgoingFrame->data, ddpMaxData, theFlagsOffset);
+
+		try {
+			bool haveFlags = false;
+			for(size_t j = 0; j < sNetworkPlayers.size(); j++)
+			{
+				if(std::min(inEndTick, inSmallestTickWeWontSend[j]) > inStartTick)
+					haveFlags = true;
+			}
+
+			if(haveFlags)
+			{
+				fs << inStartTick;
+				for(size_t j = 0; j < sNetworkPlayers.size(); j++)
+				{
+					theFlags.clear();
+					for(int32 tick = inStartTick; tick < std::min(inEndTick, inSmallestTickWeWontSend[j]); tick++)
+						theFlags.push_back(getFlagsQueue(j).peek(tick));
+					write_compact_action_flags(fs, theFlags);
+				}
+			}
+
+			ps.ignore(fs.tellp() - theFlagsOffset);
+			return;
+		}
+		catch (const AStream::failure&)
+		{
+			if(inEndTick - inStartTick <= 1)
+				throw;
+
+			inEndTick = inStartTick + (inEndTick - inStartTick) / 2;
+		}
+	}
+}
+
 static void
 send_packets()
 {
@@ -1541,8 +1632,8 @@ send_packets()
 						int maxTicks = 4 * effectiveLatency;
 
 						int bytesAvailableForFlags = ps.maxp() - ps.tellp() - 4; // have to encode the tick
-						// don't run out of room in the packet, though
-						if (maxTicks * sNetworkPlayers.size() * 4 > bytesAvailableForFlags) 
+						// don't run out of room in the packet, though (compact flags are trimmed to fit as they are written)
+						if (!thePlayer.mCompactActionFlags && maxTicks * sNetworkPlayers.size() * 4 > bytesAvailableForFlags) 
 						{
 							int maximumBytesPerTick = sNetworkPlayers.size() * 4;
 							maxTicks = bytesAvailableForFlags / maximumBytesPerTick;
@@ -1593,25 +1684,36 @@ send_packets()
                                                 theSmallestTickWeWontSend[j] = theOtherPlayer.mNetDeadTick;
                                 }
         
-                                // Now, encode the flags in tick-major order (this is much easier to decode
-                                // at the other end)
-                                for(int32 tick = startTick; tick < endTick; tick++)
+                                if(thePlayer.mCompactActionFlags)
                                 {
-                                        for(size_t j = 0; j < sNetworkPlayers.size(); j++)
+                                        // Players who hold the same keys cost a few bytes a second this way
+                                        write_compact_game_data_flags(ps, startTick, endTick, theSmallestTickWeWontSend);
+                                }
+                                else
+                                {
+                                        // Now, encode the flags in tick-major order (this is much easier to decode
+                                        // at the other end)
+                                        for(int32 tick = startTick; tick < endTick; tick++)
                                         {
-                                                if(tick < theSmallestTickWeWontSend[j])
+                                                for(size_t j = 0; j < sNetworkPlayers.size(); j++)
                                                 {
-                                                        if(!haveSentStartTick)
+                                                        if(tick < theSmallestTickWeWontSend[j])
                                                         {
-                                                                ps << tick;
-                                                                haveSentStartTick = true;
+                                                                if(!haveSentStartTick)
+                                                                {
+                                                                        ps << tick;
+                                                                        haveSentStartTick = true;
+                                                                }
+                                                                ps << getFlagsQueue(j).peek(tick);
                                                         }
-                                                        ps << getFlagsQueue(j).peek(tick);
                                                 }
                                         }
                                 }
 				
-				hdr << (uint16) (reflectFlags ? kHubToSpokeGameDataPacketWithSpokeFlagsV1Magic : kHubToSpokeGameDataPacketV1Magic);
+				if(thePlayer.mCompactActionFlags)
+					hdr << (uint16) (reflectFlags ? kHubToSpokeGameDataPacketWithSpokeFlagsV2Magic : kHubToSpokeGameDataPacketV2Magic);
+				else
+					hdr << (uint16) (reflectFlags ? kHubToSpokeGameDataPacketWithSpokeFlagsV1Magic : kHubToSpokeGameDataPacketV1Magic);
 
 				// blank out the CRC field before calculating
 				sOutgoingFrame->data[2] = 0;
@@ -0,0 +1,898 @@
+/*
+ *  network_star_loopback.cpp - the star hub against simulated spokes, over a simulated network
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+
+ *  The hub is network_star_hub.cpp's, started with no local player as on the dedicated
+ *  hub, and its frames leave through NetDDPSendFrame() as ever; NetDDPSetSendProc()
+ *  hands them to the simulated network here instead of the socket.  The first spoke is
+ *  network_star_spoke.cpp's, given action queues of its own in place of the game's;
+ *  it sends no keys, since there is no one at the keyboard.  It is one per process, so
+ *  the other spokes are this file's: they play its part of the protocol
+ *  (identification, acks, recovery sends, timing adjustments, netdead messages, giving
+ *  up on a silent hub) by the same rules and with the same constants, and make up
+ *  their own keys.
+ *
+ *  Datagrams never reach a socket: the network here hands them straight to
+ *  hub_received_network_packet() and spoke_received_network_packet(), so network_udp.cpp's
+ *  receiving thread isn't part of the test (the report says so).
+ *
+ *  Everything runs on mytm tasks - the hub's tick, the spokes' ticks, and the network,
+ *  which delivers datagrams as they come due - so everything here happens with the
+ *  mytm mutex held, as it would with a real socket.
+ */
+
+#if !defined(DISABLE_NETWORKING)
+
+#include "cseries.h"
+#include "network_star_loopback.h"
+
+#include "network_star.h"
+#include "network_private.h"
+#include "mytm.h"
+#include "AStream.h"
+#include "crc.h"
+#include "Logging.h"
+
+#include <vector>
+#include <deque>
+#include <sstream>
+#include <algorithm>
+
+#include "SDL_timer.h"
+
+extern const NetworkStats& hub_stats(int player_index);
+extern void hub_set_minimum_send_period(int32);
+extern int32& hub_get_minimum_send_period();
+
+enum {
+	// as network_star_spoke.cpp's defaults
+	kPregameTicksBeforeNetDeath = 90 * TICKS_PER_SECOND,
+	kInGameTicksBeforeNetDeath = 5 * TICKS_PER_SECOND,
+	kOutgoingFlagsQueueSize = TICKS_PER_SECOND / 2,
+	kRecoverySendPeriod = TICKS_PER_SECOND / 2,
+	kIdentificationPeriod = TICKS_PER_SECOND,
+
+	kMaximumLoopbackPlayers = 32,	// the hub keeps players in 32-bit masks
+	kRealSpoke = 0,			// network_star_spoke.cpp's
+	kRealSpokeQueueSize = kMaximumCompactActionFlagsCount,
+	kReorderDelay = 2 * 1000 / TICKS_PER_SECOND,	// ms; enough to fall behind the next datagram
+	kLoopbackPort = 4226
+};
+
+struct LoopbackSettings
+{
+	int players;
+	int latency;
+	int jitter;
+	double loss;
+	double reorder;
+	int seconds;
+	int tolerance;
+	bool compact;
+	int quit;
+	uint32 seed;
+
+	LoopbackSettings() :
+		players(2), latency(30), jitter(5), loss(0), reorder(0), seconds(30),
+		tolerance(NONE), compact(true), quit(0), seed(1) { }
+};
+
+struct Datagram
+{
+	uint32 due;
+	uint32 sequence;
+	NetAddrBlock source;
+	NetAddrBlock destination;
+	std::vector<byte> data;
+};
+
+struct LinkStats
+{
+	uint32 datagrams;
+	uint32 bytes;
+	uint32 dropped;
+	uint32 reordered;
+
+	LinkStats() : datagrams(0), bytes(0), dropped(0), reordered(0) { }
+};
+
+struct SimulatedSpoke
+{
+	NetAddrBlock address;
+	bool connected;		// false once we've given up on the hub
+	bool silent;		// quit: stopped sending and listening
+	bool heardFromHub;
+	int32 ticker;
+	int32 lastTickHeard;
+	int32 lastTickSent;
+	int32 smallestUnreceivedTick;
+	int32 smallestUnsentTick;
+	int32 outgoingReadTick;
+	std::deque<action_flags_t> outgoing;
+	action_flags_t keys;
+	int8 requestedTimingAdjustment;
+	int8 outstandingTimingAdjustment;
+	std::vector<bool> playerConnected;
+	std::vector<int32> playerNetDeadTick;
+
+	// what happened
+	int64 latencyTicks;
+	uint32 latencySamples;
+	int32 maximumLatency;
+	uint32 flagsSent;
+	uint32 flagsResent;
+	uint32 ticksReceived;
+	uint32 ticksReceivedAgain;
+	uint32 earlyPackets;
+	uint32 timingAdjustments;
+	uint32 timingAdjustmentTicks;
+	uint32 stalledTicks;
+	NetworkStats hubStats;
+
+	int32 outgoingWriteTick() const { return outgoingReadTick + static_cast<int32>(outgoing.size()); }
+};
+
+static LoopbackSettings sSettings;
+static std::vector<SimulatedSpoke> sSpokes;
+static std::vector<Datagram> sInFlight;
+static uint32 sDatagramSequence;
+static uint32 sRandomState;
+static uint32 sStartTime;
+static NetAddrBlock sHubAddress;
+static LinkStats sToHub;
+static LinkStats sFromHub;
+static std::vector<int32> sNetDeadTicks;	// as the spokes heard it from the hub, or NONE
+static DDPFramePtr sSpokeFrame = NULL;
+static DDPPacketBuffer sIncomingPacket;
+static std::vector<TickBasedActionQueue*> sRealSpokeQueues;	// stand-ins for the game's
+
+static inline bool
+operator ==(const NetAddrBlock& a, const NetAddrBlock& b)
+{
+	return a.host == b.host && a.port == b.port;
+}
+
+// xorshift; the same seed makes the same network
+static uint32
+loopback_random()
+{
+	sRandomState ^= sRandomState << 13;
+	sRandomState ^= sRandomState >> 17;
+	sRandomState ^= sRandomState << 5;
+	return sRandomState;
+}
+
+static bool
+loopback_chance(double inPercentage)
+{
+	return (loopback_random() % 10000) < inPercentage * 100;
+}
+
+static void
+transmit(const NetAddrBlock& inSource, const NetAddrBlock& inDestination, const byte* inData, uint16 inLength)
+{
+	LinkStats& theLink = (inDestination == sHubAddress) ? sToHub : sFromHub;
+	theLink.datagrams++;
+	theLink.bytes += inLength;
+
+	if(loopback_chance(sSettings.loss))
+	{
+		theLink.dropped++;
+		return;
+	}
+
+	int32 theDelay = sSettings.latency;
+	if(sSettings.jitter > 0)
+		theDelay += static_cast<int32>(loopback_random() % (2 * sSettings.jitter + 1)) - sSettings.jitter;
+	if(loopback_chance(sSettings.reorder))
+	{
+		theDelay += kReorderDelay;
+		theLink.reordered++;
+	}
+
+	Datagram theDatagram;
+	theDatagram.due = machine_tick_count() + std::max(theDelay, static_cast<int32>(0));
+	theDatagram.sequence = sDatagramSequence++;
+	theDatagram.source = inSource;
+	theDatagram.destination = inDestination;
+	theDatagram.data.assign(inData, inData + inLength);
+	sInFlight.push_back(theDatagram);
+}
+
+// NetDDPSendFrame(), from the hub or from the real spoke (the hub never sends to itself)
+static void
+loopback_send_frame(DDPFramePtr inFrame, NetAddrBlock* inAddress)
+{
+	const NetAddrBlock& theSource = (*inAddress == sHubAddress) ? sSpokes[kRealSpoke].address : sHubAddress;
+	transmit(theSource, *inAddress, inFrame->data, inFrame->data_size);
+}
+
+static void
+send_spoke_frame(SimulatedSpoke& inSpoke, AOStream& hdr, AOStream& ps)
+{
+	// blank out the CRC before calculating it
+	sSpokeFrame->data[2] = 0;
+	sSpokeFrame->data[3] = 0;
+
+	uint16 crc = calculate_data_crc_ccitt(sSpokeFrame->data, ps.tellp());
+	hdr << crc;
+
+	transmit(inSpoke.address, sHubAddress, sSpokeFrame->data, ps.tellp());
+}
+
+static void
+send_identification_packet(size_t inIndex)
+{
+	AOStreamBE hdr(sSpokeFrame->data, kStarPacketHeaderSize);
+	AOStreamBE ps(sSpokeFrame->data, ddpMaxData, kStarPacketHeaderSize);
+
+	hdr << (uint16)kSpokeToHubIdentification;
+	ps << (uint16)inIndex;
+
+	send_spoke_frame(sSpokes[inIndex], hdr, ps);
+}
+
+static void
+send_game_data_packet(SimulatedSpoke& inSpoke)
+{
+	AOStreamBE hdr(sSpokeFrame->data, kStarPacketHeaderSize);
+	AOStreamBE ps(sSpokeFrame->data, ddpMaxData, kStarPacketHeaderSize);
+
+	try {
+		hdr << (uint16)(sSettings.compact ? kSpokeToHubGameDataPacketV2Magic : kSpokeToHubGameDataPacketV1Magic);
+		ps << inSpoke.smallestUnreceivedTick;
+		ps << (uint16)kEndOfMessagesMessageType;
+
+		if(!inSpoke.outgoing.empty())
+		{
+			ps << inSpoke.outgoingReadTick;
+			if(sSettings.compact)
+			{
+				std::vector<action_flags_t> theFlags(inSpoke.outgoing.begin(), inSpoke.outgoing.end());
+				write_compact_action_flags(ps, theFlags);
+			}
+			else
+			{
+				for(size_t i = 0; i < inSpoke.outgoing.size(); i++)
+					ps << inSpoke.outgoing[i];
+			}
+
+			int32 theResentTicks = std::max(inSpoke.smallestUnsentTick - inSpoke.outgoingReadTick, static_cast<int32>(0));
+			inSpoke.flagsResent += theResentTicks;
+			inSpoke.flagsSent += inSpoke.outgoing.size() - theResentTicks;
+			inSpoke.smallestUnsentTick = inSpoke.outgoingWriteTick();
+		}
+
+		send_spoke_frame(inSpoke, hdr, ps);
+		inSpoke.lastTickSent = inSpoke.ticker;
+	}
+	catch (...) {
+	}
+}
+
+// the players who have flags in a V1 packet's tick, tick-major
+static size_t
+flags_in_tick(const SimulatedSpoke& inSpoke, size_t inIndex, int32 inTick, bool inReflected)
+{
+	size_t theCount = 0;
+	for(size_t j = 0; j < inSpoke.playerConnected.size(); j++)
+	{
+		if(j == inIndex && !inReflected)
+			continue;
+		if(inSpoke.playerConnected[j] || inTick < inSpoke.playerNetDeadTick[j])
+			theCount++;
+	}
+	return theCount;
+}
+
+// as spoke_received_game_data_packet_v1(), keeping count instead of keeping the flags
+static void
+spoke_received_game_data_packet(size_t inIndex, AIStream& ps, bool inReflected, bool inCompact)
+{
+	SimulatedSpoke& theSpoke = sSpokes[inIndex];
+
+	int32 theSmallestUnacknowledgedTick;
+	ps >> theSmallestUnacknowledgedTick;
+
+	if(theSmallestUnacknowledgedTick > theSpoke.outgoingWriteTick())
+	{
+		if(!inReflected)
+		{
+			theSpoke.earlyPackets++;
+			return;
+		}
+		theSmallestUnacknowledgedTick = theSpoke.outgoingWriteTick();
+	}
+
+	theSpoke.heardFromHub = true;
+	theSpoke.lastTickHeard = theSpoke.ticker;
+
+	while(theSpoke.outgoingReadTick < theSmallestUnacknowledgedTick)
+	{
+		theSpoke.outgoing.pop_front();
+		theSpoke.outgoingReadTick++;
+	}
+
+	bool gotTimingAdjustment = false;
+	bool messagesDone = false;
+	while(!messagesDone)
+	{
+		uint16 theMessageType;
+		ps >> theMessageType;
+
+		switch(theMessageType)
+		{
+		case kEndOfMessagesMessageType:
+			messagesDone = true;
+			break;
+
+		case kTimingAdjustmentMessageType:
+		{
+			int8 theAdjustment;
+			ps >> theAdjustment;
+			if(theAdjustment != theSpoke.requestedTimingAdjustment)
+			{
+				theSpoke.outstandingTimingAdjustment = theAdjustment;
+				theSpoke.requestedTimingAdjustment = theAdjustment;
+				theSpoke.timingAdjustments++;
+				theSpoke.timingAdjustmentTicks += std::abs(static_cast<int>(theAdjustment));
+			}
+			gotTimingAdjustment = true;
+		}
+		break;
+
+		case kPlayerNetDeadMessageType:
+		{
+			uint8 thePlayerIndex;
+			int32 theTick;
+			ps >> thePlayerIndex >> theTick;
+			if(thePlayerIndex < theSpoke.playerConnected.size())
+			{
+				theSpoke.playerConnected[thePlayerIndex] = false;
+				theSpoke.playerNetDeadTick[thePlayerIndex] = theTick;
+				if(sNetDeadTicks[thePlayerIndex] == NONE)
+				{
+					sNetDeadTicks[thePlayerIndex] = theTick;
+					logNoteNMT("loopback: the hub says player %d went netdead in tick %d", thePlayerIndex, theTick);
+				}
+			}
+		}
+		break;
+
+		default:
+		{
+			// optional messages (lossy byte streams) give their length
+			uint16 theLength;
+			ps >> theLength;
+			ps.ignore(theLength);
+		}
+		break;
+		}
+	}
+
+	if(!gotTimingAdjustment)
+		theSpoke.requestedTimingAdjustment = 0;
+
+	if(ps.tellg() >= ps.maxg())
+	{
+		// the "we are alone" case: nobody else's flags will come, so the ack is all we need
+		bool weAreAlone = true;
+		for(size_t j = 0; j < theSpoke.playerConnected.size(); j++)
+		{
+			if(j != inIndex && (theSpoke.playerConnected[j] || theSpoke.playerNetDeadTick[j] > theSpoke.outgoingReadTick))
+				weAreAlone = false;
+		}
+		if(weAreAlone && theSpoke.smallestUnreceivedTick < theSpoke.outgoingReadTick)
+			theSpoke.smallestUnreceivedTick = theSpoke.outgoingReadTick;
+		return;
+	}
+
+	int32 theSmallestUnreadTick;
+	ps >> theSmallestUnreadTick;
+
+	if(theSmallestUnreadTick > theSpoke.smallestUnreceivedTick)
+	{
+		theSpoke.earlyPackets++;
+		return;
+	}
+
+	int32 theEndTick = theSmallestUnreadTick;
+	if(inCompact)
+	{
+		std::vector<action_flags_t> theFlags;
+		for(size_t j = 0; j < theSpoke.playerConnected.size(); j++)
+		{
+			read_compact_action_flags(ps, theFlags);
+			theEndTick = std::max(theEndTick, theSmallestUnreadTick + static_cast<int32>(theFlags.size()));
+		}
+	}
+	else
+	{
+		uint32 theRemainingBytes = ps.maxg() - ps.tellg();
+		while(theRemainingBytes > 0)
+		{
+			size_t theFlagsInTick = flags_in_tick(theSpoke, inIndex, theEndTick, inReflected);
+			if(theFlagsInTick == 0 || theFlagsInTick * kActionFlagsSerializedLength > theRemainingBytes)
+				break;
+			theRemainingBytes -= theFlagsInTick * kActionFlagsSerializedLength;
+			theEndTick++;
+		}
+	}
+
+	theSpoke.ticksReceivedAgain += std::max(std::min(theEndTick, theSpoke.smallestUnreceivedTick) - theSmallestUnreadTick, static_cast<int32>(0));
+	while(theSpoke.smallestUnreceivedTick < theEndTick)
+	{
+		theSpoke.smallestUnreceivedTick++;
+		theSpoke.ticksReceived++;
+
+		// the spoke's own latency measurement: how far its keys are ahead of the game
+		if(theSpoke.smallestUnreceivedTick > 0)
+		{
+			int32 theLatency = theSpoke.outgoingWriteTick() - theSpoke.smallestUnreceivedTick;
+			theSpoke.latencyTicks += theLatency;
+			theSpoke.latencySamples++;
+			theSpoke.maximumLatency = std::max(theSpoke.maximumLatency, theLatency);
+		}
+	}
+}
+
+static void
+spoke_received_packet(size_t inIndex, Datagram& inDatagram)
+{
+	SimulatedSpoke& theSpoke = sSpokes[inIndex];
+	if(!theSpoke.connected || theSpoke.silent)
+		return;
+
+	try {
+		AIStreamBE ps(&inDatagram.data[0], inDatagram.data.size());
+
+		uint16 thePacketMagic;
+		uint16 thePacketCRC;
+		ps >> thePacketMagic >> thePacketCRC;
+
+		inDatagram.data[2] = 0;
+		inDatagram.data[3] = 0;
+		if(thePacketCRC != calculate_data_crc_ccitt(&inDatagram.data[0], inDatagram.data.size()))
+			return;
+
+		switch(thePacketMagic)
+		{
+		case kHubToSpokeGameDataPacketV1Magic:
+			spoke_received_game_data_packet(inIndex, ps, false, false);
+			break;
+		case kHubToSpokeGameDataPacketWithSpokeFlagsV1Magic:
+			spoke_received_game_data_packet(inIndex, ps, true, false);
+			break;
+		case kHubToSpokeGameDataPacketV2Magic:
+			spoke_received_game_data_packet(inIndex, ps, false, true);
+			break;
+		case kHubToSpokeGameDataPacketWithSpokeFlagsV2Magic:
+			spoke_received_game_data_packet(inIndex, ps, true, true);
+			break;
+		default:
+			break;
+		}
+	}
+	catch (...) {
+	}
+}
+
+// as spoke_tick()
+static void
+spoke_tick(size_t inIndex)
+{
+	SimulatedSpoke& theSpoke = sSpokes[inIndex];
+	if(!theSpoke.connected || theSpoke.silent)
+		return;
+
+	theSpoke.ticker++;
+
+	if(inIndex == sSpokes.size() - 1 && sSettings.quit > 0 && theSpoke.outgoingWriteTick() >= sSettings.quit * TICKS_PER_SECOND)
+	{
+		logNoteNMT("loopback: player %d goes silent", static_cast<int>(inIndex));
+		theSpoke.silent = true;
+		return;
+	}
+
+	int32 theSilentTicksBeforeNetDeath = (theSpoke.outgoingReadTick >= 0) ? kInGameTicksBeforeNetDeath : kPregameTicksBeforeNetDeath;
+	if(theSpoke.ticker - theSpoke.lastTickHeard > theSilentTicksBeforeNetDeath)
+	{
+		logWarningNMT("loopback: player %d gave up on the hub", static_cast<int>(inIndex));
+		theSpoke.connected = false;
+		return;
+	}
+
+	bool shouldSend = false;
+	if(theSpoke.outstandingTimingAdjustment <= 0)
+	{
+		int theNumberOfFlagsToProvide = -theSpoke.outstandingTimingAdjustment + 1;
+		while(theNumberOfFlagsToProvide > 0 && theSpoke.outgoing.size() < static_cast<size_t>(kOutgoingFlagsQueueSize))
+		{
+			// hold the same keys for a while, as players do
+			if(loopback_random() % 8 == 0)
+				theSpoke.keys = loopback_random() & 0x0fffffff;
+			theSpoke.outgoing.push_back(theSpoke.keys);
+			shouldSend = true;
+			theNumberOfFlagsToProvide--;
+		}
+
+		if(theNumberOfFlagsToProvide > 0)
+			theSpoke.stalledTicks++;
+
+		if(theNumberOfFlagsToProvide != -theSpoke.outstandingTimingAdjustment + 1)
+			theSpoke.outstandingTimingAdjustment = -theNumberOfFlagsToProvide;
+	}
+	else
+		theSpoke.outstandingTimingAdjustment--;
+
+	if(theSpoke.heardFromHub)
+	{
+		if(shouldSend || theSpoke.ticker - theSpoke.lastTickSent >= kRecoverySendPeriod)
+			send_game_data_packet(theSpoke);
+	}
+	else if(theSpoke.ticker % kIdentificationPeriod == 0)
+		send_identification_packet(inIndex);
+}
+
+// the game's part, for the real spoke: takes the flags it's given as the game would, and
+// measures how far its keys are ahead of them
+static void
+real_spoke_tick()
+{
+	SimulatedSpoke& theSpoke = sSpokes[kRealSpoke];
+	theSpoke.connected = spoke_is_connected();
+
+	for(size_t i = 0; i < sRealSpokeQueues.size(); i++)
+	{
+		TickBasedActionQueue& theQueue = *sRealSpokeQueues[i];
+		if(i == kRealSpoke)
+			theSpoke.ticksReceived += theQueue.size();
+		while(theQueue.size() > 0)
+			theQueue.dequeue();
+	}
+
+	// as StarGameProtocol::UpdateUnconfirmedActionFlags()
+	TickBasedActionQueue* theUnconfirmedFlags = spoke_get_unconfirmed_flags_queue();
+	while(theUnconfirmedFlags->getReadTick() < spoke_get_smallest_unconfirmed_tick() && theUnconfirmedFlags->getReadTick() < theUnconfirmedFlags->getWriteTick())
+		theUnconfirmedFlags->dequeue();
+
+	theSpoke.smallestUnreceivedTick = sRealSpokeQueues[kRealSpoke]->getWriteTick();
+	theSpoke.flagsSent = theUnconfirmedFlags->getWriteTick();
+	if(theSpoke.smallestUnreceivedTick > 0)
+	{
+		int32 theLatency = theUnconfirmedFlags->getWriteTick() - theSpoke.smallestUnreceivedTick;
+		theSpoke.latencyTicks += theLatency;
+		theSpoke.latencySamples++;
+		theSpoke.maximumLatency = std::max(theSpoke.maximumLatency, theLatency);
+	}
+}
+
+static bool
+loopback_spokes_tick()
+{
+	real_spoke_tick();
+	for(size_t i = 0; i < sSpokes.size(); i++)
+	{
+		if(i != kRealSpoke)
+			spoke_tick(i);
+	}
+
+	return true;
+}
+
+// delivers whatever has come due, soonest (then first sent) first
+static bool
+loopback_network_tick()
+{
+	uint32 theTime = machine_tick_count();
+	while(true)
+	{
+		size_t theNext = sInFlight.size();
+		for(size_t i = 0; i < sInFlight.size(); i++)
+		{
+			if(sInFlight[i].due <= theTime && (theNext == sInFlight.size() || sInFlight[i].due < sInFlight[theNext].due || (sInFlight[i].due == sInFlight[theNext].due && sInFlight[i].sequence < sInFlight[theNext].sequence)))
+				theNext = i;
+		}
+		if(theNext == sInFlight.size())
+			break;
+
+		Datagram theDatagram;
+		std::swap(theDatagram, sInFlight[theNext]);
+		sInFlight.erase(sInFlight.begin() + theNext);
+
+		sIncomingPacket.protocolType = kPROTOCOL_TYPE;
+		sIncomingPacket.sourceAddress = theDatagram.source;
+		sIncomingPacket.datagramSize = theDatagram.data.size();
+		memcpy(sIncomingPacket.datagramData, &theDatagram.data[0], theDatagram.data.size());
+
+		if(theDatagram.destination == sHubAddress)
+			hub_received_network_packet(&sIncomingPacket);
+		else if(theDatagram.destination == sSpokes[kRealSpoke].address)
+			spoke_received_network_packet(&sIncomingPacket);
+		else
+		{
+			for(size_t i = 0; i < sSpokes.size(); i++)
+			{
+				if(sSpokes[i].address == theDatagram.destination)
+					spoke_received_packet(i, theDatagram);
+			}
+		}
+	}
+
+	return true;
+}
+
+static bool
+parse_settings(const std::string& inSettings)
+{
+	std::istringstream theSettings(inSettings);
+	std::string theSetting;
+	while(std::getline(theSettings, theSetting, ','))
+	{
+		if(theSetting.empty())
+			continue;
+
+		std::string::size_type theEquals = theSetting.find('=');
+		if(theEquals == std::string::npos)
+		{
+			fprintf(stderr, "loopback setting '%s' has no value\n", theSetting.c_str());
+			return false;
+		}
+
+		std::string theName = theSetting.substr(0, theEquals);
+		const char* theValue = theSetting.c_str() + theEquals + 1;
+
+		if(theName == "players")
+			sSettings.players = atoi(theValue);
+		else if(theName == "latency")
+			sSettings.latency = atoi(theValue);
+		else if(theName == "jitter")
+			sSettings.jitter = atoi(theValue);
+		else if(theName == "loss")
+			sSettings.loss = atof(theValue);
+		else if(theName == "reorder")
+			sSettings.reorder = atof(theValue);
+		else if(theName == "seconds")
+			sSettings.seconds = atoi(theValue);
+		else if(theName == "tolerance")
+			sSettings.tolerance = atoi(theValue);
+		else if(theName == "compact")
+			sSettings.compact = (atoi(theValue) != 0);
+		else if(theName == "quit")
+			sSettings.quit = atoi(theValue);
+		else if(theName == "seed")
+			sSettings.seed = strtoul(theValue, NULL, 10);
+		else
+		{
+			fprintf(stderr, "unknown loopback setting '%s'\n", theName.c_str());
+			return false;
+		}
+	}
+
+	if(sSettings.players < 1 || sSettings.players > kMaximumLoopbackPlayers)
+	{
+		fprintf(stderr, "loopback players must be from 1 to %d\n", kMaximumLoopbackPlayers);
+		return false;
+	}
+
+	if(sSettings.quit > 0 && sSettings.players < 2)
+	{
+		fprintf(stderr, "loopback quit needs a second player: the first is the real spoke, which can't be told to\n");
+		return false;
+	}
+
+	sSettings.latency = std::max(sSettings.latency, 0);
+	sSettings.jitter = std::max(sSettings.jitter, 0);
+	sSettings.seconds = std::max(sSettings.seconds, 1);
+	if(sSettings.seed == 0)
+		sSettings.seed = 1;
+
+	return true;
+}
+
+static void
+report(uint32 inElapsed)
+{
+	printf("Loopback: %d players, %d ms one way +/- %d ms, %.1f%% lost, %.1f%% reordered, %s action_flags, latency tolerance %d\n",
+	       sSettings.players, sSettings.latency, sSettings.jitter, sSettings.loss, sSettings.reorder,
+	       sSettings.compact ? "compact" : "V1", hub_get_minimum_send_period());
+	printf("%.1f s; to the hub %u datagrams (%u bytes/s), %u dropped, %u reordered; from the hub %u datagrams (%u bytes/s), %u dropped, %u reordered\n",
+	       inElapsed / 1000.0,
+	       sToHub.datagrams, static_cast<uint32>(sToHub.bytes * 1000.0 / std::max(inElapsed, 1u)), sToHub.dropped, sToHub.reordered,
+	       sFromHub.datagrams, static_cast<uint32>(sFromHub.bytes * 1000.0 / std::max(inElapsed, 1u)), sFromHub.dropped, sFromHub.reordered);
+	printf("player  latency avg/max (ticks)  hub latency/jitter (ms)  flags sent/resent  ticks received/again  adjustments (ticks)  stalls  netdead\n");
+
+	for(size_t i = 0; i < sSpokes.size(); i++)
+	{
+		const SimulatedSpoke& theSpoke = sSpokes[i];
+		double theAverageLatency = theSpoke.latencySamples ? static_cast<double>(theSpoke.latencyTicks) / theSpoke.latencySamples : 0;
+
+		char theNetDead[32];
+		if(sNetDeadTicks[i] != NONE)
+			snprintf(theNetDead, sizeof(theNetDead), "tick %d", sNetDeadTicks[i]);
+		else if(!theSpoke.connected)
+			strcpy(theNetDead, "lost hub");
+		else
+			strcpy(theNetDead, "-");
+
+		// the real spoke's resends, repeats, adjustments and stalls are its own business
+		if(i == kRealSpoke)
+			printf("%6d  %11.1f / %-11d  %10d / %-10d  %8u / %-7s  %10u / %-9s  %10s (%s)  %6s  %s\n",
+			       static_cast<int>(i), theAverageLatency, theSpoke.maximumLatency,
+			       theSpoke.hubStats.latency, theSpoke.hubStats.jitter,
+			       theSpoke.flagsSent, "-",
+			       theSpoke.ticksReceived, "-",
+			       "-", "-",
+			       "-", theNetDead);
+		else
+			printf("%6d  %11.1f / %-11d  %10d / %-10d  %8u / %-7u  %10u / %-9u  %10u (%u)  %6u  %s\n",
+			       static_cast<int>(i), theAverageLatency, theSpoke.maximumLatency,
+			       theSpoke.hubStats.latency, theSpoke.hubStats.jitter,
+			       theSpoke.flagsSent, theSpoke.flagsResent,
+			       theSpoke.ticksReceived, theSpoke.ticksReceivedAgain,
+			       theSpoke.timingAdjustments, theSpoke.timingAdjustmentTicks,
+			       theSpoke.stalledTicks, theNetDead);
+
+		logNote("loopback: player %d latency %.1f ticks (max %d), hub latency %d ms jitter %d ms, %u flags resent, %u ticks received again, %u timing adjustments, %s",
+			static_cast<int>(i), theAverageLatency, theSpoke.maximumLatency, theSpoke.hubStats.latency, theSpoke.hubStats.jitter,
+			theSpoke.flagsResent, theSpoke.ticksReceivedAgain, theSpoke.timingAdjustments, theNetDead);
+	}
+	printf("Player %d is network_star_spoke.cpp's spoke, the rest are simulated; datagrams were handed over directly, so network_udp.cpp's sockets and receiving thread were not tested\n", static_cast<int>(kRealSpoke));
+	fflush(stdout);
+}
+
+int
+run_star_loopback(const std::string& inSettings)
+{
+	sSettings = LoopbackSettings();
+	if(!parse_settings(inSettings))
+		return 2;
+
+	// (the preferences aren't read for the loopback, so that it runs without game data)
+	DefaultHubPreferences();
+	DefaultSpokePreferences();
+
+	if(sSettings.tolerance != NONE)
+		hub_set_minimum_send_period(sSettings.tolerance);
+
+	sRandomState = sSettings.seed;
+	sDatagramSequence = 0;
+	sInFlight.clear();
+	sToHub = LinkStats();
+	sFromHub = LinkStats();
+	sNetDeadTicks.assign(sSettings.players, NONE);
+
+	// 10.0.0.1 is the hub, the spokes follow
+	sHubAddress.host = SDL_SwapBE32(0x0a000001);
+	sHubAddress.port = SDL_SwapBE16(kLoopbackPort);
+
+	sSpokes.clear();
+	sSpokes.resize(sSettings.players);
+	std::vector<const NetAddrBlock*> theAddresses(sSettings.players);
+	bool theCompactFlags[kMaximumLoopbackPlayers];
+	for(int i = 0; i < sSettings.players; i++)
+	{
+		SimulatedSpoke& theSpoke = sSpokes[i];
+		obj_clear(theSpoke.address);
+		theSpoke.address.host = SDL_SwapBE32(0x0a000002 + i);
+		theSpoke.address.port = SDL_SwapBE16(kLoopbackPort);
+		theSpoke.connected = true;
+		theSpoke.silent = false;
+		theSpoke.heardFromHub = false;
+		theSpoke.ticker = theSpoke.lastTickHeard = theSpoke.lastTickSent = 0;
+		theSpoke.smallestUnreceivedTick = theSpoke.smallestUnsentTick = theSpoke.outgoingReadTick = -kPregameTicks;
+		theSpoke.keys = 0;
+		theSpoke.requestedTimingAdjustment = theSpoke.outstandingTimingAdjustment = 0;
+		theSpoke.playerConnected.assign(sSettings.players, true);
+		theSpoke.playerNetDeadTick.assign(sSettings.players, -kPregameTicks - 1);
+		theSpoke.latencyTicks = 0;
+		theSpoke.latencySamples = 0;
+		theSpoke.maximumLatency = 0;
+		theSpoke.flagsSent = theSpoke.flagsResent = 0;
+		theSpoke.ticksReceived = theSpoke.ticksReceivedAgain = 0;
+		theSpoke.earlyPackets = 0;
+		theSpoke.timingAdjustments = theSpoke.timingAdjustmentTicks = 0;
+		theSpoke.stalledTicks = 0;
+		theSpoke.hubStats.latency = theSpoke.hubStats.jitter = NetworkStats::invalid;
+		theSpoke.hubStats.errors = 0;
+
+		theAddresses[i] = &theSpoke.address;
+		theCompactFlags[i] = sSettings.compact;
+	}
+
+	sSpokeFrame = NetDDPNewFrame();
+	NetDDPSetSendProc(loopback_send_frame);
+
+	hub_initialize(0, sSettings.players, &theAddresses[0], static_cast<size_t>(NONE), theCompactFlags);
+
+	WritableTickBasedActionQueue* theQueues[kMaximumLoopbackPlayers];
+	bool theConnectedPlayers[kMaximumLoopbackPlayers];
+	sRealSpokeQueues.resize(sSettings.players);
+	for(int i = 0; i < sSettings.players; i++)
+	{
+		sRealSpokeQueues[i] = new TickBasedActionQueue(kRealSpokeQueueSize);
+		theQueues[i] = sRealSpokeQueues[i];
+		theConnectedPlayers[i] = true;
+	}
+	spoke_initialize(sHubAddress, 0, sSettings.players, theQueues, theConnectedPlayers, kRealSpoke, false, sSettings.compact);
+
+	sStartTime = machine_tick_count();
+	myTMTaskPtr theNetworkTask = myXTMSetup(1, loopback_network_tick);
+	myTMTaskPtr theSpokesTask = myXTMSetup(1000 / TICKS_PER_SECOND, loopback_spokes_tick);
+
+	// the pregame, then the game
+	uint32 theEndTime = sStartTime + (kPregameTicks / TICKS_PER_SECOND + sSettings.seconds) * MACHINE_TICKS_PER_SECOND;
+	while(machine_tick_count() < theEndTime)
+		SDL_Delay(100);
+
+	// end the game where the spokes have got to, and let them finish as real ones would
+	int32 theSmallestPostGameTick = 0;
+	if(take_mytm_mutex())
+	{
+		for(size_t i = 0; i < sSpokes.size(); i++)
+		{
+			if(sSpokes[i].connected && !sSpokes[i].silent)
+				theSmallestPostGameTick = std::max(theSmallestPostGameTick, sSpokes[i].smallestUnreceivedTick);
+			sSpokes[i].hubStats = hub_stats(i);
+		}
+		release_mytm_mutex();
+	}
+	uint32 theElapsed = machine_tick_count() - sStartTime;
+
+	hub_cleanup(true, theSmallestPostGameTick);
+	spoke_cleanup(true);
+
+	myTMRemove(theSpokesTask);
+	myTMRemove(theNetworkTask);
+	myTMCleanup(true);
+
+	NetDDPSetSendProc(NULL);
+	NetDDPDisposeFrame(sSpokeFrame);
+	sSpokeFrame = NULL;
+	sInFlight.clear();
+
+	for(size_t i = 0; i < sRealSpokeQueues.size(); i++)
+		delete sRealSpokeQueues[i];
+	sRealSpokeQueues.clear();
+
+	report(theElapsed);
+
+	// only the spoke told to quit should have gone netdead, and the rest should have got
+	// well into the game (the pregame outlasts a short run, so a hub that never got
+	// through wouldn't have been given up on yet)
+	bool theResult = true;
+	for(size_t i = 0; i < sSpokes.size(); i++)
+	{
+		bool shouldHaveGone = (sSettings.quit > 0 && i == sSpokes.size() - 1);
+		bool hasGone = !sSpokes[i].connected || sNetDeadTicks[i] != NONE;
+		if(hasGone && !shouldHaveGone)
+		{
+			fprintf(stderr, "loopback: player %d went netdead\n", static_cast<int>(i));
+			theResult = false;
+		}
+		else if(!shouldHaveGone && sSpokes[i].smallestUnreceivedTick < TICKS_PER_SECOND)
+		{
+			fprintf(stderr, "loopback: player %d only got to tick %d\n", static_cast<int>(i), sSpokes[i].smallestUnreceivedTick);
+			theResult = false;
+		}
+	}
+
+	return theResult ? 0 : 1;
+}
+
+#endif // !defined(DISABLE_NETWORKING)
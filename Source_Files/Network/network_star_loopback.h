@@ -0,0 +1,50 @@
+#ifndef NETWORK_STAR_LOOPBACK_H
+#define NETWORK_STAR_LOOPBACK_H
+
+/*
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+
+	Runs the star hub against spokes over a simulated network, all in this process,
+	for as long as asked, then reports how the game would have gone: the spokes'
+	effective input latency, how many action_flags were sent again, who went netdead
+	and what timing adjustments the hub asked for.  The first spoke is the game's own
+	(network_star_spoke.cpp), the rest are simulated.  It needs no game data and reads
+	no preferences, so it runs wherever the engine was built.
+
+	The network is described by a comma-separated list of settings, for example
+	"players=6,latency=60,jitter=15,loss=2,reorder=1,seconds=60":
+		players		spokes in the game, the real one included (2)
+		latency		one-way delay, in ms (30)
+		jitter		random extra or lesser delay, up to this many ms (5)
+		loss		percentage of datagrams dropped (0)
+		reorder		percentage of datagrams held back behind the next (0)
+		seconds		how long to play, after the pregame (30)
+		tolerance	the hub's latency tolerance, in ticks (the default, 5)
+		compact		1: the spokes read and send compact action_flags; 0: the V1 packets (1)
+		quit		the last spoke goes silent this many seconds in (0: never; it
+				can't be the real one, so this needs 2 players or more)
+		seed		for the random numbers, so that runs can be repeated (1)
+*/
+
+#include <string>
+
+// returns the exit status: nonzero if the settings were bad, or a spoke went netdead
+// when it shouldn't have
+int run_star_loopback(const std::string& settings);
+
+#endif
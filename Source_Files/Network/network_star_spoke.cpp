@@ -116,6 +116,7 @@ static DDPFramePtr sOutgoingFrame = NULL;
 static DDPPacketBuffer sLocalOutgoingBuffer;
 static bool sNeedToSendLocalOutgoingBuffer = false;
 static bool sHubIsLocal = false;
+static bool sHubReadsCompactActionFlags = false;
 static NetAddrBlock sHubAddress;
 static size_t sLocalPlayerIndex;
 static int32 sSmallestUnreceivedTick;
@@ -148,7 +149,7 @@ static byte sScratchBuffer[kLossyByteStreamDataBufferSize];
 
 
 static void spoke_became_disconnected();
-static void spoke_received_game_data_packet_v1(AIStream& ps, bool reflected_flags);
+static void spoke_received_game_data_packet_v1(AIStream& ps, bool reflected_flags, bool compact_flags);
 static void spoke_received_ping_request(AIStream& ps, NetAddrBlock address);
 static void spoke_received_ping_response(AIStream& ps, NetAddrBlock address);
 static void process_messages(AIStream& ps, IncomingGameDataPacketProcessingContext& context);
@@ -208,7 +209,7 @@ check_send_packet_to_hub()
 
 
 void
-spoke_initialize(const NetAddrBlock& inHubAddress, int32 inFirstTick, size_t inNumberOfPlayers, WritableTickBasedActionQueue* const inPlayerQueues[], bool inPlayerConnected[], size_t inLocalPlayerIndex, bool inHubIsLocal)
+spoke_initialize(const NetAddrBlock& inHubAddress, int32 inFirstTick, size_t inNumberOfPlayers, WritableTickBasedActionQueue* const inPlayerQueues[], bool inPlayerConnected[], size_t inLocalPlayerIndex, bool inHubIsLocal, bool inHubReadsCompactActionFlags)
 {
         assert(inNumberOfPlayers >= 1);
         assert(inLocalPlayerIndex < inNumberOfPlayers);
@@ -216,6 +217,7 @@ spoke_initialize(const NetAddrBlock& inHubAddress, int32 inFirstTick, size_t inN
         assert(inPlayerConnected[inLocalPlayerIndex]);
 
         sHubIsLocal = inHubIsLocal;
+        sHubReadsCompactActionFlags = inHubReadsCompactActionFlags;
         sHubAddress = inHubAddress;
 
         sLocalPlayerIndex = inLocalPlayerIndex;
@@ -446,11 +448,19 @@ spoke_received_network_packet(DDPPacketBufferPtr inPacket)
                 switch(thePacketMagic)
                 {
 		case kHubToSpokeGameDataPacketV1Magic:
-			spoke_received_game_data_packet_v1(ps, false);
+			spoke_received_game_data_packet_v1(ps, false, false);
 			break;
 
 		case kHubToSpokeGameDataPacketWithSpokeFlagsV1Magic:
-			spoke_received_game_data_packet_v1(ps, true);
+			spoke_received_game_data_packet_v1(ps, true, false);
+			break;
+
+		case kHubToSpokeGameDataPacketV2Magic:
+			spoke_received_game_data_packet_v1(ps, false, true);
+			break;
+
+		case kHubToSpokeGameDataPacketWithSpokeFlagsV2Magic:
+			spoke_received_game_data_packet_v1(ps, true, true);
 			break;
 		
 		case kPingRequestPacket:
@@ -475,8 +485,10 @@ spoke_received_network_packet(DDPPacketBufferPtr inPacket)
 
 
 
+// V2 packets differ only in carrying the action_flags in the compact encoding: one
+// run-length encoded stream per player, rather than every player's flags tick by tick.
 static void
-spoke_received_game_data_packet_v1(AIStream& ps, bool reflected_flags)
+spoke_received_game_data_packet_v1(AIStream& ps, bool reflected_flags, bool compact_flags)
 {
 	sHeardFromHub = true;
 
@@ -618,11 +630,26 @@ spoke_received_game_data_packet_v1(AIStream& ps, bool reflected_flags)
 
 	logDumpNMT("%d queue space available", theSmallestQueueSpace);
 
+	// The loop below takes each player's flags in tick order, which is all a stream is
+	std::vector<std::vector<action_flags_t> > theCompactFlags;
+	std::vector<size_t> theCompactFlagsRead;
+	size_t theCompactFlagsRemaining = 0;
+	if(compact_flags)
+	{
+		theCompactFlags.resize(sNetworkPlayers.size());
+		theCompactFlagsRead.resize(sNetworkPlayers.size(), 0);
+		for(size_t i = 0; i < sNetworkPlayers.size(); i++)
+		{
+			read_compact_action_flags(ps, theCompactFlags[i]);
+			theCompactFlagsRemaining += theCompactFlags[i].size();
+		}
+	}
+
         // Read and enqueue the actual action_flags from the packet
         // The body of this loop is a bit more convoluted than you might
         // expect, because the same loop is used to skip already-seen action_flags
         // and to enqueue new ones.
-	while(ps.tellg() < ps.maxg())
+	while(compact_flags ? theCompactFlagsRemaining > 0 : ps.tellg() < ps.maxg())
         {
                 // If we've no room to enqueue stuff, no point in finishing reading the packet.
                 if(theSmallestQueueSpace <= 0)
@@ -676,6 +703,16 @@ spoke_received_game_data_packet_v1(AIStream& ps, bool reflected_flags)
                         if(shouldEnqueueNetDeadFlags)
                                 // We effectively generate a tick's worth of flags in lieu of reading it from the packet.
                                 theFlags = static_cast<action_flags_t>(NET_DEAD_ACTION_FLAG);
+                        else if(compact_flags)
+			{
+				if(theCompactFlagsRead[i] >= theCompactFlags[i].size())
+				{
+					logWarningNMT("ran out of compact flags for player %i at theSmallestUnreadTick %i! OOS is likely!\n", i, theSmallestUnreadTick);
+					return;
+				}
+				theFlags = theCompactFlags[i][theCompactFlagsRead[i]++];
+				theCompactFlagsRemaining--;
+			}
                         else
 			{
                                 // We should have a flag for this player for this tick!
@@ -1028,7 +1065,7 @@ send_packet()
                 AOStreamBE ps(sOutgoingFrame->data, ddpMaxData, kStarPacketHeaderSize);
         
                 // Packet type
-                hdr << (uint16)kSpokeToHubGameDataPacketV1Magic;
+                hdr << (uint16)(sHubReadsCompactActionFlags ? kSpokeToHubGameDataPacketV2Magic : kSpokeToHubGameDataPacketV1Magic);
 
                 // Acknowledgement
                 ps << sSmallestUnreceivedTick;
@@ -1069,8 +1106,18 @@ send_packet()
                 if(sOutgoingFlags.size() > 0)
                 {
                         ps << sOutgoingFlags.getReadTick();
-                        for(int32 tick = sOutgoingFlags.getReadTick(); tick < sOutgoingFlags.getWriteTick(); tick++)
-                                ps << sOutgoingFlags.peek(tick);
+                        if(sHubReadsCompactActionFlags)
+                        {
+                                std::vector<action_flags_t> theFlags;
+                                for(int32 tick = sOutgoingFlags.getReadTick(); tick < sOutgoingFlags.getWriteTick(); tick++)
+                                        theFlags.push_back(sOutgoingFlags.peek(tick));
+                                write_compact_action_flags(ps, theFlags);
+                        }
+                        else
+                        {
+                                for(int32 tick = sOutgoingFlags.getReadTick(); tick < sOutgoingFlags.getWriteTick(); tick++)
+                                        ps << sOutgoingFlags.peek(tick);
+                        }
                 }
 
 		logDumpNMT("preparing to send packet: ACK %d, flags [%d,%d)", sSmallestUnreceivedTick, sOutgoingFlags.getReadTick(), sOutgoingFlags.getWriteTick());
@@ -1143,6 +1190,11 @@ int32 spoke_get_smallest_unconfirmed_tick()
 {
 	return sSmallestUnconfirmedTick;
 }
+
+bool spoke_is_connected()
+{
+	return sConnected;
+}
 		
 
 enum {
@@ -27,6 +27,8 @@
  *  Sept-Nov 2001 (Woody Zenfell): a few additions to implement socket-listening thread.
  *
  *  May 18, 2003 (Woody Zenfell): now uses passed-in port number for local socket.
+ *
+ *  Oct 17, 2026: NetDDPSetSendProc() diverts outgoing frames, for the loopback harness.
  */
 
 #if !defined(DISABLE_NETWORKING)
@@ -62,6 +64,9 @@ static SDL_Thread*		sReceivingThread	= NULL;
 // See if the receiving thread should exit
 static volatile bool		sKeepListening		= false;
 
+// Where frames go instead of the socket, if anywhere
+static DDPSendProcPtr		sSendProc		= NULL;
+
 
 // ZZZ: the socket listening thread loops in this function.  It calls the registered
 // packet handler when it gets something.
@@ -236,6 +241,11 @@ OSErr NetDDPSendFrame(DDPFramePtr frame, NetAddrBlock *address, short protocolTy
 //fdprintf("NetDDPSendFrame\n");
 	assert(frame->data_size <= ddpMaxData);
 
+	if (sSendProc) {
+		sSendProc(frame, address);
+		return 0;
+	}
+
 	sUDPPacketBuffer->channel = -1;
 	memcpy(sUDPPacketBuffer->data, frame->data, frame->data_size);
 	sUDPPacketBuffer->len = frame->data_size;
@@ -243,4 +253,10 @@ OSErr NetDDPSendFrame(DDPFramePtr frame, NetAddrBlock *address, short protocolTy
 	return SDLNet_UDP_Send(sSocket, -1, sUDPPacketBuffer) ? 0 : -1;
 }
 
+
+void NetDDPSetSendProc(DDPSendProcPtr sendProc)
+{
+	sSendProc = sendProc;
+}
+
 #endif // !defined(DISABLE_NETWORKING)
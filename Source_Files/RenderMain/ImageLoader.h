@@ -121,6 +121,14 @@ private:
 	bool LoadMipMapFromFile(OpenedFile &File, int flags, int level, DDSURFACEDESC2 &ddsd, int skip);
 	bool SkipMipMapFromFile(OpenedFile &File, int flags, int level, DDSURFACEDESC2 &ddsd);
 
+	// on-disk cache of decoded RGBA images; keys are 0 when the cache can't be used
+	static uint64 CacheKey(FileSpecifier& File, int flags, int actual_width, int actual_height, int maxSize);
+	bool LoadFromCache(uint64 key);
+	void SaveToCache(uint64 key);
+
+	// takes the image ImageLoader_Prefetch() decoded for these arguments, if there is one
+	bool LoadPrefetched(FileSpecifier& File, int flags, int actual_width, int actual_height, int maxSize);
+
 	ImageFormat Format;
 };
 
@@ -204,11 +212,33 @@ enum {
 	ImageLoader_CanUseDXTC = 0x2,
 	ImageLoader_LoadMipMaps = 0x4,
 	ImageLoader_LoadDXTC1AsDXTC3 = 0x8,
-	ImageLoader_ImageIsAlreadyPremultiplied = 0x10
+	ImageLoader_ImageIsAlreadyPremultiplied = 0x10,
+	ImageLoader_CacheDecoded = 0x20		// keep decoded RGBA images in the on-disk texture cache
 };
 // Returns whether or not the loading was successful
 //bool LoadImageFromFile(ImageDescriptor& Img, FileSpecifier& File, int ImgMode, int flags, int maxSize = 0);
 
 uint32 *GetMipMapPtr(uint32 *pixels, int size, int level, int width, int height, int format);
 
+// Calls proc(index, arg) for every index in [0, count) on a pool of image loading
+// threads, the caller's included, and returns when they have all finished; calls made
+// while the pool is already busy (from inside proc, say) run on the calling thread
+typedef void (*ImageLoaderProc)(int index, void *arg);
+void ImageLoader_Run(int count, ImageLoaderProc proc, void *arg);
+
+// A color image to decode ahead of time; the fields are LoadFromFile()'s arguments
+struct ImageLoader_PrefetchRequest
+{
+	FileSpecifier File;
+	int flags;
+	int actual_width, actual_height, maxSize;
+};
+
+// Decodes the image on the calling thread and holds on to it; the next LoadFromFile()
+// asking for it with the same arguments takes it instead of reading the file
+void ImageLoader_Prefetch(ImageLoader_PrefetchRequest& request);
+
+// Frees prefetched images nobody asked for
+void ImageLoader_DiscardPrefetched();
+
 #endif
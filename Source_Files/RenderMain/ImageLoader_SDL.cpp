@@ -43,10 +43,20 @@ bool ImageDescriptor::LoadFromFile(FileSpecifier& File, int ImgMode, int flags,
 	if (flags & ImageLoader_ImageIsAlreadyPremultiplied)
 		PremultipliedAlpha = true;
 
+	uint64 cache_key = 0;
+
 	// Don't load opacity if there is no color component:
 	switch(ImgMode) {
 		case ImageLoader_Colors:
-			if (LoadDDSFromFile(File, flags, actual_width, actual_height, maxSize)) return true;
+			if (LoadPrefetched(File, flags, actual_width, actual_height, maxSize)) return true;
+
+			cache_key = CacheKey(File, flags, actual_width, actual_height, maxSize);
+			if (LoadFromCache(cache_key)) return true;
+
+			if (LoadDDSFromFile(File, flags, actual_width, actual_height, maxSize)) {
+				SaveToCache(cache_key);
+				return true;
+			}
 			break;
 		
 		case ImageLoader_Opacity:
@@ -120,6 +130,7 @@ bool ImageDescriptor::LoadFromFile(FileSpecifier& File, int ImgMode, int flags,
 	switch (ImgMode) {
 		case ImageLoader_Colors:
 			memcpy(GetPixelBasePtr(), rgba->pixels, Width * Height * 4);
+			SaveToCache(cache_key);
 			break;
 
 		case ImageLoader_Opacity: {
@@ -35,21 +35,77 @@
 #include "SDL.h"
 #include "SDL_endian.h"
 #include "Logging.h"
-
-
-#ifdef HAVE_OPENGL
-#include "OGL_Headers.h"
-#include "OGL_Setup.h" // OGL_IsActive
-#endif
+#include "FileHandler.h"
+#include "WorkerPool.h"
 
 #include <cmath>
+#include <stdarg.h>
 #include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <SDL_atomic.h>
+#include <SDL_cpuinfo.h>
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
 
 using std::min;
 using std::max;
 
 static inline float log2(int x) { return std::log((float) x) / std::log(2.0); }
 
+// more threads than this just queue up behind the disk
+static const int kMaximumImageLoaderThreads = 8;
+
+// The logger isn't thread-safe, so warnings from the image loading threads (and the
+// level prefetcher's) wait here until the main thread reports them: at the end of
+// ImageLoader_Run(), or when it next loads or picks up an image itself
+static const SDL_threadID image_loader_main_thread = SDL_ThreadID();
+static std::vector<std::string> image_loader_warnings;
+
+static SDL_mutex *image_loader_warnings_mutex()
+{
+	static SDL_mutex *mutex = SDL_CreateMutex();
+	return mutex;
+}
+
+static void report_image_loader_warnings()
+{
+	std::vector<std::string> warnings;
+	SDL_LockMutex(image_loader_warnings_mutex());
+	warnings.swap(image_loader_warnings);
+	SDL_UnlockMutex(image_loader_warnings_mutex());
+
+	for (std::vector<std::string>::const_iterator it = warnings.begin(); it != warnings.end(); ++it)
+		logWarning("%s", it->c_str());
+}
+
+static void image_loader_warning(const char *format, ...)
+{
+	char message[256];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+
+	SDL_LockMutex(image_loader_warnings_mutex());
+	image_loader_warnings.push_back(message);
+	SDL_UnlockMutex(image_loader_warnings_mutex());
+
+	if (SDL_ThreadID() == image_loader_main_thread)
+		report_image_loader_warnings();
+}
+
+void ImageLoader_Run(int count, ImageLoaderProc proc, void *arg)
+{
+	static WorkerPool *pool = new WorkerPool("ImageLoader_loadThread");
+	pool->Run(count, PIN(SDL_GetCPUCount(), 1, kMaximumImageLoaderThreads), proc, arg);
+	report_image_loader_warnings();
+}
+
 int ImageDescriptor::GetMipMapSize(int level) const
 {
 
@@ -121,6 +177,98 @@ void ImageDescriptor::Resize(int _Width, int _Height, int _TotalBytes)
 	Pixels = new uint32[_TotalBytes];
 }
 
+// images smaller than this aren't worth handing to the image loading threads
+static const int kParallelPixelCount = 256 * 256;
+
+// rows of a minified image each image loading thread takes at a time
+static const int kMinifyRowsPerJob = 32;
+
+// Minify() used to be gluScaleImage(), which needs the GL context; these do what the
+// reference GLU does instead, so that the results stay the same: halving both ways
+// averages 2x2 blocks, rounding half up, and anything else (an odd side) averages the
+// source area under each new pixel, weighted by how much of each source pixel it covers
+
+struct minify_state {
+	const uint32 *src;
+	uint32 *dst;
+	int width, height;
+	int new_width, new_height;
+};
+
+// averages 2x2 blocks of RGBA8 pixels; two channels at a time, each in 16 bits
+static inline uint32 average_pixels(uint32 a, uint32 b, uint32 c, uint32 d)
+{
+	const uint32 mask = 0x00ff00ff;
+	uint32 lo = (a & mask) + (b & mask) + (c & mask) + (d & mask) + 0x00020002;
+	uint32 hi = ((a >> 8) & mask) + ((b >> 8) & mask) + ((c >> 8) & mask) + ((d >> 8) & mask) + 0x00020002;
+	return ((lo >> 2) & mask) | (((hi >> 2) & mask) << 8);
+}
+
+static void minify_rows(int index, void *arg)
+{
+	minify_state *state = reinterpret_cast<minify_state *>(arg);
+	int first = index * kMinifyRowsPerJob;
+	int last = MIN(first + kMinifyRowsPerJob, state->new_height);
+
+	for (int y = first; y < last; ++y)
+	{
+		// a source that is only one pixel across gets averaged with itself
+		const uint32 *row0 = state->src + (2 * y) * state->width;
+		const uint32 *row1 = state->src + MIN(2 * y + 1, state->height - 1) * state->width;
+		uint32 *out = state->dst + y * state->new_width;
+		for (int x = 0; x < state->new_width; ++x)
+		{
+			int x0 = 2 * x;
+			int x1 = MIN(2 * x + 1, state->width - 1);
+			out[x] = average_pixels(row0[x0], row0[x1], row1[x0], row1[x1]);
+		}
+	}
+}
+
+static void minify_rows_by_area(int index, void *arg)
+{
+	minify_state *state = reinterpret_cast<minify_state *>(arg);
+	int first = index * kMinifyRowsPerJob;
+	int last = MIN(first + kMinifyRowsPerJob, state->new_height);
+
+	float convy = (float) state->height / state->new_height;
+	float convx = (float) state->width / state->new_width;
+
+	for (int y = first; y < last; ++y)
+	{
+		float lowy = convy * y;
+		float highy = lowy + convy;
+		uint32 *out = state->dst + y * state->new_width;
+		for (int x = 0; x < state->new_width; ++x)
+		{
+			float lowx = convx * x;
+			float highx = lowx + convx;
+
+			float totals[4] = { 0, 0, 0, 0 };
+			float area = 0;
+			int yint = (int) std::floor(lowy);
+			for (float sy = lowy; sy < highy; sy = ++yint)
+			{
+				float ypercent = (highy < yint + 1) ? highy - sy : yint + 1 - sy;
+				const uint8 *row = reinterpret_cast<const uint8 *>(state->src + MIN(yint, state->height - 1) * state->width);
+				int xint = (int) std::floor(lowx);
+				for (float sx = lowx; sx < highx; sx = ++xint)
+				{
+					float percent = ypercent * ((highx < xint + 1) ? highx - sx : xint + 1 - sx);
+					const uint8 *pixel = row + 4 * MIN(xint, state->width - 1);
+					area += percent;
+					for (int k = 0; k < 4; ++k)
+						totals[k] += pixel[k] * percent;
+				}
+			}
+
+			uint8 *pixel = reinterpret_cast<uint8 *>(out + x);
+			for (int k = 0; k < 4; ++k)
+				pixel[k] = (uint8) ((totals[k] + 0.5f) / area);
+		}
+	}
+}
+
 bool ImageDescriptor::Minify()
 {
 	if (MipMapCount > 1)
@@ -140,28 +288,39 @@ bool ImageDescriptor::Minify()
 	else if (Format == RGBA8)
 	{
 		if (!(Width > 1 || Height > 1)) return false;
-		int newWidth = Width >> 1;
-		int newHeight = Height >> 1;
-#ifdef HAVE_OPENGL
-		if (OGL_IsActive())
+
+		// on the CPU, so that textures can be minified off the main thread
+		minify_state state;
+		state.src = Pixels;
+		state.width = Width;
+		state.height = Height;
+		state.new_width = MAX(1, Width >> 1);
+		state.new_height = MAX(1, Height >> 1);
+
+		uint32 *newPixels = new uint32[state.new_width * state.new_height];
+		state.dst = newPixels;
+
+		// a side of one pixel stays one pixel, which halving handles too
+		bool halving = (Width == 1 || !(Width & 1)) && (Height == 1 || !(Height & 1));
+		ImageLoaderProc proc = halving ? minify_rows : minify_rows_by_area;
+
+		int jobs = (state.new_height + kMinifyRowsPerJob - 1) / kMinifyRowsPerJob;
+		if (state.new_width * state.new_height >= kParallelPixelCount)
 		{
-			
-			uint32 *newPixels = new uint32[newWidth * newHeight];
-			gluScaleImage(GL_RGBA, Width, Height, GL_UNSIGNED_BYTE, Pixels, newWidth, newHeight, GL_UNSIGNED_BYTE, newPixels);
-			delete []Pixels;
-			Pixels = newPixels;
-			Width = newWidth;
-			Height = newHeight;
-			Size = newWidth * newHeight;
-			return true;
-			
-		} 
-		else 
-#endif
+			ImageLoader_Run(jobs, proc, &state);
+		}
+		else
 		{
-			fprintf(stderr, "GL not active\n");
-			return false;
+			for (int job = 0; job < jobs; ++job)
+				proc(job, &state);
 		}
+
+		delete []Pixels;
+		Pixels = newPixels;
+		Width = state.new_width;
+		Height = state.new_height;
+		Size = Width * Height * 4;
+		return true;
 	} 
 	else 
 	{
@@ -342,7 +501,7 @@ bool ImageDescriptor::SkipMipMapFromFile(OpenedFile& File, int flags, int level,
 bool ImageDescriptor::LoadDDSFromFile(FileSpecifier& File, int flags, int actual_width, int actual_height, int maxSize)
 {
 	OpenedFile dds_file;
-	if (!File.Open(dds_file)) {
+	if (!File.Open(dds_file, false, false)) {
 		return false;
 	}
 
@@ -455,7 +614,7 @@ bool ImageDescriptor::LoadDDSFromFile(FileSpecifier& File, int flags, int actual
 		// we don't handle incomplete mip map chains
 		// if we're only missing one, that's OK; XBLA textures do that
 		if (!(OriginalMipMapCount == ExpectedMipMapCount || OriginalMipMapCount == (ExpectedMipMapCount - 1))) {
-			logWarning("incomplete mipmap chain (%ix%i, %ix%i, %i mipmaps)", Width, Height, ddsd.dwWidth, ddsd.dwHeight, OriginalMipMapCount);
+			image_loader_warning("incomplete mipmap chain (%ix%i, %ix%i, %i mipmaps)", Width, Height, ddsd.dwWidth, ddsd.dwHeight, OriginalMipMapCount);
 			return false;
 		}
 
@@ -572,8 +731,51 @@ static bool DecompressDXTC1(uint32 *out, int width, int height, uint32 *in);
 static bool DecompressDXTC3(uint32 *out, int width, int height, uint32 *in);
 static bool DecompressDXTC5(uint32 *out, int width, int height, uint32 *in);
 	
+// rows of a mipmap each image loading thread decodes at a time; a multiple of four
+static const int kDecodeRowsPerJob = 64;
+
+struct dxtc_decode_job {
+	int level;
+	int y;
+	int height;
+};
+
+struct dxtc_decode_state {
+	int format;
+	ImageDescriptor *source;
+	ImageDescriptor *dest;
+	std::vector<dxtc_decode_job> jobs;
+	SDL_atomic_t failed;
+};
+
+static void decode_dxtc_rows(int index, void *arg)
+{
+	dxtc_decode_state *state = reinterpret_cast<dxtc_decode_state *>(arg);
+	const dxtc_decode_job& job = state->jobs[index];
+
+	int width = MAX(1, state->source->GetWidth() >> job.level);
+	int block_bytes = (state->format == ImageDescriptor::DXTC1) ? 8 : 16;
+
+	// every row of 4x4 blocks is (width + 3) / 4 blocks long
+	uint32 *in = state->source->GetMipMapPtr(job.level) + (job.y / 4) * ((width + 3) / 4) * block_bytes / 4;
+	uint32 *out = state->dest->GetMipMapPtr(job.level) + job.y * width;
+
+	bool decoded;
+	if (state->format == ImageDescriptor::DXTC1)
+		decoded = DecompressDXTC1(out, width, job.height, in);
+	else if (state->format == ImageDescriptor::DXTC3)
+		decoded = DecompressDXTC3(out, width, job.height, in);
+	else
+		decoded = DecompressDXTC5(out, width, job.height, in);
+
+	if (!decoded)
+		SDL_AtomicSet(&state->failed, 1);
+}
+	
 bool ImageDescriptor::MakeRGBA()
 {
+	if (Format != DXTC1 && Format != DXTC3 && Format != DXTC5) return false;
+
 	ImageDescriptor RGBADesc;
 	RGBADesc.Width = Width;
 	RGBADesc.Height = Height;
@@ -586,18 +788,32 @@ bool ImageDescriptor::MakeRGBA()
 	}
 
 	RGBADesc.Pixels = new uint32[RGBADesc.Size / 4];
-	
+
+	// every mipmap is cut into bands of block rows, which decode independently
+	dxtc_decode_state state;
+	state.format = Format;
+	state.source = this;
+	state.dest = &RGBADesc;
+	SDL_AtomicSet(&state.failed, 0);
 	for (int i = 0; i < MipMapCount; i++) {
-		if (Format == DXTC1) {
-			if (!DecompressDXTC1(RGBADesc.GetMipMapPtr(i), MAX(1, Width >> i), MAX(1, Height >> i), GetMipMapPtr(i))) return false;
-		} else if (Format == DXTC3) {
-			if (!DecompressDXTC3(RGBADesc.GetMipMapPtr(i), MAX(1, Width >> i), MAX(1, Height >> i), GetMipMapPtr(i))) return false;
-		} else if (Format == DXTC5) {
-			if (!DecompressDXTC5(RGBADesc.GetMipMapPtr(i), MAX(1, Width >> i), MAX(1, Height >> i), GetMipMapPtr(i))) return false;
-		} else {
-			return false;
+		int height = MAX(1, Height >> i);
+		for (int y = 0; y < height; y += kDecodeRowsPerJob) {
+			dxtc_decode_job job;
+			job.level = i;
+			job.y = y;
+			job.height = MIN(kDecodeRowsPerJob, height - y);
+			state.jobs.push_back(job);
 		}
 	}
+
+	if (RGBADesc.Size / 4 >= kParallelPixelCount) {
+		ImageLoader_Run(static_cast<int>(state.jobs.size()), decode_dxtc_rows, &state);
+	} else {
+		for (size_t job = 0; job < state.jobs.size(); job++)
+			decode_dxtc_rows(static_cast<int>(job), &state);
+	}
+
+	if (SDL_AtomicGet(&state.failed)) return false;
 	
 	delete []Pixels;
 	Pixels = RGBADesc.Pixels;
@@ -644,6 +860,313 @@ void ImageDescriptor::PremultiplyAlpha()
 	PremultipliedAlpha = true;
 }
 
+// On-disk cache of decoded RGBA images (with their mipmaps, if any), so that texture
+// packs in formats that are slow to decode only have to be decoded once; each entry
+// is keyed by a hash of the source file's path, size and modification date and the
+// flags it was loaded with, so looking an image up doesn't mean reading all of it
+
+static const uint32 kTextureCacheMagic = FOUR_CHARS_TO_INT('A', '1', 'T', 'X');
+static const uint32 kTextureCacheVersion = 2;
+static const int kTextureCacheHeaderSize = 13 * 4;
+
+// an entry's modification date is when it was last used; once per run, the least
+// recently used entries are dropped until the cache fits in its size limit
+static const int64 kTextureCacheSizeLimit = 500000000;
+static SDL_atomic_t texture_cache_pruned;
+
+static const uint64 kFNVOffsetBasis = 0xcbf29ce484222325ULL;
+static const uint64 kFNVPrime = 0x100000001b3ULL;
+
+static uint64 fnv1a(uint64 hash, const void *data, size_t length)
+{
+	const uint8 *p = reinterpret_cast<const uint8 *>(data);
+	for (size_t i = 0; i < length; i++) {
+		hash ^= p[i];
+		hash *= kFNVPrime;
+	}
+	return hash;
+}
+
+static FileSpecifier texture_cache_dir()
+{
+	FileSpecifier dir;
+	dir.SetToImageCacheDir();
+	dir.AddPart("Textures");
+	return dir;
+}
+
+static FileSpecifier texture_cache_file(uint64 key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%08x%08x.a1tx", (uint32) (key >> 32), (uint32) key);
+	FileSpecifier file = texture_cache_dir();
+	file.AddPart(name);
+	return file;
+}
+
+static bool texture_cache_entry_used_later(const dir_entry& a, const dir_entry& b)
+{
+	return a.date > b.date;
+}
+
+static void prune_texture_cache()
+{
+	if (!SDL_AtomicCAS(&texture_cache_pruned, 0, 1)) return;
+
+	FileSpecifier dir = texture_cache_dir();
+	std::vector<dir_entry> entries;
+	if (!dir.ReadDirectory(entries)) return;
+
+	std::sort(entries.begin(), entries.end(), texture_cache_entry_used_later);
+
+	int64 total = 0;
+	for (std::vector<dir_entry>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+		if (it->is_directory || it->name.size() < 5 || it->name.compare(it->name.size() - 5, 5, ".a1tx") != 0) continue;
+
+		total += it->size;
+		if (total > kTextureCacheSizeLimit) {
+			FileSpecifier file = dir;
+			file.AddPart(it->name);
+			file.Delete();
+		}
+	}
+}
+
+static inline uint64 double_bits(double d)
+{
+	uint64 bits;
+	memcpy(&bits, &d, sizeof(bits));
+	return bits;
+}
+
+static inline double bits_double(uint32 lo, uint32 hi)
+{
+	uint64 bits = ((uint64) hi << 32) | lo;
+	double d;
+	memcpy(&d, &bits, sizeof(d));
+	return d;
+}
+
+uint64 ImageDescriptor::CacheKey(FileSpecifier& File, int flags, int actual_width, int actual_height, int maxSize)
+{
+	if (!(flags & ImageLoader_CacheDecoded)) return 0;
+
+	OpenedFile file;
+	int32 length;
+	if (!File.Open(file, false, false) || !file.GetLength(length)) return 0;
+
+	// compressed DDS files go to the card as they are, there is nothing to cache
+	Uint32 dwMagic;
+	if ((flags & ImageLoader_CanUseDXTC) && length >= 4) {
+		if (!file.Read(4, &dwMagic)) return 0;
+		if (SDL_SwapLE32(dwMagic) == FOUR_CHARS_TO_INT(' ', 'S', 'D', 'D')) return 0;
+	}
+
+	const char *path = File.GetPath();
+	int64 date = static_cast<int64>(File.GetDate());
+
+	uint64 hash = kFNVOffsetBasis;
+	hash = fnv1a(hash, path, strlen(path));
+	hash = fnv1a(hash, &length, sizeof(length));
+	hash = fnv1a(hash, &date, sizeof(date));
+
+	int32 options[5] = { static_cast<int32>(kTextureCacheVersion), flags & ~ImageLoader_CacheDecoded, actual_width, actual_height, maxSize };
+	hash = fnv1a(hash, options, sizeof(options));
+
+	return hash ? hash : 1;
+}
+
+bool ImageDescriptor::LoadFromCache(uint64 key)
+{
+	if (!key) return false;
+
+	FileSpecifier File = texture_cache_file(key);
+	if (!File.Exists()) return false;
+
+	OpenedFile file;
+	int32 length;
+	if (!File.Open(file, false, false) || !file.GetLength(length)) return false;
+
+	uint8 header[kTextureCacheHeaderSize];
+	if (length < kTextureCacheHeaderSize || !file.Read(kTextureCacheHeaderSize, header)) return false;
+
+	uint32 magic, version, key_lo, key_hi;
+	int32 width, height, mipmaps, premultiplied;
+	uint32 vscale_lo, vscale_hi, uscale_lo, uscale_hi;
+	int32 size;
+
+	AIStreamLE stream(header, kTextureCacheHeaderSize);
+	try {
+		stream >> magic >> version >> key_lo >> key_hi;
+		stream >> width >> height >> mipmaps >> premultiplied;
+		stream >> vscale_lo >> vscale_hi >> uscale_lo >> uscale_hi;
+		stream >> size;
+	} catch (AStream::failure&) {
+		return false;
+	}
+
+	if (magic != kTextureCacheMagic || version != kTextureCacheVersion) return false;
+	if (key_lo != (uint32) key || key_hi != (uint32) (key >> 32)) return false;
+	if (width <= 0 || height <= 0 || mipmaps < 0 || size != length - kTextureCacheHeaderSize) return false;
+
+	// make sure the pixels are exactly what the dimensions say they should be
+	ImageDescriptor Cached;
+	Cached.Width = width;
+	Cached.Height = height;
+	Cached.Format = RGBA8;
+	int expected = 0;
+	for (int i = 0; i < MAX(1, mipmaps); i++) {
+		expected += Cached.GetMipMapSize(i);
+	}
+	if (size != expected) return false;
+
+	Cached.Pixels = new uint32[size / 4];
+	if (!file.Read(size, Cached.Pixels)) return false;
+	file.Close();
+
+	// keeps the entry from being pruned while it is still being used
+	File.SetDate(time(NULL));
+
+	delete []Pixels;
+	Pixels = Cached.Pixels;
+	Cached.Pixels = NULL;
+
+	Width = width;
+	Height = height;
+	VScale = bits_double(vscale_lo, vscale_hi);
+	UScale = bits_double(uscale_lo, uscale_hi);
+	Size = size;
+	MipMapCount = mipmaps;
+	Format = RGBA8;
+	PremultipliedAlpha = premultiplied != 0;
+
+	return true;
+}
+
+void ImageDescriptor::SaveToCache(uint64 key)
+{
+	if (!key || Format != RGBA8 || !Pixels) return;
+
+	texture_cache_dir().CreateDirectory();
+	prune_texture_cache();
+
+	FileSpecifier File = texture_cache_file(key);
+	FileSpecifier TempFile;
+	TempFile.SetTempName(File);
+
+	uint8 header[kTextureCacheHeaderSize];
+	AOStreamLE stream(header, kTextureCacheHeaderSize);
+	try {
+		stream << kTextureCacheMagic << kTextureCacheVersion << (uint32) key << (uint32) (key >> 32);
+		stream << (int32) Width << (int32) Height << (int32) MipMapCount << (int32) (PremultipliedAlpha ? 1 : 0);
+		stream << (uint32) double_bits(VScale) << (uint32) (double_bits(VScale) >> 32);
+		stream << (uint32) double_bits(UScale) << (uint32) (double_bits(UScale) >> 32);
+		stream << (int32) Size;
+	} catch (AStream::failure&) {
+		return;
+	}
+
+	bool written;
+	{
+		OpenedFile file;
+		written = TempFile.Open(file, true, false) &&
+			file.Write(kTextureCacheHeaderSize, header) &&
+			file.Write(Size, Pixels);
+	}
+
+	if (!written || !TempFile.Rename(File))
+		TempFile.Delete();
+}
+
+// images decoded by ImageLoader_Prefetch(), waiting for the LoadFromFile() that wants them
+static std::map<std::string, ImageDescriptor *> prefetched_images;
+
+static SDL_mutex *prefetched_images_mutex()
+{
+	static SDL_mutex *mutex = SDL_CreateMutex();
+	return mutex;
+}
+
+static std::string prefetch_key(FileSpecifier& File, int flags, int actual_width, int actual_height, int maxSize)
+{
+	char options[64];
+	snprintf(options, sizeof(options), "|%x|%d|%d|%d", flags & ~ImageLoader_CacheDecoded, actual_width, actual_height, maxSize);
+	return std::string(File.GetPath()) + options;
+}
+
+bool ImageDescriptor::LoadPrefetched(FileSpecifier& File, int flags, int actual_width, int actual_height, int maxSize)
+{
+	ImageDescriptor *image = NULL;
+
+	if (SDL_ThreadID() == image_loader_main_thread)
+		report_image_loader_warnings();
+
+	SDL_LockMutex(prefetched_images_mutex());
+	if (!prefetched_images.empty()) {
+		std::map<std::string, ImageDescriptor *>::iterator it = prefetched_images.find(prefetch_key(File, flags, actual_width, actual_height, maxSize));
+		if (it != prefetched_images.end()) {
+			image = it->second;
+			prefetched_images.erase(it);
+		}
+	}
+	SDL_UnlockMutex(prefetched_images_mutex());
+
+	if (!image) return false;
+
+	delete []Pixels;
+	Pixels = image->Pixels;
+	image->Pixels = NULL;
+
+	Width = image->Width;
+	Height = image->Height;
+	VScale = image->VScale;
+	UScale = image->UScale;
+	Size = image->Size;
+	MipMapCount = image->MipMapCount;
+	Format = image->Format;
+	PremultipliedAlpha = image->PremultipliedAlpha;
+
+	delete image;
+	return true;
+}
+
+void ImageLoader_Prefetch(ImageLoader_PrefetchRequest& request)
+{
+	std::string key = prefetch_key(request.File, request.flags, request.actual_width, request.actual_height, request.maxSize);
+
+	SDL_LockMutex(prefetched_images_mutex());
+	bool prefetched = prefetched_images.count(key) != 0;
+	SDL_UnlockMutex(prefetched_images_mutex());
+	if (prefetched) return;
+
+	ImageDescriptor *image = new ImageDescriptor;
+	if (!image->LoadFromFile(request.File, ImageLoader_Colors, request.flags, request.actual_width, request.actual_height, request.maxSize)) {
+		delete image;
+		return;
+	}
+
+	SDL_LockMutex(prefetched_images_mutex());
+	ImageDescriptor *&slot = prefetched_images[key];
+	if (slot)
+		delete image;
+	else
+		slot = image;
+	SDL_UnlockMutex(prefetched_images_mutex());
+}
+
+void ImageLoader_DiscardPrefetched()
+{
+	std::map<std::string, ImageDescriptor *> images;
+
+	SDL_LockMutex(prefetched_images_mutex());
+	images.swap(prefetched_images);
+	SDL_UnlockMutex(prefetched_images_mutex());
+
+	for (std::map<std::string, ImageDescriptor *>::iterator it = images.begin(); it != images.end(); ++it) {
+		delete it->second;
+	}
+}
+
 // DXTC decompression code adapted from DevIL (openil.sourceforge.net)
 
 typedef struct Color8888
@@ -254,6 +254,7 @@ void OGL_SetDefaults(OGL_ConfigureData& Data)
 	Data.WaitForVSync = true;
 	Data.Use_sRGB = false;
 	Data.Use_NPOT = false;
+	Data.CacheTextures = false;
 }
 
 
@@ -267,11 +268,9 @@ inline bool StringPresent(vector<char>& String)
 GLint glMaxTextureSize = 0;
 bool hasS3TC = false;
 
-void OGL_TextureOptionsBase::Load()
+int OGL_TextureOptionsBase::LoadFlags(int& maxTextureSize)
 {
-	FileSpecifier File;
-
-	GLint maxTextureSize = glMaxTextureSize;
+	maxTextureSize = glMaxTextureSize;
 	if (GetMaxSize())
 	{
 		maxTextureSize = MIN(maxTextureSize, GetMaxSize());
@@ -293,6 +292,51 @@ void OGL_TextureOptionsBase::Load()
 	{
 		flags |= ImageLoader_LoadDXTC1AsDXTC3;
 	}
+
+	if (Get_OGL_ConfigureData().CacheTextures)
+	{
+		flags |= ImageLoader_CacheDecoded;
+	}
+
+	return flags;
+}
+
+void OGL_TextureOptionsBase::GetPrefetches(std::vector<ImageLoader_PrefetchRequest>& prefetches)
+{
+	int maxTextureSize;
+	int flags = LoadFlags(maxTextureSize);
+
+	ImageLoader_PrefetchRequest request;
+	request.actual_width = actual_width;
+	request.actual_height = actual_height;
+	request.maxSize = maxTextureSize;
+
+	// whether or not they are loaded now; changing levels unloads them all
+	if (NormalColors != FileSpecifier() && NormalColors.Exists())
+	{
+		request.File = NormalColors;
+		request.flags = flags | (NormalIsPremultiplied ? ImageLoader_ImageIsAlreadyPremultiplied : 0);
+		prefetches.push_back(request);
+
+		if (OffsetMap != FileSpecifier() && OffsetMap.Exists())
+		{
+			request.File = OffsetMap;
+			prefetches.push_back(request);
+		}
+	}
+
+	if (GlowColors != FileSpecifier() && GlowColors.Exists())
+	{
+		request.File = GlowColors;
+		request.flags = flags | (GlowIsPremultiplied ? ImageLoader_ImageIsAlreadyPremultiplied : 0);
+		prefetches.push_back(request);
+	}
+}
+
+void OGL_TextureOptionsBase::Load()
+{
+	int maxTextureSize;
+	int flags = LoadFlags(maxTextureSize);
 	
 	// Load the normal image with alpha channel
 
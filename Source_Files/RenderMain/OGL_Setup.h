@@ -254,6 +254,7 @@ struct OGL_ConfigureData
 	bool WaitForVSync;
   bool Use_sRGB;
 	bool Use_NPOT;
+	bool CacheTextures;	// keep decoded replacement textures on disk
 };
 
 OGL_ConfigureData& Get_OGL_ConfigureData();
@@ -32,8 +32,12 @@
 
 #include <set>
 #include <string>
+#include <vector>
 #include <boost/unordered_map.hpp>
 
+#include <SDL_atomic.h>
+#include <SDL_thread.h>
+
 #ifdef HAVE_OPENGL
 
 // Texture-options stuff;
@@ -63,14 +67,47 @@ int OGL_CountTextures(short Collection)
 
 extern void OGL_ProgressCallback(int);
 
+struct texture_load_state {
+	std::vector<OGL_TextureOptions *> options;
+	SDL_threadID loader;	// only this thread may report progress
+	SDL_atomic_t loaded;
+	int reported;
+};
+
+static void load_texture_options(int index, void *arg)
+{
+	texture_load_state *state = reinterpret_cast<texture_load_state *>(arg);
+	state->options[index]->Load();
+
+	int loaded = SDL_AtomicAdd(&state->loaded, 1) + 1;
+	if (SDL_ThreadID() == state->loader)
+	{
+		OGL_ProgressCallback(loaded - state->reported);
+		state->reported = loaded;
+	}
+}
+
 void OGL_LoadTextures(short Collection)
 {
+	// nothing in Load() touches OpenGL, so the images can load side by side
+	texture_load_state state;
+	for (TOHash::iterator it = Collections[Collection].begin(); it != Collections[Collection].end(); ++it)
+	{
+		state.options.push_back(&it->second);
+	}
+	state.loader = SDL_ThreadID();
+	SDL_AtomicSet(&state.loaded, 0);
+	state.reported = 0;
 
+	ImageLoader_Run(static_cast<int>(state.options.size()), load_texture_options, &state);
+	OGL_ProgressCallback(static_cast<int>(state.options.size()) - state.reported);
+}
+
+void OGL_GetTexturePrefetches(short Collection, std::vector<ImageLoader_PrefetchRequest>& prefetches)
+{
 	for (TOHash::iterator it = Collections[Collection].begin(); it != Collections[Collection].end(); ++it)
 	{
-		it->second.Load();
-		OGL_ProgressCallback(1);
-		
+		it->second.GetPrefetches(prefetches);
 	}
 }
 
@@ -53,6 +53,9 @@ int OGL_CountTextures(short Collection);
 void OGL_LoadTextures(short Collection);
 void OGL_UnloadTextures(short Collection);
 
+// the images OGL_LoadTextures() would decode for the collection, for prefetching
+void OGL_GetTexturePrefetches(short Collection, std::vector<ImageLoader_PrefetchRequest>& prefetches);
+
 class InfoTree;
 void parse_mml_opengl_texture(const InfoTree& root);
 void reset_mml_opengl_texture();
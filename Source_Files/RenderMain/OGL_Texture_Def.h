@@ -145,6 +145,12 @@ struct OGL_TextureOptionsBase
 	void Load();
 	void Unload();
 
+	// the color images Load() would decode, for ImageLoader_Prefetch()
+	void GetPrefetches(std::vector<ImageLoader_PrefetchRequest>& prefetches);
+
+	// the ImageLoader flags and size limit Load() uses
+	int LoadFlags(int& maxTextureSize);
+
 	virtual int GetMaxSize();
 	
 	OGL_TextureOptionsBase():
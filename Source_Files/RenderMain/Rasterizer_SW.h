@@ -44,6 +44,11 @@ public:
 	// Rendering calls
 	// These are defined in scottish_textures.c (too great a name to change)
 	
+	// With more than one rendering thread, Begin() starts recording the draw calls and
+	// End() draws them, one horizontal band of the screen per thread
+	void Begin();
+	void End();
+	
 	void texture_horizontal_polygon(polygon_definition& textured_polygon);
 	
 	void texture_vertical_polygon(polygon_definition& textured_polygon);
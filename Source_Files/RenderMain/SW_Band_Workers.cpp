@@ -0,0 +1,38 @@
+/*
+SW_BAND_WORKERS.CPP
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+
+*/
+
+#include "SW_Band_Workers.h"
+
+#include "preferences.h"
+
+#include <SDL_cpuinfo.h>
+
+// more threads than this stop paying for themselves long before 1080p does
+static const int kMaximumThreads = 16;
+
+int SW_Band_Workers::ThreadCount()
+{
+	int count = graphics_preferences->software_render_threads;
+	if (count <= 0)
+		count = SDL_GetCPUCount();
+
+	return PIN(count, 1, kMaximumThreads);
+}
@@ -0,0 +1,56 @@
+#ifndef __SW_BAND_WORKERS_H
+#define __SW_BAND_WORKERS_H
+
+/*
+SW_BAND_WORKERS.H
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+
+	A pool of threads that the software rasterizer uses to draw horizontal bands of the
+	screen at the same time; the calling thread always draws bands too.
+*/
+
+#include "cseries.h"
+#include "WorkerPool.h"
+
+class SW_Band_Workers
+{
+public:
+	static SW_Band_Workers* instance() {
+		static SW_Band_Workers *instance_ = nullptr;
+		if (!instance_)
+			instance_ = new SW_Band_Workers();
+		return instance_;
+	}
+
+	typedef WorkerPool::WorkProc BandProc;
+
+	// how many threads (the caller included) should draw; from the graphics preferences,
+	// or the number of processors if those say "automatic"
+	int ThreadCount();
+
+	// calls proc once for every band in [0, band_count), spread over ThreadCount()
+	// threads, and returns when they have all finished
+	void Run(int band_count, BandProc proc, void *arg) { pool_.Run(band_count, ThreadCount(), proc, arg); }
+
+private:
+	SW_Band_Workers() : pool_("SW_Band_Workers_workThread") { }
+
+	WorkerPool pool_;
+};
+
+#endif
@@ -0,0 +1,133 @@
+/*
+WORKERPOOL.CPP
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+
+*/
+
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(const char *thread_name) :
+	thread_name_(thread_name),
+	wanted_(0),
+	active_(0),
+	generation_(0),
+	proc_(0),
+	arg_(0),
+	count_(0)
+{
+	SDL_AtomicSet(&running_, 0);
+	SDL_AtomicSet(&next_, 0);
+	mutex_ = SDL_CreateMutex();
+	work_cond_ = SDL_CreateCond();
+	done_cond_ = SDL_CreateCond();
+}
+
+void WorkerPool::StartThreads(int count)
+{
+	while (static_cast<int>(threads_.size()) < count)
+	{
+		Worker *worker = new Worker;
+		worker->pool = this;
+		worker->index = static_cast<int>(threads_.size());
+
+		SDL_Thread *thread = SDL_CreateThread(Work, thread_name_, worker);
+		if (!thread)
+		{
+			delete worker;
+			break;
+		}
+		threads_.push_back(thread);
+	}
+}
+
+void WorkerPool::DoItems(WorkProc proc, void *arg, int count)
+{
+	int index;
+	while ((index = SDL_AtomicAdd(&next_, 1)) < count)
+	{
+		proc(index, arg);
+	}
+}
+
+void WorkerPool::Run(int count, int thread_count, WorkProc proc, void *arg)
+{
+	int workers = MIN(thread_count, count) - 1;
+	if (workers <= 0 || !SDL_AtomicCAS(&running_, 0, 1))
+	{
+		for (int index = 0; index < count; ++index)
+			proc(index, arg);
+		return;
+	}
+
+	StartThreads(workers);
+	workers = MIN(workers, static_cast<int>(threads_.size()));
+
+	SDL_LockMutex(mutex_);
+	proc_ = proc;
+	arg_ = arg;
+	count_ = count;
+	wanted_ = workers;
+	SDL_AtomicSet(&next_, 0);
+	++generation_;
+	SDL_CondBroadcast(work_cond_);
+	SDL_UnlockMutex(mutex_);
+
+	DoItems(proc, arg, count);
+
+	// every item has been handed out; wait for the workers still on theirs, so that
+	// none of them can pick up items from the next Run() with this one's arguments
+	SDL_LockMutex(mutex_);
+	wanted_ = 0;
+	while (active_)
+		SDL_CondWait(done_cond_, mutex_);
+	SDL_UnlockMutex(mutex_);
+
+	SDL_AtomicSet(&running_, 0);
+}
+
+int WorkerPool::Work(void *pv)
+{
+	Worker *worker = reinterpret_cast<Worker *>(pv);
+	WorkerPool *pool = worker->pool;
+	uint32 generation = 0;
+
+	SDL_LockMutex(pool->mutex_);
+	while (true)
+	{
+		while (pool->generation_ == generation || worker->index >= pool->wanted_)
+		{
+			generation = pool->generation_;
+			SDL_CondWait(pool->work_cond_, pool->mutex_);
+		}
+
+		generation = pool->generation_;
+		WorkProc proc = pool->proc_;
+		void *arg = pool->arg_;
+		int count = pool->count_;
+		++pool->active_;
+		SDL_UnlockMutex(pool->mutex_);
+
+		pool->DoItems(proc, arg, count);
+
+		SDL_LockMutex(pool->mutex_);
+		if (--pool->active_ == 0)
+			SDL_CondSignal(pool->done_cond_);
+	}
+
+	return 0;
+}
@@ -0,0 +1,78 @@
+#ifndef __WORKERPOOL_H
+#define __WORKERPOOL_H
+
+/*
+WORKERPOOL.H
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+
+	A pool of threads that work through numbered items of a job together with the
+	thread that hands the job over; the software rasterizer draws bands of the screen
+	with one, the image loader decodes textures with another.
+*/
+
+#include "cseries.h"
+
+#include <vector>
+
+#include <SDL_atomic.h>
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
+
+class WorkerPool
+{
+public:
+	typedef void (*WorkProc)(int index, void *arg);
+
+	// thread_name is what the workers are called; it must outlive the pool
+	explicit WorkerPool(const char *thread_name);
+
+	// calls proc once for every index in [0, count), spread over up to thread_count
+	// threads (the caller included), and returns when they have all finished; if
+	// another thread is running the pool already, the caller does all of it alone
+	void Run(int count, int thread_count, WorkProc proc, void *arg);
+
+private:
+	void StartThreads(int count);
+	void DoItems(WorkProc proc, void *arg, int count);
+
+	const char *thread_name_;
+
+	std::vector<SDL_Thread *> threads_;
+	SDL_atomic_t running_;	// set while a Run() owns the pool
+	int wanted_;		// workers (not counting the caller) that take part in Run()
+	int active_;		// workers still working on the current generation
+	uint32 generation_;	// bumped by every Run()
+
+	WorkProc proc_;
+	void *arg_;
+	int count_;
+	SDL_atomic_t next_;
+
+	// thread fun
+	SDL_mutex *mutex_;
+	SDL_cond *work_cond_;
+	SDL_cond *done_cond_;
+
+	struct Worker {
+		WorkerPool *pool;
+		int index;
+	};
+	static int Work(void *);
+};
+
+#endif
@@ -91,6 +91,11 @@ struct collection_definition
 	std::vector<std::vector<uint8> > high_level_shapes;
 	std::vector<low_level_shape_definition> low_level_shapes;
 	std::vector<std::vector<uint8> > bitmaps;
+
+	// the collection as read from the Shapes file; for each bitmap whose pixels are still
+	// in there, bitmap_origins points at them, otherwise they follow its row address table
+	std::vector<uint8> data;
+	std::vector<uint8 *> bitmap_origins;
 };
 const int SIZEOF_collection_definition = 544;
 
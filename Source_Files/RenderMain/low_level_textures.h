@@ -28,6 +28,10 @@ Monday, February 27, 1995 11:40:47 PM  (Jason')
 Jan 30, 2000 (Loren Petrich):
 	Added some typecasts
 	Removed some "static" declarations that conflict with "extern"
+
+Oct 17, 2026:
+	Added SSE4.1 and AVX2 versions of the 32-bit horizontal span and four-column vertical
+	loops, picked at runtime by span_kernels(); the scalar loops remain the reference
 */
 
 #include "cseries.h"
@@ -35,6 +39,20 @@ Jan 30, 2000 (Loren Petrich):
 #include "textures.h"
 #include "scottish_textures.h"
 
+#include <SDL_cpuinfo.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#define SW_TEXTURES_X86
+#if defined(__GNUC__) || defined(__clang__)
+#define SW_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SW_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SW_TARGET_SSE41
+#define SW_TARGET_AVX2
+#endif
+#endif
+
 /* ---------- global state */
 
 inline uint16 & texture_random_seed()
@@ -149,6 +167,274 @@ void inline write_pixel(T *dst, pixel8 pixel, T *shading_table, uint8 *opacity_t
 	}	
 }
 
+/* ---------- vector span kernels */
+
+enum /* span kernels */
+{
+	_scalar_span_kernels,
+	_sse41_span_kernels,
+	_avx2_span_kernels
+};
+
+inline int detect_span_kernels()
+{
+#ifdef SW_TEXTURES_X86
+#if SDL_VERSION_ATLEAST(2, 0, 4)
+	if (SDL_HasAVX2()) return _avx2_span_kernels;
+#endif
+	if (SDL_HasSSE41()) return _sse41_span_kernels;
+#endif
+	return _scalar_span_kernels;
+}
+
+// which kernels the 32-bit mappers use; the span benchmark switches this back and forth
+inline int & span_kernels()
+{
+	static int kernels = detect_span_kernels();
+	return kernels;
+}
+
+#ifdef SW_TEXTURES_X86
+
+SW_TARGET_SSE41 inline __m128i average4(__m128i fg, __m128i bg)
+{
+	return _mm_add_epi32(_mm_srli_epi32(_mm_and_si128(_mm_xor_si128(fg, bg), _mm_set1_epi32(0xfffefefe)), 1), _mm_and_si128(fg, bg));
+}
+
+/* alpha_blend() keeps the low 32 bits of each channel's difference times alpha before
+	shifting, which is just what a 32-bit multiply gives us */
+SW_TARGET_SSE41 inline __m128i alpha_blend4(__m128i fg, __m128i bg, __m128i alpha, pixel32 rmask, pixel32 gmask, pixel32 bmask)
+{
+	pixel32 masks[3]= { rmask, gmask, bmask };
+	__m128i result= _mm_setzero_si128();
+	
+	for (int i= 0; i<3; ++i)
+	{
+		__m128i mask= _mm_set1_epi32(masks[i]);
+		__m128i bg_channel= _mm_and_si128(bg, mask);
+		__m128i delta= _mm_srai_epi32(_mm_mullo_epi32(_mm_sub_epi32(_mm_and_si128(fg, mask), bg_channel), alpha), 8);
+		
+		result= _mm_or_si128(result, _mm_and_si128(_mm_add_epi32(bg_channel, delta), mask));
+	}
+	
+	return result;
+}
+
+SW_TARGET_AVX2 inline __m256i average8(__m256i fg, __m256i bg)
+{
+	return _mm256_add_epi32(_mm256_srli_epi32(_mm256_and_si256(_mm256_xor_si256(fg, bg), _mm256_set1_epi32(0xfffefefe)), 1), _mm256_and_si256(fg, bg));
+}
+
+SW_TARGET_AVX2 inline __m256i alpha_blend8(__m256i fg, __m256i bg, __m256i alpha, pixel32 rmask, pixel32 gmask, pixel32 bmask)
+{
+	pixel32 masks[3]= { rmask, gmask, bmask };
+	__m256i result= _mm256_setzero_si256();
+	
+	for (int i= 0; i<3; ++i)
+	{
+		__m256i mask= _mm256_set1_epi32(masks[i]);
+		__m256i bg_channel= _mm256_and_si256(bg, mask);
+		__m256i delta= _mm256_srai_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(_mm256_and_si256(fg, mask), bg_channel), alpha), 8);
+		
+		result= _mm256_or_si256(result, _mm256_and_si256(_mm256_add_epi32(bg_channel, delta), mask));
+	}
+	
+	return result;
+}
+
+/* the texel address of texture_horizontal_polygon_lines() for four or eight pixels at once */
+#define HORIZONTAL_TEXEL_SHIFT (HORIZONTAL_HEIGHT_DOWNSHIFT-7)
+#define HORIZONTAL_TEXEL_MASK (0x7f<<7)
+
+/* draws the first count&~3 pixels of a 32-bit horizontal span and returns how many it drew;
+	texels are fetched one by one, since a 32-bit gather could read past the texture */
+template <int sw_alpha_blend>
+SW_TARGET_SSE41 int texture_horizontal_span32_sse41(
+	pixel32 *write,
+	pixel8 *base_address,
+	uint32 source_x,
+	uint32 source_y,
+	uint32 source_dx,
+	uint32 source_dy,
+	int count,
+	pixel32 *shading_table,
+	uint8 *opacity_table,
+	pixel32 rmask,
+	pixel32 gmask,
+	pixel32 bmask)
+{
+	__m128i lanes= _mm_setr_epi32(0, 1, 2, 3);
+	__m128i x= _mm_add_epi32(_mm_set1_epi32(source_x), _mm_mullo_epi32(lanes, _mm_set1_epi32(source_dx)));
+	__m128i y= _mm_add_epi32(_mm_set1_epi32(source_y), _mm_mullo_epi32(lanes, _mm_set1_epi32(source_dy)));
+	__m128i dx= _mm_set1_epi32(source_dx<<2), dy= _mm_set1_epi32(source_dy<<2);
+	__m128i texel_mask= _mm_set1_epi32(HORIZONTAL_TEXEL_MASK);
+	int drawn;
+	
+	for (drawn= 0; drawn+4<=count; drawn+= 4)
+	{
+		__m128i offsets= _mm_add_epi32(_mm_and_si128(_mm_srli_epi32(y, HORIZONTAL_TEXEL_SHIFT), texel_mask), _mm_srli_epi32(x, HORIZONTAL_WIDTH_DOWNSHIFT));
+		pixel8 t0= base_address[_mm_extract_epi32(offsets, 0)];
+		pixel8 t1= base_address[_mm_extract_epi32(offsets, 1)];
+		pixel8 t2= base_address[_mm_extract_epi32(offsets, 2)];
+		pixel8 t3= base_address[_mm_extract_epi32(offsets, 3)];
+		__m128i fg= _mm_setr_epi32(shading_table[t0], shading_table[t1], shading_table[t2], shading_table[t3]);
+		__m128i *dst= (__m128i *) (write+drawn);
+		
+		if (sw_alpha_blend==_sw_alpha_fast)
+		{
+			fg= average4(fg, _mm_loadu_si128(dst));
+		}
+		else if (sw_alpha_blend==_sw_alpha_nice)
+		{
+			__m128i alpha= _mm_setr_epi32(opacity_table[t0], opacity_table[t1], opacity_table[t2], opacity_table[t3]);
+			fg= alpha_blend4(fg, _mm_loadu_si128(dst), alpha, rmask, gmask, bmask);
+		}
+		_mm_storeu_si128(dst, fg);
+		
+		x= _mm_add_epi32(x, dx), y= _mm_add_epi32(y, dy);
+	}
+	
+	return drawn;
+}
+
+/* as above, eight pixels at a time, gathering the shading table entries */
+template <int sw_alpha_blend>
+SW_TARGET_AVX2 int texture_horizontal_span32_avx2(
+	pixel32 *write,
+	pixel8 *base_address,
+	uint32 source_x,
+	uint32 source_y,
+	uint32 source_dx,
+	uint32 source_dy,
+	int count,
+	pixel32 *shading_table,
+	uint8 *opacity_table,
+	pixel32 rmask,
+	pixel32 gmask,
+	pixel32 bmask)
+{
+	__m256i lanes= _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i x= _mm256_add_epi32(_mm256_set1_epi32(source_x), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(source_dx)));
+	__m256i y= _mm256_add_epi32(_mm256_set1_epi32(source_y), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(source_dy)));
+	__m256i dx= _mm256_set1_epi32(source_dx<<3), dy= _mm256_set1_epi32(source_dy<<3);
+	__m256i texel_mask= _mm256_set1_epi32(HORIZONTAL_TEXEL_MASK);
+	int32 offsets[8];
+	int drawn;
+	
+	for (drawn= 0; drawn+8<=count; drawn+= 8)
+	{
+		_mm256_storeu_si256((__m256i *) offsets, _mm256_add_epi32(_mm256_and_si256(_mm256_srli_epi32(y, HORIZONTAL_TEXEL_SHIFT), texel_mask), _mm256_srli_epi32(x, HORIZONTAL_WIDTH_DOWNSHIFT)));
+		__m256i texels= _mm256_setr_epi32(base_address[offsets[0]], base_address[offsets[1]], base_address[offsets[2]], base_address[offsets[3]],
+			base_address[offsets[4]], base_address[offsets[5]], base_address[offsets[6]], base_address[offsets[7]]);
+		__m256i fg= _mm256_i32gather_epi32((const int *) shading_table, texels, 4);
+		__m256i *dst= (__m256i *) (write+drawn);
+		
+		if (sw_alpha_blend==_sw_alpha_fast)
+		{
+			fg= average8(fg, _mm256_loadu_si256(dst));
+		}
+		else if (sw_alpha_blend==_sw_alpha_nice)
+		{
+			int32 t[8];
+			
+			_mm256_storeu_si256((__m256i *) t, texels);
+			__m256i alpha= _mm256_setr_epi32(opacity_table[t[0]], opacity_table[t[1]], opacity_table[t[2]], opacity_table[t[3]],
+				opacity_table[t[4]], opacity_table[t[5]], opacity_table[t[6]], opacity_table[t[7]]);
+			fg= alpha_blend8(fg, _mm256_loadu_si256(dst), alpha, rmask, gmask, bmask);
+		}
+		_mm256_storeu_si256(dst, fg);
+		
+		x= _mm256_add_epi32(x, dx), y= _mm256_add_epi32(y, dy);
+	}
+	
+	return drawn;
+}
+
+/* the parallel (x4) part of texture_vertical_polygon_lines() for 32-bit pixels: one lane per
+	column, with transparent texels writing back what was already there */
+template <int sw_alpha_blend, bool check_transparent>
+SW_TARGET_SSE41 void texture_vertical_columns32_sse41(
+	pixel32 *write,
+	int bytes_per_row,
+	int rows,
+	pixel8 *read0, pixel8 *read1, pixel8 *read2, pixel8 *read3,
+	uint32 texture_y0, uint32 texture_y1, uint32 texture_y2, uint32 texture_y3,
+	uint32 texture_dy0, uint32 texture_dy1, uint32 texture_dy2, uint32 texture_dy3,
+	pixel32 *shading_table0, pixel32 *shading_table1, pixel32 *shading_table2, pixel32 *shading_table3,
+	int downshift,
+	uint8 *opacity_table,
+	pixel32 rmask,
+	pixel32 gmask,
+	pixel32 bmask)
+{
+	__m128i y= _mm_setr_epi32(texture_y0, texture_y1, texture_y2, texture_y3);
+	__m128i dy= _mm_setr_epi32(texture_dy0, texture_dy1, texture_dy2, texture_dy3);
+	__m128i shift= _mm_cvtsi32_si128(downshift);
+	
+	for (; rows>0; --rows)
+	{
+		__m128i offsets= _mm_srl_epi32(y, shift);
+		pixel8 t0= read0[(uint32) _mm_extract_epi32(offsets, 0)];
+		pixel8 t1= read1[(uint32) _mm_extract_epi32(offsets, 1)];
+		pixel8 t2= read2[(uint32) _mm_extract_epi32(offsets, 2)];
+		pixel8 t3= read3[(uint32) _mm_extract_epi32(offsets, 3)];
+		__m128i fg= _mm_setr_epi32(shading_table0[t0], shading_table1[t1], shading_table2[t2], shading_table3[t3]);
+		__m128i *dst= (__m128i *) write;
+		
+		if (sw_alpha_blend==_sw_alpha_off && !check_transparent)
+		{
+			_mm_storeu_si128(dst, fg);
+		}
+		else
+		{
+			__m128i bg= _mm_loadu_si128(dst);
+			
+			if (sw_alpha_blend==_sw_alpha_fast)
+			{
+				fg= average4(fg, bg);
+			}
+			else if (sw_alpha_blend==_sw_alpha_nice)
+			{
+				__m128i alpha= _mm_setr_epi32(opacity_table[t0], opacity_table[t1], opacity_table[t2], opacity_table[t3]);
+				fg= alpha_blend4(fg, bg, alpha, rmask, gmask, bmask);
+			}
+			if (check_transparent)
+			{
+				__m128i transparent= _mm_cmpeq_epi32(_mm_setr_epi32(t0, t1, t2, t3), _mm_setzero_si128());
+				fg= _mm_blendv_epi8(fg, bg, transparent);
+			}
+			_mm_storeu_si128(dst, fg);
+		}
+		
+		y= _mm_add_epi32(y, dy);
+		write= (pixel32 *) ((byte *) write + bytes_per_row);
+	}
+}
+
+#endif
+
+/* skip the lines of a horizontal polygon which lie outside of [clip_top, clip_bottom); the
+	threaded rasterizer hands each band of the screen the same precalculated lines */
+inline void clip_horizontal_polygon_lines(
+	struct _horizontal_polygon_line_data *&data,
+	short &y0,
+	short *&x0_table,
+	short *&x1_table,
+	short &line_count,
+	short clip_top,
+	short clip_bottom)
+{
+	if (y0<clip_top)
+	{
+		short skip= MIN(line_count, clip_top-y0);
+		
+		data+= skip, x0_table+= skip, x1_table+= skip;
+		line_count-= skip;
+		y0+= skip;
+	}
+	if (y0+line_count>clip_bottom) line_count= MAX(0, clip_bottom-y0);
+}
+
 template <typename T, int sw_alpha_blend>
 void texture_horizontal_polygon_lines
 (
@@ -160,11 +446,15 @@ void texture_horizontal_polygon_lines
 	short *x0_table,
 	short *x1_table,
 	short line_count,
+	short clip_top,
+	short clip_bottom,
 	uint8 *opacity_table = 0
 )
 {
 	(void) (view);
 
+	clip_horizontal_polygon_lines(data, y0, x0_table, x1_table, line_count, clip_top, clip_bottom);
+
 	pixel32 rmask = 0;
 	pixel32 gmask = 0;
 	pixel32 bmask = 0;
@@ -179,6 +469,10 @@ void texture_horizontal_polygon_lines
 		bmask = fmt->Bmask;
 	}
 
+#ifdef SW_TEXTURES_X86
+	int vector_spans= (sizeof(T)==sizeof(pixel32)) ? span_kernels() : _scalar_span_kernels;
+#endif
+
 	while ((line_count-= 1)>=0)
 	{
 		short x0= *x0_table++, x1= *x1_table++;
@@ -191,6 +485,19 @@ void texture_horizontal_polygon_lines
 		uint32 source_dx= data->source_dx;
 		uint32 source_dy= data->source_dy;
 		short count= x1-x0;
+
+#ifdef SW_TEXTURES_X86
+		if (vector_spans!=_scalar_span_kernels && count>0)
+		{
+			int drawn= (vector_spans==_avx2_span_kernels) ?
+				texture_horizontal_span32_avx2<sw_alpha_blend>((pixel32 *) write, base_address, source_x, source_y, source_dx, source_dy, count, (pixel32 *) shading_table, opacity_table, rmask, gmask, bmask) :
+				texture_horizontal_span32_sse41<sw_alpha_blend>((pixel32 *) write, base_address, source_x, source_y, source_dx, source_dy, count, (pixel32 *) shading_table, opacity_table, rmask, gmask, bmask);
+			
+			/* the scalar loop finishes the span */
+			write+= drawn, count-= drawn;
+			source_x+= drawn*source_dx, source_y+= drawn*source_dy;
+		}
+#endif
 		
 		while ((count-= 1)>=0)
 		{
@@ -215,12 +522,16 @@ void landscape_horizontal_polygon_lines(
 	short y0,
 	short *x0_table,
 	short *x1_table,
-	short line_count)
+	short line_count,
+	short clip_top,
+	short clip_bottom)
 {
 	short landscape_texture_width_downshift= 32 - NextLowerExponent(texture->height);
 
 	(void) (view);
 
+	clip_horizontal_polygon_lines(data, y0, x0_table, x1_table, line_count, clip_top, clip_bottom);
+
 	while ((line_count-= 1)>=0)
 	{
 		short x0= *x0_table++, x1= *x1_table++;
@@ -253,6 +564,41 @@ void inline copy_check_transparent(T *dst, pixel8 read, T *shading_table)
 }
 
 
+/* copy rows [y0, y1) of one column, clipped to [clip_top, clip_bottom); texture_y is the
+	texture position at y0 and always comes back advanced to y1, as if nothing were clipped */
+template <typename T, bool check_transparent>
+inline void copy_vertical_polygon_segment(
+	struct bitmap_definition *screen,
+	int x,
+	int y0,
+	int y1,
+	int clip_top,
+	int clip_bottom,
+	pixel8 *read,
+	uint32 &texture_y,
+	uint32 texture_dy,
+	int downshift,
+	T *shading_table)
+{
+	int top= MAX(y0, clip_top), bottom= MIN(y1, clip_bottom);
+	
+	if (top<bottom)
+	{
+		int bytes_per_row= screen->bytes_per_row;
+		uint32 clipped_texture_y= texture_y + (top-y0)*texture_dy;
+		T *write= (T *)screen->row_addresses[top] + x;
+		
+		for (int count= bottom-top; count>0; --count)
+		{
+			copy_check_transparent<T, check_transparent>(write, read[clipped_texture_y>>downshift], shading_table);
+			write = (T *)((byte *)write + bytes_per_row);
+			clipped_texture_y+= texture_dy;
+		}
+	}
+	
+	if (y1>y0) texture_y+= (y1-y0)*texture_dy;
+}
+
 template <typename T, int sw_alpha_blend, bool check_transparent>
 void texture_vertical_polygon_lines(
 	struct bitmap_definition *screen,
@@ -260,6 +606,8 @@ void texture_vertical_polygon_lines(
 	struct _vertical_polygon_data *data,
 	short *y0_table,
 	short *y1_table, 
+	short clip_top,
+	short clip_bottom,
 	uint8 *opacity_table = 0)
 {
 	struct _vertical_polygon_line_data *line= (struct _vertical_polygon_line_data *) (data+1);
@@ -285,11 +633,17 @@ void texture_vertical_polygon_lines(
 		bmask = fmt->Bmask;
 	}
 
+#ifdef SW_TEXTURES_X86
+	bool vector_columns= sizeof(T)==sizeof(pixel32) && span_kernels()!=_scalar_span_kernels;
+#endif
+
+	/* the grouping of columns below decides which pixels are blended and which are copied, so
+		it is always done on the unclipped tables; clipping only decides which rows get written */
 	while (line_count>0)	
 	{
 		if (line_count<4 || (x&3) || aborted)
 		{
-			int y0= *y0_table++, y1= *y1_table++;
+			int y0= MAX(*y0_table, clip_top), y1= MIN(*y1_table, clip_bottom);
 			uint32 texture_y= line->texture_y;
 			uint32 texture_dy= line->texture_dy;
 			T *write, *shading_table;
@@ -297,16 +651,22 @@ void texture_vertical_polygon_lines(
 
 			shading_table= (T *)line->shading_table;
 			read= line->texture;
-			write= (T *)screen->row_addresses[y0] + x;
 
-			for (count= y1-y0; count>0; --count)
+			if (y0<y1)
 			{
-				write_pixel<T, sw_alpha_blend, check_transparent>(write, read[texture_y>>downshift], shading_table, opacity_table, rmask, gmask, bmask);
+				texture_y+= (y0-*y0_table)*texture_dy;
+				write= (T *)screen->row_addresses[y0] + x;
+
+				for (count= y1-y0; count>0; --count)
+				{
+					write_pixel<T, sw_alpha_blend, check_transparent>(write, read[texture_y>>downshift], shading_table, opacity_table, rmask, gmask, bmask);
 
-				write = (T *)((byte *)write + bytes_per_row);
-				texture_y+= texture_dy;
+					write = (T *)((byte *)write + bytes_per_row);
+					texture_y+= texture_dy;
+				}
 			}
 			
+			y0_table+= 1, y1_table+= 1;
 			x+= 1;
 			line+= 1;
 			line_count-= 1;
@@ -331,17 +691,11 @@ void texture_vertical_polygon_lines(
 			pixel8 *read3= line[3].texture;
 			T *shading_table3= (T *)line[3].shading_table;
 			
-			T *write;
-
 			int ymax;
 			
 			/* sync */	
 			{
-				int y0= y0_table[0], y1= y0_table[1], y2= y0_table[2], y3= y0_table[3];
-				T *temp_write;
-				
-				ymax= MAX(y0, y1), ymax= MAX(ymax, y2), ymax= MAX(ymax, y3);
-				write= (T *)screen->row_addresses[ymax] + x;
+				ymax= MAX(y0_table[0], y0_table[1]), ymax= MAX(ymax, y0_table[2]), ymax= MAX(ymax, y0_table[3]);
 				
 				{
 					int ymin= MIN(y1_table[0], y1_table[1]);
@@ -356,33 +710,10 @@ void texture_vertical_polygon_lines(
 					}
 				}
 
-				for (count= ymax-y0, temp_write= (T *)screen->row_addresses[y0] + x; count>0; --count)
-				{
-					copy_check_transparent<T, check_transparent>(temp_write, read0[texture_y0>>downshift], shading_table0);
-					temp_write = (T *)((byte *)temp_write + bytes_per_row);
-					texture_y0+= texture_dy0;
-				}
-				
-				for (count= ymax-y1, temp_write= (T *)screen->row_addresses[y1] + x; count>0; --count)
-				{
-					copy_check_transparent<T, check_transparent>(temp_write + 1, read1[texture_y1>>downshift], shading_table1);
-					temp_write = (T *)((byte *)temp_write + bytes_per_row);
-					texture_y1+= texture_dy1;
-				}
-				
-				for (count= ymax-y2, temp_write= (T *)screen->row_addresses[y2] + x; count>0; --count)
-				{
-					copy_check_transparent<T, check_transparent>(temp_write + 2, read2[texture_y2>>downshift], shading_table2);
-					temp_write = (T *)((byte *)temp_write + bytes_per_row);
-					texture_y2+= texture_dy2;
-				}
-		
-				for (count= ymax-y3, temp_write= (T *)screen->row_addresses[y3] + x; count>0; --count)
-				{
-					copy_check_transparent<T, check_transparent>(temp_write + 3, read3[texture_y3>>downshift], shading_table3);
-					temp_write = (T *)((byte *)temp_write + bytes_per_row);
-					texture_y3+= texture_dy3;
-				}
+				copy_vertical_polygon_segment<T, check_transparent>(screen, x, y0_table[0], ymax, clip_top, clip_bottom, read0, texture_y0, texture_dy0, downshift, shading_table0);
+				copy_vertical_polygon_segment<T, check_transparent>(screen, x+1, y0_table[1], ymax, clip_top, clip_bottom, read1, texture_y1, texture_dy1, downshift, shading_table1);
+				copy_vertical_polygon_segment<T, check_transparent>(screen, x+2, y0_table[2], ymax, clip_top, clip_bottom, read2, texture_y2, texture_dy2, downshift, shading_table2);
+				copy_vertical_polygon_segment<T, check_transparent>(screen, x+3, y0_table[3], ymax, clip_top, clip_bottom, read3, texture_y3, texture_dy3, downshift, shading_table3);
 			}
 
 			/* parallel map (x4) */
@@ -391,59 +722,61 @@ void texture_vertical_polygon_lines(
 				int dy1= y1_table[1] - ymax;
 				int dy2= y1_table[2] - ymax;
 				int dy3= y1_table[3] - ymax;
+				int top, bottom;
 				
 				count= MIN(dy0, dy1), count= MIN(count, dy2), count= MIN(count, dy3);
-				ymax+= count;
+				top= MAX(ymax, clip_top), bottom= MIN(ymax+count, clip_bottom);
 				
-				for (; count>0; --count)
+				if (top<bottom)
 				{
-					write_pixel<T, sw_alpha_blend, check_transparent>(write, read0[texture_y0>>downshift], shading_table0, opacity_table, rmask, gmask, bmask);
-					texture_y0+= texture_dy0;
-		
-					write_pixel<T, sw_alpha_blend, check_transparent>(write+1, read1[texture_y1>>downshift], shading_table1, opacity_table, rmask, gmask, bmask);
-					texture_y1+= texture_dy1;
+					int skip= top-ymax;
+					uint32 y0= texture_y0 + skip*texture_dy0;
+					uint32 y1= texture_y1 + skip*texture_dy1;
+					uint32 y2= texture_y2 + skip*texture_dy2;
+					uint32 y3= texture_y3 + skip*texture_dy3;
+					T *write= (T *)screen->row_addresses[top] + x;
+					
+#ifdef SW_TEXTURES_X86
+					if (vector_columns)
+					{
+						texture_vertical_columns32_sse41<sw_alpha_blend, check_transparent>((pixel32 *) write, bytes_per_row, bottom-top,
+							read0, read1, read2, read3, y0, y1, y2, y3, texture_dy0, texture_dy1, texture_dy2, texture_dy3,
+							(pixel32 *) shading_table0, (pixel32 *) shading_table1, (pixel32 *) shading_table2, (pixel32 *) shading_table3,
+							downshift, opacity_table, rmask, gmask, bmask);
+					}
+					else
+#endif
+					for (int rows= bottom-top; rows>0; --rows)
+					{
+						write_pixel<T, sw_alpha_blend, check_transparent>(write, read0[y0>>downshift], shading_table0, opacity_table, rmask, gmask, bmask);
+						y0+= texture_dy0;
+			
+						write_pixel<T, sw_alpha_blend, check_transparent>(write+1, read1[y1>>downshift], shading_table1, opacity_table, rmask, gmask, bmask);
+						y1+= texture_dy1;
 
-					write_pixel<T, sw_alpha_blend, check_transparent>(write+2, read2[texture_y2>>downshift], shading_table2, opacity_table, rmask, gmask, bmask);
-					texture_y2+= texture_dy2;
+						write_pixel<T, sw_alpha_blend, check_transparent>(write+2, read2[y2>>downshift], shading_table2, opacity_table, rmask, gmask, bmask);
+						y2+= texture_dy2;
 
-					write_pixel<T, sw_alpha_blend, check_transparent>(write+3, read3[texture_y3>>downshift], shading_table3, opacity_table, rmask, gmask, bmask);
-					texture_y3+= texture_dy3;
-					
-					write = (T *)((byte *)write + bytes_per_row);
+						write_pixel<T, sw_alpha_blend, check_transparent>(write+3, read3[y3>>downshift], shading_table3, opacity_table, rmask, gmask, bmask);
+						y3+= texture_dy3;
+						
+						write = (T *)((byte *)write + bytes_per_row);
+					}
 				}
+				
+				texture_y0+= count*texture_dy0;
+				texture_y1+= count*texture_dy1;
+				texture_y2+= count*texture_dy2;
+				texture_y3+= count*texture_dy3;
+				ymax+= count;
 			}
 
 			/* desync */	
 			{
-				T *temp_write;
-				
-				for (count= y1_table[0] - ymax, temp_write= write; count>0; --count)
-				{
-					copy_check_transparent<T, check_transparent>(temp_write, read0[texture_y0>>downshift], shading_table0);
-					temp_write = (T *)((byte *)temp_write + bytes_per_row);
-					texture_y0+= texture_dy0;
-				}
-				
-				for (count= y1_table[1] - ymax, temp_write= write; count>0; --count)
-				{
-					copy_check_transparent<T, check_transparent>(temp_write + 1, read1[texture_y1>>downshift], shading_table1);
-					temp_write = (T *)((byte *)temp_write + bytes_per_row);
-					texture_y1+= texture_dy1;
-				}
-				
-				for (count= y1_table[2] - ymax, temp_write= write; count>0; --count)
-				{
-					copy_check_transparent<T, check_transparent>(temp_write + 2, read2[texture_y2>>downshift], shading_table2);
-					temp_write = (T *)((byte *)temp_write + bytes_per_row);
-					texture_y2+= texture_dy2;
-				}
-		
-				for (count= y1_table[3] - ymax, temp_write= write; count>0; --count)
-				{
-					copy_check_transparent<T, check_transparent>(temp_write + 3, read3[texture_y3>>downshift], shading_table3);
-					temp_write = (T *)((byte *)temp_write + bytes_per_row);
-					texture_y3+= texture_dy3;
-				}
+				copy_vertical_polygon_segment<T, check_transparent>(screen, x, ymax, y1_table[0], clip_top, clip_bottom, read0, texture_y0, texture_dy0, downshift, shading_table0);
+				copy_vertical_polygon_segment<T, check_transparent>(screen, x+1, ymax, y1_table[1], clip_top, clip_bottom, read1, texture_y1, texture_dy1, downshift, shading_table1);
+				copy_vertical_polygon_segment<T, check_transparent>(screen, x+2, ymax, y1_table[2], clip_top, clip_bottom, read2, texture_y2, texture_dy2, downshift, shading_table2);
+				copy_vertical_polygon_segment<T, check_transparent>(screen, x+3, ymax, y1_table[3], clip_top, clip_bottom, read3, texture_y3, texture_dy3, downshift, shading_table3);
 			}
 
 			y0_table+= 4, y1_table+= 4;
@@ -519,6 +852,8 @@ void tint_vertical_polygon_lines(
 	struct _vertical_polygon_data *data,
 	short *y0_table,
 	short *y1_table,
+	short clip_top,
+	short clip_bottom,
 	uint16 transfer_data)
 {
 	short tint_table_index= transfer_data&0xff;
@@ -538,9 +873,17 @@ void tint_vertical_polygon_lines(
 	while ((line_count-= 1)>=0)
 	{
 		short y0= *y0_table++, y1= *y1_table++;
-		T *write= (T *) screen->row_addresses[y0] + x;
-		pixel8 *read= line->texture;
 		_fixed texture_y= line->texture_y, texture_dy= line->texture_dy;
+		
+		if (y0<clip_top)
+		{
+			texture_y= (_fixed)((uint32)texture_y + (uint32)(clip_top-y0)*(uint32)texture_dy);
+			y0= clip_top;
+		}
+		if (y1>clip_bottom) y1= clip_bottom;
+		
+		T *write= (y0<y1) ? (T *) screen->row_addresses[y0] + x : NULL;
+		pixel8 *read= line->texture;
 		short count= y1-y0;
 
 		while ((count-=1)>=0)
@@ -96,6 +96,11 @@ Aug 9, 2000 (Loren Petrich):
 
 May 16, 2002 (Woody Zenfell):
     MSVC doesn't like "void f();  void g() { return f(); }"... fixed.
+
+Oct 17, 2026:
+	The texture_* calls now describe what to draw with an sw_draw_command; with more than
+	one rendering thread these are recorded between Begin() and End() and drawn in
+	horizontal bands of the screen, each clipped to its band, by SW_Band_Workers.
 */
 
 /*
@@ -119,8 +124,11 @@ not only that, but texture_horizontal_polygon() is actually faster than texture_
 #include <limits.h>
 
 #include "preferences.h"
+#include "SW_Band_Workers.h"
 #include "SW_Texture_Extras.h"
 
+#include <vector>
+
 
 /* ---------- constants */
 
@@ -133,6 +141,22 @@ not only that, but texture_horizontal_polygon() is actually faster than texture_
 
 #define LARGEST_N 24
 
+// recorded tables and precalculations are copied into blocks of this size
+#define COMMAND_BLOCK_SIZE (1<<20)
+
+// bands per rendering thread; more than one evens out bands with more overdraw
+#define BANDS_PER_THREAD 4
+#define MINIMUM_BAND_HEIGHT 8
+
+enum /* draw command kinds */
+{
+	_textured_horizontal_lines,
+	_landscaped_horizontal_lines,
+	_textured_vertical_lines,
+	_tinted_vertical_lines,
+	_static_vertical_lines
+};
+
 /* ---------- macros */
 
 #if defined(DEBUG) && defined(DEBUG_FAST_CODE)
@@ -180,6 +204,32 @@ static void calculate_shading_table(void * &result,view_data *view, void *shadin
 static short *scratch_table0 = NULL, *scratch_table1 = NULL;
 static void *precalculation_table = NULL;
 
+extern SDL_Surface *world_pixels;
+
+/* everything the low-level mappers need to draw one polygon or rectangle, once its line
+	tables and precalculations are built; top and bottom are the screen rows it touches */
+struct sw_draw_command
+{
+	short kind;
+	short sw_alpha_blend;
+	bool check_transparent;
+	uint16 transfer_data;
+	uint8 *opacity_table;
+	
+	struct bitmap_definition *texture;
+	short y0, line_count; /* horizontal lines only */
+	short top, bottom;
+	
+	short *table0, *table1;
+	void *precalculation;
+};
+
+/* while recording, draw commands and copies of their tables are kept here until End() */
+static bool recording_commands = false;
+static std::vector<sw_draw_command> recorded_commands;
+static std::vector<std::vector<byte> > command_blocks;
+static size_t command_block_index = 0, command_block_used = 0;
+
 /* ---------- private prototypes */
 
 static void _pretexture_horizontal_polygon_lines(struct polygon_definition *polygon,
@@ -197,6 +247,13 @@ static void _prelandscape_horizontal_polygon_lines(struct polygon_definition *po
 	struct bitmap_definition *screen, struct view_data *view, struct _horizontal_polygon_line_data *data,
 	short y0, short *x0_table, short *x1_table, short line_count);
 
+static void select_alpha_blending(struct sw_draw_command *command, struct polygon_definition *polygon);
+static void submit_draw_command(struct sw_draw_command *command, struct bitmap_definition *screen,
+	struct view_data *view, size_t table_size, size_t precalculation_size);
+static void draw_command(struct sw_draw_command *command, struct bitmap_definition *screen,
+	struct view_data *view, short clip_top, short clip_bottom);
+static void draw_recorded_commands(struct bitmap_definition *screen, struct view_data *view);
+
 /* ---------- code */
 
 /* set aside memory at launch for two line tables (remember, we precalculate all the y-values
@@ -324,105 +381,34 @@ void Rasterizer_SW_Class::texture_horizontal_polygon(polygon_definition& texture
 		}
 		
 		/* render all lines */
-		switch (bit_depth)
 		{
-			case 8:
-				switch (polygon->transfer_mode)
-				{
-	
-					case _textured_transfer:
-						texture_horizontal_polygon_lines<pixel8, _sw_alpha_off>(polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table,
-							vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count);
-						break;
-					case _big_landscaped_transfer:
-						landscape_horizontal_polygon_lines<pixel8>(polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table,
-							vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count);
-						break;
-						
-					default:
-						fc_assert(false);
-						break;
-				}
-				break;
-
-			case 16:
-				switch (polygon->transfer_mode)
-				{
-					case _textured_transfer:
-					{
-						SW_Texture *sw_texture = 0;
-						if (graphics_preferences->software_alpha_blending)
-						{
-							sw_texture = SW_Texture_Extras::instance()->GetTexture(polygon->ShapeDesc);
-						}
-						if (sw_texture && !polygon->VoidPresent && sw_texture->opac_type())
-						{
-							if (graphics_preferences->software_alpha_blending == _sw_alpha_fast) {
-								texture_horizontal_polygon_lines<pixel16, _sw_alpha_fast>(polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table, vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count);
-							}
-							else if (graphics_preferences->software_alpha_blending == _sw_alpha_nice) {
-								texture_horizontal_polygon_lines<pixel16, _sw_alpha_nice>(polygon->texture, screen, view, (struct _horizontal_polygon_line_data *) precalculation_table, vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count, sw_texture->opac_table());
-							}
-						} else {
-							texture_horizontal_polygon_lines<pixel16, _sw_alpha_off>(polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table,
-											  vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count);
-						}
-					}
-					break;
-						
-				case _big_landscaped_transfer:
-						landscape_horizontal_polygon_lines<pixel16>(polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table,
-							vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count);
-						break;
-					default:
-						fc_assert(false);
-						break;
-				}
-				break;
-
-			case 32:
-				switch (polygon->transfer_mode)
-				{
+			struct sw_draw_command command;
+			
+			command.kind= (polygon->transfer_mode==_big_landscaped_transfer) ? _landscaped_horizontal_lines : _textured_horizontal_lines;
+			command.check_transparent= false;
+			command.transfer_data= polygon->transfer_data;
+			command.texture= polygon->texture;
+			command.y0= vertices[highest_vertex].y;
+			command.line_count= aggregate_total_line_count;
+			command.top= command.y0;
+			command.bottom= command.y0+aggregate_total_line_count;
+			command.table0= left_table;
+			command.table1= right_table;
+			command.precalculation= precalculation_table;
+			select_alpha_blending(&command, polygon);
+			
+			switch (polygon->transfer_mode)
+			{
 				case _textured_transfer:
-				{
-					SW_Texture *sw_texture = 0;
-					if (graphics_preferences->software_alpha_blending)
-					{
-						sw_texture = SW_Texture_Extras::instance()->GetTexture(polygon->ShapeDesc);
-					}
-					if (sw_texture && sw_texture->opac_type() && !polygon->VoidPresent)
-					{
-						if (graphics_preferences->software_alpha_blending == _sw_alpha_fast)
-						{
-							texture_horizontal_polygon_lines<pixel32, _sw_alpha_fast>(polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table, vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count);
-						} 
-						else if (graphics_preferences->software_alpha_blending == _sw_alpha_nice)
-						{
-							texture_horizontal_polygon_lines<pixel32, _sw_alpha_nice>(polygon->texture, screen, view, (struct _horizontal_polygon_line_data *) precalculation_table, vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count, sw_texture->opac_table());
-						}
-					}
-					else 
-					{
-						texture_horizontal_polygon_lines<pixel32, _sw_alpha_off>(polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table,
-											  vertices[highest_vertex].y, left_table, right_table,
-											  aggregate_total_line_count);
-					}
-				}
-				break;
-					case _big_landscaped_transfer:
-						landscape_horizontal_polygon_lines<pixel32>(polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table,
-							vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count);
-						break;
-					
-					default:
-						fc_assert(false);
-						break;
-				}
-				break;
-
-			default:
-				fc_assert(false);
-				break;
+				case _big_landscaped_transfer:
+					submit_draw_command(&command, screen, view, aggregate_total_line_count*sizeof(short),
+						aggregate_total_line_count*sizeof(struct _horizontal_polygon_line_data));
+					break;
+				
+				default:
+					fc_assert(false);
+					break;
+			}
 		}
 	}
 }
@@ -531,127 +517,31 @@ void Rasterizer_SW_Class::texture_vertical_polygon(polygon_definition& textured_
           else VHALT_DEBUG(csprintf(temporary, "vertical_polygons dont support mode #%d", polygon->transfer_mode));
           
 		/* render all lines */
-		switch (bit_depth)
 		{
-			case 8:
-				switch (polygon->transfer_mode)
-				{
-					case _textured_transfer:
-						if (polygon->texture->flags&_TRANSPARENT_BIT)
-							texture_vertical_polygon_lines<pixel8, _sw_alpha_off, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
-						else
-							texture_vertical_polygon_lines<pixel8, _sw_alpha_off, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
-						break;
-					case _static_transfer:
-						if (polygon->texture->flags&_TRANSPARENT_BIT)
-							randomize_vertical_polygon_lines<pixel8, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, polygon->transfer_data);
-						else
-							randomize_vertical_polygon_lines<pixel8, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, polygon->transfer_data);
-						break;
-						
-				default:
-					fc_assert(false);
-					break;
-				}
-				break;
-				
-			case 16:
-				switch (polygon->transfer_mode)
-				{
+			struct sw_draw_command command;
+			
+			command.kind= (polygon->transfer_mode==_static_transfer) ? _static_vertical_lines : _textured_vertical_lines;
+			command.check_transparent= (polygon->texture->flags&_TRANSPARENT_BIT) ? true : false;
+			command.transfer_data= polygon->transfer_data;
+			command.texture= polygon->texture;
+			command.y0= command.line_count= 0;
+			command.table0= left_table;
+			command.table1= right_table;
+			command.precalculation= precalculation_table;
+			select_alpha_blending(&command, polygon);
+			
+			switch (polygon->transfer_mode)
+			{
 				case _textured_transfer:
-				{
-					SW_Texture *sw_texture =0 ;
-					if (graphics_preferences->software_alpha_blending)
-					{
-						sw_texture = SW_Texture_Extras::instance()->GetTexture(polygon->ShapeDesc);
-					}
-					if (sw_texture && !polygon->VoidPresent && sw_texture->opac_type())
-					{
-						if (graphics_preferences->software_alpha_blending == _sw_alpha_fast) {
-							if (polygon->texture->flags & _TRANSPARENT_BIT) {
-								texture_vertical_polygon_lines<pixel16, _sw_alpha_fast, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
-							} else {
-								texture_vertical_polygon_lines<pixel16, _sw_alpha_fast, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
-							}
-						} 
-						else if (graphics_preferences->software_alpha_blending == _sw_alpha_nice) {
-							if (polygon->texture->flags & _TRANSPARENT_BIT)  {
-								texture_vertical_polygon_lines<pixel16, _sw_alpha_nice, true>(screen, view, (struct _vertical_polygon_data *) precalculation_table, left_table, right_table, sw_texture->opac_table());
-							} else {
-								texture_vertical_polygon_lines<pixel16, _sw_alpha_nice, false>(screen, view, (struct _vertical_polygon_data *) precalculation_table, left_table, right_table, sw_texture->opac_table());
-							}
-						}
-					} else {
-						if (polygon->texture->flags & _TRANSPARENT_BIT) {
-							texture_vertical_polygon_lines<pixel16, _sw_alpha_off, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
-						} else {
-							texture_vertical_polygon_lines<pixel16, _sw_alpha_off, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
-						}
-					}
-				}
-				break;
 				case _static_transfer:
-					if (polygon->texture->flags & _TRANSPARENT_BIT) {
-						randomize_vertical_polygon_lines<pixel16, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, polygon->transfer_data);
-					} else {
-						randomize_vertical_polygon_lines<pixel16, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, polygon->transfer_data);
-					}
-					break;
-				default:
-					fc_assert(false);
+					submit_draw_command(&command, screen, view, aggregate_total_line_count*sizeof(short),
+						sizeof(struct _vertical_polygon_data) + aggregate_total_line_count*sizeof(struct _vertical_polygon_line_data));
 					break;
-				}
-				break;
 				
-			case 32:
-				switch (polygon->transfer_mode)
-				{
-					case _textured_transfer:
-					{
-						SW_Texture *sw_texture = 0;
-						if (graphics_preferences->software_alpha_blending)
-						{
-							sw_texture = SW_Texture_Extras::instance()->GetTexture(polygon->ShapeDesc);
-						}
-						if (sw_texture && !polygon->VoidPresent && sw_texture->opac_type())
-						{
-							if (graphics_preferences->software_alpha_blending == _sw_alpha_fast) {
-								if (polygon->texture->flags&_TRANSPARENT_BIT)
-									texture_vertical_polygon_lines<pixel32, _sw_alpha_fast, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
-								else
-									texture_vertical_polygon_lines<pixel32, _sw_alpha_fast, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
-							}
-							else if (graphics_preferences->software_alpha_blending == _sw_alpha_nice) 
-							{
-								if (polygon->texture->flags & _TRANSPARENT_BIT)
-									texture_vertical_polygon_lines<pixel32, _sw_alpha_nice, true>(screen, view, (struct _vertical_polygon_data *) precalculation_table, left_table, right_table, sw_texture->opac_table());
-								else
-									texture_vertical_polygon_lines<pixel32, _sw_alpha_nice, false>(screen, view, (struct _vertical_polygon_data *) precalculation_table, left_table, right_table, sw_texture->opac_table());
-							}
-						} else {
-							if (polygon->texture->flags & _TRANSPARENT_BIT)
-								texture_vertical_polygon_lines<pixel32, _sw_alpha_off, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
-							else
-								texture_vertical_polygon_lines<pixel32, _sw_alpha_off, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
-						}
-						break;
-					}
-					case _static_transfer:
-						if (polygon->texture->flags & _TRANSPARENT_BIT)
-							randomize_vertical_polygon_lines<pixel32, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, polygon->transfer_data);
-						else
-							randomize_vertical_polygon_lines<pixel32, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, polygon->transfer_data);
-						break;
-						
 				default:
 					fc_assert(false);
 					break;
-				}
-				break;
-				
-		default:
-			fc_assert(false);
-			break;
+			}
 		}
 	}
 }
@@ -804,86 +694,393 @@ void Rasterizer_SW_Class::texture_rectangle(rectangle_definition& textured_recta
 					fc_assert(y1<=screen->height);
 				}
 		
-				switch (bit_depth)
 				{
-					case 8:
-						switch (rectangle->transfer_mode)
-						{
-							case _textured_transfer:
-								texture_vertical_polygon_lines<pixel8, _sw_alpha_off, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table,
-									scratch_table0, scratch_table1);
-								break;
-							
-							case _static_transfer:
-								randomize_vertical_polygon_lines<pixel8, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table,
-									scratch_table0, scratch_table1, rectangle->transfer_data);
-								break;
-							
-							case _tinted_transfer:
-								tint_vertical_polygon_lines<pixel8>(screen, view, (struct _vertical_polygon_data *)precalculation_table,
-									scratch_table0, scratch_table1, rectangle->transfer_data);
-								break;
-							
-							default:
-								fc_assert(false);
-								break;
-						}
-						break;
+					struct sw_draw_command command;
+					
+					switch (rectangle->transfer_mode)
+					{
+						case _textured_transfer: command.kind= _textured_vertical_lines; break;
+						case _static_transfer: command.kind= _static_vertical_lines; break;
+						case _tinted_transfer: command.kind= _tinted_vertical_lines; break;
+						
+						default:
+							fc_assert(false);
+							return;
+					}
+					command.sw_alpha_blend= _sw_alpha_off;
+					command.opacity_table= NULL;
+					command.check_transparent= true;
+					command.transfer_data= rectangle->transfer_data;
+					command.texture= texture;
+					command.y0= command.line_count= 0;
+					command.table0= scratch_table0;
+					command.table1= scratch_table1;
+					command.precalculation= precalculation_table;
+					
+					submit_draw_command(&command, screen, view, header->width*sizeof(short),
+						sizeof(struct _vertical_polygon_data) + header->width*sizeof(struct _vertical_polygon_line_data));
+				}
+			}
+		}
+	}
+}
+
+/* ---------- drawing and recording */
+
+void Rasterizer_SW_Class::Begin()
+{
+	recording_commands= SW_Band_Workers::instance()->ThreadCount()>1;
+}
+
+void Rasterizer_SW_Class::End()
+{
+	draw_recorded_commands(screen, view);
+	recording_commands= false;
+}
+
+/* pick the alpha blending for a textured polygon the way the 16- and 32-bit mappers always
+	have; 8-bit never blends */
+static void select_alpha_blending(
+	struct sw_draw_command *command,
+	struct polygon_definition *polygon)
+{
+	command->sw_alpha_blend= _sw_alpha_off;
+	command->opacity_table= NULL;
+	
+	if (bit_depth!=8 && polygon->transfer_mode==_textured_transfer && graphics_preferences->software_alpha_blending)
+	{
+		SW_Texture *sw_texture= SW_Texture_Extras::instance()->GetTexture(polygon->ShapeDesc);
 		
-					case 16:
-						switch (rectangle->transfer_mode)
-						{
-							case _textured_transfer:
-								texture_vertical_polygon_lines<pixel16, _sw_alpha_off, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, scratch_table0, scratch_table1);
-								break;
-								
-							case _static_transfer:
-								randomize_vertical_polygon_lines<pixel16, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table,
-									scratch_table0, scratch_table1, rectangle->transfer_data);
-								break;
-							
-							case _tinted_transfer:
-								tint_vertical_polygon_lines<pixel16>(screen, view, (struct _vertical_polygon_data *)precalculation_table,
-									scratch_table0, scratch_table1, rectangle->transfer_data);
-								break;
-							
-							default:
-								fc_assert(false);
-								break;
-						}
-						break;
+		if (sw_texture && !polygon->VoidPresent && sw_texture->opac_type())
+		{
+			command->sw_alpha_blend= graphics_preferences->software_alpha_blending;
+			if (command->sw_alpha_blend==_sw_alpha_nice) command->opacity_table= sw_texture->opac_table();
+		}
+	}
+}
+
+/* returns storage for size bytes that stays put until the recorded commands are drawn */
+static void *allocate_command_storage(
+	size_t size)
+{
+	size= (size+7)&~(size_t)7;
+	
+	while (command_block_index<command_blocks.size() &&
+		command_block_used+size>command_blocks[command_block_index].size())
+	{
+		command_block_index+= 1;
+		command_block_used= 0;
+	}
+	if (command_block_index==command_blocks.size())
+	{
+		command_blocks.push_back(std::vector<byte>(MAX(size, (size_t)COMMAND_BLOCK_SIZE)));
+		command_block_used= 0;
+	}
+	
+	void *storage= &command_blocks[command_block_index][command_block_used];
+	command_block_used+= size;
+	
+	return storage;
+}
+
+static void *copy_to_command_storage(
+	void *source,
+	size_t size)
+{
+	return size ? memcpy(allocate_command_storage(size), source, size) : NULL;
+}
+
+/* draw the command now, or if we are recording, copy its tables and draw it at End();
+	the static mapper's random number generator runs in drawing order, so static commands
+	are drawn whole, in order, on this thread */
+static void submit_draw_command(
+	struct sw_draw_command *command,
+	struct bitmap_definition *screen,
+	struct view_data *view,
+	size_t table_size,
+	size_t precalculation_size)
+{
+	if (command->kind==_textured_horizontal_lines || command->kind==_landscaped_horizontal_lines)
+	{
+		if (command->line_count<=0) return;
+	}
+	else
+	{
+		struct _vertical_polygon_data *header= (struct _vertical_polygon_data *) command->precalculation;
 		
-					case 32:
-						switch (rectangle->transfer_mode)
-						{
-							case _textured_transfer:
-								texture_vertical_polygon_lines<pixel32, _sw_alpha_off, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table,
-									scratch_table0, scratch_table1);
-								break;
-							
-							case _static_transfer:
-								randomize_vertical_polygon_lines<pixel32, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table,
-									scratch_table0, scratch_table1, rectangle->transfer_data);
-								break;
-							
-							case _tinted_transfer:
-								tint_vertical_polygon_lines<pixel32>(screen, view, (struct _vertical_polygon_data *)precalculation_table,
-									scratch_table0, scratch_table1, rectangle->transfer_data);
-								break;
-							
-							default:
-								fc_assert(false);
-								break;
-						}
-						break;
+		if (header->width<=0) return;
 		
-					default:
-						fc_assert(false);
-						break;
-				}
+		command->top= SHRT_MAX, command->bottom= SHRT_MIN;
+		for (short i= 0; i<header->width; ++i)
+		{
+			command->top= MIN(command->top, command->table0[i]);
+			command->bottom= MAX(command->bottom, command->table1[i]);
+		}
+	}
+	
+	if (!recording_commands)
+	{
+		draw_command(command, screen, view, 0, screen->height);
+	}
+	else if (command->kind==_static_vertical_lines)
+	{
+		draw_recorded_commands(screen, view);
+		draw_command(command, screen, view, 0, screen->height);
+	}
+	else
+	{
+		command->table0= (short *) copy_to_command_storage(command->table0, table_size);
+		command->table1= (short *) copy_to_command_storage(command->table1, table_size);
+		command->precalculation= copy_to_command_storage(command->precalculation, precalculation_size);
+		
+		recorded_commands.push_back(*command);
+	}
+}
+
+template <typename T>
+static void draw_command_lines(
+	struct sw_draw_command *command,
+	struct bitmap_definition *screen,
+	struct view_data *view,
+	short clip_top,
+	short clip_bottom)
+{
+	struct _horizontal_polygon_line_data *horizontal_data= (struct _horizontal_polygon_line_data *) command->precalculation;
+	struct _vertical_polygon_data *vertical_data= (struct _vertical_polygon_data *) command->precalculation;
+	short *table0= command->table0, *table1= command->table1;
+	
+	switch (command->kind)
+	{
+		case _textured_horizontal_lines:
+			switch (command->sw_alpha_blend)
+			{
+				case _sw_alpha_off:
+					texture_horizontal_polygon_lines<T, _sw_alpha_off>(command->texture, screen, view, horizontal_data,
+						command->y0, table0, table1, command->line_count, clip_top, clip_bottom);
+					break;
+				case _sw_alpha_fast:
+					texture_horizontal_polygon_lines<T, _sw_alpha_fast>(command->texture, screen, view, horizontal_data,
+						command->y0, table0, table1, command->line_count, clip_top, clip_bottom);
+					break;
+				case _sw_alpha_nice:
+					texture_horizontal_polygon_lines<T, _sw_alpha_nice>(command->texture, screen, view, horizontal_data,
+						command->y0, table0, table1, command->line_count, clip_top, clip_bottom, command->opacity_table);
+					break;
+			}
+			break;
+		
+		case _landscaped_horizontal_lines:
+			landscape_horizontal_polygon_lines<T>(command->texture, screen, view, horizontal_data,
+				command->y0, table0, table1, command->line_count, clip_top, clip_bottom);
+			break;
+		
+		case _textured_vertical_lines:
+			switch (command->sw_alpha_blend)
+			{
+				case _sw_alpha_off:
+					if (command->check_transparent)
+						texture_vertical_polygon_lines<T, _sw_alpha_off, true>(screen, view, vertical_data, table0, table1, clip_top, clip_bottom);
+					else
+						texture_vertical_polygon_lines<T, _sw_alpha_off, false>(screen, view, vertical_data, table0, table1, clip_top, clip_bottom);
+					break;
+				case _sw_alpha_fast:
+					if (command->check_transparent)
+						texture_vertical_polygon_lines<T, _sw_alpha_fast, true>(screen, view, vertical_data, table0, table1, clip_top, clip_bottom);
+					else
+						texture_vertical_polygon_lines<T, _sw_alpha_fast, false>(screen, view, vertical_data, table0, table1, clip_top, clip_bottom);
+					break;
+				case _sw_alpha_nice:
+					if (command->check_transparent)
+						texture_vertical_polygon_lines<T, _sw_alpha_nice, true>(screen, view, vertical_data, table0, table1, clip_top, clip_bottom, command->opacity_table);
+					else
+						texture_vertical_polygon_lines<T, _sw_alpha_nice, false>(screen, view, vertical_data, table0, table1, clip_top, clip_bottom, command->opacity_table);
+					break;
+			}
+			break;
+		
+		case _tinted_vertical_lines:
+			tint_vertical_polygon_lines<T>(screen, view, vertical_data, table0, table1, clip_top, clip_bottom, command->transfer_data);
+			break;
+		
+		case _static_vertical_lines:
+			/* never clipped; see submit_draw_command() */
+			fc_assert(clip_top<=command->top && clip_bottom>=command->bottom);
+			if (command->check_transparent)
+				randomize_vertical_polygon_lines<T, true>(screen, view, vertical_data, table0, table1, command->transfer_data);
+			else
+				randomize_vertical_polygon_lines<T, false>(screen, view, vertical_data, table0, table1, command->transfer_data);
+			break;
+		
+		default:
+			fc_assert(false);
+			break;
+	}
+}
+
+static void draw_command(
+	struct sw_draw_command *command,
+	struct bitmap_definition *screen,
+	struct view_data *view,
+	short clip_top,
+	short clip_bottom)
+{
+	if (command->bottom<=clip_top || command->top>=clip_bottom) return;
+	
+	switch (bit_depth)
+	{
+		case 8: draw_command_lines<pixel8>(command, screen, view, clip_top, clip_bottom); break;
+		case 16: draw_command_lines<pixel16>(command, screen, view, clip_top, clip_bottom); break;
+		case 32: draw_command_lines<pixel32>(command, screen, view, clip_top, clip_bottom); break;
+		
+		default:
+			fc_assert(false);
+			break;
+	}
+}
+
+struct draw_bands_data
+{
+	struct bitmap_definition *screen;
+	struct view_data *view;
+	int band_count;
+};
+
+/* each band draws every recorded command in order, clipped to its own rows, so blending
+	and tinting see exactly what they would have single-threaded */
+static void draw_band(
+	int band,
+	void *arg)
+{
+	struct draw_bands_data *data= (struct draw_bands_data *) arg;
+	short clip_top= (short) ((int32) data->screen->height*band/data->band_count);
+	short clip_bottom= (short) ((int32) data->screen->height*(band+1)/data->band_count);
+	
+	for (size_t i= 0; i<recorded_commands.size(); ++i)
+	{
+		draw_command(&recorded_commands[i], data->screen, data->view, clip_top, clip_bottom);
+	}
+}
+
+static void draw_recorded_commands(
+	struct bitmap_definition *screen,
+	struct view_data *view)
+{
+	if (!recorded_commands.empty())
+	{
+		struct draw_bands_data data;
+		int threads= SW_Band_Workers::instance()->ThreadCount();
+		
+		data.screen= screen;
+		data.view= view;
+		data.band_count= MAX(1, MIN(threads*BANDS_PER_THREAD, screen->height/MINIMUM_BAND_HEIGHT));
+		SW_Band_Workers::instance()->Run(data.band_count, draw_band, &data);
+	}
+	
+	recorded_commands.clear();
+	command_block_index= command_block_used= 0;
+}
+
+/* ---------- span benchmark */
+
+#define BENCHMARK_SCREEN_WIDTH 640
+#define BENCHMARK_SCREEN_HEIGHT 480
+
+static uint32 benchmark_random(
+	uint32 &seed)
+{
+	seed= seed*1103515245 + 12345;
+	return seed>>8;
+}
+
+/* draws the same floors and walls, in every blending mode, once with the scalar mappers and
+	once with whatever span_kernels() picked; returns true if both drew the same pixels */
+bool benchmark_texture_spans(
+	int32 pixel_count,
+	uint32 *scalar_ticks,
+	uint32 *vector_ticks)
+{
+	const short width= BENCHMARK_SCREEN_WIDTH, height= BENCHMARK_SCREEN_HEIGHT;
+	uint32 seed= 6906; /* our own generator; the game's is part of the simulation */
+	
+	std::vector<pixel8> texture_pixels(VERTICAL_TEXTURE_WIDTH*VERTICAL_TEXTURE_WIDTH);
+	std::vector<byte> texture_storage(sizeof(struct bitmap_definition) + VERTICAL_TEXTURE_WIDTH*sizeof(pixel8 *));
+	struct bitmap_definition *texture= (struct bitmap_definition *) &texture_storage[0];
+	std::vector<byte> screen_storage(sizeof(struct bitmap_definition) + height*sizeof(pixel8 *));
+	struct bitmap_definition *screen= (struct bitmap_definition *) &screen_storage[0];
+	std::vector<pixel32> shading_table(MAXIMUM_SHADING_TABLE_INDEXES), pixels(width*height), scalar_pixels;
+	std::vector<uint8> opacity_table(MAXIMUM_SHADING_TABLE_INDEXES);
+	
+	for (size_t i= 0; i<texture_pixels.size(); ++i) texture_pixels[i]= (i%7) ? benchmark_random(seed) : 0;
+	for (size_t i= 0; i<shading_table.size(); ++i) shading_table[i]= benchmark_random(seed)*2654435761U;
+	for (size_t i= 0; i<opacity_table.size(); ++i) opacity_table[i]= benchmark_random(seed);
+	
+	texture->width= texture->height= texture->bytes_per_row= VERTICAL_TEXTURE_WIDTH;
+	texture->flags= _TRANSPARENT_BIT;
+	texture->bit_depth= 8;
+	for (short i= 0; i<VERTICAL_TEXTURE_WIDTH; ++i) texture->row_addresses[i]= &texture_pixels[i*VERTICAL_TEXTURE_WIDTH];
+	
+	screen->width= width, screen->height= height;
+	screen->bytes_per_row= width*sizeof(pixel32);
+	
+	/* one floor covering the screen */
+	std::vector<struct _horizontal_polygon_line_data> floor(height);
+	std::vector<short> floor_x0(height, 0), floor_x1(height, width);
+	for (short y= 0; y<height; ++y)
+	{
+		floor[y].source_x= benchmark_random(seed)<<8, floor[y].source_dx= benchmark_random(seed)<<2;
+		floor[y].source_y= benchmark_random(seed)<<8, floor[y].source_dy= benchmark_random(seed)<<2;
+		floor[y].shading_table= &shading_table[0];
+	}
+	
+	/* one wall covering the screen, with uneven tops and bottoms */
+	std::vector<byte> wall_storage(sizeof(struct _vertical_polygon_data) + width*sizeof(struct _vertical_polygon_line_data));
+	struct _vertical_polygon_data *wall= (struct _vertical_polygon_data *) &wall_storage[0];
+	struct _vertical_polygon_line_data *wall_lines= (struct _vertical_polygon_line_data *) (wall+1);
+	std::vector<short> wall_y0(width), wall_y1(width);
+	wall->downshift= VERTICAL_TEXTURE_DOWNSHIFT;
+	wall->x0= 0;
+	wall->width= width;
+	for (short x= 0; x<width; ++x)
+	{
+		wall_y0[x]= benchmark_random(seed)%(height/8);
+		wall_y1[x]= height - benchmark_random(seed)%(height/8);
+		wall_lines[x].shading_table= &shading_table[0];
+		wall_lines[x].texture= texture->row_addresses[x&(VERTICAL_TEXTURE_WIDTH-1)];
+		wall_lines[x].texture_y= benchmark_random(seed)<<8;
+		wall_lines[x].texture_dy= (benchmark_random(seed)<<4)|1;
+	}
+	
+	/* nice blending reads the pixel format off the screen */
+	bool blend_nicely= world_pixels!=NULL;
+	int passes= MAX(1, pixel_count/(width*height*(blend_nicely ? 6 : 4)));
+	int vector_kernels= span_kernels();
+	
+	for (int run= 0; run<2; ++run)
+	{
+		for (short y= 0; y<height; ++y) screen->row_addresses[y]= (pixel8 *) &pixels[y*width];
+		for (size_t i= 0; i<pixels.size(); ++i) pixels[i]= i*0x9e3779b9U;
+		
+		span_kernels()= run ? vector_kernels : _scalar_span_kernels;
+		uint32 start= machine_tick_count();
+		for (int pass= 0; pass<passes; ++pass)
+		{
+			texture_horizontal_polygon_lines<pixel32, _sw_alpha_off>(texture, screen, NULL, &floor[0], 0, &floor_x0[0], &floor_x1[0], height, 0, height);
+			texture_horizontal_polygon_lines<pixel32, _sw_alpha_fast>(texture, screen, NULL, &floor[0], 0, &floor_x0[0], &floor_x1[0], height, 0, height);
+			texture_vertical_polygon_lines<pixel32, _sw_alpha_off, false>(screen, NULL, wall, &wall_y0[0], &wall_y1[0], 0, height);
+			texture_vertical_polygon_lines<pixel32, _sw_alpha_fast, true>(screen, NULL, wall, &wall_y0[0], &wall_y1[0], 0, height);
+			if (blend_nicely)
+			{
+				texture_horizontal_polygon_lines<pixel32, _sw_alpha_nice>(texture, screen, NULL, &floor[0], 0, &floor_x0[0], &floor_x1[0], height, 0, height, &opacity_table[0]);
+				texture_vertical_polygon_lines<pixel32, _sw_alpha_nice, true>(screen, NULL, wall, &wall_y0[0], &wall_y1[0], 0, height, &opacity_table[0]);
 			}
 		}
+		*(run ? vector_ticks : scalar_ticks)= machine_tick_count() - start;
+		
+		if (!run) scalar_pixels= pixels;
 	}
+	span_kernels()= vector_kernels;
+	
+	return scalar_pixels==pixels;
 }
 
 /* ---------- private code */
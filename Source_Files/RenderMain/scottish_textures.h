@@ -216,4 +216,7 @@ extern short number_of_shading_tables, shading_table_fractional_bits, shading_ta
 
 void allocate_texture_tables(void);
 
+// compares the scalar and vector 32-bit span mappers; true if they drew the same pixels
+bool benchmark_texture_spans(int32 pixel_count, uint32 *scalar_ticks, uint32 *vector_ticks);
+
 #endif
@@ -73,6 +73,13 @@ Sept 2, 2000 (Loren Petrich):
 
 Jan 17, 2001 (Loren Petrich):
 	Added support for offsets for OpenGL-rendered substitute textures
+
+Oct 17, 2026:
+	load_collection() reads each collection with one read and parses it from memory;
+	bitmaps that need no conversion are used where they are in that buffer.
+	Added benchmark_collection_loading() to compare against reading field by field.
+	Added prefetch_collection(), so the level prefetcher can read collections on its own
+	thread before load_collections() wants them.
 */
 
 /*
@@ -104,6 +111,7 @@ Jan 17, 2001 (Loren Petrich):
 // LP addition: OpenGL support
 #include "OGL_Render.h"
 #include "OGL_LoadScreen.h"
+#include "ImageLoader.h"
 
 // LP addition: infravision XML setup needs colors
 #include "InfoTree.h"
@@ -111,6 +119,7 @@ Jan 17, 2001 (Loren Petrich):
 #include "Packing.h"
 #include "SW_Texture_Extras.h"
 
+#include <SDL_mutex.h>
 #include <SDL_rwops.h>
 #include <memory>
 
@@ -172,6 +181,7 @@ short number_of_shading_tables, shading_table_fractional_bits, shading_table_siz
 // LP addition: opened-shapes-file object
 static OpenedFile ShapesFile;
 static OpenedResourceFile M1ShapesFile;
+static FileSpecifier ShapesFileSpec;
 
 static enum {
 	M1_SHAPES_VERSION = 1,
@@ -484,7 +494,7 @@ static void load_collection_definition(collection_definition* cd, SDL_RWops *p)
 	cd->high_level_shapes.resize(cd->high_level_shape_count);
 	cd->low_level_shapes.resize(cd->low_level_shape_count);
 	cd->bitmaps.resize(cd->bitmap_count);
-
+	cd->bitmap_origins.resize(cd->bitmap_count);
 }
 
 static void load_clut(rgb_color_value *r, int count, SDL_RWops *p)
@@ -637,7 +647,10 @@ static void convert_m1_rle(std::vector<uint8>& bitmap, int scanlines, int scanli
 	}
 }
 
-static void load_bitmap(std::vector<uint8>& bitmap, SDL_RWops *p, int version)
+// if data holds everything p reads from (offset 0 being data[0]), pixels that need no
+// conversion are left there; the return value is then where they start, and only the
+// definition and row address table are stored in bitmap
+static pixel8 *load_bitmap(std::vector<uint8>& bitmap, SDL_RWops *p, int version, std::vector<uint8> *data = NULL)
 {
 	bitmap_definition b;
 
@@ -657,18 +670,13 @@ static void load_bitmap(std::vector<uint8>& bitmap, SDL_RWops *p, int version)
 	// Skip row address pointers
 	SDL_RWseek(p, (rows + 1) * sizeof(uint32), SEEK_CUR);
 
+	int32 pixels_offset = SDL_RWtell(p);
+	int32 size = 0;
 	if (b.bytes_per_row == NONE) 
 	{
-		if (version == M1_SHAPES_VERSION)
-		{
-			// make enough room for the definition, then append as we convert RLE
-			bitmap.resize(sizeof(bitmap_definition) + rows * sizeof(pixel8*));
-		}
-		else
+		if (version != M1_SHAPES_VERSION)
 		{
 			// ugly--figure out how big it's going to be
-			
-			int32 size = 0;
 			for (int j = 0; j < rows; j++) {
 				int16 first = SDL_ReadBE16(p);
 				int16 last = SDL_ReadBE16(p);
@@ -676,18 +684,30 @@ static void load_bitmap(std::vector<uint8>& bitmap, SDL_RWops *p, int version)
 				SDL_RWseek(p, last - first, SEEK_CUR);
 				size += last - first;
 			}
-			
-			bitmap.resize(sizeof(bitmap_definition) + rows * sizeof(pixel8*) + size);
-			
-			// Now, seek back
-			SDL_RWseek(p, -size, SEEK_CUR);
 		}
 	} 
 	else
 	{
-		bitmap.resize(sizeof(bitmap_definition) + rows * sizeof(pixel8*) + rows * b.bytes_per_row);
+		size = rows * b.bytes_per_row;
 	}
 
+	// M1 RLE gets converted, so it can't stay where it is
+	bool in_place = data && version != M1_SHAPES_VERSION && pixels_offset >= 0 && pixels_offset + size <= static_cast<int32>(data->size());
+
+	if (in_place)
+	{
+		bitmap.resize(sizeof(bitmap_definition) + rows * sizeof(pixel8*));
+	}
+	else
+	{
+		// for M1 RLE, make enough room for the definition, then append as we convert
+		bitmap.resize(sizeof(bitmap_definition) + rows * sizeof(pixel8*) + size);
+		if (b.bytes_per_row == NONE && version != M1_SHAPES_VERSION)
+		{
+			// Now, seek back
+			SDL_RWseek(p, -size, SEEK_CUR);
+		}
+	}
 
 	uint8* c = &bitmap[0];
 	bitmap_definition *d = (bitmap_definition *) &bitmap[0];
@@ -702,6 +722,13 @@ static void load_bitmap(std::vector<uint8>& bitmap, SDL_RWops *p, int version)
 	// Skip row address pointers
 	c += rows * sizeof(pixel8 *);
 
+	if (in_place)
+	{
+		if (b.bytes_per_row != NONE)
+			SDL_RWseek(p, size, SEEK_CUR);
+		return &(*data)[0] + pixels_offset;
+	}
+
 	// Copy bitmap data
 	if (d->bytes_per_row == NONE) 
 	{
@@ -729,6 +756,7 @@ static void load_bitmap(std::vector<uint8>& bitmap, SDL_RWops *p, int version)
 		c += rows * d->bytes_per_row;
 	}
 
+	return NULL;
 }
 
 static void allocate_shading_tables(short collection_index, bool strip)
@@ -747,51 +775,138 @@ static void allocate_shading_tables(short collection_index, bool strip)
  *  Load collection
  */
 
-static bool load_collection(short collection_index, bool strip)
+// where a collection is in the Shapes file at the given bit depth
+static bool get_collection_range(collection_header *header, short depth, int32& offset, int32& length)
 {
-	SDL_RWops* p;
-	boost::shared_ptr<SDL_RWops> m1_p; // automatic deallocation
-	LoadedResource r;
-	int32 src_offset;
-
-	collection_header *header = get_collection_header(collection_index);
-	
-	if (shapes_file_version == M1_SHAPES_VERSION)
-	{
-		// Collections are stored in .256 resources
-		if (!M1ShapesFile.Get('.', '2', '5', '6', 128 + collection_index, r))
+	if (depth == 8 || header->offset16 == -1) {
+		if (header->offset == -1)
 		{
 			return false;
 		}
+		offset = header->offset;
+		length = header->length;
+	} else {
+		offset = header->offset16;
+		length = header->length16;
+	}
+
+	return length > 0;
+}
 
-		m1_p.reset(SDL_RWFromConstMem(r.GetPointer(), r.GetLength()), SDL_FreeRW);
-		p = m1_p.get();
-		src_offset = 0;
+// reads all of a collection with one read, instead of seeking around the file for every field
+static bool read_collection_data(collection_header *header, short depth, std::vector<uint8>& data)
+{
+	int32 offset, length;
+	if (!get_collection_range(header, depth, offset, length))
+	{
+		return false;
 	}
-	else
+
+	data.resize(length);
+	return ShapesFile.SetPosition(offset) && ShapesFile.Read(length, &data[0]);
+}
+
+// collections prefetch_collection() has read, waiting for load_collection(); only the bytes
+// are staged, so nothing about them depends on the state of the game
+struct prefetched_collection
+{
+	short depth;
+	std::vector<uint8> data;
+
+	prefetched_collection() : depth(0) {}
+};
+
+static prefetched_collection prefetched_collections[MAXIMUM_COLLECTIONS];
+static uint32 shapes_file_generation;	// bumped whenever open_shapes_file() runs
+
+static SDL_mutex *prefetch_mutex()
+{
+	static SDL_mutex *mutex = SDL_CreateMutex();
+	return mutex;
+}
+
+bool prefetch_collection(short collection_index, short depth)
+{
+	if (collection_index < 0 || collection_index >= MAXIMUM_COLLECTIONS)
 	{
-		// Get offset and length of data in source file from header
-		
-		if (bit_depth == 8 || header->offset16 == -1) {
-			if (header->offset == -1)
-			{
-				return false;
-			}
-			src_offset = header->offset;
-		} else {
-			src_offset = header->offset16;
-		}
+		return false;
+	}
+
+	SDL_LockMutex(prefetch_mutex());
+	bool staged = prefetched_collections[collection_index].depth == depth;
+	bool m1 = shapes_file_version == M1_SHAPES_VERSION;
+	FileSpecifier File = ShapesFileSpec;
+	uint32 generation = shapes_file_generation;
+	int32 offset, length;
+	bool found = get_collection_range(get_collection_header(collection_index), depth, offset, length);
+	SDL_UnlockMutex(prefetch_mutex());
 
-		p = ShapesFile.GetRWops();
-		ShapesFile.SetPosition(0);
-		src_offset += SDL_RWtell(p);
+	if (staged)
+	{
+		return true;
 	}
 
+	// the resource fork has no thread-safe way in; M1 shapes are small anyway
+	if (m1 || !found)
+	{
+		return false;
+	}
+
+	// a file of our own, so that the main thread's position in ShapesFile doesn't move
+	std::vector<uint8> data(length);
+	OpenedFile OFile;
+	if (!File.Open(OFile, false, false) || !OFile.SetPosition(offset) || !OFile.Read(length, &data[0]))
+	{
+		return false;
+	}
+	OFile.Close();
+
+	SDL_LockMutex(prefetch_mutex());
+	bool current = generation == shapes_file_generation;
+	if (current)
+	{
+		prefetched_collections[collection_index].depth = depth;
+		prefetched_collections[collection_index].data.swap(data);
+	}
+	SDL_UnlockMutex(prefetch_mutex());
+
+	return current;
+}
+
+// hands over what prefetch_collection() read for this collection, if anything
+static bool take_prefetched_collection(short collection_index, short depth, std::vector<uint8>& data)
+{
+	SDL_LockMutex(prefetch_mutex());
+	prefetched_collection& staged = prefetched_collections[collection_index];
+	bool taken = staged.depth == depth;
+	if (taken)
+	{
+		data.swap(staged.data);
+	}
+	staged.depth = 0;
+	std::vector<uint8>().swap(staged.data);
+	SDL_UnlockMutex(prefetch_mutex());
+
+	return taken;
+}
+
+void discard_prefetched_collections()
+{
+	SDL_LockMutex(prefetch_mutex());
+	for (int i = 0; i < MAXIMUM_COLLECTIONS; ++i)
+	{
+		prefetched_collections[i].depth = 0;
+		std::vector<uint8>().swap(prefetched_collections[i].data);
+	}
+	SDL_UnlockMutex(prefetch_mutex());
+}
+
+// parses the collection that starts at src_offset in p; see load_bitmap() for data
+static void load_collection_contents(collection_definition *cd, SDL_RWops *p, int32 src_offset, int version, std::vector<uint8> *data)
+{
 	// Read collection definition
-	std::unique_ptr<collection_definition> cd(new collection_definition);
 	SDL_RWseek(p, src_offset, RW_SEEK_SET);
-	load_collection_definition(cd.get(), p);
-	header->status &= ~markPATCHED;
+	load_collection_definition(cd, p);
 
 	// Convert CLUTS
 	if (cd->clut_count && cd->color_count) {
@@ -834,9 +949,41 @@ static bool load_collection(short collection_index, bool strip)
 
 		for (int i = 0; i < cd->bitmap_count; i++) {
 			SDL_RWseek(p, src_offset + t[i], RW_SEEK_SET);
-			load_bitmap(cd->bitmaps[i], p, shapes_file_version);
+			cd->bitmap_origins[i] = load_bitmap(cd->bitmaps[i], p, version, data);
 		}
 	}
+}
+
+static bool load_collection(short collection_index, bool strip)
+{
+	collection_header *header = get_collection_header(collection_index);
+	std::unique_ptr<collection_definition> cd(new collection_definition);
+	
+	if (shapes_file_version == M1_SHAPES_VERSION)
+	{
+		// Collections are stored in .256 resources
+		LoadedResource r;
+		if (!M1ShapesFile.Get('.', '2', '5', '6', 128 + collection_index, r))
+		{
+			return false;
+		}
+
+		boost::shared_ptr<SDL_RWops> p(SDL_RWFromConstMem(r.GetPointer(), r.GetLength()), SDL_FreeRW);
+		load_collection_contents(cd.get(), p.get(), 0, shapes_file_version, NULL);
+	}
+	else
+	{
+		// the collection keeps its bytes; unconverted bitmaps point into them
+		if (!take_prefetched_collection(collection_index, bit_depth, cd->data) &&
+			!read_collection_data(header, bit_depth, cd->data))
+		{
+			return false;
+		}
+
+		boost::shared_ptr<SDL_RWops> p(SDL_RWFromMem(&cd->data[0], cd->data.size()), SDL_FreeRW);
+		load_collection_contents(cd.get(), p.get(), 0, shapes_file_version, &cd->data);
+	}
+	header->status &= ~markPATCHED;
 
 	header->collection = cd.release();
 	
@@ -859,6 +1006,102 @@ static bool load_collection(short collection_index, bool strip)
 }	
 			
 
+static bool same_collection_contents(collection_definition *streamed, collection_definition *bulk)
+{
+	if (!streamed || !bulk)
+	{
+		return streamed == bulk;
+	}
+
+	if (streamed->color_tables.size() != bulk->color_tables.size() ||
+	    (streamed->color_tables.size() && memcmp(&streamed->color_tables[0], &bulk->color_tables[0], streamed->color_tables.size() * sizeof(rgb_color_value))) ||
+	    streamed->high_level_shapes != bulk->high_level_shapes ||
+	    streamed->low_level_shapes.size() != bulk->low_level_shapes.size() ||
+	    (streamed->low_level_shapes.size() && memcmp(&streamed->low_level_shapes[0], &bulk->low_level_shapes[0], streamed->low_level_shapes.size() * sizeof(low_level_shape_definition))) ||
+	    streamed->bitmaps.size() != bulk->bitmaps.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < streamed->bitmaps.size(); ++i)
+	{
+		std::vector<uint8>& s = streamed->bitmaps[i];
+		std::vector<uint8>& b = bulk->bitmaps[i];
+		size_t header_size = calculate_bitmap_origin((bitmap_definition *) &s[0]) - &s[0];
+		pixel8 *pixels = bulk->bitmap_origins[i] ? bulk->bitmap_origins[i] : &b[0] + header_size;
+
+		if (b.size() != (bulk->bitmap_origins[i] ? header_size : s.size()) ||
+		    memcmp(&s[0], &b[0], header_size) ||
+		    memcmp(&s[0] + header_size, pixels, s.size() - header_size))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool benchmark_collection_loading(uint32 streamed_ticks[3], uint32 bulk_ticks[3])
+{
+	static const short depths[3] = { 8, 16, 32 };
+	bool identical = true;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		streamed_ticks[i] = bulk_ticks[i] = 0;
+		if (shapes_file_version != M2_SHAPES_VERSION || !ShapesFile.IsOpen())
+		{
+			continue;
+		}
+
+		std::vector<std::unique_ptr<collection_definition> > streamed(MAXIMUM_COLLECTIONS);
+		std::vector<std::unique_ptr<collection_definition> > bulk(MAXIMUM_COLLECTIONS);
+
+		// the way load_collection() used to do it: every field is a read from the file
+		uint32 start_ticks = machine_tick_count();
+		for (int collection_index = 0; collection_index < MAXIMUM_COLLECTIONS; ++collection_index)
+		{
+			int32 offset, length;
+			if (!get_collection_range(get_collection_header(collection_index), depths[i], offset, length))
+			{
+				continue;
+			}
+
+			streamed[collection_index].reset(new collection_definition);
+			SDL_RWops *p = ShapesFile.GetRWops();
+			ShapesFile.SetPosition(0);
+			load_collection_contents(streamed[collection_index].get(), p, offset + SDL_RWtell(p), shapes_file_version, NULL);
+		}
+		streamed_ticks[i] = machine_tick_count() - start_ticks;
+
+		start_ticks = machine_tick_count();
+		for (int collection_index = 0; collection_index < MAXIMUM_COLLECTIONS; ++collection_index)
+		{
+			std::unique_ptr<collection_definition> cd(new collection_definition);
+			if (!read_collection_data(get_collection_header(collection_index), depths[i], cd->data))
+			{
+				continue;
+			}
+
+			SDL_RWops *p = SDL_RWFromMem(&cd->data[0], cd->data.size());
+			load_collection_contents(cd.get(), p, 0, shapes_file_version, &cd->data);
+			SDL_RWclose(p);
+			bulk[collection_index].swap(cd);
+		}
+		bulk_ticks[i] = machine_tick_count() - start_ticks;
+
+		for (int collection_index = 0; collection_index < MAXIMUM_COLLECTIONS; ++collection_index)
+		{
+			if (!same_collection_contents(streamed[collection_index].get(), bulk[collection_index].get()))
+			{
+				identical = false;
+			}
+		}
+	}
+
+	return identical;
+}
+
 /*
  *  Unload collection
  */
@@ -982,6 +1225,7 @@ void load_shapes_patch(SDL_RWops *p, bool override_replacements)
 					if (cd && patch_bit_depth == 8 && bitmap_index < cd->bitmaps.size())
 					{
 						load_bitmap(cd->bitmaps[bitmap_index], p, M2_SHAPES_VERSION);
+						cd->bitmap_origins[bitmap_index] = NULL;
 						if (override_replacements)
 						{
 							get_bitmap_definition(collection_index, bitmap_index)->flags |= _PATCHED_BIT;
@@ -1041,6 +1285,16 @@ void initialize_shape_handler()
 
 void open_shapes_file(FileSpecifier& File)
 {
+	// the headers are about to change under prefetch_collection()
+	SDL_LockMutex(prefetch_mutex());
+	++shapes_file_generation;
+	ShapesFileSpec = File;
+	for (int i = 0; i < MAXIMUM_COLLECTIONS; ++i)
+	{
+		prefetched_collections[i].depth = 0;
+		std::vector<uint8>().swap(prefetched_collections[i].data);
+	}
+
 	bool m1_loaded = false;
 	if (File.Open(M1ShapesFile) && M1ShapesFile.Check('.','2','5','6',128))
 	{
@@ -1063,6 +1317,7 @@ void open_shapes_file(FileSpecifier& File)
 		{
 			ShapesFile.Close();
 			delete []CollHdrStream;
+			SDL_UnlockMutex(prefetch_mutex());
 			return;
 		}
 		
@@ -1092,6 +1347,7 @@ void open_shapes_file(FileSpecifier& File)
 		delete []CollHdrStream;
 		
 	}
+	SDL_UnlockMutex(prefetch_mutex());
 	set_shapes_images_file(File);
 }
 
@@ -1460,6 +1716,9 @@ void load_collections(
 		(finally) update the screen to reflect our changes */
 	update_color_environment(is_opengl);
 
+	// whatever was prefetched and not loaded is for a level we didn't go to
+	discard_prefetched_collections();
+
 	// load software enhancements
 	if (!is_opengl) {
 		for (collection_index= 0, header= collection_headers; collection_index < MAXIMUM_COLLECTIONS; ++collection_index, ++header)
@@ -1504,6 +1763,8 @@ void load_replacement_collections()
 			OGL_LoadModelsImages(collection_index);
 		}
 	}
+
+	ImageLoader_DiscardPrefetched();
 }
 
 #endif
@@ -1642,10 +1903,11 @@ static void update_color_environment(
 			for (bitmap_index= 0; bitmap_index<collection->bitmap_count; ++bitmap_index)
 			{
 				struct bitmap_definition *bitmap= get_bitmap_definition(collection_index, bitmap_index);
+				pixel8 *origin= collection->bitmap_origins[bitmap_index];
 				assert(bitmap);
 				
 				/* calculate row base addresses ... */
-				bitmap->row_addresses[0]= calculate_bitmap_origin(bitmap);
+				bitmap->row_addresses[0]= origin ? origin : calculate_bitmap_origin(bitmap);
 				precalculate_bitmap_row_addresses(bitmap);
 
 				/* ... and remap it */
@@ -80,6 +80,9 @@ Jun 23, 2001 (Loren Petrich):
 
 Jan 25, 2002 (Br'fin (Jeremy Parsons)):
 	Added accessors for datafields now opaque in Carbon
+
+Oct 17, 2026:
+	Opening a terminal that can teleport to another level starts prefetching that level
 */
 
 // add logon/logoff keywords. (& make terminal display them)
@@ -123,6 +126,7 @@ Jan 25, 2002 (Br'fin (Jeremy Parsons)):
 #include "lua_script.h"
 
 #include "Logging.h"
+#include "LevelPrefetcher.h"
 
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/iostreams/device/array.hpp>
@@ -546,6 +550,13 @@ void enter_computer_interface(
 	terminal->terminal_id= text_number;
 	terminal->last_action_flag= -1l; /* Eat the first key */
 
+	/* If this terminal can take us to another level, start reading it now */
+	unsigned teleport_group= find_group_type(terminal_text, _interlevel_teleport_group);
+	if (teleport_group<terminal_text->groupings.size())
+	{
+		LevelPrefetcher::instance()->Prefetch(get_indexed_grouping(terminal_text, teleport_group)->permutation);
+	}
+
 	/* And select the first one. */
 	next_terminal_group(player_index, terminal_text);
 }
@@ -68,9 +68,20 @@
 #include "lua_hud_script.h"
 #include "HUDRenderer_Lua.h"
 #include "Movie.h"
+#include "SW_Band_Workers.h"
 
 #include <algorithm>
 
+#include <SDL_cpuinfo.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCREEN_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SCREEN_NEON
+#endif
+
 #if defined(__WIN32__) || (defined(__MACH__) && defined(__APPLE__))
 #define MUST_RELOAD_VIEW_CONTEXT
 #endif
@@ -135,6 +146,7 @@ static void build_sdl_color_table(const color_table *color_table, SDL_Color *col
 static void reallocate_world_pixels(int width, int height);
 static void reallocate_map_pixels(int width, int height);
 static void apply_gamma(SDL_Surface *src, SDL_Surface *dst);
+static bool vector_blits_available();
 static void update_screen(SDL_Rect &source, SDL_Rect &destination, bool hi_rez);
 static void update_fps_display(SDL_Surface *s);
 static void DisplayPosition(SDL_Surface *s);
@@ -143,6 +155,9 @@ static void DisplayNetMicStatus(SDL_Surface *s);
 static void DrawSurface(SDL_Surface *s, SDL_Rect &dest_rect, SDL_Rect &src_rect);
 static void clear_screen_margin();
 
+// pixel doubling uses SSE2/NEON where the processor has them
+static bool use_vector_blits = vector_blits_available();
+
 SDL_PixelFormat pixel_format_16, pixel_format_32;
 
 // LP addition:
@@ -1552,7 +1567,8 @@ static inline void quadruple_surface(const T *src, int src_pitch, T *dst, int ds
 	}
 }
 
-static void apply_gamma(SDL_Surface *src, SDL_Surface *dst)
+// the original one-pixel-at-a-time gamma correction, for benchmark_screen_blits()
+static void apply_gamma_per_pixel(SDL_Surface *src, SDL_Surface *dst)
 {
 	if (SDL_MUSTLOCK(dst)) {
 	    if (SDL_LockSurface(dst) < 0) return;
@@ -1618,10 +1634,391 @@ static inline bool pixel_formats_equal(SDL_PixelFormat* a, SDL_PixelFormat* b)
 		a->Bmask == b->Bmask);
 }
 
+// writes every source pixel twice
+static inline void double_pixels(const pixel8 *src, pixel8 *dst, int count)
+{
+	int i = 0;
+#if defined(SCREEN_SSE2)
+	if (use_vector_blits)
+	{
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), _mm_unpacklo_epi8(p, p));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2 + 16), _mm_unpackhi_epi8(p, p));
+		}
+	}
+#elif defined(SCREEN_NEON)
+	if (use_vector_blits)
+	{
+		for (; i + 16 <= count; i += 16)
+		{
+			uint8x16x2_t p;
+			p.val[0] = p.val[1] = vld1q_u8(src + i);
+			vst2q_u8(dst + i * 2, p);
+		}
+	}
+#endif
+	for (; i < count; ++i)
+		dst[i * 2] = dst[i * 2 + 1] = src[i];
+}
+
+static inline void double_pixels(const pixel16 *src, pixel16 *dst, int count)
+{
+	int i = 0;
+#if defined(SCREEN_SSE2)
+	if (use_vector_blits)
+	{
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), _mm_unpacklo_epi16(p, p));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2 + 8), _mm_unpackhi_epi16(p, p));
+		}
+	}
+#elif defined(SCREEN_NEON)
+	if (use_vector_blits)
+	{
+		for (; i + 8 <= count; i += 8)
+		{
+			uint16x8x2_t p;
+			p.val[0] = p.val[1] = vld1q_u16(src + i);
+			vst2q_u16(dst + i * 2, p);
+		}
+	}
+#endif
+	for (; i < count; ++i)
+		dst[i * 2] = dst[i * 2 + 1] = src[i];
+}
+
+static inline void double_pixels(const pixel32 *src, pixel32 *dst, int count)
+{
+	int i = 0;
+#if defined(SCREEN_SSE2)
+	if (use_vector_blits)
+	{
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), _mm_unpacklo_epi32(p, p));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2 + 4), _mm_unpackhi_epi32(p, p));
+		}
+	}
+#elif defined(SCREEN_NEON)
+	if (use_vector_blits)
+	{
+		for (; i + 4 <= count; i += 4)
+		{
+			uint32x4x2_t p;
+			p.val[0] = p.val[1] = vld1q_u32(src + i);
+			vst2q_u32(dst + i * 2, p);
+		}
+	}
+#endif
+	for (; i < count; ++i)
+		dst[i * 2] = dst[i * 2 + 1] = src[i];
+}
+
+// gamma correction (or just format conversion) as three lookups: each channel of the
+// source pixel indexes its share of the destination pixel
+struct blit_tables
+{
+	uint32 r[256], g[256], b[256];
+	uint32 rmask, gmask, bmask;
+	uint8 rshift, gshift, bshift;
+};
+
+static void build_blit_channel(uint32 *table, uint32 src_mask, uint8 src_shift, uint8 src_loss,
+	uint32 dst_mask, uint8 dst_shift, uint8 dst_loss, const uint16 *gamma)
+{
+	uint32 count = (src_mask >> src_shift) + 1;
+	for (uint32 v = 0; v < count && v < 256; ++v)
+	{
+		uint8 value = static_cast<uint8>(v << src_loss);
+		if (gamma)
+			value = gamma[value] >> 8;	// as apply_gamma_per_pixel() reads it
+		else if (src_loss && src_loss <= 4)
+			value |= v >> (8 - 2 * src_loss);	// as SDL widens it
+		table[v] = ((static_cast<uint32>(value) >> dst_loss) << dst_shift) & dst_mask;
+	}
+}
+
+static void build_blit_tables(blit_tables &t, const SDL_PixelFormat *src, const SDL_PixelFormat *dst, bool gamma)
+{
+	build_blit_channel(t.r, src->Rmask, src->Rshift, src->Rloss, dst->Rmask, dst->Rshift, dst->Rloss, gamma ? current_gamma_r : NULL);
+	build_blit_channel(t.g, src->Gmask, src->Gshift, src->Gloss, dst->Gmask, dst->Gshift, dst->Gloss, gamma ? current_gamma_g : NULL);
+	build_blit_channel(t.b, src->Bmask, src->Bshift, src->Bloss, dst->Bmask, dst->Bshift, dst->Bloss, gamma ? current_gamma_b : NULL);
+	t.rmask = src->Rmask;
+	t.gmask = src->Gmask;
+	t.bmask = src->Bmask;
+	t.rshift = src->Rshift;
+	t.gshift = src->Gshift;
+	t.bshift = src->Bshift;
+}
+
+struct blit_job
+{
+	const blit_tables *tables;	// NULL to copy pixels as they are
+	const uint8 *src;
+	int src_pitch;
+	uint8 *dst;
+	int dst_pitch;
+	int width, height;		// in source pixels
+	bool doubled;
+	int src_bpp, dst_bpp;
+};
+
+// source rows per band handed to SW_Band_Workers
+static const int kBlitBandRows = 16;
+// pixels converted at a time before doubling
+static const int kBlitChunk = 256;
+
+template <class S, class D>
+static void blit_rows(const blit_job &job, int first_row, int last_row)
+{
+	const blit_tables *t = job.tables;
+	D converted[kBlitChunk];
+
+	for (int y = first_row; y < last_row; ++y)
+	{
+		const S *src = reinterpret_cast<const S *>(job.src + y * job.src_pitch);
+		D *dst = reinterpret_cast<D *>(job.dst + (job.doubled ? 2 * y : y) * job.dst_pitch);
+
+		for (int x = 0; x < job.width; x += kBlitChunk)
+		{
+			int count = MIN(kBlitChunk, job.width - x);
+			const D *pixels = reinterpret_cast<const D *>(src + x);
+			if (t)
+			{
+				D *out = job.doubled ? converted : dst + x;
+				for (int i = 0; i < count; ++i)
+				{
+					uint32 p = src[x + i];
+					out[i] = static_cast<D>(t->r[(p & t->rmask) >> t->rshift] | t->g[(p & t->gmask) >> t->gshift] | t->b[(p & t->bmask) >> t->bshift]);
+				}
+				pixels = converted;
+			}
+			if (job.doubled)
+				double_pixels(pixels, dst + x * 2, count);
+		}
+
+		if (job.doubled)
+			memcpy(reinterpret_cast<uint8 *>(dst) + job.dst_pitch, dst, job.width * 2 * sizeof(D));
+	}
+}
+
+static void blit_band(int band, void *arg)
+{
+	const blit_job &job = *reinterpret_cast<const blit_job *>(arg);
+	int first_row = band * kBlitBandRows;
+	int last_row = MIN(first_row + kBlitBandRows, job.height);
+
+	switch (job.src_bpp * 8 + job.dst_bpp)
+	{
+	case 1 * 8 + 1:
+		blit_rows<pixel8, pixel8>(job, first_row, last_row);
+		break;
+	case 2 * 8 + 2:
+		blit_rows<pixel16, pixel16>(job, first_row, last_row);
+		break;
+	case 2 * 8 + 4:
+		blit_rows<pixel16, pixel32>(job, first_row, last_row);
+		break;
+	case 4 * 8 + 2:
+		blit_rows<pixel32, pixel16>(job, first_row, last_row);
+		break;
+	case 4 * 8 + 4:
+		blit_rows<pixel32, pixel32>(job, first_row, last_row);
+		break;
+	}
+}
+
+// copies src into dst at dst_rect's corner, gamma-corrected and converted to dst's format
+// on the way and doubled in both directions if asked, in one pass spread over the
+// software renderer's threads; false if it can't (and nothing was drawn). The caller
+// locks dst
+static bool blit_world(SDL_Surface *src, SDL_Surface *dst, const SDL_Rect &dst_rect, bool doubled, bool gamma)
+{
+	blit_job job;
+	job.width = doubled ? dst_rect.w / 2 : src->w;
+	job.height = doubled ? dst_rect.h / 2 : src->h;
+	job.src_bpp = src->format->BytesPerPixel;
+	job.dst_bpp = dst->format->BytesPerPixel;
+	int scale = doubled ? 2 : 1;
+
+	if (job.width <= 0 || job.height <= 0 || job.width > src->w || job.height > src->h ||
+		dst_rect.x < 0 || dst_rect.y < 0 || dst_rect.x + job.width * scale > dst->w || dst_rect.y + job.height * scale > dst->h)
+		return false;
+
+	bool same_format = pixel_formats_equal(src->format, dst->format);
+	blit_tables tables;
+	if (gamma || !same_format)
+	{
+		if ((job.src_bpp != 2 && job.src_bpp != 4) || (job.dst_bpp != 2 && job.dst_bpp != 4))
+			return false;
+		build_blit_tables(tables, src->format, dst->format, gamma);
+		job.tables = &tables;
+	}
+	else if (doubled && (job.src_bpp == 1 || job.src_bpp == 2 || job.src_bpp == 4))
+		job.tables = NULL;
+	else
+		return false;
+
+	job.src = static_cast<const uint8 *>(src->pixels);
+	job.src_pitch = src->pitch;
+	job.dst = static_cast<uint8 *>(dst->pixels) + dst_rect.y * dst->pitch + dst_rect.x * job.dst_bpp;
+	job.dst_pitch = dst->pitch;
+	job.doubled = doubled;
+
+	SW_Band_Workers::instance()->Run((job.height + kBlitBandRows - 1) / kBlitBandRows, blit_band, &job);
+	return true;
+}
+
+static bool vector_blits_available()
+{
+#if defined(SCREEN_SSE2)
+	return SDL_HasSSE2();
+#elif defined(SCREEN_NEON)
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+	return SDL_HasNEON();
+#else
+	return true;
+#endif
+#else
+	return false;
+#endif
+}
+
+static void apply_gamma(SDL_Surface *src, SDL_Surface *dst)
+{
+	if (SDL_MUSTLOCK(dst)) {
+	    if (SDL_LockSurface(dst) < 0) return;
+	}
+	SDL_Rect origin = { 0, 0, dst->w, dst->h };
+	if (!blit_world(src, dst, origin, false, true))
+		apply_gamma_per_pixel(src, dst);
+	if (SDL_MUSTLOCK(dst))
+		SDL_UnlockSurface(dst);
+}
+
+bool benchmark_screen_blits(int frames, uint32 *scalar_ticks, uint32 *vector_ticks)
+{
+	*scalar_ticks = *vector_ticks = 0;
+	if (!world_pixels || !main_surface || world_pixels->format->BytesPerPixel < 2)
+		return false;
+
+	SDL_PixelFormat *f = main_surface->format;
+	int w = world_pixels->w, h = world_pixels->h;
+	SDL_Surface *corrected = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, world_pixels->format->BitsPerPixel, world_pixels->format->Rmask, world_pixels->format->Gmask, world_pixels->format->Bmask, 0);
+	SDL_Surface *scalar_output = SDL_CreateRGBSurface(SDL_SWSURFACE, w * 2, h * 2, f->BitsPerPixel, f->Rmask, f->Gmask, f->Bmask, 0);
+	SDL_Surface *vector_output = SDL_CreateRGBSurface(SDL_SWSURFACE, w * 2, h * 2, f->BitsPerPixel, f->Rmask, f->Gmask, f->Bmask, 0);
+	if (!corrected || !scalar_output || !vector_output)
+	{
+		SDL_FreeSurface(corrected);
+		SDL_FreeSurface(scalar_output);
+		SDL_FreeSurface(vector_output);
+		return false;
+	}
+
+	// a gamma ramp that isn't the identity, so that the lookups are all exercised
+	uint16 saved_gamma[3][256];
+	memcpy(saved_gamma[0], current_gamma_r, sizeof(current_gamma_r));
+	memcpy(saved_gamma[1], current_gamma_g, sizeof(current_gamma_g));
+	memcpy(saved_gamma[2], current_gamma_b, sizeof(current_gamma_b));
+	for (int i = 0; i < 256; ++i)
+		current_gamma_r[i] = current_gamma_g[i] = current_gamma_b[i] = static_cast<uint16>(65535 * pow(i / 255.0, 0.7));
+
+	SDL_Rect rect = { 0, 0, w * 2, h * 2 };
+
+	// what update_screen() did for low resolution: correct, convert, then double
+	uint32 start = machine_tick_count();
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		apply_gamma_per_pixel(world_pixels, corrected);
+		SDL_Surface *s = corrected;
+		SDL_Surface *intermediary = 0;
+		if (!pixel_formats_equal(s->format, scalar_output->format))
+			s = intermediary = SDL_ConvertSurface(s, scalar_output->format, s->flags);
+		if (!s)
+			break;
+		if (s->format->BytesPerPixel == 2)
+			quadruple_surface((pixel16 *)s->pixels, s->pitch, (pixel16 *)scalar_output->pixels, scalar_output->pitch, rect);
+		else
+			quadruple_surface((pixel32 *)s->pixels, s->pitch, (pixel32 *)scalar_output->pixels, scalar_output->pitch, rect);
+		if (intermediary)
+			SDL_FreeSurface(intermediary);
+	}
+	*scalar_ticks = machine_tick_count() - start;
+
+	start = machine_tick_count();
+	for (int frame = 0; frame < frames; ++frame)
+		blit_world(world_pixels, vector_output, rect, true, true);
+	*vector_ticks = machine_tick_count() - start;
+
+	memcpy(current_gamma_r, saved_gamma[0], sizeof(current_gamma_r));
+	memcpy(current_gamma_g, saved_gamma[1], sizeof(current_gamma_g));
+	memcpy(current_gamma_b, saved_gamma[2], sizeof(current_gamma_b));
+
+	// converting straight to the output format keeps bits the old intermediate surface
+	// dropped, so the channels may differ by up to what that surface's format loses
+	SDL_PixelFormat *wf = world_pixels->format;
+	int tolerance = 1 << std::max(wf->Rloss, std::max(wf->Gloss, wf->Bloss));
+	bool identical = true;
+	for (int y = 0; y < h * 2 && identical; ++y)
+	{
+		for (int x = 0; x < w * 2; ++x)
+		{
+			uint32 a, b;
+			uint8 *pa = static_cast<uint8 *>(scalar_output->pixels) + y * scalar_output->pitch + x * f->BytesPerPixel;
+			uint8 *pb = static_cast<uint8 *>(vector_output->pixels) + y * vector_output->pitch + x * f->BytesPerPixel;
+			if (f->BytesPerPixel == 2)
+			{
+				a = *reinterpret_cast<uint16 *>(pa);
+				b = *reinterpret_cast<uint16 *>(pb);
+			}
+			else
+			{
+				a = *reinterpret_cast<uint32 *>(pa);
+				b = *reinterpret_cast<uint32 *>(pb);
+			}
+			uint8 ar, ag, ab, br, bg, bb;
+			SDL_GetRGB(a, f, &ar, &ag, &ab);
+			SDL_GetRGB(b, f, &br, &bg, &bb);
+			if (abs(ar - br) > tolerance || abs(ag - bg) > tolerance || abs(ab - bb) > tolerance)
+			{
+				identical = false;
+				break;
+			}
+		}
+	}
+
+	SDL_FreeSurface(corrected);
+	SDL_FreeSurface(scalar_output);
+	SDL_FreeSurface(vector_output);
+
+	return identical;
+}
+
 static void update_screen(SDL_Rect &source, SDL_Rect &destination, bool hi_rez)
 {
+	bool gamma = !using_default_gamma && bit_depth > 8;
+
+	// gamma, conversion and doubling in one pass, with no intermediate surfaces
+	if (gamma || !hi_rez)
+	{
+		if (SDL_MUSTLOCK(main_surface))
+		{
+			if (SDL_LockSurface(main_surface) < 0) return;
+		}
+		bool drawn = blit_world(world_pixels, main_surface, destination, !hi_rez, gamma);
+		if (SDL_MUSTLOCK(main_surface))
+			SDL_UnlockSurface(main_surface);
+		if (drawn)
+			return;
+	}
+
 	SDL_Surface *s = world_pixels;
-	if (!using_default_gamma && bit_depth > 8) {
+	if (gamma) {
 		apply_gamma(world_pixels, world_pixels_corrected);
 		s = world_pixels_corrected;
 	}
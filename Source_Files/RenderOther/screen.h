@@ -271,4 +271,8 @@ SDL_Surface *MainScreenSurface();
 void MainScreenUpdateRect(int x, int y, int w, int h);
 void MainScreenUpdateRects(size_t count, const SDL_Rect *rects);
 
+// compares the old gamma/convert/double steps with the single threaded pass on the
+// world view; true if they drew the same picture (to within the world format's precision)
+bool benchmark_screen_blits(int frames, uint32 *scalar_ticks, uint32 *vector_ticks);
+
 #endif
@@ -522,28 +522,44 @@ int sdl_font_info::_draw_text(SDL_Surface *s, const char *text, size_t length, i
 	return width;
 }
 
-int ttf_font_info::_draw_text(SDL_Surface *s, const char *text, size_t length, int x, int y, uint32 pixel, uint16 style, bool utf8) const
+static uint32 text_cache_hits = 0;
+static uint32 text_cache_misses = 0;
+
+// enough for every string on a busy Lua HUD, but bounded in case the text keeps changing
+const size_t MAXIMUM_CACHED_RUNS = 512;
+const size_t MAXIMUM_CACHED_RUN_BYTES = 4 * 1024 * 1024;
+
+void get_text_cache_stats(uint32& hits, uint32& misses)
 {
-	int clip_top, clip_bottom, clip_left, clip_right;
-	if (draw_clip_rect_active) {
-		clip_top = draw_clip_rect.top;
-		clip_bottom = draw_clip_rect.bottom;
-		clip_left = draw_clip_rect.left;
-		clip_right = draw_clip_rect.right;
-	} else {
-		clip_top = clip_left = 0;
-		clip_right = s->w;
-		clip_bottom = s->h;
+	hits = text_cache_hits;
+	misses = text_cache_misses;
+}
+
+void reset_text_cache_stats()
+{
+	text_cache_hits = text_cache_misses = 0;
+}
+
+// the surface SDL_ttf renders for this run, from the cache if possible; owned by the cache
+SDL_Surface *ttf_font_info::render_run(const char *text, size_t length, uint16 style, SDL_Color c, bool utf8) const
+{
+	bool smooth = environment_preferences->smooth_text;
+	ttf_run_key_t key(std::string(text, length), style & (styleBold | styleItalic), (c.r << 16) | (c.g << 8) | c.b, utf8, smooth);
+
+	std::map<ttf_run_key_t, run_list_t::iterator>::iterator found = m_run_index.find(key);
+	if (found != m_run_index.end())
+	{
+		++text_cache_hits;
+		m_run_cache.splice(m_run_cache.begin(), m_run_cache, found->second);
+		return found->second->surface;
 	}
+	++text_cache_misses;
 
-	SDL_Color c;
-	SDL_GetRGB(pixel, s->format, &c.r, &c.g, &c.b);
-	c.a = 0xff;
 	SDL_Surface *text_surface = 0;
 	if (utf8) 
 	{
 		char *temp = process_printable(text, length);
-		if (environment_preferences->smooth_text)
+		if (smooth)
 			text_surface = TTF_RenderUTF8_Blended(get_ttf(style), temp, c);	
 		else
 			text_surface = TTF_RenderUTF8_Solid(get_ttf(style), temp, c);
@@ -551,12 +567,63 @@ int ttf_font_info::_draw_text(SDL_Surface *s, const char *text, size_t length, i
 	else
 	{
 		uint16 *temp = process_macroman(text, length);
-		if (environment_preferences->smooth_text)
+		if (smooth)
 			text_surface = TTF_RenderUNICODE_Blended(get_ttf(style), temp, c);
 		else
 			text_surface = TTF_RenderUNICODE_Solid(get_ttf(style), temp, c);
 	}
 	if (!text_surface) return 0;
+
+	rendered_run run;
+	run.key = key;
+	run.surface = text_surface;
+	m_run_cache.push_front(run);
+	m_run_index[key] = m_run_cache.begin();
+	m_run_cache_bytes += text_surface->pitch * text_surface->h;
+
+	while (m_run_cache.size() > 1 &&
+	       (m_run_cache.size() > MAXIMUM_CACHED_RUNS || m_run_cache_bytes > MAXIMUM_CACHED_RUN_BYTES))
+	{
+		rendered_run& oldest = m_run_cache.back();
+		m_run_cache_bytes -= oldest.surface->pitch * oldest.surface->h;
+		SDL_FreeSurface(oldest.surface);
+		m_run_index.erase(oldest.key);
+		m_run_cache.pop_back();
+	}
+
+	return text_surface;
+}
+
+void ttf_font_info::clear_run_cache() const
+{
+	for (run_list_t::iterator it = m_run_cache.begin(); it != m_run_cache.end(); ++it)
+	{
+		SDL_FreeSurface(it->surface);
+	}
+	m_run_cache.clear();
+	m_run_index.clear();
+	m_run_cache_bytes = 0;
+}
+
+int ttf_font_info::_draw_text(SDL_Surface *s, const char *text, size_t length, int x, int y, uint32 pixel, uint16 style, bool utf8) const
+{
+	int clip_top, clip_bottom, clip_left, clip_right;
+	if (draw_clip_rect_active) {
+		clip_top = draw_clip_rect.top;
+		clip_bottom = draw_clip_rect.bottom;
+		clip_left = draw_clip_rect.left;
+		clip_right = draw_clip_rect.right;
+	} else {
+		clip_top = clip_left = 0;
+		clip_right = s->w;
+		clip_bottom = s->h;
+	}
+
+	SDL_Color c;
+	SDL_GetRGB(pixel, s->format, &c.r, &c.g, &c.b);
+	c.a = 0xff;
+	SDL_Surface *text_surface = render_run(text, length, style, c, utf8);
+	if (!text_surface) return 0;
 	
 	SDL_Rect dst_rect;
 	dst_rect.x = x;
@@ -589,9 +656,7 @@ int ttf_font_info::_draw_text(SDL_Surface *s, const char *text, size_t length, i
 	if (s == MainScreenSurface())
 		MainScreenUpdateRect(x, y - TTF_FontAscent(get_ttf(style)), text_width(text, style, utf8), TTF_FontHeight(get_ttf(style)));
 
-	int width = text_surface->w;
-	SDL_FreeSurface(text_surface);
-	return width;
+	return text_surface->w;
 }
 
 static void draw_text(const char *text, int x, int y, uint32 pixel, const font_info *font, uint16 style)
@@ -440,6 +440,8 @@ void sdl_font_info::_unload()
 
 void ttf_font_info::_unload()
 {
+	clear_run_cache();
+
 	for (int i = 0; i < styleUnderline; ++i)
 	{
 		ttf_font_list_t::iterator it = ttf_font_list.find(m_keys[i]);
@@ -32,7 +32,10 @@
 #include "FileHandler.h"
 #include <SDL_ttf.h>
 #include <boost/tuple/tuple.hpp>
+#include <boost/tuple/tuple_comparison.hpp>
 
+#include <list>
+#include <map>
 #include <string>
 
 /*
@@ -113,6 +116,9 @@ private:
 
 typedef boost::tuple<std::string, uint16, int16> ttf_font_key_t;
 
+// text (as passed to _draw_text), style, RGB color, utf8, smooth
+typedef boost::tuple<std::string, uint16, uint32, bool, bool> ttf_run_key_t;
+
 class ttf_font_info : public font_info { 
 public:
 	uint16 get_ascent() const { return TTF_FontAscent(m_styles[styleNormal]); };
@@ -127,10 +133,10 @@ public:
 
 	int8 char_width(uint8, uint16) const;
 
-	ttf_font_info() { 
+	ttf_font_info() : m_run_cache_bytes(0) { 
 		for (int i = 0; i < styleUnderline; i++) { m_styles[i] = 0; } 
 	}
-	virtual ~ttf_font_info() = default;
+	virtual ~ttf_font_info() { clear_run_cache(); }
 protected:
 	virtual int _draw_text(SDL_Surface *s, const char *text, size_t length, int x, int y, uint32 pixel, uint16 style, bool utf8) const;
 	virtual uint16 _text_width(const char *text, size_t length, uint16 style, bool utf8) const;
@@ -141,6 +147,20 @@ private:
 	uint16 *process_macroman(const char *src, int len) const;
 	TTF_Font *get_ttf(uint16 style) const { return m_styles[style & (styleBold | styleItalic)]; }
 	virtual void _unload();
+
+	// The same strings get drawn every frame (HUD, terminals, Lua HUD text), so keep the
+	// surfaces SDL_ttf rendered for them, most recently used first
+	struct rendered_run {
+		ttf_run_key_t key;
+		SDL_Surface *surface;
+	};
+	typedef std::list<rendered_run> run_list_t;
+	mutable run_list_t m_run_cache;
+	mutable std::map<ttf_run_key_t, run_list_t::iterator> m_run_index;
+	mutable size_t m_run_cache_bytes;
+
+	SDL_Surface *render_run(const char *text, size_t length, uint16 style, SDL_Color c, bool utf8) const;
+	void clear_run_cache() const;
 };
 
 /*
@@ -156,4 +176,8 @@ extern font_info *load_font(const TextSpec &spec);
 // Unload font
 extern void unload_font(font_info *font);
 
+// Hits and misses in the TrueType fonts' rendered text caches, since the last reset
+extern void get_text_cache_stats(uint32& hits, uint32& misses);
+extern void reset_text_cache_stats();
+
 #endif
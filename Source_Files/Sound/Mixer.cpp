@@ -17,17 +17,54 @@
 	which is included with this source code; it is available online at
 	http://www.gnu.org/licenses/gpl.html
 
+Oct 17, 2026:
+	Resample_() runs each stretch of a channel that can't reach the end of its data through a
+	loop without the per-sample checks, and Mix() skips idle channels.  Accumulating, volume,
+	clipping and 16-bit output have SSE2/NEON versions, picked in Start(); BenchmarkMix()
+	checks them, and the scalar ones, against the original per-sample loop.
+
 */
 
 #include "Mixer.h"
 #include "interface.h" // for strERRORS
 
+#include <SDL_cpuinfo.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIXER_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MIXER_NEON
+#endif
+
 extern bool option_nosound;
 
+// set by Start(); BenchmarkMix() flips it to compare against the scalar kernels
+static bool use_vector_kernels = false;
+// only BenchmarkMix() sets this, so that Resample_() runs the original per-sample loop alone
+static bool use_reference_resampler = false;
+
+static bool vector_kernels_available()
+{
+#if defined(MIXER_SSE2)
+	return SDL_HasSSE2();
+#elif defined(MIXER_NEON)
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+	return SDL_HasNEON();
+#else
+	return true;
+#endif
+#else
+	return false;
+#endif
+}
+
 void Mixer::Start(uint16 rate, bool sixteen_bit, bool stereo, int num_channels, int volume, uint16 samples)
 {
 	sound_channel_count = num_channels;
 	main_volume = volume;
+	use_vector_kernels = vector_kernels_available();
 	desired.freq = rate;
 #if defined(__MACH__) && defined(__APPLE__)
 	desired.format = sixteen_bit ? AUDIO_S16SYS : AUDIO_U8;
@@ -65,6 +102,96 @@ void Mixer::Start(uint16 rate, bool sixteen_bit, bool stereo, int num_channels,
 	}
 }
 
+bool Mixer::BenchmarkMix(int seconds, int channel_count, uint32 *reference_ticks, uint32 *scalar_ticks, uint32 *vector_ticks)
+{
+	const int output_rate = 44100;
+	const int frames = output_rate * seconds;
+	const _fixed rates[] = { 0x10000, 0x8000, 0x4000, 0x1126a, 0xd3e1 };
+
+	// one of each sample format at a spread of rates and volumes, looping forever
+	std::vector<Channel> bench_channels(channel_count + EXTRA_CHANNELS);
+	uint32 seed = 0x2545f491;
+	for (int i = 0; i < channel_count; ++i)
+	{
+		Channel& c = bench_channels[i];
+		c.info.sixteen_bit = (i % 4) < 2;
+		c.info.stereo = (i % 2) == 0;
+		c.info.signed_8bit = (i % 4) == 2;
+		c.info.little_endian = (i % 8) < 4;
+		c.info.bytes_per_frame = (c.info.sixteen_bit ? 2 : 1) * (c.info.stereo ? 2 : 1);
+
+		int32 length = (4000 + i * 777) * c.info.bytes_per_frame;
+		c.sound_data.reset(new SoundData(length));
+		for (int32 j = 0; j < length; ++j)
+		{
+			seed = seed * 1664525 + 1013904223;
+			(*c.sound_data)[j] = seed >> 24;
+		}
+		c.info.length = length;
+
+		c.active = true;
+		c.data = c.loop = &(*c.sound_data)[0];
+		c.length = c.loop_length = length;
+		c.rate = rates[i % (sizeof(rates) / sizeof(rates[0]))];
+		c.counter = 0;
+		c.left_volume = 0x100 - (i * 37) % 0x100;
+		c.right_volume = 0x40 + (i * 53) % 0x100;
+		c.source = Channel::SOURCE_SOUND_HEADERS;
+		c.sound_manager_index = i;
+	}
+
+	std::vector<uint8> reference_output(frames * 4);
+	std::vector<uint8> scalar_output(frames * 4);
+	std::vector<uint8> vector_output(frames * 4);
+
+	std::vector<Channel> pass_channels = bench_channels;
+	*reference_ticks = BenchmarkPass(pass_channels, channel_count, false, true, &reference_output[0], frames);
+
+	pass_channels = bench_channels;
+	*scalar_ticks = BenchmarkPass(pass_channels, channel_count, false, false, &scalar_output[0], frames);
+
+	pass_channels = bench_channels;
+	*vector_ticks = BenchmarkPass(pass_channels, channel_count, vector_kernels_available(), false, &vector_output[0], frames);
+
+	return scalar_output == reference_output && vector_output == reference_output;
+}
+
+uint32 Mixer::BenchmarkPass(std::vector<Channel>& bench_channels, int channel_count, bool vector_kernels, bool reference_resampler, uint8* output, int frames)
+{
+	// the audio callback is only kept out for a callback's worth of frames at a time,
+	// while the benchmark's channels and settings are swapped in
+	const int chunk_frames = 1024;
+
+	uint64 elapsed = 0;
+	for (int frame = 0; frame < frames; frame += chunk_frames)
+	{
+		int chunk = std::min(chunk_frames, frames - frame);
+
+		SDL_LockAudio();
+		channels.swap(bench_channels);
+		int saved_sound_channel_count = sound_channel_count;
+		int16 saved_main_volume = main_volume;
+		bool saved_use_vector_kernels = use_vector_kernels;
+		sound_channel_count = channel_count;
+		main_volume = 0x100;
+		use_vector_kernels = vector_kernels;
+		use_reference_resampler = reference_resampler;
+
+		uint64 start = SDL_GetPerformanceCounter();
+		Mix(output + frame * 4, chunk, true, true, true);
+		elapsed += SDL_GetPerformanceCounter() - start;
+
+		use_reference_resampler = false;
+		use_vector_kernels = saved_use_vector_kernels;
+		main_volume = saved_main_volume;
+		sound_channel_count = saved_sound_channel_count;
+		channels.swap(bench_channels);
+		SDL_UnlockAudio();
+	}
+
+	return static_cast<uint32>(elapsed * 1000 / SDL_GetPerformanceFrequency());
+}
+
 void Mixer::Stop()
 {
 	SDL_CloseAudio();
@@ -333,9 +460,114 @@ static inline int32 lerp(int32 x0, int32 x1, _fixed rate)
 	return v;
 }
 
+// de-interleaves native-endian 16-bit stereo, for channels playing at the output rate
+static void SplitStereo16(const int16* data, int16* left, int16* right, int frames)
+{
+	int i = 0;
+#if defined(MIXER_SSE2)
+	if (use_vector_kernels)
+	{
+		for (; i + 8 <= frames; i += 8)
+		{
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 2));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 2 + 8));
+			__m128i l = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+			__m128i r = _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(left + i), l);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(right + i), r);
+		}
+	}
+#elif defined(MIXER_NEON)
+	if (use_vector_kernels)
+	{
+		for (; i + 8 <= frames; i += 8)
+		{
+			int16x8x2_t lr = vld2q_s16(data + i * 2);
+			vst1q_s16(left + i, lr.val[0]);
+			vst1q_s16(right + i, lr.val[1]);
+		}
+	}
+#endif
+	for (; i < frames; ++i)
+	{
+		left[i] = data[i * 2];
+		right[i] = data[i * 2 + 1];
+	}
+}
+
 template<class T, bool stereo, bool le_or_signed>
 void Mixer::Resample_(Channel* c, int16* left, int16* right, int& samples)
 {
+	// While the current frame and the one after it are both in this buffer and the step
+	// can't run off its end, there is nothing to check per sample; the rest (and the
+	// inactive case) goes through the general loop below.
+	const int32 bytes_per_frame = c->info.bytes_per_frame;
+	if (!use_reference_resampler && c->active && c->rate >= 0 && c->length > 0 && bytes_per_frame > 0)
+	{
+		const int32 frames = (c->length + bytes_per_frame - 1) / bytes_per_frame;
+		const uint8* base = c->data;
+		_fixed counter = c->counter;
+		int32 position = 0;
+		int done = 0;
+
+		if (c->rate == 0x10000 && counter == 0 &&
+		    stereo && sizeof(T) == 2 && le_or_signed == (SDL_BYTEORDER == SDL_LIL_ENDIAN) &&
+		    bytes_per_frame == 4)
+		{
+			// no interpolation, one frame per sample: a straight copy
+			done = std::max(0, std::min(samples, frames - 1));
+			SplitStereo16(reinterpret_cast<const int16*>(base), left, right, done);
+			position = done;
+		}
+		else
+		{
+			while (done < samples && position <= frames - 2)
+			{
+				_fixed next_counter = counter + c->rate;
+				if (next_counter >= 0x10000 && position + (next_counter >> 16) > frames - 1)
+					break;
+
+				const T* data = reinterpret_cast<const T*>(base + position * bytes_per_frame);
+				int32 left0 = Convert<le_or_signed>(*data++);
+				int32 right0 = stereo ? Convert<le_or_signed>(*data++) : 0;
+				if (counter & 0xffff)
+				{
+					int32 left1 = Convert<le_or_signed>(*data++);
+					left[done] = lerp(left0, left1, counter);
+					if (stereo)
+					{
+						int32 right1 = Convert<le_or_signed>(*data++);
+						right[done] = lerp(right0, right1, counter);
+					}
+					else
+					{
+						right[done] = left[done];
+					}
+				}
+				else
+				{
+					left[done] = left0;
+					right[done] = stereo ? right0 : left0;
+				}
+
+				counter = next_counter;
+				if (counter >= 0x10000)
+				{
+					position += counter >> 16;
+					counter &= 0xffff;
+				}
+				++done;
+			}
+		}
+
+		c->counter = counter;
+		c->data += position * bytes_per_frame;
+		c->length -= position * bytes_per_frame;
+		left += done;
+		right += done;
+		samples -= done;
+	}
+
 	while (samples--)
 	{
 
@@ -462,8 +694,77 @@ void Mixer::ResampleInner(Channel* c, int16* left, int16* right, int& samples)
 	}
 }
 
+static inline void accumulate(int32* output, const int16* input, int16 volume, int samples)
+{
+	int i = 0;
+#if defined(MIXER_SSE2)
+	if (use_vector_kernels)
+	{
+		__m128i v = _mm_set1_epi16(volume);
+		for (; i + 8 <= samples; i += 8)
+		{
+			__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+			__m128i lo = _mm_mullo_epi16(x, v);
+			__m128i hi = _mm_mulhi_epi16(x, v);
+			__m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 8);
+			__m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 8);
+			__m128i* o = reinterpret_cast<__m128i*>(output + i);
+			_mm_storeu_si128(o, _mm_add_epi32(_mm_loadu_si128(o), p0));
+			_mm_storeu_si128(o + 1, _mm_add_epi32(_mm_loadu_si128(o + 1), p1));
+		}
+	}
+#elif defined(MIXER_NEON)
+	if (use_vector_kernels)
+	{
+		int16x4_t v = vdup_n_s16(volume);
+		for (; i + 8 <= samples; i += 8)
+		{
+			int16x8_t x = vld1q_s16(input + i);
+			int32x4_t p0 = vshrq_n_s32(vmull_s16(vget_low_s16(x), v), 8);
+			int32x4_t p1 = vshrq_n_s32(vmull_s16(vget_high_s16(x), v), 8);
+			vst1q_s32(output + i, vaddq_s32(vld1q_s32(output + i), p0));
+			vst1q_s32(output + i + 4, vaddq_s32(vld1q_s32(output + i + 4), p1));
+		}
+	}
+#endif
+	for (; i < samples; ++i)
+	{
+		output[i] += (input[i] * volume) >> 8;
+	}
+}
+
 static inline void apply_volume_and_clip(int32* v, int16 main_volume, int samples)
 {
+#if defined(MIXER_SSE2)
+	if (use_vector_kernels)
+	{
+		// SSE2 has no 32-bit mullo; the low halves of the unsigned products are the same bits
+		__m128i m = _mm_set1_epi32(main_volume);
+		for (; samples >= 8; samples -= 8, v += 8)
+		{
+			__m128i p[2];
+			for (int j = 0; j < 2; ++j)
+			{
+				__m128i a = _mm_loadu_si128(reinterpret_cast<__m128i*>(v) + j);
+				__m128i even = _mm_mul_epu32(a, m);
+				__m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), m);
+				p[j] = _mm_srai_epi32(_mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))), 8);
+			}
+			__m128i clipped = _mm_packs_epi32(p[0], p[1]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(v), _mm_srai_epi32(_mm_unpacklo_epi16(clipped, clipped), 16));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(v) + 1, _mm_srai_epi32(_mm_unpackhi_epi16(clipped, clipped), 16));
+		}
+	}
+#elif defined(MIXER_NEON)
+	if (use_vector_kernels)
+	{
+		for (; samples >= 4; samples -= 4, v += 4)
+		{
+			int32x4_t p = vshrq_n_s32(vmulq_n_s32(vld1q_s32(v), main_volume), 8);
+			vst1q_s32(v, vmovl_s16(vqmovn_s32(p)));
+		}
+	}
+#endif
 	while (samples--)
 	{
 		*v = (*v * main_volume) >> 8;
@@ -482,6 +783,30 @@ static inline void apply_volume_and_clip(int32* v, int16 main_volume, int sample
 
 void Output(int16* output, int32* left, int32* right, int samples, bool)
 {
+	// the values are already clipped, so saturating packs don't change them
+#if defined(MIXER_SSE2)
+	if (use_vector_kernels)
+	{
+		for (; samples >= 8; samples -= 8, left += 8, right += 8, output += 16)
+		{
+			__m128i l = _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<__m128i*>(left)), _mm_loadu_si128(reinterpret_cast<__m128i*>(left + 4)));
+			__m128i r = _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<__m128i*>(right)), _mm_loadu_si128(reinterpret_cast<__m128i*>(right + 4)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_unpacklo_epi16(l, r));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(output + 8), _mm_unpackhi_epi16(l, r));
+		}
+	}
+#elif defined(MIXER_NEON)
+	if (use_vector_kernels)
+	{
+		for (; samples >= 4; samples -= 4, left += 4, right += 4, output += 8)
+		{
+			int16x4x2_t lr;
+			lr.val[0] = vqmovn_s32(vld1q_s32(left));
+			lr.val[1] = vqmovn_s32(vld1q_s32(right));
+			vst2_s16(output, lr);
+		}
+	}
+#endif
 	while (samples--)
 	{
 		*output++ = *left++;
@@ -555,6 +880,11 @@ void Mixer::Mix(uint8* p, int len, bool stereo, bool is_sixteen_bit, bool is_sig
 		for (int channel = 0; channel < channel_count; ++channel)
 		{
 			Channel* c = &channels[channel];
+			if (!c->active)
+			{
+				// it would only resample to silence
+				continue;
+			}
 			Resample(c, channel_left, channel_right, samples);
 
 			int16 left_volume = c->left_volume;
@@ -564,11 +894,8 @@ void Mixer::Mix(uint8* p, int len, bool stereo, bool is_sixteen_bit, bool is_sig
 				left_volume = right_volume = SoundManager::instance()->GetNetmicVolumeAdjustment();
 			}
 
-			for (int i = 0; i < samples; ++i)
-			{
-				output_left[i] += (channel_left[i] * left_volume) >> 8;
-				output_right[i] += (channel_right[i] * right_volume) >> 8;
-			}
+			accumulate(output_left, channel_left, left_volume, samples);
+			accumulate(output_right, channel_right, right_volume, samples);
 		}
 
 		if (game_is_networked &&
@@ -75,6 +75,12 @@ public:
 	void PlaySoundResource(LoadedResource &rsrc, _fixed pitch = _normal_frequency);
 	void StopSoundResource();
 
+	// renders seconds of channel_count synthetic looping channels to memory three times:
+	// with the original per-sample resampling loop and scalar kernels, as the reference;
+	// with the fast resampler and scalar kernels; and with the fast resampler and vector
+	// kernels; false if either of the last two differs from the reference
+	bool BenchmarkMix(int seconds, int channel_count, uint32 *reference_ticks, uint32 *scalar_ticks, uint32 *vector_ticks);
+
 private:
         Mixer() : sNetworkAudioBufferDesc(0) { };
 	
@@ -151,6 +157,9 @@ private:
 	inline bool IsNetworkAudioPlaying() { return channels[sound_channel_count + NETWORK_AUDIO_CHANNEL].active; }
 
 	void Mix(uint8* p, int len, bool stereo, bool is_sixteen_bit, bool is_signed);
+
+	// one of BenchmarkMix()'s passes, in milliseconds
+	uint32 BenchmarkPass(std::vector<Channel>& bench_channels, int channel_count, bool vector_kernels, bool reference_resampler, uint8* output, int frames);
 };
 #endif
 
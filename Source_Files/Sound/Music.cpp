@@ -22,8 +22,27 @@
 #include "Music.h"
 #include "Mixer.h"
 #include "XML_LevelScript.h"
+#include "Logging.h"
+
+#include <string.h>
+#include <algorithm>
+
+// for the mixer, while the decoding thread catches up
+static int16 silence[2 * 256];
+
+static inline int16 lerp(int32 x0, int32 x1, _fixed counter)
+{
+	return x0 + ((1LL*x1 - x0) * (counter & 0xffff)) / 65536;
+}
 
 Music::Music() : 
+	handed_out(0),
+	crossfade_frames(0),
+	next_queued(false),
+	streaming(false),
+	decoding(false),
+	quit(false),
+	thread(0),
 	music_initialized(false), 
 	music_intro(false), 
 	music_play(false), 
@@ -32,19 +51,27 @@ Music::Music() :
 	music_fading(false), 
 	music_fade_start(0), 
 	music_fade_duration(0),
-	decoder(0),
 	marathon_1_song_index(NONE),
 	song_number(0),
 	random_order(false)
 {
-	music_buffer.resize(MUSIC_BUFFER_SIZE);
+	SDL_AtomicSet(&stream_ended, 0);
+	SDL_AtomicSet(&underruns, 0);
+	mutex = SDL_CreateMutex();
+	cond = SDL_CreateCond();
+	decoded_cond = SDL_CreateCond();
 }
 
 void Music::Open(FileSpecifier *file)
 {
 	if (music_initialized)
 	{
-		if (file && *file == music_file)
+		// the decoding thread moves music_file on to each level song it starts
+		SDL_LockMutex(mutex);
+		bool same_file = file && *file == music_file;
+		SDL_UnlockMutex(mutex);
+
+		if (same_file)
 		{
 			Rewind();
 			return;
@@ -56,7 +83,6 @@ void Music::Open(FileSpecifier *file)
 	if (file)
 	{
 		music_initialized = Load(*file);
-		music_file = *file;
 	}
 		
 }
@@ -103,7 +129,17 @@ void Music::Restart()
 	{
 		if (music_level)
 		{
-			LoadLevelMusic();
+			// a song queued to follow the one that ended didn't (it failed to load, or
+			// was queued too late); it's next, rather than being skipped over
+			SDL_LockMutex(mutex);
+			bool queued = next_queued;
+			FileSpecifier queued_file = next_file;
+			SDL_UnlockMutex(mutex);
+
+			if (queued)
+				Open(&queued_file);
+			else
+				LoadLevelMusic();
 			Play();
 		}
 		else if (music_intro)
@@ -117,6 +153,34 @@ void Music::Restart()
 void Music::Idle()
 {
 	if (!SoundManager::instance()->IsInitialized() || !SoundManager::instance()->IsActive()) return;
+
+	// the next level song goes to the decoding thread well ahead of time, so that it can
+	// follow this one without a gap
+	if (music_level && music_initialized)
+	{
+		SDL_LockMutex(mutex);
+		bool queued = next_queued;
+		SDL_UnlockMutex(mutex);
+
+		FileSpecifier* level_song_file = queued ? 0 : GetLevelMusic();
+		if (level_song_file)
+		{
+			SDL_LockMutex(mutex);
+			next_file = *level_song_file;
+			next_queued = true;
+			SDL_UnlockMutex(mutex);
+		}
+	}
+
+	// without a thread of its own, music is decoded here
+	if (!thread)
+	{
+		SDL_LockMutex(mutex);
+		while (ShouldDecode())
+			DecodeChunk(false);
+		SDL_UnlockMutex(mutex);
+	}
+
 	if (music_prelevel)
 	{
 		music_prelevel = false;
@@ -157,48 +221,91 @@ void Music::Close()
 	{
 		music_initialized = false;
 		Pause();
-		delete decoder;
-		decoder = 0;
+
+		SDL_LockMutex(mutex);
+		WaitForDecoder();
+		Flush();
+		track.Close();
+		next_queued = false;
+		SDL_UnlockMutex(mutex);
+	}
+}
+
+void Music::Shutdown()
+{
+	Close();
+
+	if (thread)
+	{
+		SDL_LockMutex(mutex);
+		quit = true;
+		SDL_CondSignal(cond);
+		SDL_UnlockMutex(mutex);
+
+		SDL_WaitThread(thread, NULL);
+		thread = 0;
+		quit = false;
 	}
 }
 
 bool Music::Load(FileSpecifier &song_file)
 {
+	SDL_LockMutex(mutex);
+	WaitForDecoder();
+	Flush();
+	bool loaded = track.Load(song_file);
+	music_file = song_file;
 
-	delete decoder;
-	decoder = StreamDecoder::Get(song_file);
+	int freq = Mixer::instance()->obtained.freq;
+	crossfade_frames = std::min(freq * kCrossfadeMilliseconds / 1000, kChunkFrames * 16);
+	SDL_UnlockMutex(mutex);
 
-	if (decoder)
-	{
-		sixteen_bit = decoder->IsSixteenBit();
-		stereo = decoder->IsStereo();
-		signed_8bit = decoder->IsSigned();
-		bytes_per_frame = decoder->BytesPerFrame();
-		rate = (_fixed) ((decoder->Rate() / Mixer::instance()->obtained.freq) * (1 << FIXED_FRACTIONAL_BITS));
-		little_endian = decoder->IsLittleEndian();
+	if (loaded && !thread)
+		thread = SDL_CreateThread(Run, "Music_decodeThread", this);
 
-		return true;
-		
-	}
-	else
-	{
-		return false;
-	}
+	return loaded;
 }
 
 void Music::Rewind()
 {
-	
-	if (decoder)
-		decoder->Rewind();
+	// the ring can only be emptied while the mixer isn't reading it
+	bool playing = music_initialized && Playing();
+	if (playing)
+		Mixer::instance()->StopMusicChannel();
+
+	SDL_LockMutex(mutex);
+	WaitForDecoder();
+	Flush();
+	track.Rewind();
+	SDL_UnlockMutex(mutex);
+
+	if (playing)
+		Play();
 }
 
 void Music::Play()
 {
 	if (!music_initialized || !SoundManager::instance()->IsInitialized() || !SoundManager::instance()->IsActive()) return;
+
+	if (Playing())
+	{
+		CheckVolume();
+		return;
+	}
+
+	// the first stretch is decoded now, so that the mixer has something to start on
+	SDL_LockMutex(mutex);
+	WaitForDecoder();
+	streaming = true;
+	const int16 *frames;
+	while (!ring.Peek(&frames, 1) && ShouldDecode())
+		DecodeChunk(false);
+	SDL_CondSignal(cond);
+	SDL_UnlockMutex(mutex);
+
 	if (FillBuffer()) {
 		// let the mixer handle it
-		Mixer::instance()->StartMusicChannel(sixteen_bit, stereo, signed_8bit, bytes_per_frame, rate, little_endian);
+		Mixer::instance()->StartMusicChannel(true, true, false, 4, FIXED_ONE, PlatformIsLittleEndian());
 		CheckVolume();
 	}
 }
@@ -207,16 +314,339 @@ bool Music::FillBuffer()
 {
 	if (!GetVolumeLevel()) return false;
 
-	if (!decoder) return false;
-	int32 bytes_read = decoder->Decode(&music_buffer.front(), MUSIC_BUFFER_SIZE);
-	if (bytes_read)
+	// the mixer is done with what it was handed last time; the decoding thread may be
+	// waiting for the room (if it misses this, it hears about it next time)
+	if (handed_out)
+	{
+		ring.Consume(handed_out);
+		handed_out = 0;
+		SDL_CondSignal(cond);
+	}
+
+	// (checked first, since the last frames go in before it is set)
+	bool ended = SDL_AtomicGet(&stream_ended);
+
+	const int16 *frames;
+	int32 count = ring.Peek(&frames, kHandOutFrames);
+	if (count)
 	{
-		Mixer::instance()->UpdateMusicChannel(&music_buffer.front(), bytes_read);
+		handed_out = count;
+		Mixer::instance()->UpdateMusicChannel((uint8 *) frames, count * 4);
 		return true;
 	}
 
-	// Failed
-	return false;
+	if (ended)
+		return false;
+
+	// the decoding thread has fallen behind; better a moment of silence than to stop
+	SDL_AtomicAdd(&underruns, 1);
+	Mixer::instance()->UpdateMusicChannel((uint8 *) silence, sizeof(silence));
+	return true;
+}
+
+// while the mutex is held and the mixer isn't playing out of the ring
+void Music::Flush()
+{
+	ring.Reset();
+	handed_out = 0;
+	held_back.clear();
+	streaming = false;
+	SDL_AtomicSet(&stream_ended, 0);
+}
+
+// with the mutex held
+bool Music::ShouldDecode()
+{
+	return streaming && !decoding && !SDL_AtomicGet(&stream_ended) && ring.Free() >= 2 * kChunkFrames + crossfade_frames;
+}
+
+// with the mutex held: track, held_back and the writing end of the ring belong to the
+// decoding thread until it's done with the chunk it's on
+void Music::WaitForDecoder()
+{
+	while (decoding)
+		SDL_CondWait(decoded_cond, mutex);
+}
+
+// decodes a chunk into the ring, with the mutex held; the decoding thread lets go of it
+// meanwhile, so that the main thread never waits on a decoder or on opening a file. While
+// a different song is queued to follow, the last crossfade_frames of track are held back,
+// to be faded into it
+void Music::DecodeChunk(bool let_go)
+{
+	bool queued = next_queued;
+	FileSpecifier next = next_file;
+
+	decoding = true;
+	if (let_go)
+		SDL_UnlockMutex(mutex);
+
+	int32 hold = (queued && !(next == track.file)) ? crossfade_frames : 0;
+
+	size_t base = held_back.size();
+	held_back.resize(base + kChunkFrames * 2);
+	int32 count = track.Render(&held_back[base], kChunkFrames);
+	held_back.resize(base + count * 2);
+
+	bool over = count < kChunkFrames;
+	bool moved_on = false;
+	if (over)
+	{
+		moved_on = StartNextTrack(queued, next);
+	}
+	else
+	{
+		int32 ready = static_cast<int32>(held_back.size() / 2) - hold;
+		if (ready > 0)
+		{
+			ring.Write(&held_back[0], ready);
+			held_back.erase(held_back.begin(), held_back.begin() + ready * 2);
+		}
+	}
+
+	if (let_go)
+		SDL_LockMutex(mutex);
+	decoding = false;
+	SDL_CondBroadcast(decoded_cond);
+
+	// (the main thread only queues a song while none is, so next_file is still next)
+	if (over && queued)
+		next_queued = false;
+	if (moved_on)
+		music_file = next;
+}
+
+// track is over: goes on to the queued level song, if there is one, fading the end of
+// track (whatever was held back) into its start; returns whether it did
+bool Music::StartNextTrack(bool queued, FileSpecifier &next_song)
+{
+	int32 held = static_cast<int32>(held_back.size() / 2);
+	int32 fade = 0;
+	bool next = false;
+
+	if (queued)
+	{
+		if (next_song == track.file)
+		{
+			// the same song again: straight on from its start
+			track.Rewind();
+			next = true;
+		}
+		else
+		{
+			fade = std::min(held, crossfade_frames);
+			next = track.Load(next_song);
+		}
+	}
+
+	if (!next)
+		fade = 0;
+
+	if (held > fade)
+		ring.Write(&held_back[0], held - fade);
+
+	if (fade)
+	{
+		std::vector<int16> start(fade * 2);
+		int32 count = track.Render(&start[0], fade);
+		int16 *tail = &held_back[(held - fade) * 2];
+		for (int32 i = 0; i < fade * 2; ++i)
+		{
+			int32 frame = i / 2;
+			int32 incoming = (frame < count) ? start[i] : 0;
+			tail[i] = (tail[i] * (fade - frame) + incoming * frame) / fade;
+		}
+		ring.Write(tail, fade);
+	}
+	held_back.clear();
+
+	if (!next)
+		SDL_AtomicSet(&stream_ended, 1);
+	return next;
+}
+
+int Music::Run(void *pv)
+{
+	Music *music = reinterpret_cast<Music *>(pv);
+
+	SDL_LockMutex(music->mutex);
+	while (!music->quit)
+	{
+		// woken by the main thread, or by the mixer making room in the ring
+		if (music->ShouldDecode())
+			music->DecodeChunk(true);
+		else
+			SDL_CondWait(music->cond, music->mutex);
+	}
+	SDL_UnlockMutex(music->mutex);
+
+	return 0;
+}
+
+bool Music::Track::Load(FileSpecifier &song_file)
+{
+	Close();
+	decoder = StreamDecoder::Get(song_file);
+	if (!decoder)
+		return false;
+
+	file = song_file;
+	sixteen_bit = decoder->IsSixteenBit();
+	stereo = decoder->IsStereo();
+	signed_8bit = decoder->IsSigned();
+	bytes_per_frame = decoder->BytesPerFrame();
+	little_endian = decoder->IsLittleEndian();
+
+	int freq = Mixer::instance()->obtained.freq;
+	rate = freq ? (_fixed) ((decoder->Rate() / freq) * (1 << FIXED_FRACTIONAL_BITS)) : FIXED_ONE;
+
+	Rewind();
+	return true;
+}
+
+void Music::Track::Rewind()
+{
+	if (decoder)
+		decoder->Rewind();
+	counter = 0;
+	frames.clear();
+	position = 0;
+	ended = !decoder;
+}
+
+void Music::Track::Close()
+{
+	delete decoder;
+	decoder = 0;
+	Rewind();
+}
+
+// appends a buffer's worth from the decoder to frames
+bool Music::Track::Decode()
+{
+	uint8 buffer[4096];
+	int32 count = decoder ? decoder->Decode(buffer, sizeof(buffer)) / bytes_per_frame : 0;
+	if (count <= 0)
+		return false;
+
+	// drop the frames that have been used up
+	int32 used = std::min(position, static_cast<int32>(frames.size() / 2));
+	frames.erase(frames.begin(), frames.begin() + used * 2);
+	position -= used;
+
+	size_t base = frames.size();
+	frames.resize(base + count * 2);
+	int16 *out = &frames[base];
+	const int sample_size = sixteen_bit ? 2 : 1;
+	for (int32 i = 0; i < count; ++i)
+	{
+		const uint8 *p = buffer + i * bytes_per_frame;
+		for (int channel = 0; channel < 2; ++channel)
+		{
+			const uint8 *sample = p + ((stereo && channel) ? sample_size : 0);
+			if (sixteen_bit)
+			{
+				int16 value;
+				memcpy(&value, sample, 2);
+				*out++ = little_endian ? SDL_SwapLE16(value) : SDL_SwapBE16(value);
+			}
+			else if (signed_8bit)
+				*out++ = static_cast<int8>(*sample) * 256;
+			else
+				*out++ = static_cast<int8>(*sample ^ 0x80) * 256;
+		}
+	}
+
+	return true;
+}
+
+int32 Music::Track::Render(int16 *out, int32 count)
+{
+	int32 done = 0;
+	while (done < count)
+	{
+		int32 available = static_cast<int32>(frames.size() / 2) - position;
+		if (available < 2 && !ended)
+		{
+			if (!Decode())
+				ended = true;
+			continue;
+		}
+		if (available <= 0)
+			break;
+
+		// interpolated the same way the mixer's Resample_() does
+		const int16 *frame = &frames[position * 2];
+		if ((counter & 0xffff) && available > 1)
+		{
+			*out++ = lerp(frame[0], frame[2], counter);
+			*out++ = lerp(frame[1], frame[3], counter);
+		}
+		else
+		{
+			*out++ = frame[0];
+			*out++ = frame[1];
+		}
+
+		counter += rate;
+		position += counter >> 16;
+		counter &= 0xffff;
+		++done;
+	}
+
+	return done;
+}
+
+Music::Ring::Ring() :
+	buffer(kFrames * 2)
+{
+	Reset();
+}
+
+void Music::Ring::Reset()
+{
+	SDL_AtomicSet(&read_position, 0);
+	SDL_AtomicSet(&write_position, 0);
+}
+
+int32 Music::Ring::Free()
+{
+	return kFrames - static_cast<int32>(static_cast<uint32>(SDL_AtomicGet(&write_position)) - static_cast<uint32>(SDL_AtomicGet(&read_position)));
+}
+
+void Music::Ring::Write(const int16 *frames, int32 count)
+{
+	// never over what the mixer hasn't played yet
+	count = std::min(count, Free());
+
+	uint32 position = SDL_AtomicGet(&write_position);
+	while (count > 0)
+	{
+		int32 offset = position & (kFrames - 1);
+		int32 n = std::min(count, kFrames - offset);
+		memcpy(&buffer[offset * 2], frames, n * 4);
+		frames += n * 2;
+		count -= n;
+		position += n;
+	}
+
+	// the frames are in before the mixer can see them
+	SDL_AtomicSet(&write_position, position);
+}
+
+int32 Music::Ring::Peek(const int16 **frames, int32 max)
+{
+	uint32 position = SDL_AtomicGet(&read_position);
+	int32 available = static_cast<int32>(static_cast<uint32>(SDL_AtomicGet(&write_position)) - position);
+	int32 offset = position & (kFrames - 1);
+
+	*frames = &buffer[offset * 2];
+	return std::min(std::min(available, max), kFrames - offset);
+}
+
+void Music::Ring::Consume(int32 count)
+{
+	SDL_AtomicAdd(&read_position, count);
 }
 
 void Music::LoadLevelMusic()
@@ -271,6 +701,14 @@ void Music::StopLevelMusic()
 	music_level = false;
 	music_play = false;
 	Close();
+
+	static uint32 logged_underruns = 0;
+	uint32 count = Underruns();
+	if (count != logged_underruns)
+	{
+		logWarning("music decoding fell behind the mixer %u times", count - logged_underruns);
+		logged_underruns = count;
+	}
 }
 
 FileSpecifier* Music::GetLevelMusic()
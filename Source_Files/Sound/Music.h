@@ -22,6 +22,11 @@
 
 	Handles both intro and level music
 
+Oct 17, 2026:
+	Songs are decoded on a thread of their own, into a ring buffer that the mixer's
+	callback takes them from; level songs follow each other without a gap, crossfading
+	when the next one is a different song
+
 */
 
 #include "cseries.h"
@@ -31,6 +36,10 @@
 #include "SoundManager.h"
 #include <vector>
 
+#include <SDL_atomic.h>
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
+
 class Music
 {
 public:
@@ -52,6 +61,11 @@ public:
 	bool Playing();
 	void Rewind();
 	void Restart();
+
+	// stops the decoding thread, at exit
+	void Shutdown();
+
+	// hands the mixer the next stretch of decoded music; called from the mixer's callback
 	bool FillBuffer();
 
 	void Idle();
@@ -70,6 +84,9 @@ public:
 
 	void CheckVolume();
 
+	// times the mixer wanted music that hadn't been decoded yet, and played silence
+	uint32 Underruns() { return SDL_AtomicGet(&underruns); }
+
 private:
 	Music();
 	bool Load(FileSpecifier &file);
@@ -79,20 +96,89 @@ private:
 
 	int16 GetVolumeLevel() { return SoundManager::instance()->parameters.music; }
 
-	static const int MUSIC_BUFFER_SIZE = 1024;
-
-	std::vector<uint8> music_buffer;
-	StreamDecoder *decoder;
-
-	SDL_RWops* music_rw;
-
-	// info about the music's format
-	bool sixteen_bit;
-	bool stereo;
-	bool signed_8bit;
-	int bytes_per_frame;
-	_fixed rate;
-	bool little_endian;
+	// a song being decoded, turned into native-endian 16-bit stereo at the mixer's rate
+	struct Track {
+		StreamDecoder *decoder;
+		FileSpecifier file;
+
+		// info about the song's format
+		bool sixteen_bit;
+		bool stereo;
+		bool signed_8bit;
+		int bytes_per_frame;
+		bool little_endian;
+
+		_fixed rate;			// song frames per output frame
+		_fixed counter;
+		std::vector<int16> frames;	// decoded, interleaved
+		int32 position;			// first of frames still needed
+		bool ended;
+
+		Track() : decoder(0), rate(FIXED_ONE), counter(0), position(0), ended(true) { }
+		bool Load(FileSpecifier &file);
+		void Rewind();
+		void Close();
+
+		// output frames, fewer than count only once the song is over
+		int32 Render(int16 *out, int32 count);
+
+	private:
+		bool Decode();
+	};
+
+	// decoded music, written by the decoding thread and read by the mixer's callback
+	// without either waiting for the other
+	class Ring {
+	public:
+		Ring();
+
+		// neither side may be using the ring
+		void Reset();
+
+		int32 Free();
+		void Write(const int16 *frames, int32 count);
+
+		// a stretch of up to max frames, left in the ring until Consume()
+		int32 Peek(const int16 **frames, int32 max);
+		void Consume(int32 count);
+
+	private:
+		static const int32 kFrames = 128 * 1024;	// a power of two
+		std::vector<int16> buffer;
+		SDL_atomic_t read_position;
+		SDL_atomic_t write_position;
+	};
+
+	bool ShouldDecode();
+	void WaitForDecoder();
+	void DecodeChunk(bool let_go);
+	bool StartNextTrack(bool queued, FileSpecifier &next);
+	void Flush();
+	static int Run(void *);
+
+	static const int32 kChunkFrames = 2048;		// decoded at a time
+	static const int32 kHandOutFrames = 1024;	// handed to the mixer at a time
+	static const int kCrossfadeMilliseconds = 1000;
+
+	Track track;
+	Ring ring;
+	int32 handed_out;			// frames the mixer is playing out of the ring
+
+	std::vector<int16> held_back;		// the latest frames of track, kept out of the ring
+	int32 crossfade_frames;			// while a different song is to follow it
+	FileSpecifier next_file;		// the level song to follow track
+	bool next_queued;
+	bool streaming;				// the thread is to keep the ring filled
+	bool decoding;				// track is being decoded with the mutex let go of
+	bool quit;
+	SDL_atomic_t stream_ended;		// nothing more will go into the ring
+	SDL_atomic_t underruns;
+
+	// thread fun
+	SDL_Thread *thread;
+	SDL_mutex *mutex;
+	SDL_cond *cond;				// wakes the decoding thread
+	SDL_cond *decoded_cond;			// signalled when decoding stops
 
 	FileSpecifier music_file;
 	FileSpecifier music_intro_file;
@@ -33,6 +33,7 @@
 #include "InfoTree.h"
 #include "XML_ParseTreeRoot.h"
 #include "Scenario.h"
+#include "StartupCache.h"
 
 #ifdef HAVE_ZZIP
 #include <zzip/lib.h>
@@ -237,15 +238,23 @@ static bool plugin_file_exists(const Plugin& Data, std::string Path)
 
 bool PluginLoader::ParsePlugin(FileSpecifier& file_name)
 {
+	// an unchanged Plugin.xml comes out of the startup cache without being opened
+	StartupCache *cache = StartupCache::instance();
+	InfoTree tree;
+	bool cached = cache->Find(file_name, "xml", tree);
+
 	OpenedFile file;
-	if (file_name.Open(file)) 
+	if (cached || file_name.Open(file)) 
 	{
-		int32 data_size;
-		file.GetLength(data_size);
+		int32 data_size = 0;
 		std::vector<char> file_data;
-		file_data.resize(data_size);
+		if (!cached)
+		{
+			file.GetLength(data_size);
+			file_data.resize(data_size);
+		}
 
-		if (file.Read(data_size, &file_data[0]))
+		if (cached || file.Read(data_size, &file_data[0]))
 		{
 			DirectorySpecifier current_plugin_directory;
 			file_name.ToDirectory(current_plugin_directory);
@@ -253,9 +262,14 @@ bool PluginLoader::ParsePlugin(FileSpecifier& file_name)
 			char name[256];
 			current_plugin_directory.GetName(name);
 			
-			std::istringstream strm(std::string(file_data.begin(), file_data.end()));
 			try {
-				InfoTree root = InfoTree::load_xml(strm).get_child("plugin");
+				if (!cached)
+				{
+					std::istringstream strm(std::string(file_data.begin(), file_data.end()));
+					tree = InfoTree::load_xml(strm);
+					cache->Store(file_name, "xml", tree);
+				}
+				InfoTree root = tree.get_child("plugin");
 				
 				Plugin Data = Plugin();
 				Data.directory = current_plugin_directory;
@@ -363,21 +377,32 @@ bool PluginLoader::ParseDirectory(FileSpecifier& dir)
 #ifdef HAVE_ZZIP
 		else if (algo::ends_with(it->name, ".zip") || algo::ends_with(it->name, ".ZIP"))
 		{
-			// search it for a Plugin.xml file
-			ZZIP_DIR* zzipdir = zzip_dir_open(file.GetPath(), 0);
-			if (zzipdir)
+			// search it for a Plugin.xml file, unless the startup cache
+			// remembers where they are from the last time
+			InfoTree listing;
+			if (!StartupCache::instance()->Find(file, "plugins", listing))
 			{
-				ZZIP_DIRENT dirent;
-				while (zzip_dir_read(zzipdir, &dirent))
+				ZZIP_DIR* zzipdir = zzip_dir_open(file.GetPath(), 0);
+				if (zzipdir)
 				{
-					if (strcmp(dirent.d_name, "Plugin.xml") == 0 || algo::ends_with(dirent.d_name, "/Plugin.xml"))
+					ZZIP_DIRENT dirent;
+					while (zzip_dir_read(zzipdir, &dirent))
 					{
-						std::string archive = file.GetPath();
-						FileSpecifier file_name = FileSpecifier(archive.substr(0, archive.find_last_of('.'))) + dirent.d_name;
-						ParsePlugin(file_name);
+						if (strcmp(dirent.d_name, "Plugin.xml") == 0 || algo::ends_with(dirent.d_name, "/Plugin.xml"))
+						{
+							listing.push_back(std::make_pair("plugin", InfoTree(std::string(dirent.d_name))));
+						}
 					}
+					zzip_dir_close(zzipdir);
+					StartupCache::instance()->Store(file, "plugins", listing);
 				}
-				zzip_dir_close(zzipdir);
+			}
+
+			BOOST_FOREACH(InfoTree entry, listing.children_named("plugin"))
+			{
+				std::string archive = file.GetPath();
+				FileSpecifier file_name = FileSpecifier(archive.substr(0, archive.find_last_of('.'))) + entry.data();
+				ParsePlugin(file_name);
 			}
 		}
 #endif
@@ -27,6 +27,7 @@
 #include <sstream>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/bind.hpp>
 
 #ifdef HAVE_SDL_IMAGE
 #include <SDL_image.h>
@@ -54,6 +55,7 @@
 #include "sdl_resize.h"
 #include "SDL_rwops_ostream.h"
 #include "WadImageCache.h"
+#include "SaveGameWriter.h"
 #include "InfoTree.h"
 
 namespace algo = boost::algorithm;
@@ -417,6 +419,7 @@ size_t saved_game_was_networked(FileSpecifier& saved_game)
 
 bool load_quick_save_dialog(FileSpecifier& saved_game)
 {
+    SaveGameWriter::instance()->Finish();
     QuickSaves::instance()->enumerate();
 
     dialog d;
@@ -499,12 +502,13 @@ bool load_quick_save_dialog(FileSpecifier& saved_game)
 extern SDL_Surface *draw_surface;
 extern bool OGL_MapActive;
 
-static bool build_map_preview(std::ostringstream& ostream)
+// renders on the main thread; encode_map_preview() runs on the save writer's thread
+static SDL_Surface *build_map_preview()
 {
     SDL_Rect r = {0, 0, RENDER_WIDTH, RENDER_HEIGHT};
     SDL_Surface *surface = SDL_CreateRGBSurface(SDL_SWSURFACE, r.w, r.h, 32, 0xff0000, 0x00ff00, 0x0000ff, 0);
     if (!surface)
-        return false;
+        return NULL;
 	
     SDL_FillRect(surface, &r, SDL_MapRGB(surface->format, 0, 0, 0));
 	
@@ -525,19 +529,36 @@ static bool build_map_preview(std::ostringstream& ostream)
     _render_overhead_map(&overhead_data);
     OGL_MapActive = old_OGL_MapActive;
     _restore_port();
-	
+
+    return surface;
+}
+
+static std::string encode_map_preview(boost::shared_ptr<SDL_Surface> surface)
+{
+    std::ostringstream ostream;
     SDL_RWops *rwops = SDL_RWFromOStream(ostream);
 //#if defined(HAVE_PNG) && defined(HAVE_SDL_IMAGE)
 //    int ret = aoIMG_SavePNG_RW(rwops, surface, IMG_COMPRESS_DEFAULT, NULL, 0);
 #ifdef HAVE_SDL_IMAGE
-	int ret = IMG_SavePNG_RW(surface, rwops, 0);
+	int ret = IMG_SavePNG_RW(surface.get(), rwops, 0);
 #else
-    int ret = SDL_SaveBMP_RW(surface, rwops, false);
+    int ret = SDL_SaveBMP_RW(surface.get(), rwops, false);
 #endif
-    SDL_FreeSurface(surface);
     SDL_RWclose(rwops);
 	
-    return (ret == 0);
+    return (ret == 0) ? ostream.str() : std::string();
+}
+
+static void quick_save_written(FileSpecifier&)
+{
+    QuickSaves::instance()->delete_surplus_saves(environment_preferences->maximum_quick_saves);
+    screen_printf("Game saved");
+}
+
+static void quick_save_failed(FileSpecifier&, int err)
+{
+    alert_user(infoError, strERRORS, fileError, err);
+    screen_printf("Save failed");
 }
 
 std::string build_save_metadata(QuickSave& save)
@@ -687,13 +708,14 @@ bool create_quick_save(void)
     save.save_file.AddPart(base + ".sgaA");
 	
     std::string metadata = build_save_metadata(save);
-    std::ostringstream image_stream;
-    bool success = build_map_preview(image_stream);
-    success = save_game_file(save.save_file, metadata, image_stream.str());
-    
-    if (success)
-        QuickSaves::instance()->delete_surplus_saves(environment_preferences->maximum_quick_saves);
-    return success;
+    SaveGameWriter::ImageBuilder build_image;
+    SDL_Surface *preview = build_map_preview();
+    if (preview)
+        build_image = boost::bind(encode_map_preview, boost::shared_ptr<SDL_Surface>(preview, SDL_FreeSurface));
+
+    // the file is written (and the surplus saves pruned) in the background; a failure
+    // after this point is reported by quick_save_failed()
+    return SaveGameWriter::instance()->Save(save.save_file, metadata, build_image, quick_save_written, quick_save_failed);
 }
 
 bool delete_quick_save(QuickSave& save)
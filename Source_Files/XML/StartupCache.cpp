@@ -0,0 +1,293 @@
+/*
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+
+	Startup cache of parsed XML trees
+*/
+
+#include "cseries.h"
+#include "StartupCache.h"
+#include "Logging.h"
+
+#include <sys/stat.h>
+
+// the file starts with these, then holds one record per entry: the entry's name, the
+// file's date and size, and the encoded tree; lengths and numbers are varints
+static const uint32 kStartupCacheMagic = FOUR_CHARS_TO_INT('A', '1', 'S', 'C');
+static const uint32 kStartupCacheVersion = 1;
+
+// deeper than any sane XML file; keeps a corrupt cache from recursing forever
+static const int kMaximumTreeDepth = 256;
+
+static FileSpecifier startup_cache_file()
+{
+	FileSpecifier file;
+	file.SetToLocalDataDir();
+	file.AddPart("Startup Cache");
+	return file;
+}
+
+// the date and size of path, or of the zip archive it is inside (which FileSpecifier
+// names as though the archive were a directory); false if there is neither
+static bool get_file_stamp(std::string path, int64& date, int64& size)
+{
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0)
+	{
+		bool found = false;
+		std::string::size_type pos;
+		while (!found && (pos = path.find_last_of("/\\")) != std::string::npos && pos > 0)
+		{
+			path.erase(pos);
+			found = stat((path + ".zip").c_str(), &st) == 0 || stat((path + ".ZIP").c_str(), &st) == 0;
+		}
+		if (!found)
+			return false;
+	}
+
+	date = st.st_mtime;
+	size = st.st_size;
+	return true;
+}
+
+static void put_number(std::string& out, uint64 n)
+{
+	while (n >= 0x80)
+	{
+		out += static_cast<char>((n & 0x7f) | 0x80);
+		n >>= 7;
+	}
+	out += static_cast<char>(n);
+}
+
+static void put_string(std::string& out, const std::string& s)
+{
+	put_number(out, s.size());
+	out += s;
+}
+
+static void encode_tree(std::string& out, const boost::property_tree::ptree& tree)
+{
+	put_string(out, tree.data());
+	put_number(out, tree.size());
+	for (boost::property_tree::ptree::const_iterator it = tree.begin(); it != tree.end(); ++it)
+	{
+		put_string(out, it->first);
+		encode_tree(out, it->second);
+	}
+}
+
+static bool get_number(const char *&p, const char *end, uint64& n)
+{
+	n = 0;
+	for (int shift = 0; p < end && shift < 64; shift += 7)
+	{
+		uint8 c = static_cast<uint8>(*p++);
+		n |= static_cast<uint64>(c & 0x7f) << shift;
+		if (!(c & 0x80))
+			return true;
+	}
+	return false;
+}
+
+static bool get_string(const char *&p, const char *end, std::string& s)
+{
+	uint64 length;
+	if (!get_number(p, end, length) || length > static_cast<uint64>(end - p))
+		return false;
+
+	s.assign(p, static_cast<size_t>(length));
+	p += length;
+	return true;
+}
+
+static bool decode_tree(const char *&p, const char *end, boost::property_tree::ptree& tree, int depth)
+{
+	uint64 count;
+	if (depth > kMaximumTreeDepth || !get_string(p, end, tree.data()) || !get_number(p, end, count))
+		return false;
+
+	for (uint64 i = 0; i < count; ++i)
+	{
+		std::string key;
+		if (!get_string(p, end, key))
+			return false;
+
+		// filled in place, rather than copied in after
+		boost::property_tree::ptree::iterator child = tree.push_back(std::make_pair(key, boost::property_tree::ptree()));
+		if (!decode_tree(p, end, child->second, depth + 1))
+			return false;
+	}
+	return true;
+}
+
+StartupCache* StartupCache::instance()
+{
+	static StartupCache *instance_ = nullptr;
+	if (!instance_)
+		instance_ = new StartupCache();
+	return instance_;
+}
+
+void StartupCache::Load()
+{
+	loaded_ = true;
+
+	FileSpecifier File = startup_cache_file();
+	OpenedFile file;
+	int32 length;
+	if (!File.Open(file) || !file.GetLength(length) || length < 8)
+		return;
+
+	std::vector<char> data(length);
+	if (!file.Read(length, &data[0]))
+		return;
+
+	uint32 magic = SDL_SwapBE32(*reinterpret_cast<uint32 *>(&data[0]));
+	uint32 version = SDL_SwapBE32(*reinterpret_cast<uint32 *>(&data[4]));
+	if (magic != kStartupCacheMagic || version != kStartupCacheVersion)
+		return;
+
+	const char *p = &data[8];
+	const char *end = &data[0] + length;
+	while (p < end)
+	{
+		std::string name;
+		uint64 date, size;
+		Entry entry;
+		if (!get_string(p, end, name) || !get_number(p, end, date) || !get_number(p, end, size) || !get_string(p, end, entry.tree))
+		{
+			// a damaged cache is only a slow start
+			logWarning("startup cache is damaged; ignoring the rest of it");
+			break;
+		}
+
+		entry.date = static_cast<int64>(date);
+		entry.size = static_cast<int64>(size);
+		entry.used = false;
+		entries_[name] = entry;
+	}
+}
+
+StartupCache::Entry *StartupCache::FindEntry(const std::string& path, const std::string& key, int64& date, int64& size)
+{
+	if (!loaded_)
+		Load();
+
+	if (!get_file_stamp(path, date, size))
+		return NULL;
+
+	std::map<std::string, Entry>::iterator it = entries_.find(path + '|' + key);
+	if (it == entries_.end() || it->second.date != date || it->second.size != size)
+		return NULL;
+
+	return &it->second;
+}
+
+bool StartupCache::Find(const FileSpecifier& File, const std::string& key, InfoTree& tree)
+{
+	int64 date, size;
+	Entry *entry = FindEntry(File.GetPath(), key, date, size);
+	if (entry)
+	{
+		InfoTree cached;
+		const char *p = entry->tree.data();
+		if (decode_tree(p, p + entry->tree.size(), cached, 0))
+		{
+			entry->used = true;
+			tree.swap(cached);
+			++hits_;
+			return true;
+		}
+	}
+
+	++misses_;
+	return false;
+}
+
+void StartupCache::Store(const FileSpecifier& File, const std::string& key, const InfoTree& tree)
+{
+	if (!loaded_)
+		Load();
+
+	Entry entry;
+	if (!get_file_stamp(File.GetPath(), entry.date, entry.size))
+		return;
+
+	encode_tree(entry.tree, tree);
+	entry.used = true;
+	entries_[std::string(File.GetPath()) + '|' + key] = entry;
+	dirty_ = true;
+}
+
+InfoTree StartupCache::LoadXML(const FileSpecifier& File)
+{
+	InfoTree tree;
+	if (!Find(File, "xml", tree))
+	{
+		tree = InfoTree::load_xml(File);
+		Store(File, "xml", tree);
+	}
+	return tree;
+}
+
+void StartupCache::Save()
+{
+	// forget files that have gone away or changed, unless something was read from them
+	// this launch
+	for (std::map<std::string, Entry>::iterator it = entries_.begin(); it != entries_.end(); )
+	{
+		int64 date, size;
+		std::string path = it->first.substr(0, it->first.find_last_of('|'));
+		if (!it->second.used && (!get_file_stamp(path, date, size) || date != it->second.date || size != it->second.size))
+		{
+			entries_.erase(it++);
+			dirty_ = true;
+		}
+		else
+			++it;
+	}
+
+	if (!dirty_)
+		return;
+
+	std::string data;
+	uint32 header[2] = { SDL_SwapBE32(kStartupCacheMagic), SDL_SwapBE32(kStartupCacheVersion) };
+	data.append(reinterpret_cast<char *>(header), sizeof(header));
+	for (std::map<std::string, Entry>::iterator it = entries_.begin(); it != entries_.end(); ++it)
+	{
+		put_string(data, it->first);
+		put_number(data, static_cast<uint64>(it->second.date));
+		put_number(data, static_cast<uint64>(it->second.size));
+		put_string(data, it->second.tree);
+	}
+
+	FileSpecifier File = startup_cache_file();
+	FileSpecifier TempFile;
+	TempFile.SetTempName(File);
+
+	bool written;
+	{
+		OpenedFile file;
+		written = TempFile.Open(file, true) && file.Write(static_cast<int32>(data.size()), &data[0]);
+	}
+
+	if (written && TempFile.Rename(File))
+		dirty_ = false;
+	else
+		TempFile.Delete();
+}
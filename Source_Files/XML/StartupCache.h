@@ -0,0 +1,71 @@
+#ifndef _STARTUP_CACHE_
+#define _STARTUP_CACHE_
+
+/*
+
+	Copyright (C) 2026 and beyond by the "Aleph One" developers.
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	This license is contained in the file "COPYING",
+	which is included with this source code; it is available online at
+	http://www.gnu.org/licenses/gpl.html
+
+	Keeps the parsed trees of Plugin.xml and MML files (and the listings of plugin
+	archives) from one launch to the next, in a compact binary form, so that only files
+	that have changed since have to be parsed again. Entries are keyed by path, and
+	thrown away when the file's size or modification date changes.
+*/
+
+#include "InfoTree.h"
+
+#include <map>
+#include <string>
+
+class StartupCache
+{
+public:
+	static StartupCache* instance();
+
+	// the XML tree of File; from the cache when File hasn't changed since it was parsed,
+	// otherwise from InfoTree::load_xml() (which throws the same errors as ever)
+	InfoTree LoadXML(const FileSpecifier& File);
+
+	// any other tree worked out from File, stored under File's path and key
+	bool Find(const FileSpecifier& File, const std::string& key, InfoTree& tree);
+	void Store(const FileSpecifier& File, const std::string& key, const InfoTree& tree);
+
+	// writes the cache out, if anything has changed; the local data directory must exist
+	void Save();
+
+	void GetStats(uint32& hits, uint32& misses) { hits = hits_; misses = misses_; }
+
+private:
+	StartupCache() : loaded_(false), dirty_(false), hits_(0), misses_(0) { }
+
+	struct Entry {
+		int64 date;
+		int64 size;
+		std::string tree;	// encoded
+		bool used;
+	};
+
+	void Load();
+	Entry *FindEntry(const std::string& path, const std::string& key, int64& date, int64& size);
+
+	std::map<std::string, Entry> entries_;
+	bool loaded_;
+	bool dirty_;
+	uint32 hits_;
+	uint32 misses_;
+};
+
+#endif
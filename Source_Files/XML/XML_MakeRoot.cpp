@@ -56,6 +56,7 @@
 #include "Console.h"
 #include "XML_LevelScript.h"
 #include "InfoTree.h"
+#include "StartupCache.h"
 
 // This will reset all values changed by MML scripts which implement ResetValues() method
 // and are part of the master MarathonParser tree.
@@ -164,7 +165,7 @@ bool ParseMMLFromFile(const FileSpecifier& FileSpec)
 {
 	bool parse_error = false;
 	try {
-		InfoTree fileroot = InfoTree::load_xml(FileSpec);
+		InfoTree fileroot = StartupCache::instance()->LoadXML(FileSpec);
 		_ParseAllMML(fileroot);
 	} catch (InfoTree::parse_error ex) {
 		logError("Error parsing MML file (%s): %s", FileSpec.GetPath(), ex.what());
@@ -117,6 +117,10 @@
 #include "Movie.h"
 #include "HTTP.h"
 #include "WadImageCache.h"
+#include "SaveGameWriter.h"
+#include "StartupCache.h"
+#include "network_dedicated_hub.h"
+#include "network_star_loopback.h"
 
 #ifdef __WIN32__
 #define WIN32_LEAN_AND_MEAN
@@ -152,6 +156,18 @@ bool option_nojoystick = false;
 bool insecure_lua = false;
 static bool force_fullscreen = false; // Force fullscreen mode
 static bool force_windowed = false;   // Force windowed mode
+static bool option_benchmark = false; // Replay a film headless, report timings and quit
+#ifdef A1_DEDICATED_HUB
+static bool option_hub = true;        // Host netgames headless, without playing in them
+#else
+static bool option_hub = false;
+#endif
+static bool option_loopback = false;  // Run the star hub over a simulated network and report
+static bool option_headless = false;  // No window: set by --benchmark, --hub and --loopback
+#if !defined(DISABLE_NETWORKING)
+static dedicated_hub_options hub_options;
+static std::string loopback_settings;
+#endif
 
 // Prototypes
 static void main_event_loop(void);
@@ -196,6 +212,26 @@ static void usage(const char *prg_name)
 	  "\t[-s | --nosound]       Do not access the sound card\n"
 	  "\t[-m | --nogamma]       Disable gamma table effects (menu fades)\n"
           "\t[-j | --nojoystick]    Do not initialize joysticks\n"
+	  "\t[-b | --benchmark]     Replay the film given on the command line as fast\n"
+	  "\t                       as possible, with no window or sound, then print\n"
+	  "\t                       timings and a world checksum and quit\n"
+#if !defined(DISABLE_NETWORKING)
+	  "\t[--hub]                Host netgames with no window or sound, without\n"
+	  "\t                       playing in them, using the network game settings\n"
+	  "\t                       from the preferences; file is the map to host\n"
+	  "\t  [--port n]           Port to host on\n"
+	  "\t  [--level n]          Level to host\n"
+	  "\t  [--players n]        Start once this many players have joined...\n"
+	  "\t  [--wait n]           ...or n seconds after the first one did\n"
+	  "\t  [--games n]          Quit after hosting this many games\n"
+	  "\t  [--report n]         Report latencies every n seconds\n"
+	  "\t  [--name name]        The host's name, as joiners see it\n"
+	  "\t[--loopback [settings]] Play a netgame between the star hub and spokes over\n"
+	  "\t                       a simulated network (no game data needed), and\n"
+	  "\t                       report how it went; settings are like players=4,\n"
+	  "\t                       latency=60,jitter=10,loss=1,reorder=1,seconds=30\n"
+	  "\t                       (see network_star_loopback.h for the rest)\n"
+#endif
 	  // Documenting this might be a bad idea?
 	  // "\t[-i | --insecure_lua]  Allow Lua netscripts to take over your computer\n"
 	  "\tdirectory              Directory containing scenario data files\n"
@@ -212,6 +248,7 @@ static void usage(const char *prg_name)
 }
 
 extern bool handle_open_replay(FileSpecifier& File);
+extern bool benchmark_replay(FileSpecifier& File);
 extern bool load_and_start_game(FileSpecifier& file);
 
 bool handle_open_document(const std::string& filename)
@@ -310,6 +347,33 @@ int main(int argc, char **argv)
 			insecure_lua = true;
 		} else if (strcmp(*argv, "-d") == 0 || strcmp(*argv, "--debug") == 0) {
 		  option_debug = true;
+		} else if (strcmp(*argv, "-b") == 0 || strcmp(*argv, "--benchmark") == 0) {
+			option_benchmark = true;
+			option_nosound = true;
+			option_nojoystick = true;
+#if !defined(DISABLE_NETWORKING)
+		} else if (strcmp(*argv, "--hub") == 0) {
+			option_hub = true;
+		} else if (strcmp(*argv, "--loopback") == 0) {
+			option_loopback = true;
+			if (argc > 1 && argv[1][0] != '-') {
+				loopback_settings = *++argv; argc--;
+			}
+		} else if (argc > 1 && strcmp(*argv, "--port") == 0) {
+			hub_options.port = atoi(*++argv); argc--;
+		} else if (argc > 1 && strcmp(*argv, "--level") == 0) {
+			hub_options.level = atoi(*++argv); argc--;
+		} else if (argc > 1 && strcmp(*argv, "--players") == 0) {
+			hub_options.players = atoi(*++argv); argc--;
+		} else if (argc > 1 && strcmp(*argv, "--wait") == 0) {
+			hub_options.wait = atoi(*++argv); argc--;
+		} else if (argc > 1 && strcmp(*argv, "--games") == 0) {
+			hub_options.games = atoi(*++argv); argc--;
+		} else if (argc > 1 && strcmp(*argv, "--report") == 0) {
+			hub_options.report_period = atoi(*++argv); argc--;
+		} else if (argc > 1 && strcmp(*argv, "--name") == 0) {
+			hub_options.name = *++argv; argc--;
+#endif
 		} else if (*argv[0] != '-') {
 			// if it's a directory, make it the default data dir
 			// otherwise push it and handle it later
@@ -330,11 +394,57 @@ int main(int argc, char **argv)
 		argv++;
 	}
 
+	if (option_hub || option_loopback)
+	{
+		option_nosound = true;
+		option_nojoystick = true;
+	}
+	option_headless = option_benchmark || option_hub || option_loopback;
+
 	try {
 		
 		// Initialize everything
 		initialize_application();
 
+		if (option_benchmark)
+		{
+			// scenario files first, so the film can find its map
+			std::vector<std::string> films;
+			for (std::vector<std::string>::iterator it = arg_files.begin(); it != arg_files.end(); ++it)
+			{
+				FileSpecifier file(*it);
+				if (file.GetType() == _typecode_film)
+					films.push_back(*it);
+				else
+					handle_open_document(*it);
+			}
+
+			if (films.empty())
+			{
+				fprintf(stderr, "--benchmark needs a film to replay\n");
+				exit(1);
+			}
+
+			bool success = true;
+			for (std::vector<std::string>::iterator it = films.begin(); it != films.end(); ++it)
+			{
+				FileSpecifier film(*it);
+				success = benchmark_replay(film) && success;
+			}
+			exit(success ? 0 : 1);
+		}
+
+#if !defined(DISABLE_NETWORKING)
+		if (option_hub)
+		{
+			// the map to host, if not the one from the preferences
+			for (std::vector<std::string>::iterator it = arg_files.begin(); it != arg_files.end(); ++it)
+				handle_open_document(*it);
+
+			exit(run_dedicated_hub(hub_options));
+		}
+#endif
+
 		for (std::vector<std::string>::iterator it = arg_files.begin(); it != arg_files.end(); ++it)
 		{
 			if (handle_open_document(*it))
@@ -374,6 +484,15 @@ static int char_is_not_filesafe(int c)
     return (c != ' ' && !std::isalnum(c));
 }
 
+// the time since ticks, which becomes now; for timing the phases of startup
+static uint32 startup_phase_ticks(uint32& ticks)
+{
+	uint32 now = machine_tick_count();
+	uint32 elapsed = now - ticks;
+	ticks = now;
+	return elapsed;
+}
+
 static void initialize_application(void)
 {
 #if defined(__WIN32__) && defined(__MINGW32__)
@@ -385,7 +504,7 @@ static void initialize_application(void)
 #endif
 
 	// Initialize SDL
-	int retval = SDL_Init(SDL_INIT_VIDEO |
+	int retval = SDL_Init((option_headless ? 0 : SDL_INIT_VIDEO) |
 						  (option_nosound ? 0 : SDL_INIT_AUDIO) |
 						  (option_nojoystick ? 0 : SDL_INIT_JOYSTICK|SDL_INIT_GAMECONTROLLER) |
 						  (option_debug ? SDL_INIT_NOPARACHUTE : 0));
@@ -403,9 +522,12 @@ static void initialize_application(void)
 #endif
 	// We only want text input events at specific times
 	SDL_StopTextInput();
+
+	uint32 startup_ticks = machine_tick_count();
+	uint32 ticks = startup_ticks;
 	
 	// See if we had a scenario folder dropped on us
-	if (arg_directory == "") {
+	if (arg_directory == "" && !option_headless) {
 		SDL_EventState(SDL_DROPFILE, SDL_ENABLE);
 		SDL_Event event;
 		while (SDL_PollEvent(&event)) {
@@ -488,6 +610,16 @@ static void initialize_application(void)
 		data_search_path.push_back(local_data_dir);
 	}
 
+#if !defined(DISABLE_NETWORKING)
+	// the loopback harness needs no game data and none of the game's subsystems, so
+	// that it can run where there are none
+	if (option_loopback)
+	{
+		mytm_initialize();
+		exit(run_star_loopback(loopback_settings));
+	}
+#endif
+
 	// Setup resource manager
 	initialize_resources();
 
@@ -495,9 +627,11 @@ static void initialize_application(void)
 	initialize_fonts(false);
 
 	load_film_profile(FILM_PROFILE_DEFAULT, false);
+	uint32 setup_ticks = startup_phase_ticks(ticks);
 
 	// Parse MML files
 	LoadBaseMMLScripts();
+	uint32 base_mml_ticks = startup_phase_ticks(ticks);
 
 	// Check for presence of strings
 	if (!TS_IsPresent(strERRORS) || !TS_IsPresent(strFILENAMES)) {
@@ -506,6 +640,10 @@ static void initialize_application(void)
 	}
 	
 	// Check for presence of files (one last chance to change data_search_path)
+	if (!have_default_files() && option_headless) {
+		fprintf(stderr, "Can't find required data files for %s.\n", option_hub ? "--hub" : "--benchmark");
+		exit(1);
+	}
 	if (!have_default_files()) {
 		char chosen_dir[256];
 		if (alert_choose_scenario(chosen_dir)) {
@@ -521,10 +659,12 @@ static void initialize_application(void)
 			initialize_fonts(false);
 			LoadBaseMMLScripts();
 		}
+		ticks = machine_tick_count();
 	}
 
 	initialize_fonts(true);
 	Plugins::instance()->enumerate();			
+	uint32 plugin_ticks = startup_phase_ticks(ticks);
 	
 	preferences_dir.CreateDirectory();
 	if (!get_data_path(kPathLegacyPreferences).empty())
@@ -560,7 +700,17 @@ static void initialize_application(void)
 		graphics_preferences->screen_mode.fullscreen = false;
 	write_preferences();
 
+	// the benchmark and the hub never draw, so don't make them load textures for OpenGL
+	// (after write_preferences() so the user's setting is kept)
+	if (option_headless)
+		graphics_preferences->screen_mode.acceleration = _no_acceleration;
+	uint32 preferences_ticks = startup_phase_ticks(ticks);
+
 	Plugins::instance()->load_mml();
+	uint32 plugin_mml_ticks = startup_phase_ticks(ticks);
+
+	// whatever had to be parsed this time won't have to be next time
+	StartupCache::instance()->Save();
 
 //	SDL_WM_SetCaption(application_name, application_name);
 
@@ -589,18 +739,32 @@ static void initialize_application(void)
 	SoundManager::instance()->Initialize(*sound_preferences);
 	initialize_marathon_music_handler();
 	initialize_keyboard_controller();
-	initialize_joystick();
-	initialize_gamma();
-	alephone::Screen::instance()->Initialize(&graphics_preferences->screen_mode);
+	if (!option_headless)
+	{
+		initialize_joystick();
+		initialize_gamma();
+		alephone::Screen::instance()->Initialize(&graphics_preferences->screen_mode);
+	}
 	initialize_marathon();
-	initialize_screen_drawing();
-	initialize_dialogs();
+	if (!option_headless)
+	{
+		initialize_screen_drawing();
+		initialize_dialogs();
+	}
 	initialize_terminal_manager();
 	initialize_shape_handler();
 	initialize_fades();
 	initialize_images_manager();
 	load_environment_from_preferences();
-	initialize_game_state();
+	uint32 subsystem_ticks = startup_phase_ticks(ticks);
+
+	uint32 cache_hits, cache_misses;
+	StartupCache::instance()->GetStats(cache_hits, cache_misses);
+	logNote("startup: setup %u ms, base MML %u ms, plugins %u ms, preferences %u ms, plugin MML %u ms, subsystems %u ms; %u ms in all", setup_ticks, base_mml_ticks, plugin_ticks, preferences_ticks, plugin_mml_ticks, subsystem_ticks, machine_tick_count() - startup_ticks);
+	logNote("startup cache: %u files parsed, %u read from the cache", cache_misses, cache_hits);
+
+	if (!option_headless)
+		initialize_game_state();
 }
 
 void shutdown_application(void)
@@ -612,7 +776,10 @@ void shutdown_application(void)
 
         already_shutting_down = true;
         
+	SaveGameWriter::instance()->Shutdown();
+	Music::instance()->Shutdown();
 	WadImageCache::instance()->save_cache();
+	StartupCache::instance()->Save();
 	close_external_resources();
         
 #if defined(HAVE_SDL_IMAGE) && (SDL_IMAGE_PATCHLEVEL >= 8)
@@ -46,6 +46,7 @@ bool chat_input_mode = false;
 #include "network_sound.h"
 #include "TextStrings.h"
 #include "InfoTree.h"
+#include "SaveGameWriter.h"
 
 #include <ctype.h>
 
@@ -302,6 +303,7 @@ void global_idle_proc(void)
 	network_speaker_idle_proc();
 	network_microphone_idle_proc();
 	SoundManager::instance()->Idle();
+	SaveGameWriter::instance()->Idle();
 }
 
 /*
@@ -0,0 +1,68 @@
+-- Field_Benchmark.lua
+--
+-- Measures how long scripts spend reading and writing object fields,
+-- e.g. Players[i].x or monster.vitality. Select it as the solo script
+-- in environment preferences and start a level with some monsters.
+--
+-- Every tick, idle reads a handful of player and monster fields, writes
+-- each player's life back unchanged and sets a custom field on everything,
+-- REPEAT times over. Every five seconds it
+-- prints the number of field accesses per tick and the average time
+-- they took.
+--
+-- Timing uses os.clock, so run Aleph One with --insecure_lua; without
+-- it only the access counts are printed, and you can compare frame
+-- rates instead.
+
+REPEAT = 200
+REPORT_TICKS = 150
+
+local clock = os and os.clock
+local elapsed = 0
+local accesses = 0
+local ticks = 0
+
+local function exercise()
+   local n = 0
+   for p in Players() do
+      local x, y, z = p.x, p.y, p.z
+      local life, oxygen = p.life, p.oxygen
+      p.life = life
+      p._benchmark = x + y + z
+      n = n + 7
+   end
+   for m in Monsters() do
+      local v = m.vitality
+      local x, y, z = m.x, m.y, m.z
+      local facing = m.facing
+      m._benchmark = v + facing
+      n = n + 6
+   end
+   return n
+end
+
+Triggers = {}
+
+function Triggers.idle()
+   local start = clock and clock()
+   for i = 1, REPEAT do
+      accesses = accesses + exercise()
+   end
+   if clock then
+      elapsed = elapsed + (clock() - start)
+   end
+   ticks = ticks + 1
+
+   if ticks == REPORT_TICKS then
+      if clock then
+         Players.print(string.format("%d field accesses per tick, %.2f ms per tick (%.1f ns each)",
+                                     accesses / ticks, elapsed * 1000 / ticks,
+                                     accesses > 0 and elapsed * 1e9 / accesses or 0))
+      else
+         Players.print(string.format("%d field accesses per tick", accesses / ticks))
+      end
+      elapsed = 0
+      accesses = 0
+      ticks = 0
+   end
+end